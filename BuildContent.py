@@ -1,5 +1,16 @@
 #
-# Finds and compiles shader files from "LearnToads.Game/Shaders" into "Build/Shaders"
+# Builds the game's content: compiles shaders from "LearnToads.Game/Shaders" into
+# "Build/Content/Shaders", bakes models and textures from "Content" into
+# "Build/Content/Models" and "Build/Content/Textures", packs everything into
+# "Build/Content/content.pak", and generates the Content:: accessors in
+# "LearnToads.Game/Content".
+#
+# Builds are incremental: a manifest of source hashes and timestamps is kept in
+# "Build/Content/manifest.json" so only new or changed content is rebuilt.
+#
+# Asset ids are taken from "Content/asset_ids.json", which is committed with the
+# content so every checkout and clean build agrees with the generated accessors.
+# New content is appended to it; commit it along with the content.
 #
 
 # imports
@@ -9,73 +20,400 @@ import glob
 import getopt
 import sys
 import shutil
+import struct
+import zlib
+import json
+import hashlib
 from collections import defaultdict
+from concurrent.futures import ThreadPoolExecutor, ProcessPoolExecutor
+
+from ContentTools.model import bake_model, MODEL_BAKER_VERSION
+from ContentTools.texture import bake_texture, TEXTURE_BAKER_VERSION
+
+# the lz4 module is much faster than the fallback encoder below, but optional
+try:
+    import lz4.block
+except ImportError:
+    lz4 = None
+
+# content archive layout -- must match LTContentPak.h
+CONTENT_PAK_MAGIC = 0x4B50544C # "LTPK"
+CONTENT_PAK_VERSION = 2
+CONTENT_PAK_HEADER = struct.Struct("<IIIIQQ")
+CONTENT_PAK_ENTRY = struct.Struct("<IIQQQIIIIII")
+CONTENT_PAK_ALIGNMENT = 64
+CONTENT_PAK_ENTRY_FLAG_EXTERNAL = 0x1
+CONTENT_PAK_ENTRY_FLAG_EMPTY = 0x2
+
+# build output locations
+CONTENT_BUILD_DIR = "Build/Content"
+CONTENT_CACHE_DIR = "Build/Content/Cache"
+CONTENT_MANIFEST_PATH = "Build/Content/manifest.json"
+CONTENT_PAK_PATH = "Build/Content/content.pak"
+
+# committed content locations
+CONTENT_ID_MAP_PATH = "Content/asset_ids.json"
+
+# bump when the manifest or the cached payloads change meaning, to force a clean build
+CONTENT_MANIFEST_VERSION = 2
+
+# payload codecs -- must match LTCompressionCodec
+CODEC_NONE = 0
+CODEC_LZ4 = 1
+CODEC_NAMES = { "none": CODEC_NONE, "lz4": CODEC_LZ4 }
+
+# the codec each asset type is packed with, by LTAssetType.
+# payloads that do not shrink are stored uncompressed regardless.
+CODEC_POLICY = {
+    0: CODEC_LZ4,   # unknown
+    1: CODEC_LZ4,   # shader
+    2: CODEC_LZ4,   # texture
+    3: CODEC_LZ4,   # model
+}
+
+# writes an lz4 length continuation: 255s followed by the remainder
+def lz4_write_length(out, length):
+    while length >= 255:
+        out.append(255)
+        length -= 255
+    out.append(length)
+
+# compresses 'data' into a single lz4 block (no frame), as decoded by LTCompression.
+# a greedy single-probe matcher -- only used when the lz4 module is missing
+def lz4_compress_block(data):
+    if lz4 is not None:
+        return lz4.block.compress(data, store_size=False)
+
+    size = len(data)
+    out = bytearray()
+    table = {}
+    anchor = 0
+    i = 0
+
+    # the format requires the last match to start 12 bytes before the end,
+    # and the last 5 bytes to be literals
+    match_start_limit = size - 12
+    match_end_limit = size - 5
+
+    while i < match_start_limit:
+        key = data[i:i + 4]
+        candidate = table.get(key)
+        table[key] = i
+
+        if candidate is None or i - candidate > 0xFFFF:
+            i += 1
+            continue
+
+        match_length = 4
+        while i + match_length < match_end_limit and data[candidate + match_length] == data[i + match_length]:
+            match_length += 1
+
+        literal_length = i - anchor
+        extra_match = match_length - 4
+
+        out.append((min(literal_length, 15) << 4) | min(extra_match, 15))
+        if literal_length >= 15:
+            lz4_write_length(out, literal_length - 15)
+        out += data[anchor:i]
+        out += struct.pack("<H", i - candidate)
+        if extra_match >= 15:
+            lz4_write_length(out, extra_match - 15)
+
+        i += match_length
+        anchor = i
+
+    # trailing literals
+    literal_length = size - anchor
+    out.append(min(literal_length, 15) << 4)
+    if literal_length >= 15:
+        lz4_write_length(out, literal_length - 15)
+    out += data[anchor:]
+
+    return bytes(out)
+
+# encodes a payload with the codec chosen for it; returns (codec, stored bytes)
+def encode_payload(payload, codec):
+    if codec == CODEC_LZ4 and len(payload) > 0:
+        compressed = lz4_compress_block(payload)
+        if len(compressed) < len(payload):
+            return (CODEC_LZ4, compressed)
+
+    return (CODEC_NONE, payload)
+
+# encodes an asset's file into the payload cache.
+# runs in a worker process; returns (codec, stored size, uncompressed size)
+def encode_cached_payload(job):
+    source_path, cache_path, codec = job
+
+    with open(source_path, "rb") as f:
+        source = f.read()
+
+    codec, payload = encode_payload(source, codec)
+
+    with open(cache_path, "wb") as f:
+        f.write(payload)
+
+    return (codec, len(payload), len(source))
+
+# hashes a file's contents
+def hash_file(path):
+    sha1 = hashlib.sha1()
+
+    with open(path, "rb") as f:
+        for chunk in iter(lambda: f.read(1 << 20), b""):
+            sha1.update(chunk)
+
+    return sha1.hexdigest()
+
+# writes a file only if its contents would change, so unchanged generated code
+# does not trigger a C++ rebuild. returns true if the file was written
+def write_if_changed(path, text):
+    if os.path.exists(path):
+        with open(path, "r") as f:
+            if f.read() == text:
+                return False
+
+    with open(path, "w") as f:
+        f.write(text)
+
+    return True
+
+# loads the manifest from the last build, or an empty one
+def load_manifest():
+    try:
+        with open(CONTENT_MANIFEST_PATH, "r") as f:
+            manifest = json.load(f)
+
+        if manifest.get("version") == CONTENT_MANIFEST_VERSION:
+            return manifest
+    except (OSError, ValueError):
+        pass
+
+    return { "version": CONTENT_MANIFEST_VERSION, "options": {}, "assets": {} }
+
+def save_manifest(manifest):
+    with open(CONTENT_MANIFEST_PATH, "w") as f:
+        json.dump(manifest, f, indent=4, sort_keys=True)
+
+# loads the committed map of content source paths to asset ids, or an empty one
+def load_id_map():
+    try:
+        with open(CONTENT_ID_MAP_PATH, "r") as f:
+            return json.load(f)
+    except FileNotFoundError:
+        return { "next_id": 0, "ids": {} }
+
+def save_id_map(id_map):
+    return write_if_changed(CONTENT_ID_MAP_PATH, json.dumps(id_map, indent=4, sort_keys=True) + "\n")
 
 # defines a useful tool for flattening the lists we get from glob.glob(...)
 def flatten(l):
     return [item for sublist in l for item in sublist]
 
-def build_shaders():
-    print("Building shaders...Finished")
+# describes how a content source file is built and exposed to the game.
+# returns (content namespace, class name, asset type, asset type class, build output path)
+def describe_content(content_file):
+    file_name_index = content_file.rfind("/") + 1
+    start_of_ext = content_file.find(".", file_name_index)
+    file_name = content_file[file_name_index:]
+    without_ext = content_file[file_name_index:start_of_ext]
+    ext = content_file[start_of_ext:]
+    class_name = without_ext[:1].capitalize() + without_ext[1:]
+
+    asset_type_unknown = 0
+    asset_type_shader  = 1
+    asset_type_texture = 2
+    asset_type_model   = 3
+
+    content_ns = "UnknownContent"
+    lookup_path = content_file
+    asset_type = asset_type_unknown
+    asset_type_cpp = "LTAsset"
+
+    if "png" in ext:
+        content_ns = "Images"
+        lookup_path = f"Build/Content/Textures/{file_name}.lttexture"
+        asset_type = asset_type_texture
+        asset_type_cpp = "LTTexture"
+    elif "fbx" in ext or "obj" in ext:
+        content_ns = "Models"
+        lookup_path = f"Build/Content/Models/{file_name}.ltmodel"
+        asset_type = asset_type_model
+        asset_type_cpp = "LTModel"
+    elif "vert" in ext:
+        content_ns = "VertexShaders"
+        lookup_path = f"Build/Content/Shaders/{file_name}.spv"
+        asset_type = asset_type_shader
+        asset_type_cpp = "LTShader"
+    elif "frag" in ext:
+        content_ns = "FragmentShaders"
+        lookup_path = f"Build/Content/Shaders/{file_name}.spv"
+        asset_type = asset_type_shader
+        asset_type_cpp = "LTShader"
+
+    return (content_ns, class_name, asset_type, asset_type_cpp, lookup_path)
+
+# compiles a single shader with glslc; returns true on success
+def compile_shader(shader_file_path, output_path):
+    # get the vulkan path where glslc is located
+    vulkan_path = os.environ['VulkanBinPath']
+
+    print(f"Building shaders...{shader_file_path}")
+
+    return subprocess.call([f"{vulkan_path}/glslc.exe", shader_file_path, f"-o{output_path}"]) == 0
 
-    # get list of shaders from disk
-    shader_file_types = ["*.vert", "*.frag"]
-    shader_files = flatten([glob.glob(f"LearnToads.Game/Shaders/{ext}") for ext in shader_file_types])
+# compiles the given shaders in parallel; returns the sources that failed
+def build_shaders(shaders):
+    print("Building shaders...")
 
     # ensure the build directories exist for shaders
     os.makedirs("Build/Content/Shaders", exist_ok=True)
 
-    # get the vulkan path where glslc is located
-    vulkan_path = os.environ['VulkanBinPath']
+    failed = []
 
-    # compile each of the shaders using glslc
-    for shader_file_path in shader_files:
-        
-        # clean the file name
-        shader_file = shader_file_path.replace("\\", "/").replace("LearnToads.Game/Shaders/", "")
-        
-        print(f"Building shaders...{shader_file}")
+    # glslc runs as its own process, so threads are enough to use every core
+    with ThreadPoolExecutor(max_workers=os.cpu_count()) as executor:
+        results = executor.map(lambda shader: compile_shader(*shader), shaders)
 
-        # compile step
-        subprocess.call([f"{vulkan_path}/glslc.exe", shader_file_path, f"-oBuild/Content/Shaders/{shader_file}.spv"])
+        for (shader_file_path, output_path), success in zip(shaders, results):
+            if not success:
+                failed.append(shader_file_path)
 
+    print(f"Building shaders...{len(shaders) - len(failed)} compiled, {len(failed)} failed")
     print("Building shaders...Finished")
 
-# main entry-point
-def main(argv):
-    print("Building content...")
+    return failed
 
-    # handle changing current working directory if needed
-    opts, args = getopt.getopt(argv, "x", ["cd="])    
-    opts = flatten(opts)
+# bakes the given models in parallel; returns the sources that failed
+def build_models(models):
+    print("Baking models...")
 
-    pop_cwd = False
-    pwd = os.getcwd()
+    # ensure the build directories exist for models
+    os.makedirs("Build/Content/Models", exist_ok=True)
 
-    if "--cd" in opts:
-        pop_cwd = True
-        os.chdir(opts[1])
+    failed = []
 
-    try:
-        # clean/remove previous build
-        shutil.rmtree(f"{os.getcwd()}/Build/Content")
-    except: pass
+    # the importers are pure python, so use processes to use every core
+    with ProcessPoolExecutor() as executor:
+        results = executor.map(bake_model, *zip(*models))
 
-    # ensure the build directories exist for content
-    os.makedirs("Build/Content", exist_ok=True)
+        for (model_file_path, output_path), success in zip(models, results):
+            if not success:
+                failed.append(model_file_path)
 
-    # get list of content from disk
-    content_file_types = ["*.*"]
-    content_files = flatten([glob.glob(f"Content/{ext}") for ext in content_file_types])
-    content_files += flatten([glob.glob(f"LearnToads.Game/Shaders/{ext}") for ext in content_file_types])
+    print(f"Baking models...{len(models) - len(failed)} baked, {len(failed)} failed")
+    print("Baking models...Finished")
+
+    return failed
+
+# bakes the given textures in parallel; returns the sources that failed
+def build_textures(textures):
+    print("Baking textures...")
+
+    # ensure the build directories exist for textures
+    os.makedirs("Build/Content/Textures", exist_ok=True)
+
+    failed = []
+
+    # the encoders are pure python, so use processes to use every core
+    with ProcessPoolExecutor() as executor:
+        results = executor.map(bake_texture, *zip(*textures))
+
+        for (texture_file_path, output_path), success in zip(textures, results):
+            if not success:
+                failed.append(texture_file_path)
+
+    print(f"Baking textures...{len(textures) - len(failed)} baked, {len(failed)} failed")
+    print("Baking textures...Finished")
+
+    return failed
+
+def align_up(value, alignment):
+    return (value + alignment - 1) & ~(alignment - 1)
+
+# writes the packed content archive read by LTContentPak.
+# content_entries: one per asset id, in id order; None for ids that are no longer used.
+#   each entry is (path, asset_type, codec, cache_path, uncompressed_size)
+# loose: reference each asset's file instead of packing its payload
+def write_content_pak(pak_path, content_entries, loose):
+    print("Packing content...")
+
+    # string table of asset paths
+    string_table = bytearray()
+    name_ranges = []
+
+    for entry in content_entries:
+        if entry is None:
+            name_ranges.append((0, 0))
+            continue
+
+        name = entry[0].encode("utf-8")
+        name_ranges.append((len(string_table), len(name)))
+        string_table += name
 
-    # build the shaders
-    build_shaders()
+    string_table_offset = CONTENT_PAK_HEADER.size + CONTENT_PAK_ENTRY.size * len(content_entries)
+    payload_offset = align_up(string_table_offset + len(string_table), CONTENT_PAK_ALIGNMENT)
 
-    # creates a csv that supplies information about the content.
-    # format: content_id, file_path
-    content_lookup_csv = ""
+    table_of_contents = bytearray()
+    payloads = bytearray()
+    total_uncompressed = 0
 
+    for asset_id, (entry, (name_offset, name_length)) in enumerate(zip(content_entries, name_ranges)):
+        if entry is None:
+            table_of_contents += CONTENT_PAK_ENTRY.pack(
+                asset_id, 0, 0, 0, 0, 0, CONTENT_PAK_ENTRY_FLAG_EMPTY, CODEC_NONE, 0, 0, 0)
+            continue
+
+        path, asset_type, codec, cache_path, uncompressed_size = entry
+
+        if loose:
+            table_of_contents += CONTENT_PAK_ENTRY.pack(
+                asset_id, asset_type, 0, 0, 0, 0, CONTENT_PAK_ENTRY_FLAG_EXTERNAL, CODEC_NONE, name_offset, name_length, 0)
+            continue
+
+        with open(cache_path, "rb") as f:
+            payload = f.read()
+
+        total_uncompressed += uncompressed_size
+
+        # every payload starts aligned so loaders can read it in place
+        payloads += bytes(align_up(len(payloads), CONTENT_PAK_ALIGNMENT) - len(payloads))
+
+        table_of_contents += CONTENT_PAK_ENTRY.pack(
+            asset_id,
+            asset_type,
+            payload_offset + len(payloads),
+            len(payload),
+            uncompressed_size,
+            zlib.crc32(payload) & 0xFFFFFFFF,
+            0,
+            codec,
+            name_offset,
+            name_length,
+            0)
+
+        payloads += payload
+
+    header = CONTENT_PAK_HEADER.pack(
+        CONTENT_PAK_MAGIC,
+        CONTENT_PAK_VERSION,
+        len(content_entries),
+        CONTENT_PAK_ALIGNMENT,
+        string_table_offset,
+        len(string_table))
+
+    with open(pak_path, "wb") as f:
+        f.write(header)
+        f.write(table_of_contents)
+        f.write(string_table)
+        f.write(bytes(payload_offset - (string_table_offset + len(string_table))))
+        f.write(payloads)
+
+    print(f"Packing content...{len(content_entries)} assets, {total_uncompressed} bytes of content packed into {payload_offset + len(payloads)} bytes")
+    print("Packing content...Finished")
+
+# generates the Content:: accessors header and source
+def generate_content_code(content_map):
     # get the text that we write to the content header
     content_header = """
 #pragma once
@@ -87,66 +425,6 @@ def main(argv):
 namespace Content {
 """
 
-    asset_id_counter = 0
-
-    content_map = defaultdict(list)
-
-    for content_file in content_files:
-        asset_id = asset_id_counter
-        fixed_content_file = content_file.replace("\\", "/")
-        file_name_index = fixed_content_file.rfind("/") + 1
-        start_of_ext = fixed_content_file.find(".", file_name_index)
-        file_name = fixed_content_file[file_name_index:]
-        without_ext = fixed_content_file[file_name_index:start_of_ext]
-        ext = fixed_content_file[start_of_ext:]
-        ns_path = fixed_content_file[:file_name_index - 1] \
-            .replace(".", "/") \
-            .replace("LearnToads/Game", "") \
-            .replace("Content", "") \
-            .replace("Shaders", "") \
-            .strip("/")
-        class_name = without_ext[:1].capitalize() + without_ext[1:]
-
-        ns_parts = ns_path.split("/")
-        ns_parts.remove('')
-
-        content_ns = "UnknownContent"
-
-        lookup_path = fixed_content_file
-
-        asset_type_unknown = 0
-        asset_type_shader  = 1
-        asset_type_texture = 2
-        asset_type_model   = 3
-
-        asset_type = asset_type_unknown
-        asset_type_cpp = "LTAsset"
-
-        if "png" in ext:
-            content_ns = "Images"
-            asset_type = asset_type_texture
-            asset_type_cpp = "LTTexture"
-        elif "fbx" in ext or "obj" in ext:
-            content_ns = "Models"
-            asset_type = asset_type_model
-            asset_type_cpp = "LTModel"
-        elif "vert" in ext:
-            content_ns = "VertexShaders"
-            lookup_path = f"Build/Content/Shaders/{file_name}.spv"
-            asset_type = asset_type_shader
-            asset_type_cpp = "LTShader"
-        elif "frag" in ext:
-            content_ns = "FragmentShaders"
-            lookup_path = f"Build/Content/Shaders/{file_name}.spv"
-            asset_type = asset_type_shader
-            asset_type_cpp = "LTShader"
-
-        content_lookup_csv += f"{asset_id},{lookup_path},{asset_type}\n"
-
-        content_map[content_ns].append((content_ns, class_name, ns_parts, asset_id, asset_type_cpp))
-
-        asset_id_counter = asset_id_counter + 1
-
     for k, v in content_map.items():
         content_header += f"class {k} {{\n"
         content_header += f"private: \n"                
@@ -159,8 +437,13 @@ namespace Content {
         for element in v:
             content_header += f"""
     static inline uint32_t Get{element[1]}ID();
-    static LTAssetHandle Get{element[1]}();
+    static LTAssetHandle Get{element[1]}(
+        LTAssetPriority priority = LTAssetPriority::LT_ASSET_PRIORITY_NORMAL,
+        uint64_t deadlineFrame = LT_ASSET_NO_DEADLINE);
     static LTAssetHandle Get{element[1]}NoLoad();
+    static LTAssetLoadToken Load{element[1]}(
+        LTAssetPriority priority = LTAssetPriority::LT_ASSET_PRIORITY_NORMAL,
+        uint64_t deadlineFrame = LT_ASSET_NO_DEADLINE);
 """        
 
         content_header += f"}}; // class {k} \n\n"
@@ -191,35 +474,247 @@ LTAssetHandle Content::{k}::Get{element[1]}NoLoad()
     return assetHandle;
 }}
 
-LTAssetHandle Content::{k}::Get{element[1]}()
+LTAssetHandle Content::{k}::Get{element[1]}(
+    LTAssetPriority priority,
+    uint64_t deadlineFrame)
 {{
     LTAssetHandle assetHandle;
-    LTAssetManager::GetInstance().GetLoad(/* asset id = */ {element[3]}, assetHandle);
+    LTAssetManager::GetInstance().GetLoad(/* asset id = */ {element[3]}, assetHandle, priority, deadlineFrame);
     return assetHandle;
 }}
+
+LTAssetLoadToken Content::{k}::Load{element[1]}(
+    LTAssetPriority priority,
+    uint64_t deadlineFrame)
+{{
+    LTAssetHandle assetHandle;
+    LTAssetLoadToken loadToken;
+    LTAssetManager::GetInstance().GetLoad(/* asset id = */ {element[3]}, assetHandle, loadToken, priority, deadlineFrame);
+    return loadToken;
+}}
 """        
-    # write out the content header
-    with open("LearnToads.Game/Content/LTContent.h", "w") as f:
-        f.write(content_header)
 
-    # write out the content header
-    with open("LearnToads.Game/Content/LTContent.cpp", "w") as f:
-        f.write(content_cpp)
+    return (content_header, content_cpp)
 
-    # write out the content header
-    with open("Build/Content/content.csv", "w") as f:
-        f.write(content_lookup_csv)
+# main entry-point
+def main(argv):
+    print("Building content...")
 
-    # todo: so that this is not slow, should probably create some kind of per-file hash and timestamp listing file
-    #       that can be used to compare/diff for changes. each run should produce this file as an output as well.
-    #       then we only perform the build step for new, changed, or removed content.
+    # --cd: change the current working directory before building
+    # --loose: reference loose files from the content archive instead of packing them
+    # --codec: pack every asset with this codec (none, lz4) instead of the per-type policy
+    # --rebuild: ignore the manifest and rebuild everything; asset ids are kept
+    opts, args = getopt.getopt(argv, "x", ["cd=", "loose", "codec=", "rebuild"])
+
+    pop_cwd = False
+    pwd = os.getcwd()
+    loose = False
+    codec_override = None
+    rebuild = False
+
+    for opt, value in opts:
+        if opt == "--cd":
+            pop_cwd = True
+            os.chdir(value)
+        elif opt == "--loose":
+            loose = True
+        elif opt == "--codec":
+            codec_override = CODEC_NAMES[value]
+        elif opt == "--rebuild":
+            rebuild = True
+
+    if rebuild:
+        try:
+            # clean/remove previous build
+            shutil.rmtree(f"{os.getcwd()}/Build/Content")
+        except: pass
+
+    # ensure the build directories exist for content
+    os.makedirs(CONTENT_BUILD_DIR, exist_ok=True)
+    os.makedirs(CONTENT_CACHE_DIR, exist_ok=True)
+
+    manifest = load_manifest()
+    old_assets = manifest["assets"]
+    new_assets = {}
+
+    id_map = load_id_map()
+
+    # get list of content from disk, in a stable order so new ids are assigned deterministically
+    content_file_types = ["*.*"]
+    content_files = sorted(flatten([glob.glob(f"Content/{ext}") for ext in content_file_types]))
+    content_files = [content_file for content_file in content_files if content_file.replace("\\", "/") != CONTENT_ID_MAP_PATH]
+    content_files += sorted(flatten([glob.glob(f"LearnToads.Game/Shaders/{ext}") for ext in content_file_types]))
+    content_files = [content_file.replace("\\", "/") for content_file in content_files]
+
+    shaders_to_build = []
+    models_to_build = []
+    textures_to_build = []
+    payloads_to_encode = []
+
+    for content_file in content_files:
+        content_ns, class_name, asset_type, asset_type_cpp, lookup_path = describe_content(content_file)
+
+        stat = os.stat(content_file)
+        old = old_assets.get(content_file)
+
+        # only hash files whose timestamp or size moved since the last build
+        if old and old["mtime"] == stat.st_mtime and old["size"] == stat.st_size:
+            source_hash = old["hash"]
+        else:
+            source_hash = hash_file(content_file)
+
+        # ids are never reused, so an asset keeps its id for as long as its source exists
+        if content_file in id_map["ids"]:
+            asset_id = id_map["ids"][content_file]
+        else:
+            asset_id = id_map["next_id"]
+            id_map["ids"][content_file] = asset_id
+            id_map["next_id"] += 1
+            print(f"Building content...new asset {content_file}, id {asset_id}")
+
+        # payloads are cached by id, so an id that moved (e.g. the map was edited
+        # by hand) invalidates the cached payload
+        if old and old["id"] != asset_id:
+            old = None
+
+        codec = codec_override if codec_override is not None else CODEC_POLICY.get(asset_type, CODEC_NONE)
+        cache_path = f"{CONTENT_CACHE_DIR}/{asset_id}.bin"
+
+        # models and textures are re-baked when their baker changes
+        baker_version = { "LTModel": MODEL_BAKER_VERSION, "LTTexture": TEXTURE_BAKER_VERSION }.get(asset_type_cpp, 0)
+
+        changed = not old or old["hash"] != source_hash or old.get("baker", 0) != baker_version
+
+        if lookup_path != content_file and (changed or not os.path.exists(lookup_path)):
+            if asset_type_cpp == "LTModel":
+                models_to_build.append((content_file, lookup_path))
+            elif asset_type_cpp == "LTTexture":
+                textures_to_build.append((content_file, lookup_path))
+            else:
+                shaders_to_build.append((content_file, lookup_path))
+            changed = True
+
+        asset = dict(old) if old else {}
+        asset.update({
+            "id": asset_id,
+            "hash": source_hash,
+            "mtime": stat.st_mtime,
+            "size": stat.st_size,
+            "type": asset_type,
+            "path": lookup_path,
+            "ns": content_ns,
+            "class": class_name,
+            "type_cpp": asset_type_cpp,
+            "target_codec": codec,
+            "baker": baker_version,
+        })
+
+        if not loose and (changed or old.get("target_codec") != codec or not os.path.exists(cache_path)):
+            payloads_to_encode.append((content_file, (lookup_path, cache_path, codec)))
+
+        new_assets[content_file] = asset
+
+    # remove the outputs of content that no longer exists; its id becomes a hole
+    removed = [content_file for content_file in old_assets if content_file not in new_assets]
+
+    for content_file in [content_file for content_file in id_map["ids"] if content_file not in new_assets]:
+        del id_map["ids"][content_file]
+
+    for content_file in removed:
+        old = old_assets[content_file]
+        print(f"Building content...removed {content_file}")
+
+        for stale_path in [f"{CONTENT_CACHE_DIR}/{old['id']}.bin", old["path"] if old["path"] != content_file else None]:
+            if stale_path and os.path.exists(stale_path):
+                os.remove(stale_path)
+
+    # build the shaders, models and textures
+    failed = build_shaders(shaders_to_build) if shaders_to_build else []
+    failed += build_models(models_to_build) if models_to_build else []
+    failed += build_textures(textures_to_build) if textures_to_build else []
+
+    for content_file in failed:
+        # forget the hash so the next run retries it
+        new_assets[content_file]["hash"] = ""
+        payloads_to_encode = [job for job in payloads_to_encode if job[0] != content_file]
+
+    # encode payloads in parallel; the fallback lz4 encoder is pure python, so use processes
+    if payloads_to_encode:
+        print(f"Encoding content...{len(payloads_to_encode)} payloads")
+
+        with ProcessPoolExecutor() as executor:
+            results = executor.map(encode_cached_payload, [job for content_file, job in payloads_to_encode])
+
+            for (content_file, job), (codec, stored_size, uncompressed_size) in zip(payloads_to_encode, results):
+                new_assets[content_file].update({
+                    "codec": codec,
+                    "stored_size": stored_size,
+                    "uncompressed_size": uncompressed_size,
+                })
+
+    options = { "loose": loose, "codec_override": codec_override }
+
+    dirty = (bool(shaders_to_build) or bool(models_to_build) or bool(textures_to_build) or bool(payloads_to_encode) or bool(removed)
+        or manifest["options"] != options
+        or set(old_assets) != set(new_assets)
+        or not os.path.exists(CONTENT_PAK_PATH))
+
+    # the archive is indexed by id, so ids of removed content are left as empty entries
+    content_entries = [None] * id_map["next_id"]
+
+    for content_file, asset in new_assets.items():
+        cache_path = f"{CONTENT_CACHE_DIR}/{asset['id']}.bin"
+
+        # content that has never built successfully is left out until it does
+        if not loose and not os.path.exists(cache_path):
+            print(f"Packing content...skipping {content_file}, it has not been built")
+            continue
+
+        content_entries[asset["id"]] = (
+            asset["path"],
+            asset["type"],
+            asset.get("codec", CODEC_NONE),
+            cache_path,
+            asset.get("uncompressed_size", 0))
+
+    # write out the content archive
+    if dirty:
+        write_content_pak(CONTENT_PAK_PATH, content_entries, loose)
+    else:
+        print("Packing content...up to date")
+
+    # build the accessors, grouped by namespace in id order
+    content_map = defaultdict(list)
+
+    for asset in sorted(new_assets.values(), key=lambda asset: asset["id"]):
+        content_map[asset["ns"]].append((asset["ns"], asset["class"], [], asset["id"], asset["type_cpp"]))
+
+    content_header, content_cpp = generate_content_code(content_map)
+
+    # write out the content header and source, leaving them untouched if nothing changed
+    header_written = write_if_changed("LearnToads.Game/Content/LTContent.h", content_header)
+    source_written = write_if_changed("LearnToads.Game/Content/LTContent.cpp", content_cpp)
+
+    if not header_written and not source_written:
+        print("Generating content code...up to date")
+
+    manifest["assets"] = new_assets
+    manifest["options"] = options
+    save_manifest(manifest)
+
+    if save_id_map(id_map):
+        print(f"Building content...updated {CONTENT_ID_MAP_PATH}, commit it with the content")
 
     # change cwd back
     if pop_cwd:
         os.chdir(pwd)
 
+    if failed:
+        print(f"Building content...Failed ({len(failed)} shaders, models or textures did not build)")
+        sys.exit(1)
+
     print("Building content...Finished")
 
 # boilerplate
 if __name__ == "__main__":
-    main(sys.argv[1:])
\ No newline at end of file
+    main(sys.argv[1:])
@@ -0,0 +1,3 @@
+#
+# Offline content importers used by BuildContent.py.
+#
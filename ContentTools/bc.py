@@ -0,0 +1,309 @@
+#
+# Block compression encoders for baked textures: BC1, BC3, BC5 and BC7.
+#
+# Every format stores 4x4 texel blocks, so a level whose size is not a multiple of
+# 4 repeats its edge texels into the partial blocks. Each encoder takes a block as
+# 16 (r, g, b, a) tuples, rows top to bottom, and returns the block's bytes.
+#
+# The endpoints of each block start at the extremes of its texels along their
+# principal axis, then one least-squares pass refits them to the indices chosen.
+# BC7 is encoded in mode 6 only: one subset, 7-bit RGBA endpoints with a shared
+# low bit each and 4-bit indices. It cannot split a block into regions the way the
+# other modes can, but it is simple and already well ahead of BC1 and BC3.
+#
+
+# imports
+import struct
+
+# the weights BC7 blends its two endpoints with for 4-bit indices, out of 64
+BC7_WEIGHTS = [0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64]
+
+# the 4-bit index whose weight is nearest to each weight from 0 to 64
+BC7_NEAREST_INDEX = [min(range(16), key = lambda index: abs(BC7_WEIGHTS[index] - weight)) for weight in range(65)]
+
+# the mean of the points and the axis they spread the most along, by power iteration
+def principal_axis(points):
+    count = len(points)
+    dims = len(points[0])
+    mean = [sum(point[axis] for point in points) / count for axis in range(dims)]
+    centered = [[point[axis] - mean[axis] for axis in range(dims)] for point in points]
+
+    covariance = [[sum(point[row] * point[column] for point in centered) for column in range(dims)] for row in range(dims)]
+
+    # start from the spread between the extremes of each axis
+    axis = [max(point[i] for point in points) - min(point[i] for point in points) for i in range(dims)]
+
+    for _ in range(8):
+        axis = [sum(covariance[row][column] * axis[column] for column in range(dims)) for row in range(dims)]
+        length = max(abs(value) for value in axis)
+
+        if length == 0.0:
+            return mean, [0.0] * dims
+
+        axis = [value / length for value in axis]
+
+    length = sum(value * value for value in axis) ** 0.5
+    return mean, [value / length for value in axis]
+
+# the endpoints spanning the points along their principal axis, pulled in by 1/16 of
+# the span so the extremes land near the interpolated entries rather than past them
+def axis_endpoints(points, inset):
+    mean, axis = principal_axis(points)
+    projections = [sum((point[i] - mean[i]) * axis[i] for i in range(len(axis))) for point in points]
+
+    low, high = min(projections), max(projections)
+    pull = (high - low) * inset
+    low, high = low + pull, high - pull
+
+    return [mean[i] + axis[i] * high for i in range(len(axis))], [mean[i] + axis[i] * low for i in range(len(axis))]
+
+# solves for the two endpoints that best reproduce the points with the given
+# blend factors, 0 at the first endpoint and 1 at the second
+def least_squares_endpoints(points, factors):
+    dims = len(points[0])
+    alpha2 = beta2 = alpha_beta = 0.0
+    alpha_x = [0.0] * dims
+    beta_x = [0.0] * dims
+
+    for point, factor in zip(points, factors):
+        alpha = 1.0 - factor
+        alpha2 += alpha * alpha
+        beta2 += factor * factor
+        alpha_beta += alpha * factor
+
+        for i in range(dims):
+            alpha_x[i] += alpha * point[i]
+            beta_x[i] += factor * point[i]
+
+    determinant = alpha2 * beta2 - alpha_beta * alpha_beta
+
+    if abs(determinant) < 1e-8:
+        return None
+
+    first = [(alpha_x[i] * beta2 - beta_x[i] * alpha_beta) / determinant for i in range(dims)]
+    second = [(beta_x[i] * alpha2 - alpha_x[i] * alpha_beta) / determinant for i in range(dims)]
+
+    return first, second
+
+def squared_distance(a, b):
+    return sum((x - y) * (x - y) for x, y in zip(a, b))
+
+def pack_565(color):
+    r = min(31, max(0, int(color[0] * 31.0 / 255.0 + 0.5)))
+    g = min(63, max(0, int(color[1] * 63.0 / 255.0 + 0.5)))
+    b = min(31, max(0, int(color[2] * 31.0 / 255.0 + 0.5)))
+    return (r << 11) | (g << 5) | b
+
+def unpack_565(value):
+    r, g, b = (value >> 11) & 31, (value >> 5) & 63, value & 31
+    return ((r << 3) | (r >> 2), (g << 2) | (g >> 4), (b << 3) | (b >> 2))
+
+# picks the BC1 indices for two packed endpoints in 4-color mode;
+# returns (error, first, second, indices)
+def bc1_fit(colors, first, second):
+    if first < second:
+        first, second = second, first
+
+    # equal endpoints select 3-color mode, where index 0 is still the endpoint
+    if first == second:
+        color = unpack_565(first)
+        return (sum(squared_distance(color, texel) for texel in colors), first, second, [0] * 16)
+
+    a, b = unpack_565(first), unpack_565(second)
+    palette = [
+        a,
+        b,
+        tuple((2 * a[i] + b[i]) / 3.0 for i in range(3)),
+        tuple((a[i] + 2 * b[i]) / 3.0 for i in range(3))]
+
+    error = 0.0
+    indices = []
+
+    for texel in colors:
+        distances = [squared_distance(entry, texel) for entry in palette]
+        index = distances.index(min(distances))
+        indices.append(index)
+        error += distances[index]
+
+    return (error, first, second, indices)
+
+# BC1's blend factor toward the second endpoint, by index
+BC1_FACTORS = [0.0, 1.0, 1.0 / 3.0, 2.0 / 3.0]
+
+# encodes an opaque block as BC1: two 565 endpoints and 2-bit indices
+def encode_bc1_block(block):
+    colors = [texel[0:3] for texel in block]
+    first, second = axis_endpoints(colors, 1.0 / 16.0)
+
+    best = bc1_fit(colors, pack_565(first), pack_565(second))
+
+    refit = least_squares_endpoints(colors, [BC1_FACTORS[index] for index in best[3]])
+    if refit is not None:
+        candidate = bc1_fit(colors, pack_565(refit[0]), pack_565(refit[1]))
+        if candidate[0] < best[0]:
+            best = candidate
+
+    error, first, second, indices = best
+    bits = 0
+
+    for i, index in enumerate(indices):
+        bits |= index << (i * 2)
+
+    return struct.pack("<HHI", first, second, bits)
+
+# picks the nearest palette entry of every value; returns (error, indices)
+def bc4_fit(values, palette):
+    error = 0.0
+    indices = []
+
+    for value in values:
+        distances = [abs(entry - value) for entry in palette]
+        index = distances.index(min(distances))
+        indices.append(index)
+        error += distances[index] * distances[index]
+
+    return error, indices
+
+# encodes one channel of a block as BC4: two 8-bit endpoints and 3-bit indices
+def encode_bc4_channel(values):
+    high, low = max(values), min(values)
+
+    # 8 interpolated values between the extremes
+    if high > low:
+        palette = [high, low] + [((7 - i) * high + i * low) / 7.0 for i in range(1, 7)]
+        best = bc4_fit(values, palette) + (high, low)
+    else:
+        best = (0.0, [0] * 16, high, low)
+
+    # 6 interpolated values plus exact 0 and 255, for blocks that hit the extremes
+    inner = [value for value in values if 0 < value < 255]
+    if inner and len(inner) < 16:
+        inner_low, inner_high = min(inner), max(inner)
+        palette = [inner_low, inner_high] + [((5 - i) * inner_low + i * inner_high) / 5.0 for i in range(1, 5)] + [0, 255]
+        candidate = bc4_fit(values, palette) + (inner_low, inner_high)
+
+        if candidate[0] < best[0]:
+            best = candidate
+
+    error, indices, first, second = best
+    bits = 0
+
+    for i, index in enumerate(indices):
+        bits |= index << (i * 3)
+
+    return bytes((first, second)) + bits.to_bytes(6, "little")
+
+# encodes a block as BC3: BC4 alpha followed by BC1 color
+def encode_bc3_block(block):
+    return encode_bc4_channel([texel[3] for texel in block]) + encode_bc1_block(block)
+
+# encodes a block as BC5: BC4 red followed by BC4 green
+def encode_bc5_block(block):
+    return encode_bc4_channel([texel[0] for texel in block]) + encode_bc4_channel([texel[1] for texel in block])
+
+# quantizes BC7 mode 6 endpoints for the given low bits and picks the indices;
+# returns (error, endpoints, pbits, indices)
+def bc7_fit(texels, first, second, pbits):
+    endpoints = []
+
+    for endpoint, pbit in zip((first, second), pbits):
+        endpoints.append([min(127, max(0, int((value - pbit) / 2.0 + 0.5))) for value in endpoint])
+
+    a = [(value << 1) | pbits[0] for value in endpoints[0]]
+    b = [(value << 1) | pbits[1] for value in endpoints[1]]
+    palette = [[((64 - weight) * a[i] + weight * b[i] + 32) >> 6 for i in range(4)] for weight in BC7_WEIGHTS]
+
+    # the index comes from projecting onto the line between the endpoints, and only
+    # its neighbours are checked, rather than all 16 entries
+    direction = [b[i] - a[i] for i in range(4)]
+    length2 = sum(value * value for value in direction)
+
+    error = 0.0
+    indices = []
+
+    for texel in texels:
+        if length2 == 0:
+            index = 0
+        else:
+            factor = sum((texel[i] - a[i]) * direction[i] for i in range(4)) / length2
+            index = BC7_NEAREST_INDEX[min(64, max(0, int(factor * 64.0 + 0.5)))]
+
+        candidates = [candidate for candidate in (index - 1, index, index + 1) if 0 <= candidate < 16]
+        distances = [squared_distance(palette[candidate], texel) for candidate in candidates]
+        nearest = distances.index(min(distances))
+
+        indices.append(candidates[nearest])
+        error += distances[nearest]
+
+    return (error, endpoints, pbits, indices)
+
+def bc7_best_fit(texels, first, second):
+    return min((bc7_fit(texels, first, second, pbits) for pbits in ((0, 0), (0, 1), (1, 0), (1, 1))), key = lambda fit: fit[0])
+
+# encodes a block as BC7 mode 6
+def encode_bc7_block(block):
+    first, second = axis_endpoints(block, 1.0 / 32.0)
+    best = bc7_best_fit(block, first, second)
+
+    refit = least_squares_endpoints(block, [BC7_WEIGHTS[index] / 64.0 for index in best[3]])
+    if refit is not None:
+        candidate = bc7_best_fit(block, refit[0], refit[1])
+        if candidate[0] < best[0]:
+            best = candidate
+
+    error, endpoints, pbits, indices = best
+
+    # the first index is stored without its high bit, so it must be below 8
+    if indices[0] >= 8:
+        endpoints = [endpoints[1], endpoints[0]]
+        pbits = (pbits[1], pbits[0])
+        indices = [15 - index for index in indices]
+
+    # mode 6 is 6 zero bits and a one, then the fields from the lowest bit up
+    bits = 1 << 6
+    position = 7
+
+    for channel in range(4):
+        for endpoint in endpoints:
+            bits |= endpoint[channel] << position
+            position += 7
+
+    for pbit in pbits:
+        bits |= pbit << position
+        position += 1
+
+    for i, index in enumerate(indices):
+        bits |= index << position
+        position += 3 if i == 0 else 4
+
+    return bits.to_bytes(16, "little")
+
+# the block encoder and bytes per block of each format name
+BLOCK_ENCODERS = {
+    "bc1": (encode_bc1_block, 8),
+    "bc3": (encode_bc3_block, 16),
+    "bc5": (encode_bc5_block, 16),
+    "bc7": (encode_bc7_block, 16),
+}
+
+# encodes RGBA8 pixels into blocks of the given format, in rows of blocks
+def encode_blocks(width, height, pixels, format_name):
+    encode_block, block_bytes = BLOCK_ENCODERS[format_name]
+    encoded = bytearray()
+
+    for block_y in range(0, height, 4):
+        # partial blocks repeat the last row and column
+        rows = [min(height - 1, block_y + y) for y in range(4)]
+
+        for block_x in range(0, width, 4):
+            columns = [min(width - 1, block_x + x) for x in range(4)]
+            block = []
+
+            for y in rows:
+                for x in columns:
+                    offset = (y * width + x) * 4
+                    block.append(tuple(pixels[offset:offset + 4]))
+
+            encoded += encode_block(block)
+
+    return bytes(encoded)
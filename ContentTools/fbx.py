@@ -0,0 +1,200 @@
+#
+# Reads binary FBX files (as written by Blender and the FBX SDK) into a Mesh.
+#
+# Only the geometry is imported: every Geometry object's vertices, polygons,
+# normals and first UV set are merged into a single mesh, in geometry space.
+#
+
+# imports
+import struct
+import zlib
+
+from ContentTools.mesh import Mesh
+
+FBX_MAGIC = b"Kaydara FBX Binary  \x00"
+
+# a node in the FBX document tree
+class FbxNode:
+    def __init__(self, name, properties, children):
+        self.name = name
+        self.properties = properties
+        self.children = children
+
+    # gets the first child with the given name, or None
+    def find(self, name):
+        for child in self.children:
+            if child.name == name:
+                return child
+        return None
+
+    # gets every child with the given name
+    def find_all(self, name):
+        return [child for child in self.children if child.name == name]
+
+    # gets the first property of the first child with the given name, or 'default'
+    def value(self, name, default = None):
+        child = self.find(name)
+        return child.properties[0] if child and child.properties else default
+
+# decodes one array property: length, encoding (0 raw, 1 zlib), compressed length, data
+def read_array(data, offset, element_format):
+    length, encoding, compressed_length = struct.unpack_from("<III", data, offset)
+    offset += 12
+
+    raw = data[offset:offset + compressed_length]
+    offset += compressed_length
+
+    if encoding == 1:
+        raw = zlib.decompress(raw)
+
+    return list(struct.unpack(f"<{length}{element_format}", raw)), offset
+
+# decodes one property; returns (value, next offset)
+def read_property(data, offset):
+    type_code = chr(data[offset])
+    offset += 1
+
+    scalar_formats = { "Y": "h", "C": "?", "I": "i", "F": "f", "D": "d", "L": "q" }
+    array_formats = { "f": "f", "d": "d", "l": "q", "i": "i", "b": "?" }
+
+    if type_code in scalar_formats:
+        scalar = struct.Struct("<" + scalar_formats[type_code])
+        return scalar.unpack_from(data, offset)[0], offset + scalar.size
+
+    if type_code in array_formats:
+        return read_array(data, offset, array_formats[type_code])
+
+    if type_code in ("S", "R"):
+        length = struct.unpack_from("<I", data, offset)[0]
+        offset += 4
+        value = bytes(data[offset:offset + length])
+        return (value.decode("utf-8", "replace") if type_code == "S" else value), offset + length
+
+    raise ValueError(f"unknown FBX property type '{type_code}' at {offset - 1}")
+
+# decodes the node starting at 'offset'; returns (node or None for the end-of-list marker, next offset)
+def read_node(data, offset, version):
+    # 7.5 widened the record header to 64 bits
+    if version >= 7500:
+        end_offset, property_count, property_list_length = struct.unpack_from("<QQQ", data, offset)
+        offset += 24
+    else:
+        end_offset, property_count, property_list_length = struct.unpack_from("<III", data, offset)
+        offset += 12
+
+    name_length = data[offset]
+    offset += 1
+
+    if end_offset == 0:
+        return None, offset + name_length
+
+    name = bytes(data[offset:offset + name_length]).decode("ascii")
+    offset += name_length
+
+    properties = []
+    for _ in range(property_count):
+        value, offset = read_property(data, offset)
+        properties.append(value)
+
+    children = []
+    while offset < end_offset:
+        child, offset = read_node(data, offset, version)
+        if child is None:
+            break
+        children.append(child)
+
+    return FbxNode(name, properties, children), end_offset
+
+# parses a binary FBX file into its top-level nodes
+def parse_fbx(path):
+    with open(path, "rb") as f:
+        data = memoryview(f.read())
+
+    if bytes(data[:len(FBX_MAGIC)]) != FBX_MAGIC:
+        raise ValueError(f"{path} is not a binary FBX file (ASCII FBX is not supported)")
+
+    version = struct.unpack_from("<I", data, 23)[0]
+    offset = 27
+
+    nodes = []
+    while offset < len(data):
+        node, offset = read_node(data, offset, version)
+        if node is None:
+            break
+        nodes.append(node)
+
+    return FbxNode("", [], nodes)
+
+# resolves a layer element's value for one polygon corner, honoring its mapping and reference modes
+def layer_element_value(values, indices, mapping, reference, polygon_vertex, control_point, width):
+    if mapping in ("ByPolygonVertex", ""):
+        index = polygon_vertex
+    elif mapping in ("ByVertice", "ByVertex", "ByControlPoint"):
+        index = control_point
+    elif mapping == "AllSame":
+        index = 0
+    else:
+        return None
+
+    if reference == "IndexToDirect" and indices is not None:
+        index = indices[index]
+
+    return tuple(values[index * width:(index + 1) * width])
+
+# imports every Geometry in the FBX file as one triangulated mesh
+def import_fbx(path):
+    document = parse_fbx(path)
+    objects = document.find("Objects")
+
+    if objects is None:
+        raise ValueError(f"{path} has no Objects")
+
+    mesh = Mesh()
+
+    for geometry in objects.find_all("Geometry"):
+        positions = geometry.value("Vertices")
+        polygon_indices = geometry.value("PolygonVertexIndex")
+
+        if not positions or not polygon_indices:
+            continue
+
+        normal_layer = geometry.find("LayerElementNormal")
+        uv_layer = geometry.find("LayerElementUV")
+
+        normals = normal_layer.value("Normals") if normal_layer else None
+        normal_indices = (normal_layer.value("NormalsIndex") or normal_layer.value("NormalIndex")) if normal_layer else None
+        normal_mapping = normal_layer.value("MappingInformationType", "") if normal_layer else ""
+        normal_reference = normal_layer.value("ReferenceInformationType", "Direct") if normal_layer else ""
+
+        uvs = uv_layer.value("UV") if uv_layer else None
+        uv_indices = uv_layer.value("UVIndex") if uv_layer else None
+        uv_mapping = uv_layer.value("MappingInformationType", "") if uv_layer else ""
+        uv_reference = uv_layer.value("ReferenceInformationType", "Direct") if uv_layer else ""
+
+        # the last index of each polygon is stored as ~index
+        polygon = []
+        for polygon_vertex, encoded_index in enumerate(polygon_indices):
+            control_point = encoded_index if encoded_index >= 0 else ~encoded_index
+
+            position = tuple(positions[control_point * 3:control_point * 3 + 3])
+
+            normal = None
+            if normals:
+                normal = layer_element_value(normals, normal_indices, normal_mapping, normal_reference, polygon_vertex, control_point, 3)
+
+            uv = (0.0, 0.0)
+            if uvs:
+                uv = layer_element_value(uvs, uv_indices, uv_mapping, uv_reference, polygon_vertex, control_point, 2) or uv
+                # FBX puts the uv origin bottom-left, Vulkan samples top-left
+                uv = (uv[0], 1.0 - uv[1])
+
+            polygon.append((position, normal, uv))
+
+            if encoded_index < 0:
+                mesh.add_polygon(polygon)
+                polygon = []
+
+    if not mesh.corners:
+        raise ValueError(f"{path} has no polygon geometry")
+
+    return mesh
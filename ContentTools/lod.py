@@ -0,0 +1,165 @@
+#
+# Generates the coarser levels of detail of a baked mesh by vertex clustering,
+# after Rossignac and Borrel: the bounds are cut into a grid of cubic cells, every
+# vertex in a cell moves to the cell's average position, and triangles that
+# collapse are dropped.
+#
+# Vertices that share a cell but face different ways keep separate normals and
+# uvs, so hard edges survive; they still share the cell's position, so the
+# simplified surface has no cracks. Every level is simplified from the full mesh,
+# not from the level before it, so its error is measured against the original.
+#
+
+# imports
+import math
+
+# the most levels a model has, counting the full mesh; must match LT_MODEL_MAX_LODS
+MAX_LODS = 4
+
+# each level aims for this fraction of the triangles of the level before it
+LOD_REDUCTION = 0.25
+
+# levels with fewer triangles than this are not worth a draw of their own
+LOD_MIN_TRIANGLES = 64
+
+# the finest grid tried, in cells along the longest side of the bounds
+LOD_MAX_GRID = 1024
+
+# the cluster a vertex normal falls in within its cell: its dominant axis and sign
+def normal_bucket(normal):
+    axis = max(range(3), key = lambda axis: abs(normal[axis]))
+    return axis * 2 + (1 if normal[axis] < 0.0 else 0)
+
+# simplifies the mesh on a grid of 'grid' cells along the longest side of the
+# bounds. vertices are (px, py, pz, nx, ny, nz, u, v) tuples. returns
+# (vertices, indices, error) where error is the farthest any vertex moved
+def cluster_vertices(vertices, indices, bounds_min, bounds_max, grid):
+    extent = max(bounds_max[axis] - bounds_min[axis] for axis in range(3))
+    cell_size = extent / grid
+
+    def cell_of(position):
+        return tuple(min(grid - 1, int((position[axis] - bounds_min[axis]) / cell_size)) for axis in range(3))
+
+    cells = [cell_of(vertex[0:3]) for vertex in vertices]
+
+    # every vertex in a cell moves to the cell's average position
+    cell_sums = {}
+    for vertex, cell in zip(vertices, cells):
+        total = cell_sums.setdefault(cell, [0.0, 0.0, 0.0, 0])
+        for axis in range(3):
+            total[axis] += vertex[axis]
+        total[3] += 1
+
+    cell_positions = { cell: tuple(total[axis] / total[3] for axis in range(3)) for cell, total in cell_sums.items() }
+
+    # normals and uvs are averaged per cluster: a cell and a facing within it.
+    # each cluster sums (nx, ny, nz, u, v, count)
+    clusters = {}
+    cluster_of = []
+
+    for vertex, cell in zip(vertices, cells):
+        key = (cell, normal_bucket(vertex[3:6]))
+        index = clusters.get(key)
+
+        if index is None:
+            index = len(clusters)
+            clusters[key] = index
+
+        cluster_of.append(index)
+
+    totals = [[0.0] * 6 for _ in range(len(clusters))]
+
+    for vertex, index in zip(vertices, cluster_of):
+        total = totals[index]
+        for i in range(5):
+            total[i] += vertex[3 + i]
+        total[5] += 1
+
+    simplified_vertices = [None] * len(clusters)
+
+    for (cell, bucket), index in clusters.items():
+        total = totals[index]
+
+        normal = total[0:3]
+        normal_length = math.sqrt(sum(value * value for value in normal))
+        if normal_length > 0.0:
+            normal = [value / normal_length for value in normal]
+
+        simplified_vertices[index] = (*cell_positions[cell], *normal, total[3] / total[5], total[4] / total[5])
+
+    # triangles with two corners in one cell have collapsed; the rest may now be
+    # duplicates of each other, which would z-fight
+    simplified_indices = []
+    seen = set()
+
+    for i in range(0, len(indices), 3):
+        a, b, c = indices[i:i + 3]
+
+        if cells[a] == cells[b] or cells[b] == cells[c] or cells[c] == cells[a]:
+            continue
+
+        triangle = (cluster_of[a], cluster_of[b], cluster_of[c])
+
+        # rotate the smallest index first so the same triangle always has the same key,
+        # without changing its winding
+        smallest = triangle.index(min(triangle))
+        key = triangle[smallest:] + triangle[:smallest]
+
+        if key in seen:
+            continue
+
+        seen.add(key)
+        simplified_indices += triangle
+
+    used = set(simplified_indices)
+    error = max((math.dist(vertex[0:3], cell_positions[cell]) for vertex, cell, cluster in zip(vertices, cells, cluster_of) if cluster in used), default = 0.0)
+
+    return simplified_vertices, simplified_indices, error
+
+# generates up to MAX_LODS - 1 coarser levels of the mesh, finest first. returns a
+# list of (vertices, indices, error)
+def build_lods(vertices, indices, bounds_min, bounds_max):
+    lods = []
+
+    if max(bounds_max[axis] - bounds_min[axis] for axis in range(3)) <= 0.0:
+        return lods
+
+    triangle_count = len(indices) // 3
+    max_grid = LOD_MAX_GRID
+
+    while len(lods) + 1 < MAX_LODS:
+        target = int(triangle_count * LOD_REDUCTION)
+
+        if target < LOD_MIN_TRIANGLES or max_grid < 1:
+            break
+
+        results = {}
+
+        def simplify(grid):
+            if grid not in results:
+                results[grid] = cluster_vertices(vertices, indices, bounds_min, bounds_max, grid)
+            return results[grid]
+
+        # the triangle count grows with the grid, so search for the finest grid that
+        # meets the target
+        low = 1
+        high = max_grid
+
+        while low < high:
+            middle = (low + high + 1) // 2
+
+            if len(simplify(middle)[1]) // 3 <= target:
+                low = middle
+            else:
+                high = middle - 1
+
+        lod = simplify(low)
+
+        if len(lod[1]) // 3 > target or len(lod[1]) // 3 < LOD_MIN_TRIANGLES // 4:
+            break
+
+        lods.append(lod)
+        triangle_count = len(lod[1]) // 3
+        max_grid = low - 1
+
+    return lods
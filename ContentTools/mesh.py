@@ -0,0 +1,42 @@
+#
+# The triangle soup the model importers produce, before it is baked.
+#
+
+# imports
+import math
+
+# a triangulated mesh as a flat list of corners; every 3 corners form a triangle.
+# each corner is (position, normal, uv)
+class Mesh:
+    def __init__(self):
+        self.corners = []
+
+    # triangulates a convex polygon as a fan and appends its triangles.
+    # corners without a normal get the polygon's face normal
+    def add_polygon(self, polygon):
+        if len(polygon) < 3:
+            return
+
+        face_normal = polygon_normal([corner[0] for corner in polygon])
+        polygon = [(position, normal or face_normal, uv) for position, normal, uv in polygon]
+
+        for i in range(1, len(polygon) - 1):
+            self.corners += [polygon[0], polygon[i], polygon[i + 1]]
+
+# computes a polygon's unit normal with Newell's method, which also works for
+# slightly non-planar polygons
+def polygon_normal(positions):
+    nx = ny = nz = 0.0
+
+    for i, current in enumerate(positions):
+        following = positions[(i + 1) % len(positions)]
+        nx += (current[1] - following[1]) * (current[2] + following[2])
+        ny += (current[2] - following[2]) * (current[0] + following[0])
+        nz += (current[0] - following[0]) * (current[1] + following[1])
+
+    length = math.sqrt(nx * nx + ny * ny + nz * nz)
+
+    if length == 0.0:
+        return (0.0, 0.0, 1.0)
+
+    return (nx / length, ny / length, nz / length)
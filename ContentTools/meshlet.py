@@ -0,0 +1,212 @@
+#
+# Splits baked meshes into meshlets: small clusters of triangles with bounds the
+# runtime culls against the frustum and by backface cone before drawing.
+#
+# Each meshlet is grown from a seed triangle across shared vertices, so it stays a
+# compact patch with tight bounds. Seeds are taken in the optimized index order, so
+# meshlets keep its coarse overdraw order, and the indices are rewritten meshlet by
+# meshlet so each one is a contiguous range of the index buffer.
+#
+
+# imports
+import math
+
+from ContentTools.meshopt import optimize_vertex_cache
+
+# the usual mesh shader limits, so the clusters stay valid if the runtime ever
+# moves culling to the GPU
+MESHLET_MAX_VERTICES = 64
+MESHLET_MAX_TRIANGLES = 124
+
+# cones wider than this (the smallest dot product between a triangle normal and
+# the cone axis) can never be culled, so they are stored disabled
+MESHLET_CONE_MIN_DOT = 0.1
+
+# a meshlet: the range of the index buffer it covers and its culling bounds
+class Meshlet:
+    def __init__(self, first_index, index_count, vertex_count, center, radius, cone_apex, cone_axis, cone_cutoff):
+        self.first_index = first_index
+        self.index_count = index_count
+        self.vertex_count = vertex_count
+        self.center = center
+        self.radius = radius
+        self.cone_apex = cone_apex
+        self.cone_axis = cone_axis
+        self.cone_cutoff = cone_cutoff
+
+def subtract(a, b):
+    return (a[0] - b[0], a[1] - b[1], a[2] - b[2])
+
+def dot(a, b):
+    return a[0] * b[0] + a[1] * b[1] + a[2] * b[2]
+
+def cross(a, b):
+    return (a[1] * b[2] - a[2] * b[1], a[2] * b[0] - a[0] * b[2], a[0] * b[1] - a[1] * b[0])
+
+def length(a):
+    return math.sqrt(dot(a, a))
+
+# an approximate bounding sphere, after Ritter: start from the two points farthest
+# apart along a search, then grow to cover the rest
+def bounding_sphere(points):
+    start = points[0]
+    a = max(points, key = lambda point: dot(subtract(point, start), subtract(point, start)))
+    b = max(points, key = lambda point: dot(subtract(point, a), subtract(point, a)))
+
+    center = tuple((a[axis] + b[axis]) * 0.5 for axis in range(3))
+    radius = length(subtract(b, a)) * 0.5
+
+    for point in points:
+        distance = length(subtract(point, center))
+
+        if distance > radius:
+            # move the center towards the point just enough to cover it
+            new_radius = (radius + distance) * 0.5
+            shift = (new_radius - radius) / distance
+            center = tuple(center[axis] + (point[axis] - center[axis]) * shift for axis in range(3))
+            radius = new_radius
+
+    return center, radius
+
+# the cone that contains every triangle normal, placed so that a camera at 'eye'
+# only sees back faces when
+#   dot(normalize(apex - eye), axis) > cutoff
+# returns (apex, axis, cutoff); a zero axis disables the test
+def normal_cone(triangles, center):
+    faces = []
+
+    for p0, p1, p2 in triangles:
+        normal = cross(subtract(p1, p0), subtract(p2, p0))
+        normal_length = length(normal)
+
+        # degenerate triangles face nowhere, so they do not widen the cone
+        if normal_length > 0.0:
+            faces.append((p0, tuple(value / normal_length for value in normal)))
+
+    disabled = (center, (0.0, 0.0, 0.0), 1.0)
+
+    axis = tuple(sum(normal[axis] for corner, normal in faces) for axis in range(3))
+    axis_length = length(axis)
+
+    if not faces or axis_length == 0.0:
+        return disabled
+
+    axis = tuple(value / axis_length for value in axis)
+    min_dot = min(min(dot(normal, axis) for corner, normal in faces), 1.0)
+
+    if min_dot <= MESHLET_CONE_MIN_DOT:
+        return disabled
+
+    # slide the apex back along the axis until it is behind every triangle's plane;
+    # any eye the test culls from then sees every triangle from behind
+    max_t = 0.0
+    for corner, normal in faces:
+        t = dot(subtract(center, corner), normal) / dot(axis, normal)
+        max_t = max(max_t, t)
+
+    apex = tuple(center[i] - axis[i] * max_t for i in range(3))
+
+    # the cone of view directions that see only back faces is the normal cone
+    # widened by 90 degrees on each side; its cosine is the sine of the half angle
+    return apex, axis, math.sqrt(1.0 - min_dot * min_dot)
+
+def triangle_centroid(indices, positions, triangle):
+    p0, p1, p2 = (positions[index] for index in indices[triangle * 3:triangle * 3 + 3])
+    return tuple((p0[axis] + p1[axis] + p2[axis]) / 3.0 for axis in range(3))
+
+# reorders a meshlet's triangles for the vertex cache; the meshlet is renumbered
+# locally so the optimizer's cost follows the meshlet, not the whole mesh
+def optimize_meshlet(meshlet_indices):
+    local = {}
+    for index in meshlet_indices:
+        local.setdefault(index, len(local))
+
+    remap = list(local.keys())
+    optimized = optimize_vertex_cache([local[index] for index in meshlet_indices], len(remap))
+
+    return [remap[index] for index in optimized]
+
+# splits the mesh into meshlets of at most max_vertices unique vertices and
+# max_triangles triangles. returns (meshlets, indices) with the indices rewritten
+# in meshlet order
+def build_meshlets(indices, positions, max_vertices = MESHLET_MAX_VERTICES, max_triangles = MESHLET_MAX_TRIANGLES):
+    triangle_count = len(indices) // 3
+
+    vertex_triangles = [[] for _ in range(len(positions))]
+    for triangle in range(triangle_count):
+        for index in indices[triangle * 3:triangle * 3 + 3]:
+            vertex_triangles[index].append(triangle)
+
+    centroids = [triangle_centroid(indices, positions, triangle) for triangle in range(triangle_count)]
+    used = [False] * triangle_count
+
+    meshlets = []
+    result = []
+    seed = 0
+
+    while True:
+        while seed < triangle_count and used[seed]:
+            seed += 1
+
+        if seed == triangle_count:
+            break
+
+        vertices = set()
+        meshlet_indices = []
+        centroid_sum = [0.0, 0.0, 0.0]
+        candidates = { seed }
+
+        while True:
+            # when the patch has no unused neighbours left, fill the meshlet with the next
+            # triangle in the optimized order rather than leaving it mostly empty
+            if not candidates:
+                while seed < triangle_count and used[seed]:
+                    seed += 1
+
+                if seed == triangle_count:
+                    break
+
+                candidates.add(seed)
+
+            triangle_count_so_far = len(meshlet_indices) // 3
+            center = [value / triangle_count_so_far for value in centroid_sum] if triangle_count_so_far else centroids[next(iter(candidates))]
+
+            # prefer triangles that add the fewest vertices, then the ones closest to the
+            # middle of the patch, which keeps meshlets round rather than stringy
+            def cost(triangle):
+                new_vertices = sum(1 for index in set(indices[triangle * 3:triangle * 3 + 3]) if index not in vertices)
+                return (new_vertices, dot(subtract(centroids[triangle], center), subtract(centroids[triangle], center)))
+
+            best = min(candidates, key = cost)
+            best_indices = indices[best * 3:best * 3 + 3]
+            new_vertices = sum(1 for index in set(best_indices) if index not in vertices)
+
+            if len(vertices) + new_vertices > max_vertices or triangle_count_so_far >= max_triangles:
+                break
+
+            used[best] = True
+            candidates.discard(best)
+            meshlet_indices += best_indices
+            vertices.update(best_indices)
+
+            for axis in range(3):
+                centroid_sum[axis] += centroids[best][axis]
+
+            for index in best_indices:
+                for triangle in vertex_triangles[index]:
+                    if not used[triangle]:
+                        candidates.add(triangle)
+
+        meshlet_indices = optimize_meshlet(meshlet_indices)
+        meshlets.append(finish_meshlet(meshlet_indices, positions, len(result), len(vertices)))
+        result += meshlet_indices
+
+    return meshlets, result
+
+def finish_meshlet(meshlet_indices, positions, first_index, vertex_count):
+    triangles = [tuple(positions[index] for index in meshlet_indices[i:i + 3]) for i in range(0, len(meshlet_indices), 3)]
+
+    center, radius = bounding_sphere([positions[index] for index in set(meshlet_indices)])
+    cone_apex, cone_axis, cone_cutoff = normal_cone(triangles, center)
+
+    return Meshlet(first_index, len(meshlet_indices), vertex_count, center, radius, cone_apex, cone_axis, cone_cutoff)
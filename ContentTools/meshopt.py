@@ -0,0 +1,313 @@
+#
+# Reorders baked meshes for the GPU: triangles for the post-transform vertex cache
+# and for overdraw, then into meshlets (see meshlet.py), then vertices for fetch
+# locality.
+#
+# Every pass works on an indexed triangle list and keeps the mesh's triangles
+# (and their winding) intact; only their order and the vertex numbering change.
+#
+
+# imports
+import math
+
+# the FIFO cache size the statistics are measured against; small enough to be
+# pessimistic for current hardware, which is how the literature reports ACMR
+STATS_CACHE_SIZE = 16
+
+# the LRU cache size the vertex cache optimizer scores against
+CACHE_SIZE = 32
+
+# the scoring curve from Tom Forsyth's "Linear-Speed Vertex Cache Optimisation"
+CACHE_DECAY_POWER = 1.5
+LAST_TRIANGLE_SCORE = 0.75
+VALENCE_BOOST_SCALE = 2.0
+VALENCE_BOOST_POWER = 0.5
+
+# how much worse than its cache-optimized order a cluster may get when it is
+# split up for overdraw ordering
+OVERDRAW_THRESHOLD = 1.05
+
+# removes triangles that reference the same vertex twice; they cover no pixels
+def remove_degenerate_triangles(indices):
+    result = []
+
+    for i in range(0, len(indices), 3):
+        a, b, c = indices[i:i + 3]
+        if a != b and b != c and c != a:
+            result += [a, b, c]
+
+    return result
+
+# simulates a FIFO post-transform cache; returns the number of vertex shader invocations
+def count_cache_misses(indices, cache_size = STATS_CACHE_SIZE):
+    timestamps = {}
+    timestamp = cache_size + 1
+    misses = 0
+
+    for index in indices:
+        # a vertex is still cached if fewer than cache_size misses happened since it was loaded
+        if timestamp - timestamps.get(index, 0) > cache_size:
+            timestamps[index] = timestamp
+            timestamp += 1
+            misses += 1
+
+    return misses
+
+# gets (ACMR, ATVR): vertex shader invocations per triangle and per unique vertex.
+# the best possible ACMR is around 0.5 for a regular grid; ATVR's best is 1.0
+def analyze_vertex_cache(indices, cache_size = STATS_CACHE_SIZE):
+    triangle_count = len(indices) // 3
+    vertex_count = len(set(indices))
+
+    if triangle_count == 0:
+        return (0.0, 0.0)
+
+    misses = count_cache_misses(indices, cache_size)
+    return (misses / triangle_count, misses / vertex_count)
+
+def build_score_tables(max_valence):
+    cache_scores = []
+    for position in range(CACHE_SIZE):
+        if position < 3:
+            # the vertices of the last triangle get a fixed score so the same triangle
+            # is not picked twice in a row and strips are not favored over fans
+            cache_scores.append(LAST_TRIANGLE_SCORE)
+        else:
+            scale = 1.0 / (CACHE_SIZE - 3)
+            cache_scores.append((1.0 - (position - 3) * scale) ** CACHE_DECAY_POWER)
+
+    # boost vertices with few triangles left so they get finished off and leave the cache
+    valence_scores = [0.0] + [VALENCE_BOOST_SCALE * valence ** -VALENCE_BOOST_POWER for valence in range(1, max_valence + 1)]
+
+    return cache_scores, valence_scores
+
+# reorders triangles to maximize post-transform cache hits, after Forsyth
+def optimize_vertex_cache(indices, vertex_count):
+    triangle_count = len(indices) // 3
+
+    if triangle_count == 0:
+        return []
+
+    vertex_triangles = [[] for _ in range(vertex_count)]
+    for triangle in range(triangle_count):
+        for index in indices[triangle * 3:triangle * 3 + 3]:
+            vertex_triangles[index].append(triangle)
+
+    cache_scores, valence_scores = build_score_tables(max(len(triangles) for triangles in vertex_triangles))
+
+    def vertex_score(vertex, cache_position):
+        valence = len(vertex_triangles[vertex])
+        if valence == 0:
+            return -1.0
+
+        score = valence_scores[valence]
+        if cache_position >= 0:
+            score += cache_scores[cache_position]
+
+        return score
+
+    vertex_scores = [vertex_score(vertex, -1) for vertex in range(vertex_count)]
+    triangle_scores = [sum(vertex_scores[index] for index in indices[triangle * 3:triangle * 3 + 3]) for triangle in range(triangle_count)]
+    emitted = [False] * triangle_count
+
+    cache = []
+    result = []
+    best_triangle = max(range(triangle_count), key = lambda triangle: triangle_scores[triangle])
+    next_unemitted = 0
+
+    while best_triangle >= 0:
+        triangle_indices = indices[best_triangle * 3:best_triangle * 3 + 3]
+        result += triangle_indices
+        emitted[best_triangle] = True
+
+        for index in triangle_indices:
+            vertex_triangles[index].remove(best_triangle)
+
+        # the emitted triangle's vertices move to the front of the LRU cache
+        new_cache = triangle_indices + [vertex for vertex in cache if vertex not in triangle_indices]
+        evicted = new_cache[CACHE_SIZE:]
+        cache = new_cache[:CACHE_SIZE]
+
+        for position, vertex in enumerate(cache):
+            vertex_scores[vertex] = vertex_score(vertex, position)
+        for vertex in evicted:
+            vertex_scores[vertex] = vertex_score(vertex, -1)
+
+        # only triangles touching a changed vertex change score, and the next triangle
+        # is picked among them so the search stays local to the cache
+        best_triangle = -1
+        best_score = -1.0
+
+        for vertex in cache + evicted:
+            for triangle in vertex_triangles[vertex]:
+                score = sum(vertex_scores[index] for index in indices[triangle * 3:triangle * 3 + 3])
+                triangle_scores[triangle] = score
+
+                if vertex in cache and score > best_score:
+                    best_triangle = triangle
+                    best_score = score
+
+        # dead end: nothing in the cache has triangles left, so continue with the
+        # next triangle in the original order
+        if best_triangle < 0:
+            while next_unemitted < triangle_count and emitted[next_unemitted]:
+                next_unemitted += 1
+
+            if next_unemitted < triangle_count:
+                best_triangle = next_unemitted
+
+    return result
+
+# counts the misses of one triangle against a FIFO cache kept as per-vertex timestamps
+def update_cache(triangle_indices, timestamps, clock, cache_size):
+    misses = 0
+
+    for index in triangle_indices:
+        if clock[0] - timestamps[index] > cache_size:
+            timestamps[index] = clock[0]
+            clock[0] += 1
+            misses += 1
+
+    return misses
+
+# splits a cache-optimized triangle order into clusters that can be reordered
+# without losing more than 'threshold' of the cache efficiency
+def generate_clusters(indices, vertex_count, cache_size, threshold):
+    triangle_count = len(indices) // 3
+    timestamps = [0] * vertex_count
+    clock = [cache_size + 1]
+
+    # a triangle that misses on all three vertices starts a new patch of the mesh
+    hard_boundaries = []
+    for triangle in range(triangle_count):
+        misses = update_cache(indices[triangle * 3:triangle * 3 + 3], timestamps, clock, cache_size)
+        if triangle == 0 or misses == 3:
+            hard_boundaries.append(triangle)
+
+    clusters = []
+
+    for i, start in enumerate(hard_boundaries):
+        end = hard_boundaries[i + 1] if i + 1 < len(hard_boundaries) else triangle_count
+
+        # measure the patch from a cold cache
+        clock[0] += cache_size + 1
+        patch_misses = sum(update_cache(indices[triangle * 3:triangle * 3 + 3], timestamps, clock, cache_size) for triangle in range(start, end))
+        target = threshold * patch_misses / (end - start)
+
+        # cut the patch every time a prefix, replayed from a cold cache, reaches the target ACMR
+        clock[0] += cache_size + 1
+        clusters.append(start)
+        running_misses = 0
+        running_triangles = 0
+
+        for triangle in range(start, end):
+            running_misses += update_cache(indices[triangle * 3:triangle * 3 + 3], timestamps, clock, cache_size)
+            running_triangles += 1
+
+            if running_misses / running_triangles <= target and triangle + 1 < end:
+                clusters.append(triangle + 1)
+                clock[0] += cache_size + 1
+                running_misses = 0
+                running_triangles = 0
+
+        # the tail rarely reaches the target on its own, so it joins the cluster before it
+        if running_triangles and len(clusters) > 1 and clusters[-1] > start:
+            clusters.pop()
+
+    return clusters
+
+# reorders the clusters of a cache-optimized mesh so the outward-facing ones draw
+# first, after Sander et al. "Fast Triangle Reordering for Vertex Locality and
+# Reduced Overdraw". positions are (x, y, z) per vertex
+def optimize_overdraw(indices, positions, threshold = OVERDRAW_THRESHOLD, cache_size = STATS_CACHE_SIZE):
+    triangle_count = len(indices) // 3
+
+    if triangle_count < 2:
+        return list(indices)
+
+    clusters = generate_clusters(indices, len(positions), cache_size, threshold)
+
+    # area-weighted centroid of the whole mesh
+    mesh_area = 0.0
+    mesh_centroid = [0.0, 0.0, 0.0]
+
+    cluster_data = []
+
+    for i, start in enumerate(clusters):
+        end = clusters[i + 1] if i + 1 < len(clusters) else triangle_count
+
+        cluster_area = 0.0
+        centroid = [0.0, 0.0, 0.0]
+        normal = [0.0, 0.0, 0.0]
+
+        for triangle in range(start, end):
+            p0, p1, p2 = (positions[index] for index in indices[triangle * 3:triangle * 3 + 3])
+
+            e1 = [p1[axis] - p0[axis] for axis in range(3)]
+            e2 = [p2[axis] - p0[axis] for axis in range(3)]
+            cross = (e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0])
+            area = math.sqrt(cross[0] * cross[0] + cross[1] * cross[1] + cross[2] * cross[2])
+
+            for axis in range(3):
+                centroid[axis] += (p0[axis] + p1[axis] + p2[axis]) / 3.0 * area
+                normal[axis] += cross[axis]
+
+            cluster_area += area
+
+        for axis in range(3):
+            mesh_centroid[axis] += centroid[axis]
+        mesh_area += cluster_area
+
+        if cluster_area > 0.0:
+            centroid = [value / cluster_area for value in centroid]
+
+        length = math.sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2])
+        if length > 0.0:
+            normal = [value / length for value in normal]
+
+        cluster_data.append((start, end, centroid, normal))
+
+    if mesh_area > 0.0:
+        mesh_centroid = [value / mesh_area for value in mesh_centroid]
+
+    # clusters far out along their own normal are likely to occlude the rest of the mesh
+    def occluder_potential(cluster):
+        start, end, centroid, normal = cluster
+        return sum((centroid[axis] - mesh_centroid[axis]) * normal[axis] for axis in range(3))
+
+    result = []
+    for start, end, centroid, normal in sorted(cluster_data, key = occluder_potential, reverse = True):
+        result += indices[start * 3:end * 3]
+
+    return result
+
+# renumbers vertices in the order the indices first use them, so vertex fetch walks
+# memory forwards; vertices no triangle uses are dropped. returns (vertices, indices)
+def optimize_vertex_fetch(vertices, indices):
+    remap = {}
+    remapped_vertices = []
+
+    for index in indices:
+        if index not in remap:
+            remap[index] = len(remapped_vertices)
+            remapped_vertices.append(vertices[index])
+
+    return remapped_vertices, [remap[index] for index in indices]
+
+# runs every pass over a deduplicated mesh and splits it into meshlets; returns
+# (vertices, indices, meshlets, stats) where stats is ((ACMR, ATVR) before, (ACMR, ATVR) after)
+def optimize_mesh(vertices, indices, positions):
+    # imported here as the meshlet builder uses the vertex cache optimizer above
+    from ContentTools.meshlet import build_meshlets
+
+    before = analyze_vertex_cache(indices)
+
+    indices = remove_degenerate_triangles(indices)
+    indices = optimize_vertex_cache(indices, len(vertices))
+    indices = optimize_overdraw(indices, positions)
+    meshlets, indices = build_meshlets(indices, positions)
+    vertices, indices = optimize_vertex_fetch(vertices, indices)
+
+    after = analyze_vertex_cache(indices)
+
+    return vertices, indices, meshlets, (before, after)
@@ -0,0 +1,170 @@
+#
+# Generates the mip chains of baked textures.
+#
+# Each level is filtered down from the one before it until the image is 1x1. The
+# filter is separable: the rows of a level are filtered into half as many rows,
+# then the same is done to its columns. Both passes work on whole rows at a time,
+# each tap adding a weighted source row to the output row, which keeps the work in
+# list comprehensions rather than a python loop per pixel.
+#
+# Color is filtered in linear space and converted back to sRGB; alpha and data
+# textures are filtered as stored. Normal maps use a box filter and renormalize
+# every texel, as the windowed sinc's negative lobes would bend normals at edges.
+#
+
+# imports
+import math
+
+# the windowed sinc spans this many destination texels on either side
+KAISER_RADIUS = 2.0
+
+# the Kaiser window's shape; higher trades sharpness for less ringing
+KAISER_ALPHA = 4.0
+
+FILTER_BOX = "box"
+FILTER_KAISER = "kaiser"
+
+# the modified Bessel function of the first kind, order 0, by its power series
+def bessel_i0(x):
+    total = 1.0
+    term = 1.0
+    k = 1
+
+    while term > total * 1e-12:
+        term *= (x / (2.0 * k)) ** 2
+        total += term
+        k += 1
+
+    return total
+
+def kaiser_sinc(t):
+    if abs(t) >= KAISER_RADIUS:
+        return 0.0
+
+    window = bessel_i0(KAISER_ALPHA * math.sqrt(1.0 - (t / KAISER_RADIUS) ** 2)) / bessel_i0(KAISER_ALPHA)
+    sinc = 1.0 if t == 0.0 else math.sin(math.pi * t) / (math.pi * t)
+
+    return sinc * window
+
+# the source texels and weights of every destination texel along one axis. taps
+# past the edges are clamped to the edge texels
+def filter_taps(source_size, target_size, filter_name):
+    scale = source_size / target_size
+    all_taps = []
+
+    for target in range(target_size):
+        weights = {}
+
+        if filter_name == FILTER_BOX:
+            # every source texel the destination texel covers, by how much it covers
+            start = target * scale
+            end = start + scale
+
+            for source in range(int(start), min(source_size, int(math.ceil(end)))):
+                weights[source] = min(end, source + 1) - max(start, source)
+        else:
+            center = (target + 0.5) * scale
+            reach = KAISER_RADIUS * scale
+
+            for source in range(int(math.floor(center - reach)), int(math.ceil(center + reach)) + 1):
+                weight = kaiser_sinc((source + 0.5 - center) / scale)
+
+                if weight != 0.0:
+                    clamped = min(source_size - 1, max(0, source))
+                    weights[clamped] = weights.get(clamped, 0.0) + weight
+
+        total = sum(weights.values())
+        all_taps.append([(source, weight / total) for source, weight in sorted(weights.items())])
+
+    return all_taps
+
+# filters a list of equally long rows into len(taps) rows
+def filter_rows(rows, taps):
+    filtered = []
+
+    for row_taps in taps:
+        source, weight = row_taps[0]
+        row = [weight * value for value in rows[source]]
+
+        for source, weight in row_taps[1:]:
+            row = [total + weight * value for total, value in zip(row, rows[source])]
+
+        filtered.append(row)
+
+    return filtered
+
+# filters an image of rows of interleaved RGBA floats down to width x height
+def downsample(rows, source_width, width, height, filter_name):
+    rows = filter_rows(rows, filter_taps(len(rows), height, filter_name))
+
+    # the columns of interleaved texels are filtered as rows, one per channel
+    x_taps = filter_taps(source_width, width, filter_name)
+    column_taps = [[(source * 4 + channel, weight) for source, weight in x_taps[x]] for x in range(width) for channel in range(4)]
+
+    columns = filter_rows([list(column) for column in zip(*rows)], column_taps)
+
+    return [list(row) for row in zip(*columns)]
+
+def srgb_to_linear(value):
+    return value / 12.92 if value <= 0.04045 else ((value + 0.055) / 1.055) ** 2.4
+
+def linear_to_srgb(value):
+    return value * 12.92 if value <= 0.0031308 else 1.055 * value ** (1.0 / 2.4) - 0.055
+
+SRGB_TO_LINEAR = [srgb_to_linear(value / 255.0) for value in range(256)]
+
+# converts RGBA8 pixels into rows of interleaved floats in the space they are filtered in
+def to_rows(image, srgb, normal_map):
+    rows = []
+    row_bytes = image.width * 4
+
+    for y in range(image.height):
+        row = image.pixels[y * row_bytes:(y + 1) * row_bytes]
+
+        if normal_map:
+            rows.append([value / 127.5 - 1.0 for value in row])
+        elif srgb:
+            rows.append([SRGB_TO_LINEAR[value] if i % 4 != 3 else value / 255.0 for i, value in enumerate(row)])
+        else:
+            rows.append([value / 255.0 for value in row])
+
+    return rows
+
+# converts filtered rows back into RGBA8 pixels
+def from_rows(rows, srgb, normal_map):
+    pixels = bytearray()
+
+    for row in rows:
+        if normal_map:
+            for i in range(0, len(row), 4):
+                x, y, z = row[i], row[i + 1], row[i + 2]
+                length = math.sqrt(x * x + y * y + z * z) or 1.0
+                row[i:i + 3] = [x / length, y / length, z / length]
+
+            values = [(value + 1.0) * 0.5 for value in row]
+        elif srgb:
+            values = [linear_to_srgb(min(1.0, max(0.0, value))) if i % 4 != 3 else value for i, value in enumerate(row)]
+        else:
+            values = row
+
+        pixels += bytes(min(255, max(0, int(value * 255.0 + 0.5))) for value in values)
+
+    return pixels
+
+# builds the mip chain of an image, level 0 first, as (width, height, RGBA8 pixels)
+def build_mips(image, srgb, normal_map, filter_name):
+    width, height = image.width, image.height
+    mips = [(width, height, image.pixels)]
+    rows = to_rows(image, srgb, normal_map)
+
+    while width > 1 or height > 1:
+        next_width = width // 2 if width > 1 else 1
+        next_height = height // 2 if height > 1 else 1
+
+        rows = downsample(rows, width, next_width, next_height, filter_name)
+        width, height = next_width, next_height
+
+        # from_rows renormalizes normal maps in place, so the next level starts from unit normals
+        mips.append((width, height, from_rows(rows, srgb, normal_map)))
+
+    return mips
@@ -0,0 +1,260 @@
+#
+# Bakes imported meshes into the GPU-ready model format loaded by LTAssetManager.
+#
+# Layout (little-endian, must match LTModelFormat.h):
+#   LTModelHeader
+#   LTModelLOD per level of detail, LOD 0 (the full mesh) first
+#   meshlets: LTModelMeshlet (bounding sphere, normal cone, index range), 64 bytes
+#     each, for every LOD
+#   per LOD, coarsest first:
+#     vertices: interleaved, in the header's vertex format
+#       float:     LTModelVertex (float3 position, float3 normal, float2 uv), 32 bytes
+#       quantized: LTModelVertexQuantized (unorm16x4 position relative to the bounds,
+#                  octahedral snorm16x2 normal, half2 uv), 16 bytes
+#     indices: uint16 when every vertex of LOD 0 fits, uint32 otherwise
+#
+# The coarser levels come from ContentTools/lod.py. Every level is welded and then
+# reordered and split into meshlets by ContentTools/meshopt.py and
+# ContentTools/meshlet.py before it is written, so the file order is already the
+# draw order. The coarsest level comes first so the runtime can show the model
+# after decoding only a small prefix of it, and stream in the rest.
+#
+
+# imports
+import math
+import os
+import struct
+
+from ContentTools.fbx import import_fbx
+from ContentTools.obj import import_obj
+from ContentTools.meshopt import optimize_mesh
+from ContentTools.lod import build_lods
+
+MODEL_MAGIC = 0x444D544C # "LTMD"
+MODEL_VERSION = 4
+MODEL_HEADER = struct.Struct("<IIIIII3f3f")
+MODEL_LOD = struct.Struct("<IIIfQQQQ")
+MODEL_VERTEX = struct.Struct("<3f3f2f")
+MODEL_VERTEX_QUANTIZED = struct.Struct("<4H2h2e")
+MODEL_MESHLET = struct.Struct("<3ff3ff3fIIIII")
+
+# LTModelVertexFormat
+MODEL_VERTEX_FORMAT_FLOAT = 0
+MODEL_VERTEX_FORMAT_QUANTIZED = 1
+
+# bump when the baker's output changes without the format changing, so the content
+# build re-bakes every model
+MODEL_BAKER_VERSION = 6
+
+# the largest magnitude a half float holds; uvs beyond it keep the float format
+HALF_MAX = 65504.0
+
+# the offset of each section is aligned so the runtime can copy it straight into a buffer
+MODEL_SECTION_ALIGNMENT = 16
+
+def align_up(value, alignment):
+    return (value + alignment - 1) & ~(alignment - 1)
+
+# imports a model source file by extension
+def import_model(source_path):
+    ext = os.path.splitext(source_path)[1].lower()
+
+    if ext == ".fbx":
+        return import_fbx(source_path)
+    if ext == ".obj":
+        return import_obj(source_path)
+
+    raise ValueError(f"{source_path} is not a supported model format")
+
+# welds identical corners into a vertex buffer and an index buffer
+def build_indexed(mesh):
+    vertices = []
+    indices = []
+    lookup = {}
+
+    for position, normal, uv in mesh.corners:
+        # weld on the exact packed bits so the result is deterministic; adding 0.0
+        # turns -0.0 into 0.0, which would otherwise never weld with it
+        key = MODEL_VERTEX.pack(*[component + 0.0 for component in (*position, *normal, *uv)])
+
+        index = lookup.get(key)
+        if index is None:
+            index = len(vertices)
+            lookup[key] = index
+            vertices.append(key)
+
+        indices.append(index)
+
+    return vertices, indices
+
+# maps a unit vector onto the octahedron, unfolded into [-1, 1]^2
+def octahedral_encode(normal):
+    x, y, z = normal
+    length = abs(x) + abs(y) + abs(z)
+
+    if length == 0.0:
+        return (0.0, 0.0)
+
+    x /= length
+    y /= length
+
+    # fold the lower hemisphere over the diagonals
+    if z < 0.0:
+        x, y = (1.0 - abs(y)) * (1.0 if x >= 0.0 else -1.0), (1.0 - abs(x)) * (1.0 if y >= 0.0 else -1.0)
+
+    return (x, y)
+
+def quantize_unorm16(value):
+    return max(0, min(0xFFFF, int(round(value * 0xFFFF))))
+
+def quantize_snorm16(value):
+    return max(-0x7FFF, min(0x7FFF, int(round(value * 0x7FFF))))
+
+# repacks LTModelVertex records as LTModelVertexQuantized; positions are stored
+# relative to the bounds, which the runtime uses to decode them
+def quantize_vertices(vertices, bounds_min, bounds_max):
+    extent = [bounds_max[axis] - bounds_min[axis] for axis in range(3)]
+    quantized = []
+
+    for vertex in vertices:
+        values = MODEL_VERTEX.unpack(vertex)
+        position, normal, uv = values[0:3], values[3:6], values[6:8]
+
+        position = [quantize_unorm16((position[axis] - bounds_min[axis]) / extent[axis]) if extent[axis] > 0.0 else 0 for axis in range(3)]
+        normal = [quantize_snorm16(value) for value in octahedral_encode(normal)]
+
+        quantized.append(MODEL_VERTEX_QUANTIZED.pack(*position, 0, *normal, *uv))
+
+    return quantized
+
+# picks the most compact vertex format that can represent the mesh
+def choose_vertex_format(vertices):
+    for vertex in vertices:
+        u, v = MODEL_VERTEX.unpack(vertex)[6:8]
+        if not (math.isfinite(u) and math.isfinite(v)) or abs(u) > HALF_MAX or abs(v) > HALF_MAX:
+            return MODEL_VERTEX_FORMAT_FLOAT
+
+    return MODEL_VERTEX_FORMAT_QUANTIZED
+
+# packs the baked model. lods are (vertices, indices, meshlets, error), LOD 0 first;
+# vertices are packed LTModelVertex records and are converted to the given vertex format
+def write_model(lods, bounds_min, bounds_max, vertex_format):
+    index_size = 2 if len(lods[0][0]) <= 0xFFFF else 4
+    index_format = "H" if index_size == 2 else "I"
+
+    if vertex_format == MODEL_VERTEX_FORMAT_QUANTIZED:
+        lods = [(quantize_vertices(vertices, bounds_min, bounds_max), indices, meshlets, error) for vertices, indices, meshlets, error in lods]
+        vertex_stride = MODEL_VERTEX_QUANTIZED.size
+    else:
+        vertex_stride = MODEL_VERTEX.size
+
+    # the meshlets of every level go first so the runtime can read them with the
+    # header, as a prefix
+    lod_offset = align_up(MODEL_HEADER.size, MODEL_SECTION_ALIGNMENT)
+    offset = align_up(lod_offset + len(lods) * MODEL_LOD.size, MODEL_SECTION_ALIGNMENT)
+
+    meshlet_offsets = []
+    for vertices, indices, meshlets, error in lods:
+        meshlet_offsets.append(offset)
+        offset = align_up(offset + len(meshlets) * MODEL_MESHLET.size, MODEL_SECTION_ALIGNMENT)
+
+    # then the geometry, coarsest level first
+    sections = [None] * len(lods)
+    for lod in reversed(range(len(lods))):
+        vertices, indices, meshlets, error = lods[lod]
+
+        vertex_offset = offset
+        index_offset = align_up(vertex_offset + len(vertices) * vertex_stride, MODEL_SECTION_ALIGNMENT)
+        end_offset = index_offset + len(indices) * index_size
+
+        sections[lod] = (vertex_offset, index_offset, end_offset)
+        offset = align_up(end_offset, MODEL_SECTION_ALIGNMENT)
+
+    blob = bytearray(MODEL_HEADER.pack(
+        MODEL_MAGIC,
+        MODEL_VERSION,
+        vertex_stride,
+        index_size,
+        vertex_format,
+        len(lods),
+        *bounds_min,
+        *bounds_max))
+
+    blob += bytes(lod_offset - len(blob))
+    for lod, (vertices, indices, meshlets, error) in enumerate(lods):
+        blob += MODEL_LOD.pack(
+            len(vertices),
+            len(indices),
+            len(meshlets),
+            error,
+            meshlet_offsets[lod],
+            *sections[lod])
+
+    for lod, (vertices, indices, meshlets, error) in enumerate(lods):
+        blob += bytes(meshlet_offsets[lod] - len(blob))
+        for meshlet in meshlets:
+            blob += MODEL_MESHLET.pack(
+                *meshlet.center,
+                meshlet.radius,
+                *meshlet.cone_apex,
+                meshlet.cone_cutoff,
+                *meshlet.cone_axis,
+                meshlet.vertex_count,
+                meshlet.first_index,
+                meshlet.index_count,
+                0,
+                0)
+
+    for lod in reversed(range(len(lods))):
+        vertices, indices, meshlets, error = lods[lod]
+        vertex_offset, index_offset, end_offset = sections[lod]
+
+        blob += bytes(vertex_offset - len(blob))
+        blob += b"".join(vertices)
+        blob += bytes(index_offset - len(blob))
+        blob += struct.pack(f"<{len(indices)}{index_format}", *indices)
+
+    return bytes(blob)
+
+# imports a model and writes the baked model file. returns true on success.
+# runs in a worker process, so failures are reported rather than raised
+def bake_model(source_path, output_path):
+    try:
+        mesh = import_model(source_path)
+        vertices, indices = build_indexed(mesh)
+
+        positions = [MODEL_VERTEX.unpack(vertex)[0:3] for vertex in vertices]
+        bounds_min = tuple(min(position[axis] for position in positions) for axis in range(3))
+        bounds_max = tuple(max(position[axis] for position in positions) for axis in range(3))
+
+        # the coarser levels are simplified from the welded full mesh, then every
+        # level goes through the same optimization
+        levels = [(vertices, indices, 0.0)]
+        for lod_vertices, lod_indices, error in build_lods([MODEL_VERTEX.unpack(vertex) for vertex in vertices], indices, bounds_min, bounds_max):
+            levels.append(([MODEL_VERTEX.pack(*vertex) for vertex in lod_vertices], lod_indices, error))
+
+        lods = []
+        stats = []
+
+        for lod_vertices, lod_indices, error in levels:
+            lod_positions = [MODEL_VERTEX.unpack(vertex)[0:3] for vertex in lod_vertices]
+            lod_vertices, lod_indices, meshlets, lod_stats = optimize_mesh(lod_vertices, lod_indices, lod_positions)
+
+            lods.append((lod_vertices, lod_indices, meshlets, error))
+            stats.append(lod_stats)
+
+        vertex_format = choose_vertex_format([vertex for lod in lods for vertex in lod[0]])
+        blob = write_model(lods, bounds_min, bounds_max, vertex_format)
+
+        with open(output_path, "wb") as f:
+            f.write(blob)
+
+        (before, after) = stats[0]
+        print(f"Baking models...{source_path}: {len(lods[0][0])} vertices, {len(lods[0][1]) // 3} triangles, {len(lods[0][2])} meshlets, {len(blob)} bytes, "
+              f"{'quantized' if vertex_format == MODEL_VERTEX_FORMAT_QUANTIZED else 'float'} vertices, "
+              f"ACMR {before[0]:.3f} -> {after[0]:.3f}, ATVR {before[1]:.3f} -> {after[1]:.3f}, "
+              f"LODs {' / '.join(str(len(lod[1]) // 3) for lod in lods)} triangles")
+        return True
+    except (OSError, ValueError, struct.error, IndexError) as e:
+        print(f"Baking models...{source_path} failed: {e}")
+        return False
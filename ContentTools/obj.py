@@ -0,0 +1,57 @@
+#
+# Reads Wavefront OBJ files into a Mesh.
+#
+# Every object and group in the file is merged into a single mesh; materials are ignored.
+#
+
+# imports
+from ContentTools.mesh import Mesh
+
+# resolves a 1-based (or negative, relative) OBJ index into a list
+def resolve_index(values, token):
+    index = int(token)
+    return values[index - 1 if index > 0 else index]
+
+# imports the OBJ file as one triangulated mesh
+def import_obj(path):
+    positions = []
+    normals = []
+    uvs = []
+
+    mesh = Mesh()
+
+    with open(path, "r") as f:
+        for line in f:
+            parts = line.split()
+
+            if not parts or parts[0].startswith("#"):
+                continue
+
+            if parts[0] == "v":
+                positions.append(tuple(float(value) for value in parts[1:4]))
+            elif parts[0] == "vn":
+                normals.append(tuple(float(value) for value in parts[1:4]))
+            elif parts[0] == "vt":
+                u = float(parts[1])
+                v = float(parts[2]) if len(parts) > 2 else 0.0
+                # OBJ puts the uv origin bottom-left, Vulkan samples top-left
+                uvs.append((u, 1.0 - v))
+            elif parts[0] == "f":
+                polygon = []
+
+                # each corner is v, v/vt, v//vn or v/vt/vn
+                for corner in parts[1:]:
+                    tokens = corner.split("/")
+
+                    position = resolve_index(positions, tokens[0])
+                    uv = resolve_index(uvs, tokens[1]) if len(tokens) > 1 and tokens[1] else (0.0, 0.0)
+                    normal = resolve_index(normals, tokens[2]) if len(tokens) > 2 and tokens[2] else None
+
+                    polygon.append((position, normal, uv))
+
+                mesh.add_polygon(polygon)
+
+    if not mesh.corners:
+        raise ValueError(f"{path} has no faces")
+
+    return mesh
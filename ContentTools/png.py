@@ -0,0 +1,218 @@
+#
+# Reads PNG files into 8-bit RGBA pixels.
+#
+# Every color type and bit depth in the specification is accepted, interlaced or
+# not. Gray and palette images are expanded to RGBA, a tRNS chunk becomes alpha,
+# and 16-bit samples keep their high byte. Ancillary chunks (gamma, color profiles,
+# text) are ignored; pixels are returned as stored.
+#
+
+# imports
+import struct
+import zlib
+
+PNG_SIGNATURE = b"\x89PNG\r\n\x1a\n"
+
+# samples per pixel, by color type
+PNG_CHANNELS = { 0: 1, 2: 3, 3: 1, 4: 2, 6: 4 }
+
+# the Adam7 passes: (x start, y start, x step, y step)
+PNG_ADAM7 = [(0, 0, 8, 8), (4, 0, 8, 8), (0, 4, 4, 8), (2, 0, 4, 4), (0, 2, 2, 4), (1, 0, 2, 2), (0, 1, 1, 2)]
+
+# a decoded image: width * height pixels of RGBA, 4 bytes each, rows top to bottom
+class Image:
+    def __init__(self, width, height, pixels):
+        self.width = width
+        self.height = height
+        self.pixels = pixels
+
+    # determines if any pixel is not fully opaque
+    def has_alpha(self):
+        return any(alpha != 255 for alpha in self.pixels[3::4])
+
+# reverses the per-scanline filters of one pass; returns its rows
+def unfilter(data, offset, row_bytes, height, pixel_bytes):
+    rows = []
+    previous = bytearray(row_bytes)
+
+    for y in range(height):
+        if offset + 1 + row_bytes > len(data):
+            raise ValueError("image data is truncated")
+
+        filter_type = data[offset]
+        row = bytearray(data[offset + 1:offset + 1 + row_bytes])
+        offset += 1 + row_bytes
+
+        if filter_type == 1:
+            for i in range(pixel_bytes, row_bytes):
+                row[i] = (row[i] + row[i - pixel_bytes]) & 0xFF
+        elif filter_type == 2:
+            row = bytearray((value + above) & 0xFF for value, above in zip(row, previous))
+        elif filter_type == 3:
+            for i in range(row_bytes):
+                left = row[i - pixel_bytes] if i >= pixel_bytes else 0
+                row[i] = (row[i] + ((left + previous[i]) >> 1)) & 0xFF
+        elif filter_type == 4:
+            for i in range(row_bytes):
+                left = row[i - pixel_bytes] if i >= pixel_bytes else 0
+                above = previous[i]
+                upper_left = previous[i - pixel_bytes] if i >= pixel_bytes else 0
+
+                # paeth: the neighbour closest to left + above - upper left
+                estimate = left + above - upper_left
+                distance_left = abs(estimate - left)
+                distance_above = abs(estimate - above)
+                distance_upper_left = abs(estimate - upper_left)
+
+                if distance_left <= distance_above and distance_left <= distance_upper_left:
+                    predictor = left
+                elif distance_above <= distance_upper_left:
+                    predictor = above
+                else:
+                    predictor = upper_left
+
+                row[i] = (row[i] + predictor) & 0xFF
+        elif filter_type != 0:
+            raise ValueError(f"unknown scanline filter {filter_type}")
+
+        rows.append(row)
+        previous = row
+
+    return rows, offset
+
+# splits a row into its samples, scaled to 8 bits unless they index a palette
+def row_samples(row, bit_depth, sample_count, scale):
+    if bit_depth == 8:
+        return row[:sample_count]
+    if bit_depth == 16:
+        return row[0:sample_count * 2:2]
+
+    per_byte = 8 // bit_depth
+    mask = (1 << bit_depth) - 1
+    factor = 255 // mask if scale else 1
+    samples = []
+
+    for i in range(sample_count):
+        shift = 8 - bit_depth * (i % per_byte + 1)
+        samples.append(((row[i // per_byte] >> shift) & mask) * factor)
+
+    return samples
+
+# imports the PNG file as an RGBA image
+def import_png(path):
+    with open(path, "rb") as f:
+        data = f.read()
+
+    if data[:8] != PNG_SIGNATURE:
+        raise ValueError(f"{path} is not a PNG file")
+
+    header = None
+    palette = None
+    transparency = None
+    compressed = bytearray()
+    offset = 8
+
+    while offset + 8 <= len(data):
+        length, chunk_type = struct.unpack_from(">I4s", data, offset)
+        chunk = data[offset + 8:offset + 8 + length]
+
+        if len(chunk) != length or offset + 12 + length > len(data):
+            raise ValueError(f"{path} is truncated")
+
+        crc = struct.unpack_from(">I", data, offset + 8 + length)[0]
+        if zlib.crc32(data[offset + 4:offset + 8 + length]) & 0xFFFFFFFF != crc:
+            raise ValueError(f"{path} has a corrupt {chunk_type.decode('latin-1')} chunk")
+
+        offset += 12 + length
+
+        if chunk_type == b"IHDR":
+            header = struct.unpack(">IIBBBBB", chunk)
+        elif chunk_type == b"PLTE":
+            palette = chunk
+        elif chunk_type == b"tRNS":
+            transparency = chunk
+        elif chunk_type == b"IDAT":
+            compressed += chunk
+        elif chunk_type == b"IEND":
+            break
+
+    if header is None:
+        raise ValueError(f"{path} has no IHDR chunk")
+
+    width, height, bit_depth, color_type, compression, filter_method, interlace = header
+
+    if (color_type not in PNG_CHANNELS or bit_depth not in (1, 2, 4, 8, 16) or compression != 0 or
+            filter_method != 0 or interlace > 1 or width == 0 or height == 0):
+        raise ValueError(f"{path} uses an unsupported PNG encoding")
+    if color_type == 3 and palette is None:
+        raise ValueError(f"{path} has no palette")
+
+    channels = PNG_CHANNELS[color_type]
+    pixel_bits = channels * bit_depth
+    pixel_bytes = max(1, pixel_bits // 8)
+
+    try:
+        raw = zlib.decompress(bytes(compressed))
+    except zlib.error as e:
+        raise ValueError(f"{path} has corrupt image data: {e}")
+
+    # the color that tRNS makes transparent, for gray and RGB images
+    transparent = None
+    if transparency is not None and color_type in (0, 2):
+        values = struct.unpack(f">{channels}H", transparency[:channels * 2])
+        transparent = tuple((value >> 8) if bit_depth == 16 else value * (255 // ((1 << bit_depth) - 1)) for value in values)
+
+    # palette entries as RGBA, with tRNS alphas for the first entries
+    entries = []
+    if color_type == 3:
+        for i in range(len(palette) // 3):
+            alpha = transparency[i] if transparency is not None and i < len(transparency) else 255
+            entries.append((palette[i * 3], palette[i * 3 + 1], palette[i * 3 + 2], alpha))
+
+    pixels = bytearray(width * height * 4)
+    passes = PNG_ADAM7 if interlace else [(0, 0, 1, 1)]
+    offset = 0
+
+    for x_start, y_start, x_step, y_step in passes:
+        pass_width = (width - x_start + x_step - 1) // x_step
+        pass_height = (height - y_start + y_step - 1) // y_step
+
+        if pass_width <= 0 or pass_height <= 0:
+            continue
+
+        rows, offset = unfilter(raw, offset, (pass_width * pixel_bits + 7) // 8, pass_height, pixel_bytes)
+
+        for row_index, row in enumerate(rows):
+            y = y_start + row_index * y_step
+            target = y * width * 4
+
+            # the common 8-bit RGB(A) rows are copied a channel at a time
+            if x_step == 1 and bit_depth == 8 and (color_type == 6 or (color_type == 2 and transparent is None)):
+                for channel in range(channels):
+                    pixels[target + channel:target + width * 4:4] = row[channel::channels]
+                if channels == 3:
+                    pixels[target + 3:target + width * 4:4] = b"\xff" * width
+                continue
+
+            samples = row_samples(row, bit_depth, pass_width * channels, color_type != 3)
+
+            for column in range(pass_width):
+                pixel = samples[column * channels:(column + 1) * channels]
+
+                if color_type == 3:
+                    if pixel[0] >= len(entries):
+                        raise ValueError(f"{path} indexes past its palette")
+                    rgba = entries[pixel[0]]
+                elif color_type == 0:
+                    rgba = (pixel[0], pixel[0], pixel[0], 0 if transparent == (pixel[0],) else 255)
+                elif color_type == 2:
+                    rgba = (pixel[0], pixel[1], pixel[2], 0 if transparent == tuple(pixel) else 255)
+                elif color_type == 4:
+                    rgba = (pixel[0], pixel[0], pixel[0], pixel[1])
+                else:
+                    rgba = pixel
+
+                target = ((y * width) + x_start + column * x_step) * 4
+                pixels[target:target + 4] = bytes(rgba)
+
+    return Image(width, height, pixels)
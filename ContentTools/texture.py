@@ -0,0 +1,125 @@
+#
+# Bakes source images into the block-compressed texture format loaded by LTAssetManager.
+#
+# Layout (little-endian, must match LTTextureFormat.h):
+#   LTTextureHeader
+#   LTTextureMip per mip level, level 0 (the full image) first
+#   per mip level, smallest first: the level's blocks, in rows of blocks
+#
+# Like KTX2, the smallest levels come first, so any prefix of the texture holds
+# every level smaller than the one it ends with.
+#
+# What a texture holds is told by its file name, and picks its format:
+#   *_n.png, *_normal.png   tangent-space normal maps: BC5 (x and y), linear, box filtered
+#   *_hq.png                color where BC1 and BC3 artifacts show: BC7, sRGB
+#   anything else           color: BC1 when opaque, BC3 when any texel has alpha, sRGB
+#
+
+# imports
+import os
+import struct
+
+from ContentTools.png import import_png
+from ContentTools.mips import build_mips, FILTER_BOX, FILTER_KAISER
+from ContentTools.bc import encode_blocks, BLOCK_ENCODERS
+
+TEXTURE_MAGIC = 0x5854544C # "LTTX"
+TEXTURE_VERSION = 1
+TEXTURE_HEADER = struct.Struct("<IIIIIIII")
+TEXTURE_MIP = struct.Struct("<IIIIQQ")
+
+# LTTextureFormat
+TEXTURE_FORMATS = { "bc1": 0, "bc3": 1, "bc5": 2, "bc7": 3 }
+
+# LTTextureFlags
+TEXTURE_FLAG_SRGB = 0x1
+
+# bump when the baker's output changes without the format changing, so the content
+# build re-bakes every texture
+TEXTURE_BAKER_VERSION = 1
+
+# the offset of each level is aligned so the runtime can copy it straight into an image
+TEXTURE_SECTION_ALIGNMENT = 16
+
+def align_up(value, alignment):
+    return (value + alignment - 1) & ~(alignment - 1)
+
+# imports a texture source file by extension
+def import_image(source_path):
+    ext = os.path.splitext(source_path)[1].lower()
+
+    if ext == ".png":
+        return import_png(source_path)
+
+    raise ValueError(f"{source_path} is not a supported image format")
+
+# decides how a texture is baked from its file name and contents;
+# returns (format name, srgb, normal map, filter)
+def choose_texture_format(source_path, image):
+    name = os.path.splitext(os.path.basename(source_path))[0].lower()
+
+    if name.endswith("_n") or name.endswith("_normal"):
+        return ("bc5", False, True, FILTER_BOX)
+    if name.endswith("_hq"):
+        return ("bc7", True, False, FILTER_KAISER)
+
+    return ("bc3" if image.has_alpha() else "bc1", True, False, FILTER_KAISER)
+
+# packs the baked texture. mips are (width, height, blocks), level 0 first
+def write_texture(mips, format_name, srgb):
+    offset = align_up(TEXTURE_HEADER.size + len(mips) * TEXTURE_MIP.size, TEXTURE_SECTION_ALIGNMENT)
+    block_bytes = BLOCK_ENCODERS[format_name][1]
+
+    # the levels are stored smallest first
+    offsets = [0] * len(mips)
+    for level in reversed(range(len(mips))):
+        offsets[level] = offset
+        offset = align_up(offset + len(mips[level][2]), TEXTURE_SECTION_ALIGNMENT)
+
+    blob = bytearray(TEXTURE_HEADER.pack(
+        TEXTURE_MAGIC,
+        TEXTURE_VERSION,
+        TEXTURE_FORMATS[format_name],
+        TEXTURE_FLAG_SRGB if srgb else 0,
+        mips[0][0],
+        mips[0][1],
+        len(mips),
+        0))
+
+    for level, (width, height, blocks) in enumerate(mips):
+        blob += TEXTURE_MIP.pack(
+            width,
+            height,
+            ((width + 3) // 4) * block_bytes,
+            0,
+            offsets[level],
+            len(blocks))
+
+    for level in reversed(range(len(mips))):
+        blob += bytes(offsets[level] - len(blob))
+        blob += mips[level][2]
+
+    return bytes(blob)
+
+# imports an image and writes the baked texture file. returns true on success.
+# runs in a worker process, so failures are reported rather than raised
+def bake_texture(source_path, output_path):
+    try:
+        image = import_image(source_path)
+        format_name, srgb, normal_map, filter_name = choose_texture_format(source_path, image)
+
+        mips = []
+        for width, height, pixels in build_mips(image, srgb, normal_map, filter_name):
+            mips.append((width, height, encode_blocks(width, height, pixels, format_name)))
+
+        blob = write_texture(mips, format_name, srgb)
+
+        with open(output_path, "wb") as f:
+            f.write(blob)
+
+        print(f"Baking textures...{source_path}: {image.width}x{image.height}, {len(mips)} mips, "
+              f"{format_name.upper()}{' sRGB' if srgb else ''}, {image.width * image.height * 4} -> {len(blob)} bytes")
+        return True
+    except (OSError, ValueError, struct.error, IndexError) as e:
+        print(f"Baking textures...{source_path} failed: {e}")
+        return False
@@ -17,13 +17,25 @@ LTAssetHandle Content::Models::GetCubeNoLoad()
     return assetHandle;
 }
 
-LTAssetHandle Content::Models::GetCube()
+LTAssetHandle Content::Models::GetCube(
+    LTAssetPriority priority,
+    uint64_t deadlineFrame)
 {
     LTAssetHandle assetHandle;
-    LTAssetManager::GetInstance().GetLoad(/* asset id = */ 0, assetHandle);
+    LTAssetManager::GetInstance().GetLoad(/* asset id = */ 0, assetHandle, priority, deadlineFrame);
     return assetHandle;
 }
 
+LTAssetLoadToken Content::Models::LoadCube(
+    LTAssetPriority priority,
+    uint64_t deadlineFrame)
+{
+    LTAssetHandle assetHandle;
+    LTAssetLoadToken loadToken;
+    LTAssetManager::GetInstance().GetLoad(/* asset id = */ 0, assetHandle, loadToken, priority, deadlineFrame);
+    return loadToken;
+}
+
 
 uint32_t Content::FragmentShaders::GetSimpleID()
 {
@@ -37,13 +49,57 @@ LTAssetHandle Content::FragmentShaders::GetSimpleNoLoad()
     return assetHandle;
 }
 
-LTAssetHandle Content::FragmentShaders::GetSimple()
+LTAssetHandle Content::FragmentShaders::GetSimple(
+    LTAssetPriority priority,
+    uint64_t deadlineFrame)
 {
     LTAssetHandle assetHandle;
-    LTAssetManager::GetInstance().GetLoad(/* asset id = */ 1, assetHandle);
+    LTAssetManager::GetInstance().GetLoad(/* asset id = */ 1, assetHandle, priority, deadlineFrame);
     return assetHandle;
 }
 
+LTAssetLoadToken Content::FragmentShaders::LoadSimple(
+    LTAssetPriority priority,
+    uint64_t deadlineFrame)
+{
+    LTAssetHandle assetHandle;
+    LTAssetLoadToken loadToken;
+    LTAssetManager::GetInstance().GetLoad(/* asset id = */ 1, assetHandle, loadToken, priority, deadlineFrame);
+    return loadToken;
+}
+
+
+uint32_t Content::FragmentShaders::GetInstancedID()
+{
+    return 3;
+}
+
+LTAssetHandle Content::FragmentShaders::GetInstancedNoLoad()
+{
+    LTAssetHandle assetHandle;
+    LTAssetManager::GetInstance().Get(/* asset id = */ 3, assetHandle);
+    return assetHandle;
+}
+
+LTAssetHandle Content::FragmentShaders::GetInstanced(
+    LTAssetPriority priority,
+    uint64_t deadlineFrame)
+{
+    LTAssetHandle assetHandle;
+    LTAssetManager::GetInstance().GetLoad(/* asset id = */ 3, assetHandle, priority, deadlineFrame);
+    return assetHandle;
+}
+
+LTAssetLoadToken Content::FragmentShaders::LoadInstanced(
+    LTAssetPriority priority,
+    uint64_t deadlineFrame)
+{
+    LTAssetHandle assetHandle;
+    LTAssetLoadToken loadToken;
+    LTAssetManager::GetInstance().GetLoad(/* asset id = */ 3, assetHandle, loadToken, priority, deadlineFrame);
+    return loadToken;
+}
+
 
 uint32_t Content::VertexShaders::GetSimpleID()
 {
@@ -57,9 +113,85 @@ LTAssetHandle Content::VertexShaders::GetSimpleNoLoad()
     return assetHandle;
 }
 
-LTAssetHandle Content::VertexShaders::GetSimple()
+LTAssetHandle Content::VertexShaders::GetSimple(
+    LTAssetPriority priority,
+    uint64_t deadlineFrame)
+{
+    LTAssetHandle assetHandle;
+    LTAssetManager::GetInstance().GetLoad(/* asset id = */ 2, assetHandle, priority, deadlineFrame);
+    return assetHandle;
+}
+
+LTAssetLoadToken Content::VertexShaders::LoadSimple(
+    LTAssetPriority priority,
+    uint64_t deadlineFrame)
+{
+    LTAssetHandle assetHandle;
+    LTAssetLoadToken loadToken;
+    LTAssetManager::GetInstance().GetLoad(/* asset id = */ 2, assetHandle, loadToken, priority, deadlineFrame);
+    return loadToken;
+}
+
+
+uint32_t Content::VertexShaders::GetInstancedID()
+{
+    return 4;
+}
+
+LTAssetHandle Content::VertexShaders::GetInstancedNoLoad()
+{
+    LTAssetHandle assetHandle;
+    LTAssetManager::GetInstance().Get(/* asset id = */ 4, assetHandle);
+    return assetHandle;
+}
+
+LTAssetHandle Content::VertexShaders::GetInstanced(
+    LTAssetPriority priority,
+    uint64_t deadlineFrame)
 {
     LTAssetHandle assetHandle;
-    LTAssetManager::GetInstance().GetLoad(/* asset id = */ 2, assetHandle);
+    LTAssetManager::GetInstance().GetLoad(/* asset id = */ 4, assetHandle, priority, deadlineFrame);
     return assetHandle;
 }
+
+LTAssetLoadToken Content::VertexShaders::LoadInstanced(
+    LTAssetPriority priority,
+    uint64_t deadlineFrame)
+{
+    LTAssetHandle assetHandle;
+    LTAssetLoadToken loadToken;
+    LTAssetManager::GetInstance().GetLoad(/* asset id = */ 4, assetHandle, loadToken, priority, deadlineFrame);
+    return loadToken;
+}
+
+
+uint32_t Content::Images::GetCrateID()
+{
+    return 5;
+}
+
+LTAssetHandle Content::Images::GetCrateNoLoad()
+{
+    LTAssetHandle assetHandle;
+    LTAssetManager::GetInstance().Get(/* asset id = */ 5, assetHandle);
+    return assetHandle;
+}
+
+LTAssetHandle Content::Images::GetCrate(
+    LTAssetPriority priority,
+    uint64_t deadlineFrame)
+{
+    LTAssetHandle assetHandle;
+    LTAssetManager::GetInstance().GetLoad(/* asset id = */ 5, assetHandle, priority, deadlineFrame);
+    return assetHandle;
+}
+
+LTAssetLoadToken Content::Images::LoadCrate(
+    LTAssetPriority priority,
+    uint64_t deadlineFrame)
+{
+    LTAssetHandle assetHandle;
+    LTAssetLoadToken loadToken;
+    LTAssetManager::GetInstance().GetLoad(/* asset id = */ 5, assetHandle, loadToken, priority, deadlineFrame);
+    return loadToken;
+}
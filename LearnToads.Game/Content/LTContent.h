@@ -11,8 +11,13 @@ private:
 public: 
 
     static inline uint32_t GetCubeID();
-    static LTAssetHandle GetCube();
+    static LTAssetHandle GetCube(
+        LTAssetPriority priority = LTAssetPriority::LT_ASSET_PRIORITY_NORMAL,
+        uint64_t deadlineFrame = LT_ASSET_NO_DEADLINE);
     static LTAssetHandle GetCubeNoLoad();
+    static LTAssetLoadToken LoadCube(
+        LTAssetPriority priority = LTAssetPriority::LT_ASSET_PRIORITY_NORMAL,
+        uint64_t deadlineFrame = LT_ASSET_NO_DEADLINE);
 }; // class Models 
 
 class FragmentShaders {
@@ -20,8 +25,22 @@ private:
 public: 
 
     static inline uint32_t GetSimpleID();
-    static LTAssetHandle GetSimple();
+    static LTAssetHandle GetSimple(
+        LTAssetPriority priority = LTAssetPriority::LT_ASSET_PRIORITY_NORMAL,
+        uint64_t deadlineFrame = LT_ASSET_NO_DEADLINE);
     static LTAssetHandle GetSimpleNoLoad();
+    static LTAssetLoadToken LoadSimple(
+        LTAssetPriority priority = LTAssetPriority::LT_ASSET_PRIORITY_NORMAL,
+        uint64_t deadlineFrame = LT_ASSET_NO_DEADLINE);
+
+    static inline uint32_t GetInstancedID();
+    static LTAssetHandle GetInstanced(
+        LTAssetPriority priority = LTAssetPriority::LT_ASSET_PRIORITY_NORMAL,
+        uint64_t deadlineFrame = LT_ASSET_NO_DEADLINE);
+    static LTAssetHandle GetInstancedNoLoad();
+    static LTAssetLoadToken LoadInstanced(
+        LTAssetPriority priority = LTAssetPriority::LT_ASSET_PRIORITY_NORMAL,
+        uint64_t deadlineFrame = LT_ASSET_NO_DEADLINE);
 }; // class FragmentShaders 
 
 class VertexShaders {
@@ -29,9 +48,37 @@ private:
 public: 
 
     static inline uint32_t GetSimpleID();
-    static LTAssetHandle GetSimple();
+    static LTAssetHandle GetSimple(
+        LTAssetPriority priority = LTAssetPriority::LT_ASSET_PRIORITY_NORMAL,
+        uint64_t deadlineFrame = LT_ASSET_NO_DEADLINE);
     static LTAssetHandle GetSimpleNoLoad();
+    static LTAssetLoadToken LoadSimple(
+        LTAssetPriority priority = LTAssetPriority::LT_ASSET_PRIORITY_NORMAL,
+        uint64_t deadlineFrame = LT_ASSET_NO_DEADLINE);
+
+    static inline uint32_t GetInstancedID();
+    static LTAssetHandle GetInstanced(
+        LTAssetPriority priority = LTAssetPriority::LT_ASSET_PRIORITY_NORMAL,
+        uint64_t deadlineFrame = LT_ASSET_NO_DEADLINE);
+    static LTAssetHandle GetInstancedNoLoad();
+    static LTAssetLoadToken LoadInstanced(
+        LTAssetPriority priority = LTAssetPriority::LT_ASSET_PRIORITY_NORMAL,
+        uint64_t deadlineFrame = LT_ASSET_NO_DEADLINE);
 }; // class VertexShaders 
 
+class Images {
+private: 
+public: 
+
+    static inline uint32_t GetCrateID();
+    static LTAssetHandle GetCrate(
+        LTAssetPriority priority = LTAssetPriority::LT_ASSET_PRIORITY_NORMAL,
+        uint64_t deadlineFrame = LT_ASSET_NO_DEADLINE);
+    static LTAssetHandle GetCrateNoLoad();
+    static LTAssetLoadToken LoadCrate(
+        LTAssetPriority priority = LTAssetPriority::LT_ASSET_PRIORITY_NORMAL,
+        uint64_t deadlineFrame = LT_ASSET_NO_DEADLINE);
+}; // class Images 
+
 } // namespace Content
 
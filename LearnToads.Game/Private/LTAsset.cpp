@@ -1,99 +1,1704 @@
 #include "PrecompiledHeader.h"
 #include "LTAsset.h"
 #include "LTVKDevice.h"
+#include "LTFileMapping.h"
+#include "LTContentPak.h"
+#include "LTModelFormat.h"
+#include "LTTextureFormat.h"
+#include "LTVKVertexFormat.h"
 
-void LTAssetManager::Initialize(LTVKDevice* ltvkDevice)
+thread_local bool LTAssetManager::s_IsContentThread = false;
+
+void LTAssetManager::Initialize(LTVKDevice* ltvkDevice, uint32_t workerCount)
 {
     m_LTVKDevice = ltvkDevice;
 
     InitializeContentLookup();
 
-    m_ContentThread = new std::thread(&LTAssetManager::ContentThread, this);
+    // leave a core for the main thread when sizing from the hardware
+    if (workerCount == 0)
+    {
+        uint32_t hardwareThreads = std::thread::hardware_concurrency();
+        workerCount = hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+    }
+
+    m_IsRunning = true;
+
+    for (uint32_t i = 0; i < workerCount; ++i)
+    {
+        m_ContentThreads.push_back(new std::thread(&LTAssetManager::ContentThread, this));
+    }
+}
+
+void LTAssetManager::QueueJob(LTAssetJob&& assetJob)
+{
+    LTJobQueue<LTAssetJob>& jobQueue = m_AssetJobs[(size_t)assetJob.priority];
+
+    assetJob.queuedTime = std::chrono::steady_clock::now();
+
+    // the ring is bounded; if it is full, make sure the workers are awake
+    // draining it and back off: yield a few times, then sleep for doubling
+    // intervals up to LT_ASSET_QUEUE_FULL_MAX_SLEEP_US. A worker never waits on
+    // the other workers, which may all be queueing too; it runs a job itself
+    uint32_t attempts = 0;
+    uint32_t sleepUs = 1;
+
+    while (!jobQueue.TryEnqueue(std::move(assetJob)))
+    {
+        if (attempts == 0)
+        {
+            m_QueueFullCount.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        m_AssetCondition.notify_all();
+
+        LTAssetJob inlineJob;
+
+        if (s_IsContentThread && TryDequeueJob(inlineJob))
+        {
+            RunJob(inlineJob);
+        }
+        else if (attempts < LT_ASSET_QUEUE_FULL_YIELDS)
+        {
+            std::this_thread::yield();
+        }
+        else
+        {
+            std::this_thread::sleep_for(std::chrono::microseconds(sleepUs));
+            sleepUs = sleepUs * 2 < LT_ASSET_QUEUE_FULL_MAX_SLEEP_US ? sleepUs * 2 : LT_ASSET_QUEUE_FULL_MAX_SLEEP_US;
+        }
+
+        attempts++;
+    }
+
+    // pairs with the fence in WaitForJobs: either the worker sees the new job
+    // or we see the worker going to sleep
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    if (m_SleepingWorkers.load(std::memory_order_relaxed) > 0)
+    {
+        // taking the lock guarantees the sleeper is either still before its
+        // re-check (and will see the job) or already waiting (and gets notified)
+        {
+            std::scoped_lock lock(m_AssetMutex);
+        }
+
+        m_AssetCondition.notify_one();
+    }
+}
+
+bool LTAssetManager::TryDequeueJob(LTAssetJob& outAssetJob)
+{
+    constexpr size_t priorityCount = (size_t)LTAssetPriority::LT_ASSET_PRIORITY_COUNT;
+
+    size_t served = priorityCount;
+
+    // serve any queue that has been passed over too many times first
+    for (size_t priority = 0; priority < priorityCount; ++priority)
+    {
+        if (m_StarvedPasses[priority].load(std::memory_order_relaxed) >= LT_ASSET_AGING_THRESHOLD
+            && m_AssetJobs[priority].TryDequeue(outAssetJob))
+        {
+            served = priority;
+            break;
+        }
+    }
+
+    // otherwise take the highest priority job available
+    if (served == priorityCount)
+    {
+        for (size_t priority = 0; priority < priorityCount; ++priority)
+        {
+            if (m_AssetJobs[priority].TryDequeue(outAssetJob))
+            {
+                served = priority;
+                break;
+            }
+        }
+    }
+
+    if (served == priorityCount)
+    {
+        return false;
+    }
+
+    m_StarvedPasses[served].store(0, std::memory_order_relaxed);
+
+    // every lower priority queue with waiting work has now been passed over once more
+    for (size_t priority = served + 1; priority < priorityCount; ++priority)
+    {
+        if (m_AssetJobs[priority].GetApproximateSize() > 0)
+        {
+            m_StarvedPasses[priority].fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    return true;
+}
+
+bool LTAssetManager::HasQueuedJobs() const
+{
+    for (const LTJobQueue<LTAssetJob>& jobQueue : m_AssetJobs)
+    {
+        if (jobQueue.GetApproximateSize() > 0)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void LTAssetManager::RecordQueueWait(const LTAssetJob& assetJob)
+{
+    auto wait = std::chrono::steady_clock::now() - assetJob.queuedTime;
+    uint64_t waitNs = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(wait).count();
+
+    std::scoped_lock lock(m_StatsMutex);
+
+    LTAssetQueueStats& stats = m_QueueStats[(size_t)assetJob.priority];
+    stats.jobCount++;
+    stats.totalWaitNs += waitNs;
+    stats.maxWaitNs = waitNs > stats.maxWaitNs ? waitNs : stats.maxWaitNs;
+}
+
+void LTAssetManager::RecordDecode(const LTAsset* asset, const LTContentPayload& payload)
+{
+    std::scoped_lock lock(m_StatsMutex);
+
+    LTAssetDecodeStats& stats = m_DecodeStats[asset->GetAssetID()];
+    stats.codec = payload.GetCodec();
+    stats.storedBytes = payload.GetStoredSize();
+    stats.uncompressedBytes = payload.GetSize();
+    stats.decodeNs = payload.GetDecodeNs();
+    stats.loadCount++;
+}
+
+void LTAssetManager::RecordDeadline(const LTAssetJob& assetJob)
+{
+    if (assetJob.deadlineFrame == LT_ASSET_NO_DEADLINE
+        || GetCurrentFrame() <= assetJob.deadlineFrame)
+    {
+        return;
+    }
+
+    std::scoped_lock lock(m_StatsMutex);
+    m_QueueStats[(size_t)assetJob.priority].deadlineMisses++;
+}
+
+LTAssetQueueStats LTAssetManager::GetQueueStats(LTAssetPriority priority)
+{
+    std::scoped_lock lock(m_StatsMutex);
+    return m_QueueStats[(size_t)priority];
+}
+
+void LTAssetManager::PrintQueueStats()
+{
+    static const char* priorityNames[] = { "critical", "high", "normal", "background" };
+
+    for (size_t priority = 0; priority < (size_t)LTAssetPriority::LT_ASSET_PRIORITY_COUNT; ++priority)
+    {
+        LTAssetQueueStats stats = GetQueueStats((LTAssetPriority)priority);
+
+        double averageWaitUs = stats.jobCount
+            ? (double)stats.totalWaitNs / (double)stats.jobCount / 1000.0
+            : 0.0;
+
+        printf("asset queue %-10s jobs: %llu, avg wait: %.1f us, max wait: %.1f us, deadline misses: %llu \n",
+            priorityNames[priority],
+            (unsigned long long)stats.jobCount,
+            averageWaitUs,
+            (double)stats.maxWaitNs / 1000.0,
+            (unsigned long long)stats.deadlineMisses);
+    }
+
+    printf("asset queue full: %llu jobs backed off, loads promoted: %llu \n",
+        (unsigned long long)m_QueueFullCount.load(std::memory_order_relaxed),
+        (unsigned long long)m_LoadPromotionCount.load(std::memory_order_relaxed));
+}
+
+LTAssetDecodeStats LTAssetManager::GetDecodeStats(LTAssetID assetID)
+{
+    std::scoped_lock lock(m_StatsMutex);
+    return m_DecodeStats[assetID];
+}
+
+void LTAssetManager::PrintDecodeStats(bool perAsset)
+{
+    static const char* typeNames[] = { "unknown", "shader", "texture", "model" };
+
+    LTAssetDecodeStats typeTotals[(size_t)LTAssetType::LT_ASSET_TYPE_COUNT];
+
+    std::scoped_lock lock(m_StatsMutex);
+
+    for (LTAsset* asset : m_Assets)
+    {
+        const LTAssetDecodeStats& stats = m_DecodeStats[asset->GetAssetID()];
+
+        if (stats.loadCount == 0)
+        {
+            continue;
+        }
+
+        if (perAsset)
+        {
+            printf("asset decode %-40s %-5s stored: %llu bytes, uncompressed: %llu bytes, decode: %.1f us \n",
+                asset->GetFileName().c_str(),
+                LTCompression::GetCodecName(stats.codec),
+                (unsigned long long)stats.storedBytes,
+                (unsigned long long)stats.uncompressedBytes,
+                (double)stats.decodeNs / 1000.0);
+        }
+
+        LTAssetDecodeStats& totals = typeTotals[(size_t)asset->GetAssetType()];
+        totals.storedBytes += stats.storedBytes;
+        totals.uncompressedBytes += stats.uncompressedBytes;
+        totals.decodeNs += stats.decodeNs;
+        totals.loadCount++;
+    }
+
+    for (size_t assetType = 0; assetType < (size_t)LTAssetType::LT_ASSET_TYPE_COUNT; ++assetType)
+    {
+        const LTAssetDecodeStats& totals = typeTotals[assetType];
+
+        if (totals.loadCount == 0)
+        {
+            continue;
+        }
+
+        double ratio = totals.storedBytes
+            ? (double)totals.uncompressedBytes / (double)totals.storedBytes
+            : 0.0;
+
+        double throughputMBs = totals.decodeNs
+            ? (double)totals.uncompressedBytes / ((double)totals.decodeNs / 1e9) / (1024.0 * 1024.0)
+            : 0.0;
+
+        printf("asset decode %-8s assets: %u, stored: %llu bytes, uncompressed: %llu bytes, ratio: %.2f, decode: %.1f us (%.0f MB/s) \n",
+            typeNames[assetType],
+            totals.loadCount,
+            (unsigned long long)totals.storedBytes,
+            (unsigned long long)totals.uncompressedBytes,
+            ratio,
+            (double)totals.decodeNs / 1000.0,
+            throughputMBs);
+    }
+}
+
+void LTAssetManager::WaitForJobs()
+{
+    std::unique_lock lock(m_AssetMutex);
+
+    m_SleepingWorkers.fetch_add(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    m_AssetCondition.wait(lock, [this]()
+    {
+        return !m_IsRunning || HasQueuedJobs();
+    });
+
+    m_SleepingWorkers.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void LTAssetManager::CompleteLoad(LTAssetJob& assetJob, bool success)
+{
+    LTAsset* asset = assetJob.assetHandle.GetAsset();
+    eastl::vector<LTAssetContinuation> continuations;
+
+    {
+        std::scoped_lock lock(m_ContinuationMutex);
+
+        // a failed load goes back to NOT_LOADED so a later Load() can retry;
+        // the state is published before the generation so a completed token
+        // always sees the final state
+        asset->SetAssetState(success
+            ? LTAssetState::LT_ASSET_STATE_LOADED
+            : LTAssetState::LT_ASSET_STATE_NOT_LOADED);
+
+        asset->m_LoadGeneration.fetch_add(1, std::memory_order_release);
+
+        continuations.swap(asset->m_Continuations);
+    }
+
+    m_LoadCompleteCondition.notify_all();
+
+    if (success)
+    {
+        AddResidency(asset);
+    }
+
+    LTAssetJobResult result = success
+        ? LTAssetJobResult::LT_ASSET_JOB_RESULT_SUCCESS
+        : LTAssetJobResult::LT_ASSET_JOB_RESULT_FAILURE;
+
+    for (const LTAssetContinuation& continuation : continuations)
+    {
+        DispatchCallback(continuation, assetJob.assetHandle, result);
+    }
+}
+
+void LTAssetManager::CompleteStream(LTAssetJob& assetJob, bool success)
+{
+    if (!success)
+    {
+        return;
+    }
+
+    LTAsset* asset = assetJob.assetHandle.GetAsset();
+    LTAssetType assetType = asset->GetAssetType();
+
+    {
+        std::scoped_lock lock(m_ResidencyMutex);
+
+        // streams that replace what was resident (texture images) release it too
+        LTAssetMemory& usage = m_MemoryUsage[(size_t)assetType];
+        usage.cpuBytes += assetJob.streamedMemory.cpuBytes - assetJob.releasedMemory.cpuBytes;
+        usage.gpuBytes += assetJob.streamedMemory.gpuBytes - assetJob.releasedMemory.gpuBytes;
+
+        asset->m_CpuBytes += assetJob.streamedMemory.cpuBytes - assetJob.releasedMemory.cpuBytes;
+        asset->m_GpuBytes += assetJob.streamedMemory.gpuBytes - assetJob.releasedMemory.gpuBytes;
+    }
+
+    EvictOverBudget(assetType);
+}
+
+void LTAssetManager::CompleteLoadJob(LTAssetJob& assetJob, bool success)
+{
+    if (assetJob.jobType == LTAssetJobType::LT_ASSET_JOB_TYPE_STREAM)
+    {
+        CompleteStream(assetJob, success);
+    }
+    else
+    {
+        CompleteLoad(assetJob, success);
+    }
+
+    // a texture stream goes straight to the level it was queued for, so there is
+    // nothing to chain; the texture can take its next stream
+    if (assetJob.assetHandle.GetAsset()->GetAssetType() == LTAssetType::LT_ASSET_TYPE_TEXTURE)
+    {
+        if (assetJob.jobType == LTAssetJobType::LT_ASSET_JOB_TYPE_STREAM)
+        {
+            LTTexture* textureAsset = (LTTexture*)assetJob.assetHandle.GetAsset();
+            textureAsset->m_IsStreaming.store(false, std::memory_order_release);
+        }
+
+        return;
+    }
+
+    // a finer level streams in only while one is asked for; the stream in flight
+    // owns m_IsStreaming, and a load takes it unless a request already has
+    LTModel* modelAsset = (LTModel*)assetJob.assetHandle.GetAsset();
+    bool ownsStream = assetJob.jobType == LTAssetJobType::LT_ASSET_JOB_TYPE_STREAM;
+
+    if (!success || assetJob.streamLevel == 0 || modelAsset->m_RequestedLOD.load(std::memory_order_relaxed) >= assetJob.streamLevel)
+    {
+        if (ownsStream)
+        {
+            modelAsset->m_IsStreaming.store(false, std::memory_order_release);
+        }
+
+        return;
+    }
+
+    bool expected = false;
+
+    if (!ownsStream && !modelAsset->m_IsStreaming.compare_exchange_strong(expected, true, std::memory_order_acq_rel))
+    {
+        return;
+    }
+
+    // the finer levels are refinement, so they stream one priority below the load
+    // that asked for the asset. the stream job's handle pins the asset until the
+    // level asked for is in; it is taken while this job still holds its own, so the
+    // asset never becomes unreferenced (and evictable) in between
+    LTAssetPriority priority = assetJob.priority;
+
+    if (assetJob.jobType == LTAssetJobType::LT_ASSET_JOB_TYPE_LOAD &&
+        priority != LTAssetPriority::LT_ASSET_PRIORITY_BACKGROUND)
+    {
+        priority = (LTAssetPriority)((uint32_t)priority + 1);
+    }
+
+    LTAssetJob streamJob(assetJob.assetHandle, LTAssetJobType::LT_ASSET_JOB_TYPE_STREAM, priority);
+    streamJob.streamLevel = assetJob.streamLevel - 1;
+
+    QueueJob(std::move(streamJob));
+}
+
+void LTAssetManager::CompleteUnload(LTAssetJob& assetJob, bool unloaded)
+{
+    LTAsset* asset = assetJob.assetHandle.GetAsset();
+    eastl::vector<LTAssetContinuation> continuations;
+    bool reload = false;
+    uint32_t loadGeneration = 0;
+
+    {
+        std::scoped_lock lock(m_ContinuationMutex);
+
+        if (unloaded)
+        {
+            // a load requested while unloading starts over from scratch; its
+            // tokens complete when that load does
+            reload = asset->m_ReloadRequested;
+
+            asset->SetAssetState(reload
+                ? LTAssetState::LT_ASSET_STATE_LOADING
+                : LTAssetState::LT_ASSET_STATE_NOT_LOADED);
+
+            if (reload)
+            {
+                asset->m_LoadPriority = asset->m_ReloadPriority;
+                asset->m_LoadDeadline = LT_ASSET_NO_DEADLINE;
+                asset->m_IsLoadClaimed = false;
+                loadGeneration = asset->m_LoadGeneration.load(std::memory_order_relaxed);
+            }
+        }
+        else
+        {
+            asset->SetAssetState(LTAssetState::LT_ASSET_STATE_LOADED);
+
+            // tokens handed out while unloading were waiting on the next completion,
+            // and the asset never stopped being loaded
+            if (asset->m_ReloadRequested)
+            {
+                asset->m_LoadGeneration.fetch_add(1, std::memory_order_release);
+                continuations.swap(asset->m_Continuations);
+            }
+        }
+
+        asset->m_ReloadRequested = false;
+    }
+
+    if (unloaded)
+    {
+        asset->m_CpuBytes = 0;
+        asset->m_GpuBytes = 0;
+    }
+    else
+    {
+        // the bytes stopped counting when the unload was queued
+        AddResidency(asset);
+    }
+
+    if (reload)
+    {
+        QueueLoad(assetJob.assetHandle, loadGeneration);
+    }
+
+    if (!continuations.empty())
+    {
+        m_LoadCompleteCondition.notify_all();
+
+        for (const LTAssetContinuation& continuation : continuations)
+        {
+            DispatchCallback(continuation, assetJob.assetHandle, LTAssetJobResult::LT_ASSET_JOB_RESULT_SUCCESS);
+        }
+    }
+}
+
+void LTAssetManager::AddResidency(LTAsset* asset)
+{
+    LTAssetType assetType = asset->GetAssetType();
+
+    {
+        std::scoped_lock lock(m_ResidencyMutex);
+
+        LTAssetMemory& usage = m_MemoryUsage[(size_t)assetType];
+        usage.cpuBytes += asset->m_CpuBytes;
+        usage.gpuBytes += asset->m_GpuBytes;
+    }
+
+    EvictOverBudget(assetType);
+}
+
+void LTAssetHandle::OnLastReferenceReleased(LTAsset* asset)
+{
+    LTAssetManager::GetInstance().OnAssetUnreferenced(asset);
 }
 
-void LTAssetManager::ContentThread()
-{
-    while (true)
+void LTAssetManager::OnAssetUnreferenced(LTAsset* asset)
+{
+    // only loaded assets hold memory worth evicting; assets that are still loading
+    // are referenced by their job and come back through here when it finishes
+    if (!m_IsRunning || !asset->IsValid())
+    {
+        return;
+    }
+
+    {
+        std::scoped_lock lock(m_ResidencyMutex);
+
+        // handles taken after the asset was linked do not unlink it, so it may
+        // already be in the list; move it back to the head
+        if (asset->m_IsInLRU)
+        {
+            UnlinkLRU(asset);
+        }
+
+        asset->m_LRUPrev = nullptr;
+        asset->m_LRUNext = m_LRUHead;
+
+        if (m_LRUHead)
+        {
+            m_LRUHead->m_LRUPrev = asset;
+        }
+        else
+        {
+            m_LRUTail = asset;
+        }
+
+        m_LRUHead = asset;
+        asset->m_IsInLRU = true;
+    }
+
+    EvictOverBudget(asset->GetAssetType());
+}
+
+void LTAssetManager::UnlinkLRU(LTAsset* asset)
+{
+    if (asset->m_LRUPrev)
+    {
+        asset->m_LRUPrev->m_LRUNext = asset->m_LRUNext;
+    }
+    else
+    {
+        m_LRUHead = asset->m_LRUNext;
+    }
+
+    if (asset->m_LRUNext)
+    {
+        asset->m_LRUNext->m_LRUPrev = asset->m_LRUPrev;
+    }
+    else
+    {
+        m_LRUTail = asset->m_LRUPrev;
+    }
+
+    asset->m_LRUPrev = nullptr;
+    asset->m_LRUNext = nullptr;
+    asset->m_IsInLRU = false;
+}
+
+void LTAssetManager::EvictOverBudget(LTAssetType assetType)
+{
+    eastl::vector<LTAssetHandle> evicted;
+
+    {
+        std::scoped_lock lock(m_ResidencyMutex);
+
+        const LTAssetMemory& budget = m_MemoryBudgets[(size_t)assetType];
+        LTAssetMemory& usage = m_MemoryUsage[(size_t)assetType];
+
+        LTAsset* asset = m_LRUTail;
+
+        while (asset && (usage.cpuBytes > budget.cpuBytes || usage.gpuBytes > budget.gpuBytes))
+        {
+            LTAsset* prev = asset->m_LRUPrev;
+
+            if (asset->GetRefCount() > 0 || !asset->IsValid())
+            {
+                // referenced again (or already on its way out) since it was linked;
+                // it is relinked when its last handle goes away
+                UnlinkLRU(asset);
+            }
+            else if (asset->GetAssetType() == assetType)
+            {
+                LTAssetState expected = LTAssetState::LT_ASSET_STATE_LOADED;
+
+                if (asset->m_AssetState.compare_exchange_strong(expected, LTAssetState::LT_ASSET_STATE_UNLOADING))
+                {
+                    UnlinkLRU(asset);
+
+                    usage.cpuBytes -= asset->m_CpuBytes;
+                    usage.gpuBytes -= asset->m_GpuBytes;
+                    m_Evictions[(size_t)assetType]++;
+
+                    // taking a handle here cannot release one, so the mutex is never re-entered
+                    evicted.push_back(LTAssetHandle(asset));
+                }
+            }
+
+            asset = prev;
+        }
+    }
+
+    for (LTAssetHandle& assetHandle : evicted)
+    {
+        QueueJob(LTAssetJob(
+            assetHandle,
+            LTAssetJobType::LT_ASSET_JOB_TYPE_UNLOAD,
+            LTAssetPriority::LT_ASSET_PRIORITY_BACKGROUND));
+    }
+}
+
+void LTAssetManager::SetMemoryBudget(LTAssetType assetType, const LTAssetMemory& budget)
+{
+    {
+        std::scoped_lock lock(m_ResidencyMutex);
+        m_MemoryBudgets[(size_t)assetType] = budget;
+    }
+
+    EvictOverBudget(assetType);
+}
+
+LTAssetMemory LTAssetManager::GetMemoryBudget(LTAssetType assetType)
+{
+    std::scoped_lock lock(m_ResidencyMutex);
+    return m_MemoryBudgets[(size_t)assetType];
+}
+
+LTAssetMemory LTAssetManager::GetMemoryUsage(LTAssetType assetType)
+{
+    std::scoped_lock lock(m_ResidencyMutex);
+    return m_MemoryUsage[(size_t)assetType];
+}
+
+void LTAssetManager::PrintMemoryStats()
+{
+    static const char* typeNames[] = { "unknown", "shader", "texture", "model" };
+
+    std::scoped_lock lock(m_ResidencyMutex);
+
+    for (size_t assetType = 0; assetType < (size_t)LTAssetType::LT_ASSET_TYPE_COUNT; ++assetType)
+    {
+        const LTAssetMemory& usage = m_MemoryUsage[assetType];
+        const LTAssetMemory& budget = m_MemoryBudgets[assetType];
+
+        printf("asset memory %-8s cpu: %zu / %zu bytes, gpu: %zu / %zu bytes, evictions: %llu \n",
+            typeNames[assetType],
+            usage.cpuBytes,
+            budget.cpuBytes,
+            usage.gpuBytes,
+            budget.gpuBytes,
+            (unsigned long long)m_Evictions[assetType]);
+    }
+}
+
+void LTAssetManager::SetRenderFrames(uint64_t recordFrame, uint64_t completedFrame)
+{
+    m_RecordFrame.store(recordFrame, std::memory_order_relaxed);
+    m_CompletedFrame.store(completedFrame, std::memory_order_relaxed);
+}
+
+void LTAssetManager::BeginFrame()
+{
+    uint64_t frame = m_CurrentFrame.fetch_add(1, std::memory_order_relaxed) + 1;
+
+    ReleaseRetiredResources(m_CompletedFrame.load(std::memory_order_relaxed));
+    UpdateTextureStreaming(frame);
+}
+
+void LTAssetManager::RequestTextureMip(const LTAssetHandle& textureHandle, uint32_t mip)
+{
+    LTAsset* asset = textureHandle.GetAsset();
+
+    if (!asset || !asset->IsValid())
+    {
+        return;
+    }
+
+    assert(asset->GetAssetType() == LTAssetType::LT_ASSET_TYPE_TEXTURE);
+
+    LTTexture* textureAsset = (LTTexture*)asset;
+    uint32_t lastMip = textureAsset->m_MipCount - 1;
+    mip = mip < lastMip ? mip : lastMip;
+
+    // keep the finest level asked for this frame; an older frame's request is
+    // replaced outright
+    uint64_t frame = m_CurrentFrame.load(std::memory_order_relaxed);
+    uint64_t desired = ((frame + 1) << 8) | mip;
+    uint64_t request = textureAsset->m_MipRequest.load(std::memory_order_relaxed);
+
+    while ((request >> 8) != frame + 1 || (request & 0xFF) > mip)
+    {
+        if (textureAsset->m_MipRequest.compare_exchange_weak(request, desired, std::memory_order_relaxed))
+        {
+            break;
+        }
+    }
+
+    if (mip >= textureAsset->GetResidentMip())
+    {
+        return;
+    }
+
+    // over budget, the tail has to do until UpdateTextureStreaming frees memory
+    {
+        std::scoped_lock lock(m_ResidencyMutex);
+
+        const LTAssetMemory& budget = m_MemoryBudgets[(size_t)LTAssetType::LT_ASSET_TYPE_TEXTURE];
+        const LTAssetMemory& usage = m_MemoryUsage[(size_t)LTAssetType::LT_ASSET_TYPE_TEXTURE];
+
+        if (usage.gpuBytes > budget.gpuBytes)
+        {
+            return;
+        }
+    }
+
+    bool expected = false;
+
+    if (!textureAsset->m_IsStreaming.compare_exchange_strong(expected, true, std::memory_order_acq_rel))
+    {
+        return;
+    }
+
+    LTAssetJob streamJob(textureHandle, LTAssetJobType::LT_ASSET_JOB_TYPE_STREAM, LTAssetPriority::LT_ASSET_PRIORITY_NORMAL);
+    streamJob.streamLevel = mip;
+
+    QueueJob(std::move(streamJob));
+}
+
+void LTAssetManager::RequestModelLOD(const LTAssetHandle& modelHandle, uint32_t lod)
+{
+    LTAsset* asset = modelHandle.GetAsset();
+
+    if (!asset || !asset->IsValid())
+    {
+        return;
+    }
+
+    assert(asset->GetAssetType() == LTAssetType::LT_ASSET_TYPE_MODEL);
+
+    LTModel* modelAsset = (LTModel*)asset;
+
+    // keep the finest level asked for; a model's levels are never trimmed
+    uint32_t requested = modelAsset->m_RequestedLOD.load(std::memory_order_relaxed);
+
+    while (lod < requested)
+    {
+        if (modelAsset->m_RequestedLOD.compare_exchange_weak(requested, lod, std::memory_order_relaxed))
+        {
+            break;
+        }
+    }
+
+    // a load or stream in flight picks the request up when it completes
+    uint32_t residentLOD = modelAsset->GetResidentLOD();
+
+    if (residentLOD == LT_MODEL_NO_LOD || lod >= residentLOD)
+    {
+        return;
+    }
+
+    bool expected = false;
+
+    if (!modelAsset->m_IsStreaming.compare_exchange_strong(expected, true, std::memory_order_acq_rel))
+    {
+        return;
+    }
+
+    LTAssetJob streamJob(modelHandle, LTAssetJobType::LT_ASSET_JOB_TYPE_STREAM, LTAssetPriority::LT_ASSET_PRIORITY_NORMAL);
+    streamJob.streamLevel = residentLOD - 1;
+
+    QueueJob(std::move(streamJob));
+}
+
+void LTAssetManager::UpdateTextureStreaming(uint64_t frame)
+{
+    size_t excessBytes = 0;
+
+    {
+        std::scoped_lock lock(m_ResidencyMutex);
+
+        const LTAssetMemory& budget = m_MemoryBudgets[(size_t)LTAssetType::LT_ASSET_TYPE_TEXTURE];
+        const LTAssetMemory& usage = m_MemoryUsage[(size_t)LTAssetType::LT_ASSET_TYPE_TEXTURE];
+
+        if (usage.gpuBytes <= budget.gpuBytes)
+        {
+            return;
+        }
+
+        excessBytes = usage.gpuBytes - budget.gpuBytes;
+    }
+
+    // a texture holding larger mips than it needs, and when it was last asked for them
+    struct LTTextureTrim
+    {
+        LTTexture* textureAsset;
+        uint32_t wantedMip;
+        uint64_t requestFrame;
+    };
+
+    eastl::vector<LTTextureTrim> trims;
+
+    for (LTAsset* asset : m_Assets)
+    {
+        if (asset->GetAssetType() != LTAssetType::LT_ASSET_TYPE_TEXTURE || !asset->IsValid())
+        {
+            continue;
+        }
+
+        LTTexture* textureAsset = (LTTexture*)asset;
+        uint64_t requestFrame = 0;
+        uint32_t wantedMip = textureAsset->GetWantedMip(frame, requestFrame);
+
+        if (textureAsset->GetResidentMip() < wantedMip)
+        {
+            trims.push_back({ textureAsset, wantedMip, requestFrame });
+        }
+    }
+
+    // the least recently requested mips go first; the oldest is picked out each
+    // time, which only runs while textures are over budget
+    while (excessBytes > 0 && !trims.empty())
+    {
+        size_t oldest = 0;
+
+        for (size_t i = 1; i < trims.size(); ++i)
+        {
+            if (trims[i].requestFrame < trims[oldest].requestFrame)
+            {
+                oldest = i;
+            }
+        }
+
+        LTTextureTrim trim = trims[oldest];
+        trims.erase(trims.begin() + oldest);
+
+        LTTexture* textureAsset = trim.textureAsset;
+        bool expected = false;
+
+        if (!textureAsset->m_IsStreaming.compare_exchange_strong(expected, true, std::memory_order_acq_rel))
+        {
+            continue;
+        }
+
+        // the handle is taken under the residency mutex, so an eviction either
+        // already moved the texture out of the loaded state or sees it referenced
+        LTAssetHandle textureHandle;
+        uint32_t residentMip = textureAsset->GetResidentMip();
+
+        {
+            std::scoped_lock lock(m_ResidencyMutex);
+
+            if (textureAsset->IsValid())
+            {
+                textureHandle = LTAssetHandle(textureAsset);
+            }
+        }
+
+        if (!textureHandle.GetAsset() || residentMip >= trim.wantedMip)
+        {
+            textureAsset->m_IsStreaming.store(false, std::memory_order_release);
+            continue;
+        }
+
+        // the levels dropped are roughly what the smaller image saves
+        size_t trimmedBytes = 0;
+
+        for (uint32_t mip = residentMip; mip < trim.wantedMip; ++mip)
+        {
+            trimmedBytes += (size_t)textureAsset->m_MipSections[mip].size;
+        }
+
+        excessBytes = trimmedBytes < excessBytes ? excessBytes - trimmedBytes : 0;
+
+        LTAssetJob streamJob(textureHandle, LTAssetJobType::LT_ASSET_JOB_TYPE_STREAM, LTAssetPriority::LT_ASSET_PRIORITY_BACKGROUND);
+        streamJob.streamLevel = trim.wantedMip;
+
+        QueueJob(std::move(streamJob));
+    }
+}
+
+void LTAssetManager::RetireImage(VkImage image, LTVKAllocation& imageAllocation, VkImageView imageView)
+{
+    if (image == VK_NULL_HANDLE)
+    {
+        return;
+    }
+
+    LTRetiredResource retired = {};
+    retired.image = image;
+    retired.imageAllocation = imageAllocation;
+    retired.imageView = imageView;
+    retired.retiredFrame = m_RecordFrame.load(std::memory_order_relaxed);
+
+    std::scoped_lock lock(m_RetiredResourcesMutex);
+    m_RetiredResources.push_back(retired);
+}
+
+void LTAssetManager::RetireGeometry(const LTVKGeometryRange& vertexRange, const LTVKGeometryRange& indexRange)
+{
+    if (vertexRange.range == LT_VK_NO_RANGE && indexRange.range == LT_VK_NO_RANGE)
+    {
+        return;
+    }
+
+    LTRetiredResource retired = {};
+    retired.vertexRange = vertexRange;
+    retired.indexRange = indexRange;
+    retired.retiredFrame = m_RecordFrame.load(std::memory_order_relaxed);
+
+    std::scoped_lock lock(m_RetiredResourcesMutex);
+    m_RetiredResources.push_back(retired);
+}
+
+void LTAssetManager::ReleaseRetiredResources(uint64_t completedFrame)
+{
+    VkDevice device = m_LTVKDevice->GetDevice();
+
+    std::scoped_lock lock(m_RetiredResourcesMutex);
+
+    for (size_t i = 0; i < m_RetiredResources.size();)
+    {
+        // the record frame is set once per frame, so a resource retired after the
+        // renderer moved on is tagged a frame early; the frame after it must
+        // complete too
+        if (completedFrame <= m_RetiredResources[i].retiredFrame)
+        {
+            ++i;
+            continue;
+        }
+
+        LTRetiredResource& retired = m_RetiredResources[i];
+
+        if (retired.image != VK_NULL_HANDLE)
+        {
+            vkDestroyImageView(device, retired.imageView, nullptr);
+            m_LTVKDevice->DestroyImage(retired.image, retired.imageAllocation);
+        }
+
+        // empty ranges are ignored
+        LTVKGeometryArena& geometryArena = m_LTVKDevice->GetGeometryArena();
+        geometryArena.FreeVertices(retired.vertexRange);
+        geometryArena.FreeIndices(retired.indexRange);
+
+        m_RetiredResources[i] = m_RetiredResources.back();
+        m_RetiredResources.pop_back();
+    }
+}
+
+void LTAssetManager::DispatchCallback(
+    const LTAssetContinuation& continuation,
+    LTAssetHandle& assetHandle,
+    LTAssetJobResult result)
+{
+    if (continuation.thread == LTAssetCallbackThread::LT_ASSET_CALLBACK_THREAD_WORKER)
+    {
+        continuation.callback(assetHandle, result);
+        return;
+    }
+
+    std::scoped_lock lock(m_MainThreadCallbackMutex);
+    m_MainThreadCallbacks.push_back({ continuation.callback, assetHandle, result });
+}
+
+void LTAssetManager::DispatchMainThreadCallbacks()
+{
+    eastl::vector<LTMainThreadCallback> callbacks;
+
+    {
+        std::scoped_lock lock(m_MainThreadCallbackMutex);
+        callbacks.swap(m_MainThreadCallbacks);
+    }
+
+    for (LTMainThreadCallback& callback : callbacks)
+    {
+        callback.callback(callback.assetHandle, callback.result);
+    }
+}
+
+void LTAssetManager::Destroy()
+{
+    {
+        std::scoped_lock lock(m_AssetMutex);
+        m_IsRunning = false;
+    }
+
+    m_AssetCondition.notify_all();
+
+    for (std::thread* contentThread : m_ContentThreads)
+    {
+        contentThread->join();
+        delete contentThread;
+    }
+
+    m_ContentThreads.clear();
+
+    // drop whatever the workers did not get to, and any callbacks the main
+    // thread did not drain, while the manager can still take their handles back
+    LTAssetJob droppedJob;
+
+    for (LTJobQueue<LTAssetJob>& jobQueue : m_AssetJobs)
+    {
+        while (jobQueue.TryDequeue(droppedJob))
+        {
+        }
+    }
+
+    droppedJob = LTAssetJob();
+
+    {
+        std::scoped_lock lock(m_MainThreadCallbackMutex);
+        m_MainThreadCallbacks.clear();
+    }
+
+    // release everything that is still resident before the device goes away
+    for (LTAsset* asset : m_Assets)
+    {
+        if (asset->IsValid() || asset->IsUnloading())
+        {
+            UnloadAsset_ByType(asset);
+            asset->SetAssetState(LTAssetState::LT_ASSET_STATE_NOT_LOADED);
+        }
+    }
+
+    // no frame is in flight any more, so every retired image and buffer goes too
+    ReleaseRetiredResources(UINT64_MAX);
+
+    std::scoped_lock lock(m_ResidencyMutex);
+
+    m_LRUHead = nullptr;
+    m_LRUTail = nullptr;
+
+    for (LTAsset* asset : m_Assets)
+    {
+        asset->m_LRUPrev = nullptr;
+        asset->m_LRUNext = nullptr;
+        asset->m_IsInLRU = false;
+    }
+
+    for (LTAssetMemory& usage : m_MemoryUsage)
+    {
+        usage = LTAssetMemory();
+    }
+}
+
+void LTAssetManager::ContentThread()
+{
+    s_IsContentThread = true;
+
+    while (m_IsRunning)
+    {
+        LTAssetJob next;
+
+        if (!TryDequeueJob(next))
+        {
+            WaitForJobs();
+            continue;
+        }
+
+        RunJob(next);
+    }
+}
+
+void LTAssetManager::RunJob(LTAssetJob& assetJob)
+{
+    RecordQueueWait(assetJob);
+
+    printf("asset: %s, type: %d \n",
+        assetJob.assetHandle.GetAsset()->GetFileName().c_str(),
+        assetJob.jobType);
+
+    switch (assetJob.jobType)
+    {
+        case LTAssetJobType::LT_ASSET_JOB_TYPE_LOAD:
+        {
+            if (!TryClaimLoad(assetJob))
+            {
+                break;
+            }
+
+            // Load() only queues a job after moving the asset into the
+            // loading state, and only the claimed copy of it runs
+            assert(assetJob.assetHandle.GetAsset()->IsLoading());
+
+            LoadAsset(assetJob);
+            RecordDeadline(assetJob);
+        }
+        break;
+        case LTAssetJobType::LT_ASSET_JOB_TYPE_UNLOAD:
+        {
+            // eviction only queues a job after moving the asset into the
+            // unloading state
+            assert(assetJob.assetHandle.GetAsset()->IsUnloading());
+
+            UnloadAsset(assetJob);
+        }
+        break;
+        case LTAssetJobType::LT_ASSET_JOB_TYPE_STREAM:
+        {
+            // the job's handle keeps the asset referenced once it is queued,
+            // but a texture mip request can race an eviction that already
+            // saw the asset unreferenced; the unload wins and the stream is dropped
+            if (!assetJob.assetHandle.GetAsset()->IsValid())
+            {
+                assetJob.result = LTAssetJobResult::LT_ASSET_JOB_RESULT_FAILURE;
+                CompleteLoadJob(assetJob, false);
+                break;
+            }
+
+            LoadAsset(assetJob);
+        }
+        break;
+    }
+}
+
+bool LTAssetManager::LoadAsset_Shader(
+    LTAssetJob& assetJob,
+    LTContentPayload& payload)
+{
+    LTShader* shaderAsset = (LTShader*)assetJob.assetHandle.GetAsset();
+
+    // shader creation needs the whole module in memory
+    const uint8_t* fileData;
+    size_t fileSize = payload.GetSize();
+
+    if (!payload.GetContiguous(fileData))
+    {
+        assetJob.result = LTAssetJobResult::LT_ASSET_JOB_RESULT_FAILURE;
+        return false;
+    }
+
+    // Vulkan shader creation info
+    VkShaderModuleCreateInfo createInfo = {};
+    createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+    createInfo.codeSize = fileSize;
+    createInfo.pCode = reinterpret_cast<const uint32_t*>(fileData);
+
+    VkDevice device = m_LTVKDevice->GetDevice();
+
+    // create the shader module
+    if (vkCreateShaderModule(
+        device,
+        &createInfo,
+        nullptr,
+        &shaderAsset->GetShaderModule()) != VK_SUCCESS)
+    {
+        assetJob.result = LTAssetJobResult::LT_ASSET_JOB_RESULT_FAILURE;
+        return false;
+    }
+
+    // the driver keeps its own copy of the code; there is no device memory to count
+    shaderAsset->m_CpuBytes = fileSize;
+    shaderAsset->m_GpuBytes = 0;
+
+    assetJob.result = LTAssetJobResult::LT_ASSET_JOB_RESULT_SUCCESS;
+    return true;
+}
+
+bool LTAssetManager::LoadAsset_Model(
+    LTAssetJob& assetJob,
+    LTContentPayload& payload)
+{
+    LTModel* modelAsset = (LTModel*)assetJob.assetHandle.GetAsset();
+
+    // the model was validated when it loaded; a stream only uploads the next level
+    if (assetJob.jobType == LTAssetJobType::LT_ASSET_JOB_TYPE_STREAM)
+    {
+        size_t gpuBytes = 0;
+
+        if (!LoadAsset_ModelLOD(modelAsset, assetJob.streamLevel, payload, gpuBytes))
+        {
+            assetJob.result = LTAssetJobResult::LT_ASSET_JOB_RESULT_FAILURE;
+            return false;
+        }
+
+        assetJob.streamedMemory.cpuBytes = 0;
+        assetJob.streamedMemory.gpuBytes = gpuBytes;
+
+        assetJob.result = LTAssetJobResult::LT_ASSET_JOB_RESULT_SUCCESS;
+        return true;
+    }
+
+    // only the header is needed to validate the model, so decode just that prefix
+    LTModelHeader header;
+    size_t payloadSize = payload.GetSize();
+
+    if (payloadSize < sizeof(LTModelHeader) ||
+        !payload.ReadInto((uint8_t*)&header, sizeof(LTModelHeader)))
+    {
+        assetJob.result = LTAssetJobResult::LT_ASSET_JOB_RESULT_FAILURE;
+        return false;
+    }
+
+    LTModelVertexFormat vertexFormat = (LTModelVertexFormat)header.vertexFormat;
+    size_t lodTableEnd = sizeof(LTModelHeader) + (size_t)header.lodCount * sizeof(LTModelLOD);
+
+    if (header.magic != LT_MODEL_MAGIC ||
+        header.version != LT_MODEL_VERSION ||
+        vertexFormat >= LTModelVertexFormat::LT_MODEL_VERTEX_FORMAT_COUNT ||
+        header.vertexStride != LTVKVertexFormat::GetModelVertexFormat(vertexFormat).binding.stride ||
+        (header.indexSize != sizeof(uint16_t) && header.indexSize != sizeof(uint32_t)) ||
+        header.lodCount == 0 ||
+        header.lodCount > LT_MODEL_MAX_LODS ||
+        lodTableEnd > payloadSize)
+    {
+        assetJob.result = LTAssetJobResult::LT_ASSET_JOB_RESULT_FAILURE;
+        return false;
+    }
+
+    // the level table and the meshlets of every level follow the header, so they
+    // are another prefix decode rather than a read back from a staging buffer
+    eastl::vector<uint8_t> prefix(lodTableEnd);
+
+    if (!payload.ReadInto(prefix.data(), lodTableEnd))
+    {
+        assetJob.result = LTAssetJobResult::LT_ASSET_JOB_RESULT_FAILURE;
+        return false;
+    }
+
+    const LTModelLOD* lodSections = (const LTModelLOD*)(prefix.data() + sizeof(LTModelHeader));
+    size_t meshletsEnd = lodTableEnd;
+
+    for (uint32_t lod = 0; lod < header.lodCount; ++lod)
+    {
+        const LTModelLOD& section = lodSections[lod];
+
+        uint64_t vertexBytes = (uint64_t)section.vertexCount * header.vertexStride;
+        uint64_t indexBytes = (uint64_t)section.indexCount * header.indexSize;
+        uint64_t meshletBytes = (uint64_t)section.meshletCount * sizeof(LTModelMeshlet);
+
+        if (section.vertexCount == 0 ||
+            section.indexCount == 0 ||
+            section.endOffset > payloadSize ||
+            section.vertexOffset > section.endOffset || vertexBytes > section.endOffset - section.vertexOffset ||
+            section.indexOffset > section.endOffset || indexBytes > section.endOffset - section.indexOffset ||
+            section.meshletOffset > payloadSize || meshletBytes > payloadSize - section.meshletOffset)
+        {
+            assetJob.result = LTAssetJobResult::LT_ASSET_JOB_RESULT_FAILURE;
+            return false;
+        }
+
+        size_t sectionMeshletsEnd = (size_t)(section.meshletOffset + meshletBytes);
+        meshletsEnd = sectionMeshletsEnd > meshletsEnd ? sectionMeshletsEnd : meshletsEnd;
+    }
+
+    // copy the table out before the prefix grows to take in the meshlets
+    for (uint32_t lod = 0; lod < header.lodCount; ++lod)
+    {
+        modelAsset->m_LODSections[lod] = lodSections[lod];
+    }
+
+    prefix.resize(meshletsEnd);
+
+    if (!payload.ReadInto(prefix.data(), meshletsEnd))
+    {
+        assetJob.result = LTAssetJobResult::LT_ASSET_JOB_RESULT_FAILURE;
+        return false;
+    }
+
+    modelAsset->m_LODCount = header.lodCount;
+
+    size_t cpuBytes = 0;
+
+    for (uint32_t lod = 0; lod < header.lodCount; ++lod)
+    {
+        const LTModelLOD& section = modelAsset->m_LODSections[lod];
+        const LTModelMeshlet* meshlets = (const LTModelMeshlet*)(prefix.data() + section.meshletOffset);
+
+        for (uint32_t meshletIndex = 0; meshletIndex < section.meshletCount; ++meshletIndex)
+        {
+            const LTModelMeshlet& meshlet = meshlets[meshletIndex];
+
+            if (meshlet.firstIndex > section.indexCount || meshlet.indexCount > section.indexCount - meshlet.firstIndex)
+            {
+                // nothing is uploaded yet, so this only releases the meshlets built so far
+                UnloadAsset_Model(modelAsset);
+
+                assetJob.result = LTAssetJobResult::LT_ASSET_JOB_RESULT_FAILURE;
+                return false;
+            }
+        }
+
+        LTModelMesh& mesh = modelAsset->m_LODs[lod];
+        LTMeshletCulling::BuildMeshlets(meshlets, section.meshletCount, mesh.meshlets);
+        mesh.error = section.error;
+
+        // only the meshlet bounds are kept on the CPU once the buffers are uploaded
+        cpuBytes +=
+            mesh.meshlets.bounds.size() * sizeof(LTMeshletBounds4) +
+            mesh.meshlets.ranges.size() * sizeof(LTMeshletDrawRange);
+    }
+
+    modelAsset->m_IndexType = header.indexSize == sizeof(uint16_t) ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
+    modelAsset->m_VertexFormat = vertexFormat;
+
+    for (uint32_t axis = 0; axis < 3; ++axis)
+    {
+        modelAsset->m_BoundsMin[axis] = header.boundsMin[axis];
+        modelAsset->m_BoundsMax[axis] = header.boundsMax[axis];
+
+        // quantized positions span the bounds; float positions are stored as-is
+        if (vertexFormat == LTModelVertexFormat::LT_MODEL_VERTEX_FORMAT_QUANTIZED)
+        {
+            modelAsset->m_VertexDecode.positionScale[axis] = header.boundsMax[axis] - header.boundsMin[axis];
+            modelAsset->m_VertexDecode.positionOffset[axis] = header.boundsMin[axis];
+        }
+        else
+        {
+            modelAsset->m_VertexDecode.positionScale[axis] = 1.0f;
+            modelAsset->m_VertexDecode.positionOffset[axis] = 0.0f;
+        }
+    }
+
+    // the coarsest level is enough for the model to count as loaded; the finer
+    // ones are streamed in after it
+    uint32_t coarsestLOD = header.lodCount - 1;
+    size_t gpuBytes = 0;
+
+    if (!LoadAsset_ModelLOD(modelAsset, coarsestLOD, payload, gpuBytes))
+    {
+        UnloadAsset_Model(modelAsset);
+
+        assetJob.result = LTAssetJobResult::LT_ASSET_JOB_RESULT_FAILURE;
+        return false;
+    }
+
+    modelAsset->m_CpuBytes = cpuBytes;
+    modelAsset->m_GpuBytes = gpuBytes;
+
+    assetJob.streamLevel = coarsestLOD;
+    assetJob.result = LTAssetJobResult::LT_ASSET_JOB_RESULT_SUCCESS;
+    return true;
+}
+
+bool LTAssetManager::LoadAsset_ModelLOD(
+    LTModel* modelAsset,
+    uint32_t lod,
+    LTContentPayload& payload,
+    size_t& outGpuBytes)
+{
+    const LTModelLOD& section = modelAsset->m_LODSections[lod];
+    LTModelMesh& mesh = modelAsset->m_LODs[lod];
+
+    uint32_t vertexStride = LTVKVertexFormat::GetModelVertexFormat(modelAsset->m_VertexFormat).binding.stride;
+    uint32_t indexSize = modelAsset->m_IndexType == VK_INDEX_TYPE_UINT16 ? sizeof(uint16_t) : sizeof(uint32_t);
+    VkDeviceSize vertexBytes = (VkDeviceSize)section.vertexCount * vertexStride;
+    VkDeviceSize indexBytes = (VkDeviceSize)section.indexCount * indexSize;
+
+    // the baked sections are already in their GPU layout, so the payload is decoded
+    // straight into staging memory and copied into device-local memory from there.
+    // only the prefix up to the end of this level is decoded; the coarser levels
+    // that come before it are small next to it
+    size_t prefixSize = (size_t)section.endOffset;
+
+    LTVKUploadManager& uploadManager = m_LTVKDevice->GetUploadManager();
+    LTVKUpload upload;
+
+    if (!uploadManager.BeginUpload(prefixSize, upload))
+    {
+        return false;
+    }
+
+    if (!payload.ReadInto((uint8_t*)upload.mappedData, prefixSize))
+    {
+        // queueing the upload with no copies releases its staging memory
+        uploadManager.EndUpload(upload);
+        return false;
+    }
+
+    // every level is placed in the device's geometry arena, so the draws of
+    // different models and levels can be issued together
+    LTVKGeometryArena& geometryArena = m_LTVKDevice->GetGeometryArena();
+
+    if (!geometryArena.AllocateVertices(vertexBytes, vertexStride, mesh.vertexRange))
+    {
+        uploadManager.EndUpload(upload);
+        return false;
+    }
+
+    if (!geometryArena.AllocateIndices(indexBytes, indexSize, mesh.indexRange))
+    {
+        geometryArena.FreeVertices(mesh.vertexRange);
+        uploadManager.EndUpload(upload);
+        return false;
+    }
+
+    // the copies are batched with those of the other workers and run on the
+    // transfer queue; only this worker waits for them, rendering carries on
+    uploadManager.CopyToBuffer(upload, section.vertexOffset, geometryArena.GetVertexBuffer(), mesh.vertexRange.offset, vertexBytes);
+    uploadManager.CopyToBuffer(upload, section.indexOffset, geometryArena.GetIndexBuffer(), mesh.indexRange.offset, indexBytes);
+    uploadManager.Wait(uploadManager.EndUpload(upload));
+
+    // the ranges start at a multiple of the stride and of the index size
+    mesh.firstVertex = (int32_t)(mesh.vertexRange.offset / vertexStride);
+    mesh.firstIndex = (uint32_t)(mesh.indexRange.offset / indexSize);
+    mesh.vertexCount = section.vertexCount;
+    mesh.indexCount = section.indexCount;
+
+    // the copies have finished, so the level can be drawn; the release pairs with
+    // the acquire in GetResidentLOD so whoever sees the level sees its ranges
+    modelAsset->m_ResidentLOD.store(lod, std::memory_order_release);
+
+    outGpuBytes = (size_t)(mesh.vertexRange.size + mesh.indexRange.size);
+    return true;
+}
+
+/**
+ * The Vulkan format of each LTTextureFormat, linear and sRGB. BC5 holds data, so
+ * it has no sRGB variant.
+ */
+static const VkFormat s_TextureVkFormats[(uint32_t)LTTextureFormat::LT_TEXTURE_FORMAT_COUNT][2] =
+{
+    { VK_FORMAT_BC1_RGB_UNORM_BLOCK, VK_FORMAT_BC1_RGB_SRGB_BLOCK },
+    { VK_FORMAT_BC3_UNORM_BLOCK, VK_FORMAT_BC3_SRGB_BLOCK },
+    { VK_FORMAT_BC5_UNORM_BLOCK, VK_FORMAT_BC5_UNORM_BLOCK },
+    { VK_FORMAT_BC7_UNORM_BLOCK, VK_FORMAT_BC7_SRGB_BLOCK },
+};
+
+/**
+ * The bytes in one 4x4 block of each LTTextureFormat.
+ */
+static const uint32_t s_TextureBlockBytes[(uint32_t)LTTextureFormat::LT_TEXTURE_FORMAT_COUNT] = { 8, 16, 16, 16 };
+
+bool LTAssetManager::LoadAsset_Texture(
+    LTAssetJob& assetJob,
+    LTContentPayload& payload)
+{
+    LTTexture* textureAsset = (LTTexture*)assetJob.assetHandle.GetAsset();
+
+    // the texture was validated when it loaded; a stream only replaces the image
+    if (assetJob.jobType == LTAssetJobType::LT_ASSET_JOB_TYPE_STREAM)
+    {
+        size_t replacedBytes = (size_t)textureAsset->m_ImageAllocation.size;
+        size_t gpuBytes = 0;
+
+        if (!LoadAsset_TextureMips(textureAsset, assetJob.streamLevel, payload, gpuBytes))
+        {
+            assetJob.result = LTAssetJobResult::LT_ASSET_JOB_RESULT_FAILURE;
+            return false;
+        }
+
+        assetJob.streamedMemory.cpuBytes = 0;
+        assetJob.streamedMemory.gpuBytes = gpuBytes;
+        assetJob.releasedMemory.cpuBytes = 0;
+        assetJob.releasedMemory.gpuBytes = replacedBytes;
+
+        assetJob.result = LTAssetJobResult::LT_ASSET_JOB_RESULT_SUCCESS;
+        return true;
+    }
+
+    // only the header is needed to validate the texture, so decode just that prefix
+    LTTextureHeader header;
+    size_t payloadSize = payload.GetSize();
+
+    if (payloadSize < sizeof(LTTextureHeader) ||
+        !payload.ReadInto((uint8_t*)&header, sizeof(LTTextureHeader)))
+    {
+        assetJob.result = LTAssetJobResult::LT_ASSET_JOB_RESULT_FAILURE;
+        return false;
+    }
+
+    size_t mipTableEnd = sizeof(LTTextureHeader) + (size_t)header.mipCount * sizeof(LTTextureMip);
+
+    if (header.magic != LT_TEXTURE_MAGIC ||
+        header.version != LT_TEXTURE_VERSION ||
+        header.format >= (uint32_t)LTTextureFormat::LT_TEXTURE_FORMAT_COUNT ||
+        header.width == 0 ||
+        header.height == 0 ||
+        header.mipCount == 0 ||
+        header.mipCount > LT_TEXTURE_MAX_MIPS ||
+        mipTableEnd > payloadSize)
+    {
+        assetJob.result = LTAssetJobResult::LT_ASSET_JOB_RESULT_FAILURE;
+        return false;
+    }
+
+    eastl::vector<uint8_t> prefix(mipTableEnd);
+
+    if (!payload.ReadInto(prefix.data(), mipTableEnd))
+    {
+        assetJob.result = LTAssetJobResult::LT_ASSET_JOB_RESULT_FAILURE;
+        return false;
+    }
+
+    const LTTextureMip* mips = (const LTTextureMip*)(prefix.data() + sizeof(LTTextureHeader));
+    uint32_t blockBytes = s_TextureBlockBytes[header.format];
+
+    // streams copy every level from its offset, so each one is checked up front
+    for (uint32_t mip = 0; mip < header.mipCount; ++mip)
+    {
+        const LTTextureMip& level = mips[mip];
+
+        uint32_t expectedWidth = header.width >> mip;
+        uint32_t expectedHeight = header.height >> mip;
+        uint64_t rowPitch = (uint64_t)((level.width + 3) / 4) * blockBytes;
+
+        if (level.width != (expectedWidth > 0 ? expectedWidth : 1) ||
+            level.height != (expectedHeight > 0 ? expectedHeight : 1) ||
+            level.rowPitch != rowPitch ||
+            level.size != rowPitch * ((level.height + 3) / 4) ||
+            level.offset > payloadSize || level.size > payloadSize - level.offset ||
+            (mip > 0 && level.offset + level.size > mips[mip - 1].offset))
+        {
+            assetJob.result = LTAssetJobResult::LT_ASSET_JOB_RESULT_FAILURE;
+            return false;
+        }
+
+        textureAsset->m_MipSections[mip] = level;
+    }
+
+    bool srgb = (header.flags & LT_TEXTURE_FLAG_SRGB) != 0;
+
+    textureAsset->m_Format = s_TextureVkFormats[header.format][srgb ? 1 : 0];
+    textureAsset->m_Width = header.width;
+    textureAsset->m_Height = header.height;
+    textureAsset->m_MipCount = header.mipCount;
+
+    // the tail starts at the first level small enough to always keep
+    uint32_t tailMip = 0;
+
+    while (tailMip + 1 < header.mipCount &&
+        (mips[tailMip].width > LT_TEXTURE_TAIL_SIZE || mips[tailMip].height > LT_TEXTURE_TAIL_SIZE))
+    {
+        ++tailMip;
+    }
+
+    textureAsset->m_TailMip = tailMip;
+
+    size_t gpuBytes = 0;
+
+    if (!LoadAsset_TextureMips(textureAsset, tailMip, payload, gpuBytes))
+    {
+        UnloadAsset_Texture(textureAsset);
+
+        assetJob.result = LTAssetJobResult::LT_ASSET_JOB_RESULT_FAILURE;
+        return false;
+    }
+
+    textureAsset->m_CpuBytes = 0;
+    textureAsset->m_GpuBytes = gpuBytes;
+
+    assetJob.result = LTAssetJobResult::LT_ASSET_JOB_RESULT_SUCCESS;
+    return true;
+}
+
+bool LTAssetManager::LoadAsset_TextureMips(
+    LTTexture* textureAsset,
+    uint32_t firstMip,
+    LTContentPayload& payload,
+    size_t& outGpuBytes)
+{
+    // the levels are stored smallest first, so the payload up to the end of the
+    // first level holds it and every smaller one, laid out as the copies expect;
+    // that prefix is decoded straight into staging memory
+    const LTTextureMip& firstLevel = textureAsset->m_MipSections[firstMip];
+    uint32_t mipCount = textureAsset->m_MipCount - firstMip;
+    size_t dataEnd = (size_t)(firstLevel.offset + firstLevel.size);
+
+    VkDevice device = m_LTVKDevice->GetDevice();
+
+    LTVKUploadManager& uploadManager = m_LTVKDevice->GetUploadManager();
+    LTVKUpload upload;
+
+    if (!uploadManager.BeginUpload(dataEnd, upload))
+    {
+        return false;
+    }
+
+    if (!payload.ReadInto((uint8_t*)upload.mappedData, dataEnd))
     {
-        LTAssetJob* next = nullptr;
+        // queueing the upload with no copies releases its staging memory
+        uploadManager.EndUpload(upload);
+        return false;
+    }
 
-        {
-            std::scoped_lock lock(m_AssetMutex);
+    VkImageCreateInfo imageInfo = {};
+    imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    imageInfo.imageType = VK_IMAGE_TYPE_2D;
+    imageInfo.format = textureAsset->m_Format;
+    imageInfo.extent.width = firstLevel.width;
+    imageInfo.extent.height = firstLevel.height;
+    imageInfo.extent.depth = 1;
+    imageInfo.mipLevels = mipCount;
+    imageInfo.arrayLayers = 1;
+    imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+    imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+    imageInfo.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+    imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
 
-            if (m_AssetJobs.size())
-            {
-                next = &m_AssetJobs.front();
-                m_AssetJobs.pop();
-            }
-        }
+    VkImage image;
+    LTVKAllocation imageAllocation;
 
-        if (!next)
-        {
-            continue;
-        }
+    // out of memory fails the job rather than the worker
+    if (!m_LTVKDevice->TryCreateImageWithInfo(
+        imageInfo,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+        image,
+        imageAllocation))
+    {
+        uploadManager.EndUpload(upload);
+        return false;
+    }
 
-        printf("asset: %s, type: %d \n",
-            next->assetHandle.GetAsset()->GetFileName().c_str(),
-            next->jobType);
+    // every level is copied in the same batch, which also transitions the image
+    // for sampling; only this worker waits for it, rendering carries on
+    VkBufferImageCopy regions[LT_TEXTURE_MAX_MIPS] = {};
 
-        switch (next->jobType)
-        {
-            case LTAssetJobType::LT_ASSET_JOB_TYPE_LOAD:
-            {
-                // an asset could have been finished loading right as the 
-                // load job was being queued; so we reject those jobs here
-                if (next->assetHandle.GetAsset()->GetAssetState() == LTAssetState::LT_ASSET_STATE_LOADED)
-                {
-                    continue;
-                }
+    for (uint32_t mip = 0; mip < mipCount; ++mip)
+    {
+        const LTTextureMip& level = textureAsset->m_MipSections[firstMip + mip];
 
-                LoadAsset(*next);
-            }
-            break;
-        }
+        regions[mip].bufferOffset = level.offset;
+        regions[mip].imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        regions[mip].imageSubresource.mipLevel = mip;
+        regions[mip].imageSubresource.baseArrayLayer = 0;
+        regions[mip].imageSubresource.layerCount = 1;
+        regions[mip].imageExtent = { level.width, level.height, 1 };
     }
-}
 
-bool LTAssetManager::LoadAsset_Shader(
-    LTAssetJob& assetJob,
-    uint8_t* fileBuffer,
-    size_t fileSize)
-{
-    LTShader* shaderAsset = (LTShader*)assetJob.assetHandle.GetAsset();
+    uploadManager.CopyToImage(upload, image, mipCount, regions, mipCount);
+    uploadManager.Wait(uploadManager.EndUpload(upload));
 
-    // Vulkan shader creation info
-    VkShaderModuleCreateInfo createInfo = {};
-    createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-    createInfo.codeSize = fileSize;
-    createInfo.pCode = reinterpret_cast<const uint32_t*>(fileBuffer);
+    VkImageViewCreateInfo viewInfo = {};
+    viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    viewInfo.image = image;
+    viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    viewInfo.format = textureAsset->m_Format;
+    viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    viewInfo.subresourceRange.baseMipLevel = 0;
+    viewInfo.subresourceRange.levelCount = mipCount;
+    viewInfo.subresourceRange.baseArrayLayer = 0;
+    viewInfo.subresourceRange.layerCount = 1;
 
-    VkDevice device = m_LTVKDevice->GetDevice();
+    VkImageView imageView;
 
-    // create the shader module
-    if (vkCreateShaderModule(
-        device,
-        &createInfo,
-        nullptr,
-        &shaderAsset->GetShaderModule()) != VK_SUCCESS)
+    if (vkCreateImageView(device, &viewInfo, nullptr, &imageView) != VK_SUCCESS)
     {
-        assetJob.result = LTAssetJobResult::LT_ASSET_JOB_RESULT_FAILURE;
+        m_LTVKDevice->DestroyImage(image, imageAllocation);
         return false;
     }
 
-    assetJob.result = LTAssetJobResult::LT_ASSET_JOB_RESULT_SUCCESS;
+    // frames already recorded may still sample the image being replaced, so it
+    // is retired rather than destroyed
+    RetireImage(
+        textureAsset->m_Image,
+        textureAsset->m_ImageAllocation,
+        textureAsset->m_ImageView.load(std::memory_order_relaxed));
+
+    textureAsset->m_Image = image;
+    textureAsset->m_ImageAllocation = imageAllocation;
+
+    // the upload has finished; the view is published last, so a reader that
+    // loads the view and then the resident mip never sees an older mip
+    textureAsset->m_ResidentMip.store(firstMip, std::memory_order_release);
+    textureAsset->m_ImageView.store(imageView, std::memory_order_release);
+
+    // the image's memory is what the allocator reserved for it, padding and all
+    outGpuBytes = (size_t)imageAllocation.size;
     return true;
 }
 
 bool LTAssetManager::LoadAsset_ByType(
     LTAssetJob& assetJob,
-    uint8_t* fileBuffer,
-    size_t fileSize)
+    LTContentPayload& payload)
 {
     switch (assetJob.assetHandle.GetAsset()->GetAssetType())
     {
         case LTAssetType::LT_ASSET_TYPE_SHADER:
         {
-            return LoadAsset_Shader(assetJob, fileBuffer, fileSize);
+            return LoadAsset_Shader(assetJob, payload);
+        }
+        case LTAssetType::LT_ASSET_TYPE_TEXTURE:
+        {
+            return LoadAsset_Texture(assetJob, payload);
+        }
+        case LTAssetType::LT_ASSET_TYPE_MODEL:
+        {
+            return LoadAsset_Model(assetJob, payload);
         }
     }
 
@@ -103,26 +1708,81 @@ bool LTAssetManager::LoadAsset_ByType(
 
 bool LTAssetManager::LoadAsset(LTAssetJob& assetJob)
 {
-    // load the asset file
+    LTAsset* asset = assetJob.assetHandle.GetAsset();
+    const LTContentPakEntry& entry = m_ContentPak.GetEntry(asset->GetAssetID());
+    const std::string& fileName = asset->GetFileName();
+
+    // packed assets are read straight out of the archive's mapping
+    const uint8_t* fileData = nullptr;
+    size_t fileSize = 0;
+    size_t uncompressedSize = 0;
+    LTCompressionCodec codec = LTCompressionCodec::LT_COMPRESSION_CODEC_NONE;
+
+    // external assets map their own file, or if it cannot be mapped, read it
+    // into a heap buffer instead
+    LTFileMapping fileMapping;
     std::ifstream file;
-    uint8_t* fileBuffer;
-    size_t fileSize;
+    uint8_t* fileBuffer = nullptr;
+
+    if (entry.flags & LT_CONTENT_PAK_ENTRY_FLAG_EMPTY)
+    {
+        assetJob.result = LTAssetJobResult::LT_ASSET_JOB_RESULT_FAILURE;
+        CompleteLoadJob(assetJob, false);
+        return false;
+    }
+    else if (!(entry.flags & LT_CONTENT_PAK_ENTRY_FLAG_EXTERNAL))
+    {
+        fileData = m_ContentPak.GetPayload(entry);
+        fileSize = (size_t)entry.size;
+        uncompressedSize = (size_t)entry.uncompressedSize;
+        codec = (LTCompressionCodec)entry.codec;
+
+#if LT_CONTENT_VERIFY_HASHES
+        if (LTContentPak::ComputeHash(fileData, fileSize) != entry.hash)
+        {
+            printf("Asset %s does not match its content archive hash.\n", fileName.c_str());
 
-    if (!LoadAsset_File(
-        assetJob.assetHandle.GetAsset()->GetFileName(),
-        file,
-        fileBuffer,
-        fileSize))
+            assetJob.result = LTAssetJobResult::LT_ASSET_JOB_RESULT_FAILURE;
+            CompleteLoadJob(assetJob, false);
+            return false;
+        }
+#endif
+    }
+    else if (m_UseFileMapping && fileMapping.Open(fileName))
+    {
+        fileData = fileMapping.GetData();
+        fileSize = fileMapping.GetSize();
+        uncompressedSize = fileSize;
+    }
+    else if (LoadAsset_File(fileName, file, fileBuffer, fileSize))
+    {
+        fileData = fileBuffer;
+        uncompressedSize = fileSize;
+    }
+    else
     {
         assetJob.result = LTAssetJobResult::LT_ASSET_JOB_RESULT_FAILURE;
+        CompleteLoadJob(assetJob, false);
         return false;
     }
 
-    // load the asset according to its type
-    bool success = LoadAsset_ByType(assetJob, fileBuffer, fileSize);
+    // load the asset according to its type; compressed payloads are decoded
+    // here on the worker, by the type loader
+    LTContentPayload payload(fileData, fileSize, uncompressedSize, codec);
+
+    bool success = LoadAsset_ByType(assetJob, payload);
+
+    // streams decode the same payload again; the stats describe the load
+    if (success && assetJob.jobType == LTAssetJobType::LT_ASSET_JOB_TYPE_LOAD)
+    {
+        RecordDecode(asset, payload);
+    }
 
     // deallocate file buffer
-    eastl::GetDefaultAllocator()->deallocate(fileBuffer, fileSize);
+    if (fileBuffer)
+    {
+        eastl::GetDefaultAllocator()->deallocate(fileBuffer, fileSize);
+    }
 
     // close asset file
     if (file.is_open())
@@ -130,12 +1790,107 @@ bool LTAssetManager::LoadAsset(LTAssetJob& assetJob)
         file.close();
     }
 
-    if (success)
+    fileMapping.Close();
+
+    CompleteLoadJob(assetJob, success);
+
+    return success;
+}
+
+bool LTAssetManager::UnloadAsset(LTAssetJob& assetJob)
+{
+    LTAsset* asset = assetJob.assetHandle.GetAsset();
+
+    // pairs with the fence in Get: either Get sees the asset unloading, or we see
+    // the handle it took and leave the asset loaded
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    // the job's own handle is the only reference an evicted asset may have
+    if (asset->GetRefCount() > 1)
     {
-        assetJob.assetHandle.GetAsset()->SetAssetState(LTAssetState::LT_ASSET_STATE_LOADED);
+        assetJob.result = LTAssetJobResult::LT_ASSET_JOB_RESULT_FAILURE;
+        CompleteUnload(assetJob, false);
+        return false;
     }
 
-    return success;
+    UnloadAsset_ByType(asset);
+
+    assetJob.result = LTAssetJobResult::LT_ASSET_JOB_RESULT_SUCCESS;
+    CompleteUnload(assetJob, true);
+    return true;
+}
+
+void LTAssetManager::UnloadAsset_ByType(LTAsset* asset)
+{
+    switch (asset->GetAssetType())
+    {
+        case LTAssetType::LT_ASSET_TYPE_SHADER:
+        {
+            UnloadAsset_Shader(asset);
+        }
+        break;
+        case LTAssetType::LT_ASSET_TYPE_TEXTURE:
+        {
+            UnloadAsset_Texture(asset);
+        }
+        break;
+        case LTAssetType::LT_ASSET_TYPE_MODEL:
+        {
+            UnloadAsset_Model(asset);
+        }
+        break;
+    }
+}
+
+void LTAssetManager::UnloadAsset_Shader(LTAsset* asset)
+{
+    LTShader* shaderAsset = (LTShader*)asset;
+
+    vkDestroyShaderModule(m_LTVKDevice->GetDevice(), shaderAsset->GetShaderModule(), nullptr);
+    shaderAsset->GetShaderModule() = VK_NULL_HANDLE;
+}
+
+void LTAssetManager::UnloadAsset_Model(LTAsset* asset)
+{
+    LTModel* modelAsset = (LTModel*)asset;
+
+    modelAsset->m_ResidentLOD.store(LT_MODEL_NO_LOD, std::memory_order_release);
+
+    for (uint32_t lod = 0; lod < modelAsset->m_LODCount; ++lod)
+    {
+        LTModelMesh& mesh = modelAsset->m_LODs[lod];
+
+        // frames already recorded may still draw the model
+        RetireGeometry(mesh.vertexRange, mesh.indexRange);
+
+        // assigning an empty mesh also releases the meshlets, which clear() would keep
+        mesh = LTModelMesh();
+    }
+
+    modelAsset->m_LODCount = 0;
+    modelAsset->m_RequestedLOD.store(LT_MODEL_NO_LOD, std::memory_order_relaxed);
+}
+
+void LTAssetManager::UnloadAsset_Texture(LTAsset* asset)
+{
+    LTTexture* textureAsset = (LTTexture*)asset;
+
+    // frames already recorded may still sample the texture
+    RetireImage(
+        textureAsset->m_Image,
+        textureAsset->m_ImageAllocation,
+        textureAsset->m_ImageView.load(std::memory_order_relaxed));
+
+    textureAsset->m_Image = VK_NULL_HANDLE;
+    textureAsset->m_ImageAllocation = LTVKAllocation();
+    textureAsset->m_ImageView.store(VK_NULL_HANDLE, std::memory_order_relaxed);
+    textureAsset->m_Format = VK_FORMAT_UNDEFINED;
+    textureAsset->m_Width = 0;
+    textureAsset->m_Height = 0;
+    textureAsset->m_MipCount = 0;
+    textureAsset->m_TailMip = 0;
+    textureAsset->m_ResidentMip.store(LT_TEXTURE_NO_MIP, std::memory_order_relaxed);
+    textureAsset->m_MipRequest.store(0, std::memory_order_relaxed);
 }
 
 bool LTAssetManager::LoadAsset_File(
@@ -177,81 +1932,90 @@ bool LTAssetManager::LoadAsset_File(
     return true;
 }
 
-static void FetchCsvCell(
-    size_t& start,
-    size_t& end,
-    const std::string& csvLine,
-    const std::string& delimeter,
-    std::string& outCellString)
+/**
+ * Gets the size of the concrete asset class for an asset type.
+ */
+static size_t GetAssetObjectSize(LTAssetType assetType)
 {
-    outCellString = csvLine.substr(start, end - start);
-
-    start = end + delimeter.length();
-    end = csvLine.find(delimeter, end + delimeter.length());
+    switch (assetType)
+    {
+        case LTAssetType::LT_ASSET_TYPE_SHADER:
+            return sizeof(LTShader);
+        case LTAssetType::LT_ASSET_TYPE_TEXTURE:
+            return sizeof(LTTexture);
+        case LTAssetType::LT_ASSET_TYPE_MODEL:
+            return sizeof(LTModel);
+        default:
+            return sizeof(LTAsset);
+    }
 }
 
 void LTAssetManager::InitializeContentLookup()
 {
-    // content lookup file
-    std::ifstream clf("Build/Content/content.csv");
-    std::string csvLine;
-
-    // read each line of the content.csv and create a lookup for
-    // content by ID
-    if (clf.is_open())
+    if (!m_ContentPak.Open("Build/Content/content.pak"))
     {
-        std::string delimeter = ",";
+        printf("Failed to open Build/Content/content.pak. Run BuildContent.py.\n");
+        return;
+    }
 
-        while (getline(clf, csvLine))
-        {
-            size_t start = 0;
-            size_t end = csvLine.find(delimeter);
+    uint32_t entryCount = m_ContentPak.GetEntryCount();
 
-            LTAssetID assetID;
-            LTAssetType assetType;
-            std::string assetPath;
+    // every asset object lives in one arena, so startup is a single allocation
+    constexpr size_t assetAlignment = alignof(std::max_align_t);
+    size_t arenaSize = 0;
+
+    for (uint32_t assetID = 0; assetID < entryCount; ++assetID)
+    {
+        LTAssetType assetType = (LTAssetType)m_ContentPak.GetEntry(assetID).assetType;
+        arenaSize += (GetAssetObjectSize(assetType) + assetAlignment - 1) & ~(assetAlignment - 1);
+    }
 
-            LTAsset* asset = (LTAsset*)eastl::GetDefaultAllocator()->allocate(sizeof(LTAsset));
+    uint8_t* arena = (uint8_t*)eastl::GetDefaultAllocator()->allocate(arenaSize, assetAlignment, 0);
+    size_t arenaOffset = 0;
 
-            m_Assets.push_back(asset);
+    m_Assets.reserve(entryCount);
+    m_DecodeStats.resize(entryCount);
 
-            std::string cellString;
+    // the table of contents is indexed by asset id, so entries map straight onto m_Assets
+    for (uint32_t assetID = 0; assetID < entryCount; ++assetID)
+    {
+        const LTContentPakEntry& entry = m_ContentPak.GetEntry(assetID);
 
-            // asset id
-            FetchCsvCell(start, end, csvLine, delimeter, cellString);
-            assetID = std::stoi(cellString);
+        LTAssetType assetType = (LTAssetType)entry.assetType;
+        std::string assetPath = m_ContentPak.GetName(entry);
 
-            // asset path
-            FetchCsvCell(start, end, csvLine, delimeter, cellString);
-            assetPath = cellString;
+        void* storage = arena + arenaOffset;
+        arenaOffset += (GetAssetObjectSize(assetType) + assetAlignment - 1) & ~(assetAlignment - 1);
 
-            // asset type
-            FetchCsvCell(start, end, csvLine, delimeter, cellString);
-            assetType = (LTAssetType)std::stoi(cellString);
+        LTAsset* asset = nullptr;
 
-            switch (assetType)
+        // the storage must be sized for the concrete asset type, not the base class
+        switch (assetType)
+        {
+            case LTAssetType::LT_ASSET_TYPE_SHADER:
             {
-                case LTAssetType::LT_ASSET_TYPE_SHADER:
-                {
-                    new(asset) LTShader(assetID, assetPath);
-                }
-                break;
-                case LTAssetType::LT_ASSET_TYPE_TEXTURE:
-                {
-                    new(asset) LTTexture(assetID, assetPath);
-                }
-                break;
-                case LTAssetType::LT_ASSET_TYPE_MODEL:
-                {
-                    new(asset) LTModel(assetID, assetPath);
-                }
-                break;
-                case LTAssetType::LT_ASSET_TYPE_UNKNOWN: break;
-                default: break;
+                asset = new(storage) LTShader(assetID, assetPath);
+            }
+            break;
+            case LTAssetType::LT_ASSET_TYPE_TEXTURE:
+            {
+                asset = new(storage) LTTexture(assetID, assetPath);
+            }
+            break;
+            case LTAssetType::LT_ASSET_TYPE_MODEL:
+            {
+                asset = new(storage) LTModel(assetID, assetPath);
+            }
+            break;
+            case LTAssetType::LT_ASSET_TYPE_UNKNOWN:
+            default:
+            {
+                asset = new(storage) LTAsset(assetID, assetType, assetPath);
             }
+            break;
         }
 
-        clf.close();
+        m_Assets.push_back(asset);
     }
 }
 
@@ -263,10 +2027,17 @@ bool LTAssetManager::Get(LTAssetID assetID, LTAssetHandle& outAssetHandle)
 
     outAssetHandle = asset;
 
+    // pairs with the fence in UnloadAsset: either the unload sees our reference
+    // and is cancelled, or we see the asset unloading and report it as not loaded
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
     return asset->GetAssetState() == LTAssetState::LT_ASSET_STATE_LOADED;
 }
 
-bool LTAssetManager::Load(LTAssetHandle& assetHandle)
+bool LTAssetManager::Load(
+    LTAssetHandle& assetHandle,
+    LTAssetPriority priority,
+    uint64_t deadlineFrame)
 {
     // if the asset has already been loaded, early out
     if (assetHandle.GetAsset()->GetAssetState() == LTAssetState::LT_ASSET_STATE_LOADED)
@@ -274,18 +2045,241 @@ bool LTAssetManager::Load(LTAssetHandle& assetHandle)
         return true;
     }
 
-    // lock for queuing jobs
-    std::scoped_lock lock(m_AssetMutex);
+    // beginning, promoting and re-requesting a load are decided under the
+    // continuation mutex, so they cannot race the load or an unload finishing
+    LTAssetLoadToken loadToken;
+    return Load(assetHandle, loadToken, priority, deadlineFrame);
+}
+
+bool LTAssetManager::Load(
+    LTAssetHandle& assetHandle,
+    LTAssetLoadToken& outToken,
+    LTAssetPriority priority,
+    uint64_t deadlineFrame)
+{
+    LTAsset* asset = assetHandle.GetAsset();
+
+    // if the asset has already been loaded, hand back a token that is already complete
+    if (asset->GetAssetState() == LTAssetState::LT_ASSET_STATE_LOADED)
+    {
+        outToken = LTAssetLoadToken(assetHandle, asset->m_LoadGeneration.load(std::memory_order_acquire));
+        return true;
+    }
+
+    bool queueLoad = false;
+    uint32_t generation;
+
+    priority = GetLoadPriority(priority, deadlineFrame);
+
+    {
+        // load and unload completion happen under this lock too, so the state and
+        // generation read here are consistent: anything but LOADED completes at the
+        // next generation
+        std::scoped_lock lock(m_ContinuationMutex);
+
+        generation = asset->m_LoadGeneration.load(std::memory_order_relaxed);
+
+        switch (asset->GetAssetState())
+        {
+            case LTAssetState::LT_ASSET_STATE_LOADED:
+            {
+                // the caller's handle keeps an eviction that starts now from going through
+                outToken = LTAssetLoadToken(assetHandle, generation);
+                return true;
+            }
+            case LTAssetState::LT_ASSET_STATE_UNLOADING:
+            {
+                // the reload runs at the most urgent priority requested
+                if (!asset->m_ReloadRequested || priority < asset->m_ReloadPriority)
+                {
+                    asset->m_ReloadPriority = priority;
+                }
+
+                asset->m_ReloadRequested = true;
+            }
+            break;
+            case LTAssetState::LT_ASSET_STATE_NOT_LOADED:
+            {
+                // can only fail if another caller just began the load
+                queueLoad = asset->TryBeginLoad();
+
+                if (queueLoad)
+                {
+                    asset->m_LoadPriority = priority;
+                    asset->m_LoadDeadline = deadlineFrame;
+                    asset->m_IsLoadClaimed = false;
+                }
+            }
+            break;
+            case LTAssetState::LT_ASSET_STATE_LOADING:
+            {
+                // the load is already queued; until a worker takes it, an earlier
+                // deadline moves it up and a more urgent request queues it again
+                // in the faster queue, where the first copy taken runs the load
+                if (asset->m_IsLoadClaimed)
+                {
+                    break;
+                }
+
+                if (deadlineFrame != LT_ASSET_NO_DEADLINE
+                    && (asset->m_LoadDeadline == LT_ASSET_NO_DEADLINE || deadlineFrame < asset->m_LoadDeadline))
+                {
+                    asset->m_LoadDeadline = deadlineFrame;
+                }
+
+                if (priority < asset->m_LoadPriority)
+                {
+                    asset->m_LoadPriority = priority;
+                    queueLoad = true;
+                    m_LoadPromotionCount.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+            break;
+        }
+
+        outToken = LTAssetLoadToken(assetHandle, generation + 1);
+    }
+
+    if (queueLoad)
+    {
+        QueueLoad(assetHandle, generation);
+    }
+
+    return true;
+}
+
+LTAssetPriority LTAssetManager::GetLoadPriority(LTAssetPriority priority, uint64_t deadlineFrame)
+{
+    // a load that is needed by the next frame cannot wait behind anything else
+    if (deadlineFrame != LT_ASSET_NO_DEADLINE && deadlineFrame <= GetCurrentFrame() + 1)
+    {
+        return LTAssetPriority::LT_ASSET_PRIORITY_CRITICAL;
+    }
+
+    return priority;
+}
+
+void LTAssetManager::QueueLoad(LTAssetHandle& assetHandle, uint32_t loadGeneration)
+{
+    LTAsset* asset = assetHandle.GetAsset();
+    LTAssetPriority priority;
+    uint64_t deadlineFrame;
+
+    {
+        std::scoped_lock lock(m_ContinuationMutex);
+        priority = asset->m_LoadPriority;
+        deadlineFrame = asset->m_LoadDeadline;
+    }
 
     // queue up load asset job
-    m_AssetJobs.push(LTAssetJob(assetHandle, LTAssetJobType::LT_ASSET_JOB_TYPE_LOAD));
+    LTAssetJob loadJob(
+        assetHandle,
+        LTAssetJobType::LT_ASSET_JOB_TYPE_LOAD,
+        priority,
+        deadlineFrame);
+    loadJob.loadGeneration = loadGeneration;
+
+    QueueJob(std::move(loadJob));
+}
+
+bool LTAssetManager::TryClaimLoad(LTAssetJob& assetJob)
+{
+    LTAsset* asset = assetJob.assetHandle.GetAsset();
+
+    std::scoped_lock lock(m_ContinuationMutex);
+
+    // the load this copy was queued for has completed, or another copy runs it
+    if (asset->m_LoadGeneration.load(std::memory_order_relaxed) != assetJob.loadGeneration
+        || asset->m_IsLoadClaimed)
+    {
+        return false;
+    }
+
+    asset->m_IsLoadClaimed = true;
+    assetJob.deadlineFrame = asset->m_LoadDeadline;
 
     return true;
 }
 
-bool LTAssetManager::GetLoad(LTAssetID assetID, LTAssetHandle& outAssetHandle)
+bool LTAssetManager::GetLoad(
+    LTAssetID assetID,
+    LTAssetHandle& outAssetHandle,
+    LTAssetPriority priority,
+    uint64_t deadlineFrame)
+{
+    return Get(assetID, outAssetHandle) || Load(outAssetHandle, priority, deadlineFrame);
+}
+
+bool LTAssetManager::GetLoad(
+    LTAssetID assetID,
+    LTAssetHandle& outAssetHandle,
+    LTAssetLoadToken& outToken,
+    LTAssetPriority priority,
+    uint64_t deadlineFrame)
+{
+    Get(assetID, outAssetHandle);
+    return Load(outAssetHandle, outToken, priority, deadlineFrame);
+}
+
+LTAssetJobResult LTAssetLoadToken::GetResult() const
+{
+    if (!IsComplete())
+    {
+        return LTAssetJobResult::LT_ASSET_JOB_RESULT_NONE;
+    }
+
+    return m_AssetHandle.GetAsset()->IsValid()
+        ? LTAssetJobResult::LT_ASSET_JOB_RESULT_SUCCESS
+        : LTAssetJobResult::LT_ASSET_JOB_RESULT_FAILURE;
+}
+
+bool LTAssetLoadToken::Wait(std::chrono::milliseconds timeout) const
+{
+    if (IsComplete())
+    {
+        return true;
+    }
+
+    if (!m_AssetHandle.GetAsset())
+    {
+        return false;
+    }
+
+    LTAssetManager& manager = LTAssetManager::GetInstance();
+    std::unique_lock lock(manager.m_ContinuationMutex);
+
+    return manager.m_LoadCompleteCondition.wait_for(lock, timeout, [this]()
+    {
+        return IsComplete();
+    });
+}
+
+void LTAssetLoadToken::Then(LTAssetCallback callback, LTAssetCallbackThread thread) const
 {
-    return Get(assetID, outAssetHandle) || Load(outAssetHandle);
+    LTAsset* asset = m_AssetHandle.GetAsset();
+
+    if (!asset)
+    {
+        return;
+    }
+
+    LTAssetManager& manager = LTAssetManager::GetInstance();
+    LTAssetContinuation continuation = { std::move(callback), thread };
+
+    {
+        // registering under the continuation mutex means the load either has not
+        // completed yet (and will run the continuation) or has (and we run it here)
+        std::scoped_lock lock(manager.m_ContinuationMutex);
+
+        if (!IsComplete())
+        {
+            asset->m_Continuations.push_back(std::move(continuation));
+            return;
+        }
+    }
+
+    LTAssetHandle assetHandle = m_AssetHandle;
+    manager.DispatchCallback(continuation, assetHandle, GetResult());
 }
 
 VkShaderModule& LTShader::GetShaderModule()
@@ -0,0 +1,158 @@
+#include "PrecompiledHeader.h"
+#include "LTCompression.h"
+
+#include <cstring>
+
+bool LTCompression::Decompress(
+    LTCompressionCodec codec,
+    const uint8_t* source,
+    size_t sourceSize,
+    uint8_t* destination,
+    size_t destinationSize)
+{
+    switch (codec)
+    {
+        case LTCompressionCodec::LT_COMPRESSION_CODEC_NONE:
+        {
+            if (sourceSize < destinationSize)
+            {
+                return false;
+            }
+
+            memcpy(destination, source, destinationSize);
+            return true;
+        }
+        case LTCompressionCodec::LT_COMPRESSION_CODEC_LZ4:
+        {
+            return DecompressLZ4(source, sourceSize, destination, destinationSize);
+        }
+        default:
+        {
+            // a corrupted codec
+            return false;
+        }
+    }
+}
+
+const char* LTCompression::GetCodecName(LTCompressionCodec codec)
+{
+    switch (codec)
+    {
+        case LTCompressionCodec::LT_COMPRESSION_CODEC_NONE:
+            return "none";
+        case LTCompressionCodec::LT_COMPRESSION_CODEC_LZ4:
+            return "lz4";
+        default:
+            return "unknown";
+    }
+}
+
+bool LTCompression::DecompressLZ4(
+    const uint8_t* source,
+    size_t sourceSize,
+    uint8_t* destination,
+    size_t destinationSize)
+{
+    const uint8_t* in = source;
+    const uint8_t* inEnd = source + sourceSize;
+    uint8_t* out = destination;
+    uint8_t* outEnd = destination + destinationSize;
+
+    // every sequence is a token, literals, then a back-reference; the last
+    // sequence is literals only
+    while (in < inEnd && out < outEnd)
+    {
+        uint8_t token = *in++;
+
+        // literal length, extended by 255-valued bytes when the nibble is saturated
+        size_t literalLength = token >> 4;
+
+        if (literalLength == 15)
+        {
+            uint8_t extra;
+
+            do
+            {
+                if (in >= inEnd)
+                {
+                    return false;
+                }
+
+                extra = *in++;
+                literalLength += extra;
+            } while (extra == 255);
+        }
+
+        if (literalLength > (size_t)(inEnd - in))
+        {
+            return false;
+        }
+
+        // a prefix decode may end inside the literals
+        size_t literalCopy = literalLength < (size_t)(outEnd - out) ? literalLength : (size_t)(outEnd - out);
+        memcpy(out, in, literalCopy);
+
+        in += literalLength;
+        out += literalCopy;
+
+        if (in >= inEnd || out >= outEnd)
+        {
+            break;
+        }
+
+        // back-reference into the already decoded output
+        if (inEnd - in < 2)
+        {
+            return false;
+        }
+
+        size_t offset = (size_t)in[0] | ((size_t)in[1] << 8);
+        in += 2;
+
+        if (offset == 0 || offset > (size_t)(out - destination))
+        {
+            return false;
+        }
+
+        size_t matchLength = (token & 0xF) + 4;
+
+        if ((token & 0xF) == 15)
+        {
+            uint8_t extra;
+
+            do
+            {
+                if (in >= inEnd)
+                {
+                    return false;
+                }
+
+                extra = *in++;
+                matchLength += extra;
+            } while (extra == 255);
+        }
+
+        if (matchLength > (size_t)(outEnd - out))
+        {
+            matchLength = (size_t)(outEnd - out);
+        }
+
+        const uint8_t* match = out - offset;
+
+        if (offset >= matchLength)
+        {
+            memcpy(out, match, matchLength);
+            out += matchLength;
+        }
+        else
+        {
+            // overlapping copies repeat the last 'offset' bytes, so go a byte at a time
+            for (size_t i = 0; i < matchLength; ++i)
+            {
+                *out++ = *match++;
+            }
+        }
+    }
+
+    return out == outEnd;
+}
@@ -0,0 +1,164 @@
+#include "PrecompiledHeader.h"
+#include "LTContentPak.h"
+
+bool LTContentPak::Open(const std::string& fileName)
+{
+    Close();
+
+    if (!m_FileMapping.Open(fileName))
+    {
+        return false;
+    }
+
+    const uint8_t* data = m_FileMapping.GetData();
+    size_t size = m_FileMapping.GetSize();
+
+    if (size < sizeof(LTContentPakHeader))
+    {
+        Close();
+        return false;
+    }
+
+    const LTContentPakHeader* header = (const LTContentPakHeader*)data;
+
+    if (header->magic != LT_CONTENT_PAK_MAGIC || header->version != LT_CONTENT_PAK_VERSION)
+    {
+        printf("Content archive %s has an unsupported format. Rebuild content.\n", fileName.c_str());
+        Close();
+        return false;
+    }
+
+    // everything the entries point at must be inside the mapping, so the
+    // loaders never need to bounds check
+    uint64_t entriesEnd = sizeof(LTContentPakHeader) + (uint64_t)header->entryCount * sizeof(LTContentPakEntry);
+
+    if (entriesEnd > size
+        || header->stringTableOffset < entriesEnd
+        || header->stringTableOffset + header->stringTableSize > size)
+    {
+        Close();
+        return false;
+    }
+
+    const LTContentPakEntry* entries = (const LTContentPakEntry*)(data + sizeof(LTContentPakHeader));
+
+    for (uint32_t i = 0; i < header->entryCount; ++i)
+    {
+        const LTContentPakEntry& entry = entries[i];
+
+        bool payloadInBounds = (entry.flags & LT_CONTENT_PAK_ENTRY_FLAG_EXTERNAL)
+            || (entry.offset <= size && entry.size <= size - entry.offset);
+
+        if (entry.assetID != i
+            || !payloadInBounds
+            || entry.codec >= (uint32_t)LTCompressionCodec::LT_COMPRESSION_CODEC_COUNT
+            || (uint64_t)entry.nameOffset + entry.nameLength > header->stringTableSize)
+        {
+            printf("Content archive %s has a corrupt entry (%u).\n", fileName.c_str(), i);
+            Close();
+            return false;
+        }
+    }
+
+    m_Header = header;
+    m_Entries = entries;
+    m_StringTable = (const char*)(data + header->stringTableOffset);
+
+    return true;
+}
+
+void LTContentPak::Close()
+{
+    m_FileMapping.Close();
+
+    m_Header = nullptr;
+    m_Entries = nullptr;
+    m_StringTable = nullptr;
+}
+
+uint32_t LTContentPak::ComputeHash(const uint8_t* data, size_t size)
+{
+    // the reflected CRC-32 used by zlib, so BuildContent.py can use zlib.crc32
+    static const eastl::vector<uint32_t> table = []()
+    {
+        eastl::vector<uint32_t> crcTable(256);
+
+        for (uint32_t i = 0; i < 256; ++i)
+        {
+            uint32_t crc = i;
+
+            for (int bit = 0; bit < 8; ++bit)
+            {
+                crc = (crc & 1) ? (crc >> 1) ^ 0xEDB88320u : crc >> 1;
+            }
+
+            crcTable[i] = crc;
+        }
+
+        return crcTable;
+    }();
+
+    uint32_t crc = 0xFFFFFFFFu;
+
+    for (size_t i = 0; i < size; ++i)
+    {
+        crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+
+    return crc ^ 0xFFFFFFFFu;
+}
+
+LTContentPayload::~LTContentPayload()
+{
+    if (m_DecodedData)
+    {
+        eastl::GetDefaultAllocator()->deallocate(m_DecodedData, m_Size);
+    }
+}
+
+bool LTContentPayload::ReadInto(uint8_t* destination, size_t size)
+{
+    assert(size <= m_Size);
+
+    auto start = std::chrono::steady_clock::now();
+
+    bool success = LTCompression::Decompress(m_Codec, m_StoredData, m_StoredSize, destination, size);
+
+    if (m_Codec != LTCompressionCodec::LT_COMPRESSION_CODEC_NONE)
+    {
+        m_DecodeNs += (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count();
+    }
+
+    return success;
+}
+
+bool LTContentPayload::GetContiguous(const uint8_t*& outData)
+{
+    if (m_Codec == LTCompressionCodec::LT_COMPRESSION_CODEC_NONE)
+    {
+        outData = m_StoredData;
+        return true;
+    }
+
+    if (!m_DecodedData)
+    {
+        m_DecodedData = (uint8_t*)eastl::GetDefaultAllocator()->allocate(m_Size);
+
+        if (!m_DecodedData)
+        {
+            return false;
+        }
+
+        // a partly decoded buffer must not be handed out by a later call
+        if (!ReadInto(m_DecodedData, m_Size))
+        {
+            eastl::GetDefaultAllocator()->deallocate(m_DecodedData, m_Size);
+            m_DecodedData = nullptr;
+            return false;
+        }
+    }
+
+    outData = m_DecodedData;
+    return true;
+}
@@ -0,0 +1,150 @@
+#include "PrecompiledHeader.h"
+#include "LTFileMapping.h"
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(_WIN32)
+
+bool LTFileMapping::Open(const std::string& fileName)
+{
+    Close();
+
+    // assets are read front to back once, so tell the cache manager to read ahead
+    HANDLE fileHandle = CreateFileA(
+        fileName.c_str(),
+        GENERIC_READ,
+        FILE_SHARE_READ,
+        nullptr,
+        OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN,
+        nullptr);
+
+    if (fileHandle == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+
+    LARGE_INTEGER fileSize;
+
+    // mapping an empty file fails, so report it the same way as the ifstream path
+    if (!GetFileSizeEx(fileHandle, &fileSize) || fileSize.QuadPart <= 0)
+    {
+        CloseHandle(fileHandle);
+        return false;
+    }
+
+    HANDLE mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+    if (!mappingHandle)
+    {
+        CloseHandle(fileHandle);
+        return false;
+    }
+
+    void* view = MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0);
+
+    if (!view)
+    {
+        CloseHandle(mappingHandle);
+        CloseHandle(fileHandle);
+        return false;
+    }
+
+    m_FileHandle = fileHandle;
+    m_MappingHandle = mappingHandle;
+    m_Data = (const uint8_t*)view;
+    m_Size = (size_t)fileSize.QuadPart;
+
+    return true;
+}
+
+void LTFileMapping::Close()
+{
+    if (m_Data)
+    {
+        UnmapViewOfFile(m_Data);
+    }
+
+    if (m_MappingHandle)
+    {
+        CloseHandle(m_MappingHandle);
+    }
+
+    if (m_FileHandle)
+    {
+        CloseHandle(m_FileHandle);
+    }
+
+    m_Data = nullptr;
+    m_Size = 0;
+    m_FileHandle = nullptr;
+    m_MappingHandle = nullptr;
+}
+
+#else
+
+bool LTFileMapping::Open(const std::string& fileName)
+{
+    Close();
+
+    int fileDescriptor = open(fileName.c_str(), O_RDONLY);
+
+    if (fileDescriptor < 0)
+    {
+        return false;
+    }
+
+    struct stat fileStat;
+
+    // mapping an empty file fails, so report it the same way as the ifstream path
+    if (fstat(fileDescriptor, &fileStat) != 0 || fileStat.st_size <= 0)
+    {
+        close(fileDescriptor);
+        return false;
+    }
+
+    void* view = mmap(nullptr, (size_t)fileStat.st_size, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+
+    if (view == MAP_FAILED)
+    {
+        close(fileDescriptor);
+        return false;
+    }
+
+    // assets are read front to back once, so ask the kernel to read ahead
+    madvise(view, (size_t)fileStat.st_size, MADV_SEQUENTIAL);
+
+    m_FileDescriptor = fileDescriptor;
+    m_Data = (const uint8_t*)view;
+    m_Size = (size_t)fileStat.st_size;
+
+    return true;
+}
+
+void LTFileMapping::Close()
+{
+    if (m_Data)
+    {
+        munmap((void*)m_Data, m_Size);
+    }
+
+    if (m_FileDescriptor >= 0)
+    {
+        close(m_FileDescriptor);
+    }
+
+    m_Data = nullptr;
+    m_Size = 0;
+    m_FileDescriptor = -1;
+}
+
+#endif
@@ -15,6 +15,17 @@ void LTGameWindow::Initialize()
         m_Title.c_str(),
         nullptr,
         nullptr);
+
+    // the framebuffer can be larger than the window on high DPI displays
+    int width = 0;
+    int height = 0;
+    glfwGetFramebufferSize(m_Window, &width, &height);
+
+    m_Width = (uint32_t)width;
+    m_Height = (uint32_t)height;
+
+    glfwSetWindowUserPointer(m_Window, this);
+    glfwSetFramebufferSizeCallback(m_Window, &LTGameWindow::OnFramebufferResized);
 }
 
 void LTGameWindow::Update()
@@ -28,6 +39,15 @@ void LTGameWindow::Destroy()
     glfwTerminate();
 }
 
+void LTGameWindow::OnFramebufferResized(GLFWwindow* window, int width, int height)
+{
+    LTGameWindow* gameWindow = (LTGameWindow*)glfwGetWindowUserPointer(window);
+
+    gameWindow->m_Width = (uint32_t)width;
+    gameWindow->m_Height = (uint32_t)height;
+    gameWindow->m_WasResized = true;
+}
+
 bool LTGameWindow::CreateWindowSurfaceVK(VkInstance vkInstance, VkSurfaceKHR* surface)
 {
     return glfwCreateWindowSurface(vkInstance, m_Window, nullptr, surface) == VK_SUCCESS;
@@ -0,0 +1,223 @@
+#include "PrecompiledHeader.h"
+#include "LTJobQueueBenchmark.h"
+#include "LTJobQueue.h"
+#include "LTAsset.h"
+
+/**
+ * The total number of jobs pushed through the queue in each phase.
+ */
+constexpr size_t LT_BENCHMARK_JOB_COUNT = 1 << 20;
+
+/**
+ * The thread counts the benchmark is run at.
+ */
+constexpr uint32_t LT_BENCHMARK_THREAD_COUNTS[] = { 1, 4, 16 };
+
+/**
+ * The queue that LTAssetManager used before LTJobQueue: an eastl::queue
+ * guarded by a std::mutex. Exposes the same Try* interface for comparison.
+ */
+class LTMutexJobQueue
+{
+private:
+    eastl::queue<LTAssetJob> m_Jobs;
+    std::mutex m_Mutex;
+
+public:
+    bool TryEnqueue(const LTAssetJob& assetJob)
+    {
+        std::scoped_lock lock(m_Mutex);
+        m_Jobs.push(assetJob);
+        return true;
+    }
+
+    bool TryDequeue(LTAssetJob& outAssetJob)
+    {
+        std::scoped_lock lock(m_Mutex);
+
+        if (m_Jobs.empty())
+        {
+            return false;
+        }
+
+        outAssetJob = m_Jobs.front();
+        m_Jobs.pop();
+        return true;
+    }
+};
+
+/**
+ * Runs 'function' on 'threadCount' threads that are released at the same time,
+ * and returns the wall time in seconds until all of them finish.
+ */
+template <typename Function>
+static double RunTimedPhase(uint32_t threadCount, Function function)
+{
+    std::atomic<bool> start(false);
+    eastl::vector<std::thread*> threads;
+
+    for (uint32_t i = 0; i < threadCount; ++i)
+    {
+        threads.push_back(new std::thread([&start, &function, i]()
+        {
+            while (!start.load(std::memory_order_acquire))
+            {
+                std::this_thread::yield();
+            }
+
+            function(i);
+        }));
+    }
+
+    auto begin = std::chrono::high_resolution_clock::now();
+    start.store(true, std::memory_order_release);
+
+    for (std::thread* thread : threads)
+    {
+        thread->join();
+        delete thread;
+    }
+
+    auto end = std::chrono::high_resolution_clock::now();
+
+    return std::chrono::duration<double>(end - begin).count();
+}
+
+/**
+ * Fills and then drains the queue with 'threadCount' producers and then
+ * 'threadCount' consumers, printing the throughput of each phase.
+ */
+template <typename Queue>
+static void BenchmarkQueue(const char* name, Queue& queue, uint32_t threadCount)
+{
+    size_t jobsPerThread = LT_BENCHMARK_JOB_COUNT / threadCount;
+
+    double enqueueSeconds = RunTimedPhase(threadCount, [&queue, jobsPerThread](uint32_t)
+    {
+        LTAssetJob assetJob(LTAssetHandle(), LTAssetJobType::LT_ASSET_JOB_TYPE_LOAD);
+
+        for (size_t i = 0; i < jobsPerThread; ++i)
+        {
+            while (!queue.TryEnqueue(assetJob))
+            {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    double dequeueSeconds = RunTimedPhase(threadCount, [&queue, jobsPerThread](uint32_t)
+    {
+        LTAssetJob assetJob;
+
+        for (size_t i = 0; i < jobsPerThread; ++i)
+        {
+            while (!queue.TryDequeue(assetJob))
+            {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    double jobCount = (double)(jobsPerThread * threadCount);
+
+    printf("%-12s threads: %2u  enqueue: %8.2f Mops/s  dequeue: %8.2f Mops/s\n",
+        name,
+        threadCount,
+        jobCount / enqueueSeconds / 1e6,
+        jobCount / dequeueSeconds / 1e6);
+}
+
+/**
+ * Pushes the jobs through the queue with 'threadCount' producers and 'threadCount'
+ * consumers running at the same time, as the asset workers do, and prints the
+ * throughput. Producers that find the queue full and consumers that find it empty
+ * yield and retry, so a queue smaller than the job count is full or empty for
+ * part of the run.
+ */
+template <typename Queue>
+static void BenchmarkConcurrent(const char* name, Queue& queue, uint32_t threadCount)
+{
+    size_t jobsPerThread = LT_BENCHMARK_JOB_COUNT / threadCount;
+
+    std::atomic<uint64_t> fullRetries(0);
+    std::atomic<uint64_t> emptyRetries(0);
+
+    double seconds = RunTimedPhase(threadCount * 2, [&queue, &fullRetries, &emptyRetries, jobsPerThread, threadCount](uint32_t threadIndex)
+    {
+        uint64_t retries = 0;
+
+        if (threadIndex < threadCount)
+        {
+            LTAssetJob assetJob(LTAssetHandle(), LTAssetJobType::LT_ASSET_JOB_TYPE_LOAD);
+
+            for (size_t i = 0; i < jobsPerThread; ++i)
+            {
+                while (!queue.TryEnqueue(assetJob))
+                {
+                    retries++;
+                    std::this_thread::yield();
+                }
+            }
+
+            fullRetries.fetch_add(retries, std::memory_order_relaxed);
+        }
+        else
+        {
+            LTAssetJob assetJob;
+
+            for (size_t i = 0; i < jobsPerThread; ++i)
+            {
+                while (!queue.TryDequeue(assetJob))
+                {
+                    retries++;
+                    std::this_thread::yield();
+                }
+            }
+
+            emptyRetries.fetch_add(retries, std::memory_order_relaxed);
+        }
+    });
+
+    double jobCount = (double)(jobsPerThread * threadCount);
+
+    printf("%-12s producers: %2u  consumers: %2u  concurrent: %8.2f Mops/s  full retries: %llu  empty retries: %llu\n",
+        name,
+        threadCount,
+        threadCount,
+        jobCount / seconds / 1e6,
+        (unsigned long long)fullRetries.load(),
+        (unsigned long long)emptyRetries.load());
+}
+
+void RunJobQueueBenchmark()
+{
+    printf("job queue benchmark: %zu jobs per phase\n", LT_BENCHMARK_JOB_COUNT);
+
+    for (uint32_t threadCount : LT_BENCHMARK_THREAD_COUNTS)
+    {
+        {
+            LTMutexJobQueue mutexQueue;
+            BenchmarkQueue("mutex+queue", mutexQueue, threadCount);
+        }
+
+        {
+            LTJobQueue<LTAssetJob> lockFreeQueue(LT_BENCHMARK_JOB_COUNT);
+            BenchmarkQueue("LTJobQueue", lockFreeQueue, threadCount);
+        }
+    }
+
+    // the asset manager's queues hold LT_ASSET_JOB_QUEUE_CAPACITY jobs, far fewer
+    // than are pushed through them here
+    for (uint32_t threadCount : LT_BENCHMARK_THREAD_COUNTS)
+    {
+        {
+            LTMutexJobQueue mutexQueue;
+            BenchmarkConcurrent("mutex+queue", mutexQueue, threadCount);
+        }
+
+        {
+            LTJobQueue<LTAssetJob> lockFreeQueue(LT_ASSET_JOB_QUEUE_CAPACITY);
+            BenchmarkConcurrent("LTJobQueue", lockFreeQueue, threadCount);
+        }
+    }
+}
@@ -0,0 +1,268 @@
+#include "PrecompiledHeader.h"
+#include "LTMeshletCulling.h"
+
+#include <cfloat>
+#include <cmath>
+
+#if LT_MESHLET_CULLING_SSE2
+#include <emmintrin.h>
+#endif
+
+void LTMeshletCulling::ExtractFrustum(const glm::mat4& modelViewProjection, LTFrustum& outFrustum)
+{
+    // Gribb & Hartmann: each plane is a sum or difference of the matrix rows.
+    // glm is column-major, so row i is m[0][i], m[1][i], m[2][i], m[3][i]
+    const glm::mat4& m = modelViewProjection;
+
+    for (uint32_t i = 0; i < 6; ++i)
+    {
+        uint32_t row = i / 2;
+        float sign = (i % 2 == 0) ? 1.0f : -1.0f;
+
+        glm::vec4& plane = outFrustum.planes[i];
+        plane.x = m[0][3] + sign * m[0][row];
+        plane.y = m[1][3] + sign * m[1][row];
+        plane.z = m[2][3] + sign * m[2][row];
+        plane.w = m[3][3] + sign * m[3][row];
+    }
+
+    // with a zero to one depth range the near plane is the third row on its own
+    glm::vec4& nearPlane = outFrustum.planes[4];
+    nearPlane.x = m[0][2];
+    nearPlane.y = m[1][2];
+    nearPlane.z = m[2][2];
+    nearPlane.w = m[3][2];
+
+    // normalize so plane distances can be compared against sphere radii
+    for (glm::vec4& plane : outFrustum.planes)
+    {
+        float length = std::sqrt(plane.x * plane.x + plane.y * plane.y + plane.z * plane.z);
+
+        if (length > 0.0f)
+        {
+            plane.x /= length;
+            plane.y /= length;
+            plane.z /= length;
+            plane.w /= length;
+        }
+    }
+}
+
+void LTMeshletCulling::BuildMeshlets(
+    const LTModelMeshlet* meshlets,
+    uint32_t meshletCount,
+    LTModelMeshlets& outMeshlets)
+{
+    outMeshlets.bounds.resize((meshletCount + 3) / 4);
+    outMeshlets.ranges.resize(meshletCount);
+
+    for (uint32_t blockIndex = 0; blockIndex < outMeshlets.bounds.size(); ++blockIndex)
+    {
+        LTMeshletBounds4& block = outMeshlets.bounds[blockIndex];
+
+        for (uint32_t lane = 0; lane < 4; ++lane)
+        {
+            uint32_t meshletIndex = blockIndex * 4 + lane;
+
+            if (meshletIndex >= meshletCount)
+            {
+                // a sphere of negative infinite radius is outside every plane
+                block.centerX[lane] = block.centerY[lane] = block.centerZ[lane] = 0.0f;
+                block.radius[lane] = -FLT_MAX;
+                block.coneApexX[lane] = block.coneApexY[lane] = block.coneApexZ[lane] = 0.0f;
+                block.coneAxisX[lane] = block.coneAxisY[lane] = block.coneAxisZ[lane] = 0.0f;
+                block.coneCutoff[lane] = 1.0f;
+                continue;
+            }
+
+            const LTModelMeshlet& meshlet = meshlets[meshletIndex];
+
+            block.centerX[lane] = meshlet.center[0];
+            block.centerY[lane] = meshlet.center[1];
+            block.centerZ[lane] = meshlet.center[2];
+            block.radius[lane] = meshlet.radius;
+            block.coneApexX[lane] = meshlet.coneApex[0];
+            block.coneApexY[lane] = meshlet.coneApex[1];
+            block.coneApexZ[lane] = meshlet.coneApex[2];
+            block.coneAxisX[lane] = meshlet.coneAxis[0];
+            block.coneAxisY[lane] = meshlet.coneAxis[1];
+            block.coneAxisZ[lane] = meshlet.coneAxis[2];
+            block.coneCutoff[lane] = meshlet.coneCutoff;
+
+            outMeshlets.ranges[meshletIndex] = { meshlet.firstIndex, meshlet.indexCount };
+        }
+    }
+}
+
+uint32_t LTMeshletCulling::CullMeshlets(
+    const LTModelMeshlets& meshlets,
+    const LTFrustum& frustum,
+    const glm::vec3& cameraPosition,
+    eastl::vector<LTMeshletDrawRange>& outRanges)
+{
+    outRanges.clear();
+
+    uint32_t visibleCount = 0;
+
+    for (uint32_t blockIndex = 0; blockIndex < meshlets.bounds.size(); ++blockIndex)
+    {
+        uint32_t visibleMask = CullBlock(meshlets.bounds[blockIndex], frustum, cameraPosition);
+
+        for (uint32_t lane = 0; lane < 4; ++lane)
+        {
+            if ((visibleMask & (1u << lane)) == 0)
+            {
+                continue;
+            }
+
+            AppendRange(meshlets.ranges[blockIndex * 4 + lane], outRanges);
+            ++visibleCount;
+        }
+    }
+
+    return visibleCount;
+}
+
+uint32_t LTMeshletCulling::MarkVisibleMeshlets(
+    const LTModelMeshlets& meshlets,
+    const LTFrustum& frustum,
+    const glm::vec3& cameraPosition,
+    uint8_t* inOutBlockMasks)
+{
+    // the number of lanes set in each four-lane mask
+    static const uint32_t laneCounts[16] = { 0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4 };
+
+    uint32_t visibleCount = 0;
+
+    for (uint32_t blockIndex = 0; blockIndex < meshlets.bounds.size(); ++blockIndex)
+    {
+        uint32_t visibleMask = CullBlock(meshlets.bounds[blockIndex], frustum, cameraPosition);
+
+        inOutBlockMasks[blockIndex] |= (uint8_t)visibleMask;
+        visibleCount += laneCounts[visibleMask];
+    }
+
+    return visibleCount;
+}
+
+void LTMeshletCulling::BuildDrawRanges(
+    const LTModelMeshlets& meshlets,
+    const uint8_t* blockMasks,
+    eastl::vector<LTMeshletDrawRange>& outRanges)
+{
+    outRanges.clear();
+
+    // the padding lanes of the last block are never visible, so they are never marked
+    for (uint32_t blockIndex = 0; blockIndex < meshlets.bounds.size(); ++blockIndex)
+    {
+        for (uint32_t lane = 0; lane < 4; ++lane)
+        {
+            if ((blockMasks[blockIndex] & (1u << lane)) != 0)
+            {
+                AppendRange(meshlets.ranges[blockIndex * 4 + lane], outRanges);
+            }
+        }
+    }
+}
+
+void LTMeshletCulling::AppendRange(const LTMeshletDrawRange& range, eastl::vector<LTMeshletDrawRange>& outRanges)
+{
+    // meshlets are contiguous in the index buffer, so runs of visible ones
+    // become a single draw
+    if (!outRanges.empty() &&
+        outRanges.back().firstIndex + outRanges.back().indexCount == range.firstIndex)
+    {
+        outRanges.back().indexCount += range.indexCount;
+    }
+    else
+    {
+        outRanges.push_back(range);
+    }
+}
+
+#if LT_MESHLET_CULLING_SSE2
+
+uint32_t LTMeshletCulling::CullBlock(
+    const LTMeshletBounds4& block,
+    const LTFrustum& frustum,
+    const glm::vec3& cameraPosition)
+{
+    __m128 centerX = _mm_loadu_ps(block.centerX);
+    __m128 centerY = _mm_loadu_ps(block.centerY);
+    __m128 centerZ = _mm_loadu_ps(block.centerZ);
+    __m128 radius = _mm_loadu_ps(block.radius);
+    __m128 negativeRadius = _mm_sub_ps(_mm_setzero_ps(), radius);
+
+    // visible while inside or intersecting every plane
+    __m128 visible = _mm_castsi128_ps(_mm_set1_epi32(-1));
+
+    for (const glm::vec4& plane : frustum.planes)
+    {
+        __m128 distance = _mm_add_ps(
+            _mm_add_ps(_mm_mul_ps(centerX, _mm_set1_ps(plane.x)), _mm_mul_ps(centerY, _mm_set1_ps(plane.y))),
+            _mm_add_ps(_mm_mul_ps(centerZ, _mm_set1_ps(plane.z)), _mm_set1_ps(plane.w)));
+
+        visible = _mm_and_ps(visible, _mm_cmpge_ps(distance, negativeRadius));
+    }
+
+    // backface cone: culled when dot(apex - eye, axis) > cutoff * |apex - eye|. The
+    // comparison is strict so disabled cones (zero axis) and an eye on the apex never cull
+    __m128 viewX = _mm_sub_ps(_mm_loadu_ps(block.coneApexX), _mm_set1_ps(cameraPosition.x));
+    __m128 viewY = _mm_sub_ps(_mm_loadu_ps(block.coneApexY), _mm_set1_ps(cameraPosition.y));
+    __m128 viewZ = _mm_sub_ps(_mm_loadu_ps(block.coneApexZ), _mm_set1_ps(cameraPosition.z));
+
+    __m128 viewLength = _mm_sqrt_ps(_mm_add_ps(
+        _mm_add_ps(_mm_mul_ps(viewX, viewX), _mm_mul_ps(viewY, viewY)),
+        _mm_mul_ps(viewZ, viewZ)));
+
+    __m128 viewDotAxis = _mm_add_ps(
+        _mm_add_ps(_mm_mul_ps(viewX, _mm_loadu_ps(block.coneAxisX)), _mm_mul_ps(viewY, _mm_loadu_ps(block.coneAxisY))),
+        _mm_mul_ps(viewZ, _mm_loadu_ps(block.coneAxisZ)));
+
+    __m128 backfacing = _mm_cmpgt_ps(viewDotAxis, _mm_mul_ps(_mm_loadu_ps(block.coneCutoff), viewLength));
+
+    visible = _mm_andnot_ps(backfacing, visible);
+
+    return (uint32_t)_mm_movemask_ps(visible);
+}
+
+#else
+
+uint32_t LTMeshletCulling::CullBlock(
+    const LTMeshletBounds4& block,
+    const LTFrustum& frustum,
+    const glm::vec3& cameraPosition)
+{
+    uint32_t visibleMask = 0;
+
+    for (uint32_t lane = 0; lane < 4; ++lane)
+    {
+        float centerX = block.centerX[lane];
+        float centerY = block.centerY[lane];
+        float centerZ = block.centerZ[lane];
+        float radius = block.radius[lane];
+
+        bool visible = true;
+
+        for (const glm::vec4& plane : frustum.planes)
+        {
+            float distance = centerX * plane.x + centerY * plane.y + centerZ * plane.z + plane.w;
+            visible = visible && distance >= -radius;
+        }
+
+        float viewX = block.coneApexX[lane] - cameraPosition.x;
+        float viewY = block.coneApexY[lane] - cameraPosition.y;
+        float viewZ = block.coneApexZ[lane] - cameraPosition.z;
+
+        float viewLength = std::sqrt(viewX * viewX + viewY * viewY + viewZ * viewZ);
+        float viewDotAxis = viewX * block.coneAxisX[lane] + viewY * block.coneAxisY[lane] + viewZ * block.coneAxisZ[lane];
+
+        visible = visible && !(viewDotAxis > block.coneCutoff[lane] * viewLength);
+
+        visibleMask |= visible ? (1u << lane) : 0u;
+    }
+
+    return visibleMask;
+}
+
+#endif
@@ -0,0 +1,296 @@
+#include "PrecompiledHeader.h"
+
+#include "LTVKCommandRecorder.h"
+#include "LTVKDevice.h"
+
+bool LTVKCommandRecorder::Initialize(LTVKDevice* ltvkDevice, uint32_t framesInFlight, uint32_t workerCount)
+{
+    m_LTVKDevice = ltvkDevice;
+    m_Device = ltvkDevice->GetDevice();
+
+    // leave a core for the main thread when sizing from the hardware; it records
+    // tasks as well
+    if (workerCount == 0)
+    {
+        uint32_t hardwareThreads = std::thread::hardware_concurrency();
+        workerCount = hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+    }
+
+    m_FramesInFlight = framesInFlight;
+    m_ThreadCount = workerCount + 1;
+    m_ThreadCommands.resize(m_FramesInFlight * m_ThreadCount);
+
+    for (LTVKThreadCommands& threadCommands : m_ThreadCommands)
+    {
+        // transient, since the buffers are recorded once per frame and then reset
+        // with the whole pool
+        VkCommandPoolCreateInfo poolInfo = {};
+        poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        poolInfo.queueFamilyIndex = ltvkDevice->GetQueueFamilies().graphicsFamily;
+        poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+
+        if (vkCreateCommandPool(m_Device, &poolInfo, nullptr, &threadCommands.commandPool) != VK_SUCCESS)
+        {
+            return false;
+        }
+    }
+
+    m_IsRunning = true;
+
+    for (uint32_t i = 0; i < workerCount; ++i)
+    {
+        m_RecordThreads.push_back(new std::thread(&LTVKCommandRecorder::RecordThread, this, i));
+    }
+
+    return true;
+}
+
+void LTVKCommandRecorder::Destroy()
+{
+    {
+        std::scoped_lock lock(m_Mutex);
+        m_IsRunning = false;
+    }
+
+    m_RecordingCondition.notify_all();
+
+    for (std::thread* recordThread : m_RecordThreads)
+    {
+        recordThread->join();
+        delete recordThread;
+    }
+
+    m_RecordThreads.clear();
+
+    // destroying a pool frees the command buffers allocated from it
+    for (LTVKThreadCommands& threadCommands : m_ThreadCommands)
+    {
+        vkDestroyCommandPool(m_Device, threadCommands.commandPool, nullptr);
+    }
+
+    m_ThreadCommands.clear();
+}
+
+void LTVKCommandRecorder::ResetFrame(uint32_t frameIndex)
+{
+    std::unique_lock lock(m_Mutex);
+
+    // a worker that woke too late for the last recording may still be leaving it
+    m_FinishedCondition.wait(lock, [this]()
+    {
+        return m_ActiveWorkerCount == 0;
+    });
+
+    m_FrameIndex = frameIndex;
+
+    // one reset per pool returns every buffer recorded from it two or three frames
+    // ago, rather than one reset per buffer
+    for (uint32_t i = 0; i < m_ThreadCount; ++i)
+    {
+        LTVKThreadCommands& threadCommands = m_ThreadCommands[frameIndex * m_ThreadCount + i];
+
+        if (threadCommands.usedCount > 0)
+        {
+            vkResetCommandPool(m_Device, threadCommands.commandPool, 0);
+            threadCommands.usedCount = 0;
+        }
+    }
+}
+
+void LTVKCommandRecorder::Record(
+    const VkCommandBufferInheritanceInfo& inheritance,
+    VkExtent2D extent,
+    uint32_t taskCount,
+    const LTVKRecordCallback& record,
+    eastl::vector<VkCommandBuffer>& outCommandBuffers)
+{
+    if (taskCount == 0)
+    {
+        return;
+    }
+
+    auto recordStart = std::chrono::steady_clock::now();
+
+    {
+        std::unique_lock lock(m_Mutex);
+
+        // the task counter is shared, so it may only be reset once no worker can
+        // still take from the last recording
+        m_FinishedCondition.wait(lock, [this]()
+        {
+            return m_ActiveWorkerCount == 0;
+        });
+
+        m_Record = &record;
+        m_Inheritance = inheritance;
+        m_Extent = extent;
+        m_TaskCount = taskCount;
+        m_NextTask.store(0, std::memory_order_relaxed);
+        m_TaskCommandBuffers.clear();
+        m_TaskCommandBuffers.resize(taskCount, VK_NULL_HANDLE);
+
+        ++m_RecordingNumber;
+    }
+
+    m_RecordingCondition.notify_all();
+
+    // the main thread takes tasks as well rather than waiting idle
+    RecordTasks(
+        m_ThreadCommands[m_FrameIndex * m_ThreadCount + m_ThreadCount - 1],
+        record,
+        inheritance,
+        extent,
+        taskCount);
+
+    {
+        std::unique_lock lock(m_Mutex);
+
+        // every task has been taken, so once the workers have left they have all
+        // been recorded
+        m_FinishedCondition.wait(lock, [this]()
+        {
+            return m_ActiveWorkerCount == 0;
+        });
+
+        m_Record = nullptr;
+        ++m_RecordingCount;
+        m_RecordedTaskCount += taskCount;
+        m_RecordTime += std::chrono::steady_clock::now() - recordStart;
+    }
+
+    outCommandBuffers.insert(outCommandBuffers.end(), m_TaskCommandBuffers.begin(), m_TaskCommandBuffers.end());
+}
+
+void LTVKCommandRecorder::PrintStats()
+{
+    std::scoped_lock lock(m_Mutex);
+
+    double recordMs = std::chrono::duration<double, std::milli>(m_RecordTime).count();
+
+    printf("command recorder: %u threads, %u recordings, %u tasks, %.2f ms recording (%.3f ms per recording) \n",
+        m_ThreadCount,
+        m_RecordingCount,
+        m_RecordedTaskCount,
+        recordMs,
+        m_RecordingCount > 0 ? recordMs / m_RecordingCount : 0.0);
+}
+
+void LTVKCommandRecorder::RecordThread(uint32_t threadIndex)
+{
+    uint64_t recordingNumber = 0;
+
+    while (true)
+    {
+        const LTVKRecordCallback* record;
+        VkCommandBufferInheritanceInfo inheritance;
+        VkExtent2D extent;
+        uint32_t taskCount;
+        uint32_t frameIndex;
+
+        {
+            std::unique_lock lock(m_Mutex);
+
+            m_RecordingCondition.wait(lock, [this, recordingNumber]()
+            {
+                return !m_IsRunning || (m_RecordingNumber != recordingNumber && m_Record != nullptr);
+            });
+
+            if (!m_IsRunning)
+            {
+                return;
+            }
+
+            recordingNumber = m_RecordingNumber;
+            record = m_Record;
+            inheritance = m_Inheritance;
+            extent = m_Extent;
+            taskCount = m_TaskCount;
+            frameIndex = m_FrameIndex;
+
+            ++m_ActiveWorkerCount;
+        }
+
+        RecordTasks(m_ThreadCommands[frameIndex * m_ThreadCount + threadIndex], *record, inheritance, extent, taskCount);
+
+        {
+            std::scoped_lock lock(m_Mutex);
+
+            if (--m_ActiveWorkerCount == 0)
+            {
+                m_FinishedCondition.notify_all();
+            }
+        }
+    }
+}
+
+void LTVKCommandRecorder::RecordTasks(
+    LTVKThreadCommands& threadCommands,
+    const LTVKRecordCallback& record,
+    const VkCommandBufferInheritanceInfo& inheritance,
+    VkExtent2D extent,
+    uint32_t taskCount)
+{
+    // secondary command buffers do not inherit dynamic state from the primary
+    VkViewport viewport = {};
+    viewport.x = 0.0f;
+    viewport.y = 0.0f;
+    viewport.width = (float)extent.width;
+    viewport.height = (float)extent.height;
+    viewport.minDepth = 0.0f;
+    viewport.maxDepth = 1.0f;
+
+    VkRect2D scissor = {};
+    scissor.offset = { 0, 0 };
+    scissor.extent = extent;
+
+    VkCommandBufferBeginInfo beginInfo = {};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+    beginInfo.pInheritanceInfo = &inheritance;
+
+    while (true)
+    {
+        uint32_t task = m_NextTask.fetch_add(1, std::memory_order_relaxed);
+
+        if (task >= taskCount)
+        {
+            return;
+        }
+
+        VkCommandBuffer commandBuffer = AcquireCommandBuffer(threadCommands);
+
+        vkBeginCommandBuffer(commandBuffer, &beginInfo);
+        vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+        vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+
+        record(commandBuffer, task);
+
+        vkEndCommandBuffer(commandBuffer);
+
+        // each task owns its slot; the main thread reads them once the workers have left
+        m_TaskCommandBuffers[task] = commandBuffer;
+    }
+}
+
+VkCommandBuffer LTVKCommandRecorder::AcquireCommandBuffer(LTVKThreadCommands& threadCommands)
+{
+    if (threadCommands.usedCount == threadCommands.commandBuffers.size())
+    {
+        VkCommandBufferAllocateInfo allocInfo = {};
+        allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+        allocInfo.commandPool = threadCommands.commandPool;
+        allocInfo.commandBufferCount = 1;
+
+        VkCommandBuffer commandBuffer;
+
+        if (vkAllocateCommandBuffers(m_Device, &allocInfo, &commandBuffer) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to allocate secondary command buffer!");
+        }
+
+        threadCommands.commandBuffers.push_back(commandBuffer);
+    }
+
+    return threadCommands.commandBuffers[threadCommands.usedCount++];
+}
@@ -1,13 +1,30 @@
 #include "PrecompiledHeader.h"
 
 #include "LTVKDevice.h"
+#include "LTContentPak.h"
 #include "LTGameWindow.h"
 
+#include <cstdio>
 #include <cstring>
+#include <fstream>
 #include <iostream>
 #include <set>
 #include <unordered_set>
 
+// identifies a pipeline cache file ("LTPC", little-endian)
+static constexpr uint32_t LT_VK_PIPELINE_CACHE_MAGIC = 0x4350544C;
+static constexpr uint32_t LT_VK_PIPELINE_CACHE_VERSION = 1;
+
+// written ahead of the driver's cache data, so a truncated or corrupt file is
+// rejected before the driver ever sees it
+struct LTVKPipelineCacheFileHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t dataSize;
+    uint32_t dataHash;
+};
+
 static VKAPI_ATTR VkBool32 VKAPI_CALL DebugCallback(
     VkDebugUtilsMessageSeverityFlagBitsEXT messageSeverity,
     VkDebugUtilsMessageTypeFlagsEXT messageType,
@@ -68,11 +85,26 @@ bool LTVKDevice::Initialize()
     && Initialize_CreateSurface()
     && Initialize_PickPhysicalDevice()
     && Initialize_CreateLogicalDevice()
-    && Initialize_CreateCommandPool();
+    && Initialize_CreateCommandPool()
+    && Initialize_CreateMemoryAllocator()
+    && Initialize_CreateUploadManager()
+    && Initialize_CreateGeometryArena()
+    && Initialize_CreatePipelineCache()
+    && Initialize_CreatePipelineManager();
 }
 
 void LTVKDevice::Destroy()
 {
+    m_PipelineManager.Destroy();
+
+    SavePipelineCache();
+    vkDestroyPipelineCache(m_Device, m_PipelineCache, nullptr);
+
+    // after the upload manager, which waits for the copies into the arena
+    m_UploadManager.Destroy();
+    m_GeometryArena.Destroy();
+    m_MemoryAllocator.Destroy();
+
     vkDestroyCommandPool(m_Device, m_CommandPool, nullptr);
     vkDestroyDevice(m_Device, nullptr);
 
@@ -178,7 +210,7 @@ bool LTVKDevice::Initialize_CreateLogicalDevice()
     LTVKQueueFamilyIndices indices = FindQueueFamilies(m_PhysicalDevice);
 
     std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
-    std::set<uint32_t> uniqueQueueFamilies = { indices.graphicsFamily, indices.presentFamily };
+    std::set<uint32_t> uniqueQueueFamilies = { indices.graphicsFamily, indices.presentFamily, indices.transferFamily };
 
     float queuePriority = 1.0f;
 
@@ -192,8 +224,20 @@ bool LTVKDevice::Initialize_CreateLogicalDevice()
         queueCreateInfos.push_back(queueCreateInfo);
     }
 
+    VkPhysicalDeviceFeatures supportedFeatures;
+    vkGetPhysicalDeviceFeatures(m_PhysicalDevice, &supportedFeatures);
+
     VkPhysicalDeviceFeatures deviceFeatures = {};
     deviceFeatures.samplerAnisotropy = VK_TRUE;
+    deviceFeatures.textureCompressionBC = VK_TRUE;
+
+    // optional; without it instance batches are drawn directly, since their first
+    // instance cannot come from the indirect buffer
+    deviceFeatures.drawIndirectFirstInstance = supportedFeatures.drawIndirectFirstInstance;
+
+    // optional; without it each instance batch's draw commands are issued one by one
+    // rather than by a single indirect draw
+    deviceFeatures.multiDrawIndirect = supportedFeatures.multiDrawIndirect;
 
     VkDeviceCreateInfo createInfo = {};
     createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
@@ -225,6 +269,10 @@ bool LTVKDevice::Initialize_CreateLogicalDevice()
 
     vkGetDeviceQueue(m_Device, indices.graphicsFamily, 0, &m_GraphicsQueue);
     vkGetDeviceQueue(m_Device, indices.presentFamily, 0, &m_PresentQueue);
+    vkGetDeviceQueue(m_Device, indices.transferFamily, 0, &m_TransferQueue);
+
+    m_QueueFamilies = indices;
+    m_EnabledFeatures = deviceFeatures;
 
     return true;
 }
@@ -248,6 +296,208 @@ bool LTVKDevice::Initialize_CreateCommandPool()
     return true;
 }
 
+bool LTVKDevice::Initialize_CreateMemoryAllocator()
+{
+    m_MemoryAllocator.Initialize(m_PhysicalDevice, m_Device);
+    return true;
+}
+
+bool LTVKDevice::Initialize_CreateUploadManager()
+{
+    return m_UploadManager.Initialize(this);
+}
+
+bool LTVKDevice::Initialize_CreateGeometryArena()
+{
+    return m_GeometryArena.Initialize(this);
+}
+
+bool LTVKDevice::Initialize_CreatePipelineCache()
+{
+    std::vector<uint8_t> cacheData;
+
+    // a missing or stale cache only means every pipeline compiles from scratch
+    if (!LoadPipelineCacheData(cacheData))
+    {
+        cacheData.clear();
+    }
+
+    VkPipelineCacheCreateInfo cacheInfo = {};
+    cacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+    cacheInfo.initialDataSize = cacheData.size();
+    cacheInfo.pInitialData = cacheData.empty() ? nullptr : cacheData.data();
+
+    if (vkCreatePipelineCache(m_Device, &cacheInfo, nullptr, &m_PipelineCache) != VK_SUCCESS)
+    {
+        return false;
+    }
+
+    m_PipelineCacheLoadedBytes = cacheData.size();
+    m_PipelineCacheSaveTime = std::chrono::steady_clock::now();
+
+    return true;
+}
+
+bool LTVKDevice::Initialize_CreatePipelineManager()
+{
+    m_PipelineManager.Initialize(this);
+    return true;
+}
+
+bool LTVKDevice::LoadPipelineCacheData(std::vector<uint8_t>& outData)
+{
+    std::ifstream file(LT_VK_PIPELINE_CACHE_PATH, std::ios::binary | std::ios::ate);
+
+    if (!file.is_open())
+    {
+        return false;
+    }
+
+    size_t fileSize = (size_t)file.tellg();
+    LTVKPipelineCacheFileHeader fileHeader;
+
+    if (fileSize < sizeof(fileHeader))
+    {
+        printf("pipeline cache: %s is truncated, ignoring it \n", LT_VK_PIPELINE_CACHE_PATH);
+        return false;
+    }
+
+    file.seekg(0);
+    file.read((char*)&fileHeader, sizeof(fileHeader));
+
+    if (fileHeader.magic != LT_VK_PIPELINE_CACHE_MAGIC ||
+        fileHeader.version != LT_VK_PIPELINE_CACHE_VERSION ||
+        fileHeader.dataSize != fileSize - sizeof(fileHeader) ||
+        fileHeader.dataSize < sizeof(VkPipelineCacheHeaderVersionOne))
+    {
+        printf("pipeline cache: %s is not a valid cache, ignoring it \n", LT_VK_PIPELINE_CACHE_PATH);
+        return false;
+    }
+
+    outData.resize(fileHeader.dataSize);
+    file.read((char*)outData.data(), fileHeader.dataSize);
+
+    if (!file || LTContentPak::ComputeHash(outData.data(), outData.size()) != fileHeader.dataHash)
+    {
+        printf("pipeline cache: %s is corrupt, ignoring it \n", LT_VK_PIPELINE_CACHE_PATH);
+        return false;
+    }
+
+    // the driver also checks its header, but some drivers have crashed on data from
+    // another device, so a cache from a different GPU or driver build is never passed on
+    VkPipelineCacheHeaderVersionOne cacheHeader;
+    memcpy(&cacheHeader, outData.data(), sizeof(cacheHeader));
+
+    if (cacheHeader.headerVersion != VK_PIPELINE_CACHE_HEADER_VERSION_ONE ||
+        cacheHeader.vendorID != m_Properties.vendorID ||
+        cacheHeader.deviceID != m_Properties.deviceID ||
+        memcmp(cacheHeader.pipelineCacheUUID, m_Properties.pipelineCacheUUID, VK_UUID_SIZE) != 0)
+    {
+        printf("pipeline cache: %s was written by a different device or driver, ignoring it \n",
+            LT_VK_PIPELINE_CACHE_PATH);
+        return false;
+    }
+
+    return true;
+}
+
+bool LTVKDevice::SavePipelineCache()
+{
+    std::scoped_lock lock(m_PipelineCacheSaveMutex);
+
+    if (m_PipelineCache == VK_NULL_HANDLE || m_PipelinesSinceSave.exchange(0) == 0)
+    {
+        return true;
+    }
+
+    m_PipelineCacheSaveTime = std::chrono::steady_clock::now();
+
+    size_t dataSize = 0;
+    vkGetPipelineCacheData(m_Device, m_PipelineCache, &dataSize, nullptr);
+
+    std::vector<uint8_t> cacheData(dataSize);
+
+    if (vkGetPipelineCacheData(m_Device, m_PipelineCache, &dataSize, cacheData.data()) != VK_SUCCESS)
+    {
+        return false;
+    }
+
+    cacheData.resize(dataSize);
+
+    LTVKPipelineCacheFileHeader fileHeader;
+    fileHeader.magic = LT_VK_PIPELINE_CACHE_MAGIC;
+    fileHeader.version = LT_VK_PIPELINE_CACHE_VERSION;
+    fileHeader.dataSize = (uint32_t)cacheData.size();
+    fileHeader.dataHash = LTContentPak::ComputeHash(cacheData.data(), cacheData.size());
+
+    // the cache is written beside the old one and then swapped in, so a crash while
+    // writing leaves the old cache intact
+    std::string tempPath = std::string(LT_VK_PIPELINE_CACHE_PATH) + ".tmp";
+
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+
+        file.write((const char*)&fileHeader, sizeof(fileHeader));
+        file.write((const char*)cacheData.data(), cacheData.size());
+
+        if (!file)
+        {
+            printf("pipeline cache: failed to write %s \n", tempPath.c_str());
+            return false;
+        }
+    }
+
+    std::remove(LT_VK_PIPELINE_CACHE_PATH);
+
+    if (std::rename(tempPath.c_str(), LT_VK_PIPELINE_CACHE_PATH) != 0)
+    {
+        printf("pipeline cache: failed to replace %s \n", LT_VK_PIPELINE_CACHE_PATH);
+        return false;
+    }
+
+    return true;
+}
+
+void LTVKDevice::UpdatePipelineCache()
+{
+    if (m_PipelinesSinceSave.load(std::memory_order_relaxed) == 0)
+    {
+        return;
+    }
+
+    {
+        std::scoped_lock lock(m_PipelineCacheSaveMutex);
+
+        if (std::chrono::steady_clock::now() - m_PipelineCacheSaveTime < LT_VK_PIPELINE_CACHE_SAVE_INTERVAL)
+        {
+            return;
+        }
+    }
+
+    SavePipelineCache();
+}
+
+void LTVKDevice::RecordPipelineCreation(std::chrono::nanoseconds duration)
+{
+    m_PipelineCreateNs += (uint64_t)duration.count();
+    m_PipelineCount++;
+    m_PipelinesSinceSave++;
+}
+
+void LTVKDevice::PrintPipelineStats()
+{
+    uint32_t pipelineCount = m_PipelineCount.load();
+    double totalMs = (double)m_PipelineCreateNs.load() / 1000000.0;
+
+    // with a warm cache the creation time drops to little more than a lookup, so
+    // comparing a cold run against a warm one shows what the cache saves
+    printf("pipelines: %u created in %.2f ms (%.2f ms each), %zu bytes of cache loaded from disk \n",
+        pipelineCount,
+        totalMs,
+        pipelineCount > 0 ? totalMs / pipelineCount : 0.0,
+        m_PipelineCacheLoadedBytes);
+}
+
 bool LTVKDevice::Initialize_CreateSurface()
 {
     return m_Window.CreateWindowSurfaceVK(m_Instance, &m_Surface);
@@ -272,7 +522,8 @@ bool LTVKDevice::IsDeviceSuitable(VkPhysicalDevice device)
     return indices.isComplete() &&
         extensionsSupported &&
         swapChainAdequate &&
-        supportedFeatures.samplerAnisotropy;
+        supportedFeatures.samplerAnisotropy &&
+        supportedFeatures.textureCompressionBC;
 }
 
 void LTVKDevice::PopulateDebugMessengerCreateInfo(
@@ -448,6 +699,23 @@ LTVKQueueFamilyIndices LTVKDevice::FindQueueFamilies(VkPhysicalDevice device)
         i++;
     }
 
+    // a family with transfer but neither graphics nor compute is a separate copy
+    // engine, so uploads on it run alongside rendering
+    indices.transferFamily = indices.graphicsFamily;
+
+    for (uint32_t family = 0; family < queueFamilyCount; ++family)
+    {
+        VkQueueFlags queueFlags = queueFamilies[family].queueFlags;
+
+        if (queueFamilies[family].queueCount > 0 &&
+            (queueFlags & VK_QUEUE_TRANSFER_BIT) &&
+            !(queueFlags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT)))
+        {
+            indices.transferFamily = family;
+            break;
+        }
+    }
+
     return indices;
 }
 
@@ -526,7 +794,20 @@ void LTVKDevice::CreateBuffer(
     VkBufferUsageFlags usage,
     VkMemoryPropertyFlags properties,
     VkBuffer& buffer,
-    VkDeviceMemory& bufferMemory) 
+    LTVKAllocation& bufferAllocation) 
+{
+    if (!TryCreateBuffer(size, usage, properties, buffer, bufferAllocation))
+    {
+        throw std::runtime_error("failed to create buffer!");
+    }
+}
+
+bool LTVKDevice::TryCreateBuffer(
+    VkDeviceSize size,
+    VkBufferUsageFlags usage,
+    VkMemoryPropertyFlags properties,
+    VkBuffer& buffer,
+    LTVKAllocation& bufferAllocation) 
 {
     VkBufferCreateInfo bufferInfo{};
     bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
@@ -534,29 +815,56 @@ void LTVKDevice::CreateBuffer(
     bufferInfo.usage = usage;
     bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 
+    // buffers filled on the transfer queue are shared with the graphics queue rather
+    // than having their ownership transferred
+    uint32_t queueFamilyIndices[] = { m_QueueFamilies.graphicsFamily, m_QueueFamilies.transferFamily };
+
+    if ((usage & VK_BUFFER_USAGE_TRANSFER_DST_BIT) && queueFamilyIndices[0] != queueFamilyIndices[1])
+    {
+        bufferInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+        bufferInfo.queueFamilyIndexCount = 2;
+        bufferInfo.pQueueFamilyIndices = queueFamilyIndices;
+    }
+
     if (vkCreateBuffer(m_Device, &bufferInfo, nullptr, &buffer) != VK_SUCCESS) 
     {
-        throw std::runtime_error("failed to create vertex buffer!");
+        buffer = VK_NULL_HANDLE;
+        return false;
     }
 
     VkMemoryRequirements memRequirements;
     vkGetBufferMemoryRequirements(m_Device, buffer, &memRequirements);
 
-    VkMemoryAllocateInfo allocInfo{};
-    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    allocInfo.allocationSize = memRequirements.size;
-    allocInfo.memoryTypeIndex = FindMemoryType(memRequirements.memoryTypeBits, properties);
+    // out of device memory, or at the device's allocation count
+    if (!m_MemoryAllocator.Allocate(memRequirements, properties, false, bufferAllocation)) 
+    {
+        vkDestroyBuffer(m_Device, buffer, nullptr);
+        buffer = VK_NULL_HANDLE;
+        return false;
+    }
 
-    if (vkAllocateMemory(m_Device, &allocInfo, nullptr, &bufferMemory) != VK_SUCCESS) 
+    if (vkBindBufferMemory(m_Device, buffer, bufferAllocation.memory, bufferAllocation.offset) != VK_SUCCESS)
     {
-        throw std::runtime_error("failed to allocate vertex buffer memory!");
+        DestroyBuffer(buffer, bufferAllocation);
+        return false;
     }
 
-    vkBindBufferMemory(m_Device, buffer, bufferMemory, 0);
+    return true;
+}
+
+void LTVKDevice::DestroyBuffer(VkBuffer& buffer, LTVKAllocation& bufferAllocation)
+{
+    vkDestroyBuffer(m_Device, buffer, nullptr);
+    m_MemoryAllocator.Free(bufferAllocation);
+
+    buffer = VK_NULL_HANDLE;
 }
 
 VkCommandBuffer LTVKDevice::BeginSingleTimeCommands() 
 {
+    // released by EndSingleTimeCommands
+    m_SingleTimeCommandsMutex.lock();
+
     VkCommandBufferAllocateInfo allocInfo{};
     allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
     allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
@@ -583,10 +891,45 @@ void LTVKDevice::EndSingleTimeCommands(VkCommandBuffer commandBuffer)
     submitInfo.commandBufferCount = 1;
     submitInfo.pCommandBuffers = &commandBuffer;
 
-    vkQueueSubmit(m_GraphicsQueue, 1, &submitInfo, VK_NULL_HANDLE);
-    vkQueueWaitIdle(m_GraphicsQueue);
+    // a fence waits for these commands only; vkQueueWaitIdle would also wait for
+    // every frame in flight
+    VkFenceCreateInfo fenceInfo{};
+    fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+
+    VkFence fence;
+    vkCreateFence(m_Device, &fenceInfo, nullptr, &fence);
 
+    QueueSubmit(m_GraphicsQueue, submitInfo, fence);
+    vkWaitForFences(m_Device, 1, &fence, VK_TRUE, UINT64_MAX);
+
+    vkDestroyFence(m_Device, fence, nullptr);
     vkFreeCommandBuffers(m_Device, m_CommandPool, 1, &commandBuffer);
+
+    m_SingleTimeCommandsMutex.unlock();
+}
+
+VkResult LTVKDevice::QueueSubmit(VkQueue queue, const VkSubmitInfo& submitInfo, VkFence fence)
+{
+    // the transfer queue is only submitted to by the upload manager, which holds its
+    // own lock; the graphics queue may be submitted to from any thread
+    if (queue != m_GraphicsQueue)
+    {
+        return vkQueueSubmit(queue, 1, &submitInfo, fence);
+    }
+
+    std::scoped_lock lock(m_GraphicsQueueMutex);
+    return vkQueueSubmit(queue, 1, &submitInfo, fence);
+}
+
+VkResult LTVKDevice::QueuePresent(const VkPresentInfoKHR& presentInfo)
+{
+    if (m_PresentQueue != m_GraphicsQueue)
+    {
+        return vkQueuePresentKHR(m_PresentQueue, &presentInfo);
+    }
+
+    std::scoped_lock lock(m_GraphicsQueueMutex);
+    return vkQueuePresentKHR(m_PresentQueue, &presentInfo);
 }
 
 void LTVKDevice::CopyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size) 
@@ -607,17 +950,32 @@ void LTVKDevice::CopyBufferToImage(
     VkImage image, 
     uint32_t width, 
     uint32_t height, 
-    uint32_t layerCount) 
+    uint32_t layerCount,
+    uint32_t mipLevel,
+    VkDeviceSize bufferOffset) 
 {
     VkCommandBuffer commandBuffer = BeginSingleTimeCommands();
+    CopyBufferToImage(commandBuffer, buffer, image, width, height, layerCount, mipLevel, bufferOffset);
+    EndSingleTimeCommands(commandBuffer);
+}
 
+void LTVKDevice::CopyBufferToImage(
+    VkCommandBuffer commandBuffer,
+    VkBuffer buffer,
+    VkImage image,
+    uint32_t width,
+    uint32_t height,
+    uint32_t layerCount,
+    uint32_t mipLevel,
+    VkDeviceSize bufferOffset)
+{
     VkBufferImageCopy region{};
-    region.bufferOffset = 0;
+    region.bufferOffset = bufferOffset;
     region.bufferRowLength = 0;
     region.bufferImageHeight = 0;
 
     region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-    region.imageSubresource.mipLevel = 0;
+    region.imageSubresource.mipLevel = mipLevel;
     region.imageSubresource.baseArrayLayer = 0;
     region.imageSubresource.layerCount = layerCount;
 
@@ -631,35 +989,120 @@ void LTVKDevice::CopyBufferToImage(
         VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
         1,
         &region);
-    EndSingleTimeCommands(commandBuffer);
+}
+
+void LTVKDevice::TransitionImageLayout(
+    VkCommandBuffer commandBuffer,
+    VkImage image,
+    uint32_t mipCount,
+    VkImageLayout oldLayout,
+    VkImageLayout newLayout)
+{
+    VkImageMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.oldLayout = oldLayout;
+    barrier.newLayout = newLayout;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = image;
+    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    barrier.subresourceRange.baseMipLevel = 0;
+    barrier.subresourceRange.levelCount = mipCount;
+    barrier.subresourceRange.baseArrayLayer = 0;
+    barrier.subresourceRange.layerCount = 1;
+
+    VkPipelineStageFlags srcStage;
+    VkPipelineStageFlags dstStage;
+
+    if (oldLayout == VK_IMAGE_LAYOUT_UNDEFINED)
+    {
+        // nothing to wait for; the copies wait for the transition
+        barrier.srcAccessMask = 0;
+        barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        srcStage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+        dstStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+    }
+    else
+    {
+        // the copies finish before any shader samples the image
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        srcStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+        dstStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+    }
+
+    vkCmdPipelineBarrier(
+        commandBuffer,
+        srcStage,
+        dstStage,
+        0,
+        0, nullptr,
+        0, nullptr,
+        1, &barrier);
 }
 
 void LTVKDevice::CreateImageWithInfo(
     const VkImageCreateInfo& imageInfo,
     VkMemoryPropertyFlags properties,
     VkImage& image,
-    VkDeviceMemory& imageMemory) 
+    LTVKAllocation& imageAllocation) 
 {
-    if (vkCreateImage(m_Device, &imageInfo, nullptr, &image) != VK_SUCCESS) 
+    if (!TryCreateImageWithInfo(imageInfo, properties, image, imageAllocation))
     {
         throw std::runtime_error("failed to create image!");
     }
+}
+
+bool LTVKDevice::TryCreateImageWithInfo(
+    const VkImageCreateInfo& imageInfo,
+    VkMemoryPropertyFlags properties,
+    VkImage& image,
+    LTVKAllocation& imageAllocation) 
+{
+    // images filled on the transfer queue are shared with the graphics queue, as
+    // buffers are in CreateBuffer
+    VkImageCreateInfo sharedImageInfo = imageInfo;
+    uint32_t queueFamilyIndices[] = { m_QueueFamilies.graphicsFamily, m_QueueFamilies.transferFamily };
+
+    if ((imageInfo.usage & VK_IMAGE_USAGE_TRANSFER_DST_BIT) && queueFamilyIndices[0] != queueFamilyIndices[1])
+    {
+        sharedImageInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+        sharedImageInfo.queueFamilyIndexCount = 2;
+        sharedImageInfo.pQueueFamilyIndices = queueFamilyIndices;
+    }
+
+    if (vkCreateImage(m_Device, &sharedImageInfo, nullptr, &image) != VK_SUCCESS) 
+    {
+        image = VK_NULL_HANDLE;
+        return false;
+    }
 
     VkMemoryRequirements memRequirements;
     vkGetImageMemoryRequirements(m_Device, image, &memRequirements);
 
-    VkMemoryAllocateInfo allocInfo{};
-    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    allocInfo.allocationSize = memRequirements.size;
-    allocInfo.memoryTypeIndex = FindMemoryType(memRequirements.memoryTypeBits, properties);
+    bool isOptimalImage = imageInfo.tiling == VK_IMAGE_TILING_OPTIMAL;
 
-    if (vkAllocateMemory(m_Device, &allocInfo, nullptr, &imageMemory) != VK_SUCCESS) 
+    // out of device memory, or at the device's allocation count
+    if (!m_MemoryAllocator.Allocate(memRequirements, properties, isOptimalImage, imageAllocation)) 
     {
-        throw std::runtime_error("failed to allocate image memory!");
+        vkDestroyImage(m_Device, image, nullptr);
+        image = VK_NULL_HANDLE;
+        return false;
     }
 
-    if (vkBindImageMemory(m_Device, image, imageMemory, 0) != VK_SUCCESS) 
+    if (vkBindImageMemory(m_Device, image, imageAllocation.memory, imageAllocation.offset) != VK_SUCCESS) 
     {
-        throw std::runtime_error("failed to bind image memory!");
+        DestroyImage(image, imageAllocation);
+        return false;
     }
+
+    return true;
+}
+
+void LTVKDevice::DestroyImage(VkImage& image, LTVKAllocation& imageAllocation)
+{
+    vkDestroyImage(m_Device, image, nullptr);
+    m_MemoryAllocator.Free(imageAllocation);
+
+    image = VK_NULL_HANDLE;
 }
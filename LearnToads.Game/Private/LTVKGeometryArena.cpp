@@ -0,0 +1,153 @@
+#include "PrecompiledHeader.h"
+
+#include "LTVKGeometryArena.h"
+#include "LTVKDevice.h"
+
+bool LTVKGeometryArena::Initialize(LTVKDevice* ltvkDevice)
+{
+    m_LTVKDevice = ltvkDevice;
+
+    m_LTVKDevice->CreateBuffer(
+        LT_VK_GEOMETRY_ARENA_VERTEX_BYTES,
+        VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+        m_VertexBuffer,
+        m_VertexAllocation);
+
+    m_LTVKDevice->CreateBuffer(
+        LT_VK_GEOMETRY_ARENA_INDEX_BYTES,
+        VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+        m_IndexBuffer,
+        m_IndexAllocation);
+
+    m_VertexRanges.Initialize(LT_VK_GEOMETRY_ARENA_VERTEX_BYTES);
+    m_IndexRanges.Initialize(LT_VK_GEOMETRY_ARENA_INDEX_BYTES);
+
+    return true;
+}
+
+void LTVKGeometryArena::Destroy()
+{
+    std::scoped_lock lock(m_Mutex);
+
+    if (m_VertexRanges.GetAllocationCount() > 0 || m_IndexRanges.GetAllocationCount() > 0)
+    {
+        printf("geometry arena: %u vertex and %u index ranges were never freed \n",
+            m_VertexRanges.GetAllocationCount(),
+            m_IndexRanges.GetAllocationCount());
+    }
+
+    m_LTVKDevice->DestroyBuffer(m_VertexBuffer, m_VertexAllocation);
+    m_LTVKDevice->DestroyBuffer(m_IndexBuffer, m_IndexAllocation);
+}
+
+bool LTVKGeometryArena::AllocateVertices(VkDeviceSize size, uint32_t stride, LTVKGeometryRange& outRange)
+{
+    // the allocator aligns to powers of two only. any other stride cannot be an
+    // alignment, so the range is padded by up to a vertex and its start rounded up
+    // to the next whole vertex instead
+    bool isPowerOfTwo = (stride & (stride - 1)) == 0;
+    VkDeviceSize alignment = isPowerOfTwo ? stride : 1;
+    VkDeviceSize paddedSize = isPowerOfTwo ? size : size + stride - 1;
+
+    std::scoped_lock lock(m_Mutex);
+
+    VkDeviceSize offset;
+
+    if (!m_VertexRanges.Allocate(paddedSize, alignment, outRange.range, offset))
+    {
+        ++m_FailedCount;
+        return false;
+    }
+
+    outRange.offset = (offset + stride - 1) / stride * stride;
+    outRange.size = size;
+
+    assert(outRange.offset % stride == 0);
+
+    VkDeviceSize usedBytes = m_VertexRanges.GetUsedBytes();
+    m_PeakVertexBytes = usedBytes > m_PeakVertexBytes ? usedBytes : m_PeakVertexBytes;
+
+    return true;
+}
+
+bool LTVKGeometryArena::AllocateIndices(VkDeviceSize size, uint32_t indexSize, LTVKGeometryRange& outRange)
+{
+    std::scoped_lock lock(m_Mutex);
+
+    if (!m_IndexRanges.Allocate(size, indexSize, outRange.range, outRange.offset))
+    {
+        ++m_FailedCount;
+        return false;
+    }
+
+    outRange.size = size;
+
+    VkDeviceSize usedBytes = m_IndexRanges.GetUsedBytes();
+    m_PeakIndexBytes = usedBytes > m_PeakIndexBytes ? usedBytes : m_PeakIndexBytes;
+
+    return true;
+}
+
+void LTVKGeometryArena::FreeVertices(LTVKGeometryRange& range)
+{
+    if (range.range == LT_VK_NO_RANGE)
+    {
+        return;
+    }
+
+    {
+        std::scoped_lock lock(m_Mutex);
+        m_VertexRanges.Free(range.range);
+    }
+
+    range = LTVKGeometryRange();
+}
+
+void LTVKGeometryArena::FreeIndices(LTVKGeometryRange& range)
+{
+    if (range.range == LT_VK_NO_RANGE)
+    {
+        return;
+    }
+
+    {
+        std::scoped_lock lock(m_Mutex);
+        m_IndexRanges.Free(range.range);
+    }
+
+    range = LTVKGeometryRange();
+}
+
+void LTVKGeometryArena::PrintStats()
+{
+    std::scoped_lock lock(m_Mutex);
+
+    uint32_t vertexFreeRangeCount = 0;
+    VkDeviceSize vertexLargestFreeRange = 0;
+    m_VertexRanges.GetFreeRanges(vertexFreeRangeCount, vertexLargestFreeRange);
+
+    uint32_t indexFreeRangeCount = 0;
+    VkDeviceSize indexLargestFreeRange = 0;
+    m_IndexRanges.GetFreeRanges(indexFreeRangeCount, indexLargestFreeRange);
+
+    printf("geometry arena vertices: %llu / %llu bytes in %u ranges, peak %llu, "
+        "%u free ranges, largest %llu \n",
+        (unsigned long long)m_VertexRanges.GetUsedBytes(),
+        (unsigned long long)m_VertexRanges.GetSize(),
+        m_VertexRanges.GetAllocationCount(),
+        (unsigned long long)m_PeakVertexBytes,
+        vertexFreeRangeCount,
+        (unsigned long long)vertexLargestFreeRange);
+
+    printf("geometry arena indices: %llu / %llu bytes in %u ranges, peak %llu, "
+        "%u free ranges, largest %llu, %u allocations did not fit \n",
+        (unsigned long long)m_IndexRanges.GetUsedBytes(),
+        (unsigned long long)m_IndexRanges.GetSize(),
+        m_IndexRanges.GetAllocationCount(),
+        (unsigned long long)m_PeakIndexBytes,
+        indexFreeRangeCount,
+        (unsigned long long)indexLargestFreeRange,
+        m_FailedCount);
+}
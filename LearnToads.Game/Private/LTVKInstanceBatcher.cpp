@@ -0,0 +1,638 @@
+#include "PrecompiledHeader.h"
+
+#include "LTVKInstanceBatcher.h"
+#include "LTVKDevice.h"
+#include "LTAsset.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include <glm/matrix.hpp>
+
+bool LTVKInstanceBatcher::Initialize(LTVKDevice* ltvkDevice, uint32_t framesInFlight)
+{
+    m_LTVKDevice = ltvkDevice;
+    m_Device = ltvkDevice->GetDevice();
+
+    // without it every indirect command's first instance must be 0, which would
+    // point every batch at the first batch's transforms
+    m_UseIndirectDraws = ltvkDevice->GetEnabledFeatures().drawIndirectFirstInstance == VK_TRUE;
+
+    // without it an indirect draw issues a single command, so each command is drawn
+    // on its own
+    m_UseMultiDrawIndirect = m_UseIndirectDraws && ltvkDevice->GetEnabledFeatures().multiDrawIndirect == VK_TRUE;
+    m_MaxDrawIndirectCount = m_UseMultiDrawIndirect ? ltvkDevice->GetProperties().limits.maxDrawIndirectCount : 1;
+
+    if (!CreateLayouts(framesInFlight))
+    {
+        return false;
+    }
+
+    m_Frames.resize(framesInFlight);
+
+    eastl::vector<VkDescriptorSetLayout> setLayouts(framesInFlight, m_DescriptorSetLayout);
+    eastl::vector<VkDescriptorSet> descriptorSets(framesInFlight, VK_NULL_HANDLE);
+
+    VkDescriptorSetAllocateInfo allocInfo = {};
+    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocInfo.descriptorPool = m_DescriptorPool;
+    allocInfo.descriptorSetCount = framesInFlight;
+    allocInfo.pSetLayouts = setLayouts.data();
+
+    if (vkAllocateDescriptorSets(m_Device, &allocInfo, descriptorSets.data()) != VK_SUCCESS)
+    {
+        return false;
+    }
+
+    for (uint32_t i = 0; i < framesInFlight; ++i)
+    {
+        LTVKInstanceFrame& frame = m_Frames[i];
+        frame.descriptorSet = descriptorSets[i];
+
+        GrowInstanceBuffer(frame, LT_VK_INSTANCE_INITIAL_CAPACITY);
+        GrowIndirectBuffer(frame, 16);
+    }
+
+    // the initial buffers are not growth
+    m_GrowCount = 0;
+
+    return true;
+}
+
+void LTVKInstanceBatcher::Destroy()
+{
+    for (LTVKInstanceFrame& frame : m_Frames)
+    {
+        if (frame.instanceBuffer != VK_NULL_HANDLE)
+        {
+            m_LTVKDevice->DestroyBuffer(frame.instanceBuffer, frame.instanceAllocation);
+        }
+
+        if (frame.indirectBuffer != VK_NULL_HANDLE)
+        {
+            m_LTVKDevice->DestroyBuffer(frame.indirectBuffer, frame.indirectAllocation);
+        }
+    }
+
+    m_Frames.clear();
+    m_Batches.clear();
+    m_DrawOrder.clear();
+    m_Commands.clear();
+    m_Draws.clear();
+    m_CurrentFrame = nullptr;
+
+    // destroying the pool frees the descriptor sets allocated from it
+    vkDestroyDescriptorPool(m_Device, m_DescriptorPool, nullptr);
+    vkDestroyPipelineLayout(m_Device, m_PipelineLayout, nullptr);
+    vkDestroyDescriptorSetLayout(m_Device, m_DescriptorSetLayout, nullptr);
+    vkDestroySampler(m_Device, m_Sampler, nullptr);
+
+    m_DescriptorPool = VK_NULL_HANDLE;
+    m_PipelineLayout = VK_NULL_HANDLE;
+    m_DescriptorSetLayout = VK_NULL_HANDLE;
+    m_Sampler = VK_NULL_HANDLE;
+}
+
+void LTVKInstanceBatcher::BeginFrame(uint32_t frameIndex)
+{
+    assert(frameIndex < m_Frames.size());
+
+    m_CurrentFrame = &m_Frames[frameIndex];
+
+    // a batch that got no instances last frame is dropped, so batches of models no
+    // longer drawn, or since unloaded, do not pile up; the others keep their storage
+    uint32_t keptCount = 0;
+
+    for (uint32_t i = 0; i < m_Batches.size(); ++i)
+    {
+        if (m_Batches[i].transforms.empty())
+        {
+            continue;
+        }
+
+        if (keptCount != i)
+        {
+            m_Batches[keptCount] = std::move(m_Batches[i]);
+        }
+
+        m_Batches[keptCount].transforms.clear();
+        m_Batches[keptCount].meshletMasks.clear();
+        ++keptCount;
+    }
+
+    m_Batches.resize(keptCount);
+    m_LastBatch = 0;
+    m_IsCulling = false;
+
+    m_DrawOrder.clear();
+    m_Commands.clear();
+}
+
+void LTVKInstanceBatcher::SetCamera(const glm::mat4& viewProjection, const glm::vec3& cameraPosition)
+{
+    assert(m_CurrentFrame != nullptr);
+
+    m_ViewProjection = viewProjection;
+    m_CameraPosition = cameraPosition;
+    m_IsCulling = true;
+}
+
+void LTVKInstanceBatcher::SetTexture(VkImageView imageView)
+{
+    assert(m_CurrentFrame != nullptr);
+
+    // the GPU is done with the frame's set, so it can be pointed elsewhere; a
+    // texture that stayed the same is left alone
+    if (imageView == m_CurrentFrame->textureView)
+    {
+        return;
+    }
+
+    VkDescriptorImageInfo imageInfo = {};
+    imageInfo.sampler = m_Sampler;
+    imageInfo.imageView = imageView;
+    imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+    VkWriteDescriptorSet write = {};
+    write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.dstSet = m_CurrentFrame->descriptorSet;
+    write.dstBinding = 1;
+    write.descriptorCount = 1;
+    write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    write.pImageInfo = &imageInfo;
+
+    vkUpdateDescriptorSets(m_Device, 1, &write, 0, nullptr);
+
+    m_CurrentFrame->textureView = imageView;
+}
+
+void LTVKInstanceBatcher::AddInstance(VkPipeline pipeline, const LTModel* model, uint32_t lod, const glm::mat4& transform)
+{
+    assert(m_CurrentFrame != nullptr);
+    assert(lod < model->GetLODCount());
+
+    LTVKInstanceBatch& batch = m_Batches[FindBatch(pipeline, model, lod)];
+    const LTModelMeshlets& meshlets = model->GetLOD(lod).meshlets;
+
+    // meshlets are culled in model space: the frustum comes from the instance's
+    // model-view-projection and the camera is moved into the model's space
+    if (m_IsCulling && !meshlets.bounds.empty())
+    {
+        LTFrustum frustum;
+        LTMeshletCulling::ExtractFrustum(m_ViewProjection * transform, frustum);
+
+        glm::vec4 camera = glm::inverse(transform) * glm::vec4(m_CameraPosition.x, m_CameraPosition.y, m_CameraPosition.z, 1.0f);
+
+        if (batch.meshletMasks.empty())
+        {
+            batch.meshletMasks.resize(meshlets.bounds.size(), 0);
+        }
+
+        if (LTMeshletCulling::MarkVisibleMeshlets(meshlets, frustum, glm::vec3(camera.x, camera.y, camera.z), batch.meshletMasks.data()) == 0)
+        {
+            ++m_CulledInstanceCount;
+            return;
+        }
+    }
+
+    LTVKInstanceTransform instance;
+
+    // glm is column-major, so row i is m[0][i], m[1][i], m[2][i], m[3][i]
+    for (uint32_t row = 0; row < 3; ++row)
+    {
+        for (uint32_t column = 0; column < 4; ++column)
+        {
+            instance.rows[row][column] = transform[column][row];
+        }
+    }
+
+    batch.transforms.push_back(instance);
+}
+
+void LTVKInstanceBatcher::Prepare()
+{
+    assert(m_CurrentFrame != nullptr);
+
+    LTVKInstanceFrame& frame = *m_CurrentFrame;
+
+    m_DrawOrder.clear();
+    m_Commands.clear();
+    m_Draws.clear();
+
+    uint32_t instanceCount = 0;
+
+    for (uint32_t i = 0; i < m_Batches.size(); ++i)
+    {
+        if (!m_Batches[i].transforms.empty())
+        {
+            m_DrawOrder.push_back(i);
+            instanceCount += (uint32_t)m_Batches[i].transforms.size();
+        }
+    }
+
+    // sorted so each pipeline, and each model under it, is bound once, and the
+    // commands of a model's levels under a pipeline are next to each other
+    std::sort(m_DrawOrder.begin(), m_DrawOrder.end(), [this](uint32_t a, uint32_t b)
+    {
+        const LTVKInstanceBatch& batchA = m_Batches[a];
+        const LTVKInstanceBatch& batchB = m_Batches[b];
+
+        if (batchA.pipeline != batchB.pipeline)
+        {
+            return batchA.pipeline < batchB.pipeline;
+        }
+
+        if (batchA.model != batchB.model)
+        {
+            return batchA.model < batchB.model;
+        }
+
+        return batchA.lod < batchB.lod;
+    });
+
+    // the frame's last use has completed, so its buffers can be replaced right away
+    if (instanceCount > frame.instanceCapacity)
+    {
+        GrowInstanceBuffer(frame, instanceCount);
+    }
+
+    // written front to back in one pass, which suits write-combined memory
+    LTVKInstanceTransform* instances = (LTVKInstanceTransform*)frame.instanceAllocation.mappedData;
+    uint32_t firstInstance = 0;
+
+    for (uint32_t batchIndex : m_DrawOrder)
+    {
+        LTVKInstanceBatch& batch = m_Batches[batchIndex];
+        uint32_t batchInstanceCount = (uint32_t)batch.transforms.size();
+
+        memcpy(instances + firstInstance, batch.transforms.data(), batchInstanceCount * sizeof(LTVKInstanceTransform));
+
+        // every instance of the batch draws the meshlets any of them sees
+        const LTModelMesh& mesh = batch.model->GetLOD(batch.lod);
+
+        if (batch.meshletMasks.empty())
+        {
+            m_Ranges.clear();
+            m_Ranges.push_back({ 0, mesh.indexCount });
+        }
+        else
+        {
+            LTMeshletCulling::BuildDrawRanges(mesh.meshlets, batch.meshletMasks.data(), m_Ranges);
+        }
+
+        batch.firstCommand = (uint32_t)m_Commands.size();
+        batch.commandCount = (uint32_t)m_Ranges.size();
+
+        // the level's indices are relative to its first vertex
+        for (const LTMeshletDrawRange& range : m_Ranges)
+        {
+            VkDrawIndexedIndirectCommand command = {};
+            command.indexCount = range.indexCount;
+            command.instanceCount = batchInstanceCount;
+            command.firstIndex = mesh.firstIndex + range.firstIndex;
+            command.vertexOffset = mesh.firstVertex;
+            command.firstInstance = firstInstance;
+
+            m_Commands.push_back(command);
+        }
+
+        firstInstance += batchInstanceCount;
+
+        // the levels of a model differ only in their commands, so the batches of a
+        // pipeline and model are drawn together
+        if (m_Draws.empty() || m_Draws.back().pipeline != batch.pipeline || m_Draws.back().model != batch.model)
+        {
+            LTVKInstanceDraw draw;
+            draw.pipeline = batch.pipeline;
+            draw.model = batch.model;
+            draw.firstCommand = batch.firstCommand;
+
+            m_Draws.push_back(draw);
+        }
+
+        m_Draws.back().commandCount += batch.commandCount;
+    }
+
+    // one call per draw, or per command without multiDrawIndirect
+    uint64_t drawCallCount = 0;
+
+    for (const LTVKInstanceDraw& draw : m_Draws)
+    {
+        drawCallCount += (draw.commandCount + m_MaxDrawIndirectCount - 1) / m_MaxDrawIndirectCount;
+    }
+
+    if (m_Commands.size() > frame.commandCapacity)
+    {
+        GrowIndirectBuffer(frame, (uint32_t)m_Commands.size());
+    }
+
+    if (!m_Commands.empty())
+    {
+        memcpy(frame.indirectAllocation.mappedData, m_Commands.data(), m_Commands.size() * sizeof(VkDrawIndexedIndirectCommand));
+    }
+
+    ++m_FrameCount;
+    m_InstanceCount += instanceCount;
+    m_BatchCount += m_DrawOrder.size();
+    m_CommandCount += m_Commands.size();
+    m_DrawCallCount += drawCallCount;
+}
+
+void LTVKInstanceBatcher::Draw(VkCommandBuffer commandBuffer, const glm::mat4& viewProjection) const
+{
+    const LTVKInstanceFrame& frame = *m_CurrentFrame;
+
+    // the set cannot be bound until it points at a texture
+    if (m_DrawOrder.empty() || frame.textureView == VK_NULL_HANDLE)
+    {
+        return;
+    }
+
+    // the set and push constants stay bound across the pipelines, which all share
+    // the layout
+    vkCmdBindDescriptorSets(
+        commandBuffer,
+        VK_PIPELINE_BIND_POINT_GRAPHICS,
+        m_PipelineLayout,
+        0,
+        1,
+        &frame.descriptorSet,
+        0,
+        nullptr);
+
+    // every level of every model is in the arena, so its buffers are bound once
+    const LTVKGeometryArena& geometryArena = m_LTVKDevice->GetGeometryArena();
+    VkBuffer vertexBuffer = geometryArena.GetVertexBuffer();
+    VkDeviceSize vertexOffset = 0;
+
+    vkCmdBindVertexBuffers(commandBuffer, 0, 1, &vertexBuffer, &vertexOffset);
+
+    LTVKInstancePushConstants pushConstants = {};
+    pushConstants.viewProjection = viewProjection;
+
+    VkPipeline boundPipeline = VK_NULL_HANDLE;
+    const LTModel* boundModel = nullptr;
+    VkIndexType boundIndexType = VK_INDEX_TYPE_MAX_ENUM;
+
+    for (const LTVKInstanceDraw& draw : m_Draws)
+    {
+        if (draw.pipeline != boundPipeline)
+        {
+            vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, draw.pipeline);
+            boundPipeline = draw.pipeline;
+        }
+
+        if (draw.model != boundModel)
+        {
+            const LTModelVertexDecode& vertexDecode = draw.model->GetVertexDecode();
+
+            for (uint32_t axis = 0; axis < 3; ++axis)
+            {
+                pushConstants.positionScale[axis] = vertexDecode.positionScale[axis];
+                pushConstants.positionOffset[axis] = vertexDecode.positionOffset[axis];
+            }
+
+            pushConstants.positionScale[3] =
+                draw.model->GetVertexFormat() == LTModelVertexFormat::LT_MODEL_VERTEX_FORMAT_QUANTIZED ? 1.0f : 0.0f;
+
+            vkCmdPushConstants(
+                commandBuffer,
+                m_PipelineLayout,
+                VK_SHADER_STAGE_VERTEX_BIT,
+                0,
+                sizeof(LTVKInstancePushConstants),
+                &pushConstants);
+
+            boundModel = draw.model;
+        }
+
+        // the first index of each command counts in the model's index size
+        if (draw.model->GetIndexType() != boundIndexType)
+        {
+            boundIndexType = draw.model->GetIndexType();
+            vkCmdBindIndexBuffer(commandBuffer, geometryArena.GetIndexBuffer(), 0, boundIndexType);
+        }
+
+        if (m_UseIndirectDraws)
+        {
+            // without multiDrawIndirect the most is 1
+            for (uint32_t drawn = 0; drawn < draw.commandCount; drawn += m_MaxDrawIndirectCount)
+            {
+                uint32_t remaining = draw.commandCount - drawn;
+
+                vkCmdDrawIndexedIndirect(
+                    commandBuffer,
+                    frame.indirectBuffer,
+                    (draw.firstCommand + drawn) * sizeof(VkDrawIndexedIndirectCommand),
+                    remaining < m_MaxDrawIndirectCount ? remaining : m_MaxDrawIndirectCount,
+                    sizeof(VkDrawIndexedIndirectCommand));
+            }
+        }
+        else
+        {
+            for (uint32_t commandIndex = draw.firstCommand; commandIndex < draw.firstCommand + draw.commandCount; ++commandIndex)
+            {
+                const VkDrawIndexedIndirectCommand& command = m_Commands[commandIndex];
+
+                vkCmdDrawIndexed(
+                    commandBuffer,
+                    command.indexCount,
+                    command.instanceCount,
+                    command.firstIndex,
+                    command.vertexOffset,
+                    command.firstInstance);
+            }
+        }
+    }
+}
+
+void LTVKInstanceBatcher::PrintStats()
+{
+    double instancesPerFrame = m_FrameCount > 0 ? (double)m_InstanceCount / m_FrameCount : 0.0;
+    double culledPerFrame = m_FrameCount > 0 ? (double)m_CulledInstanceCount / m_FrameCount : 0.0;
+    double batchesPerFrame = m_FrameCount > 0 ? (double)m_BatchCount / m_FrameCount : 0.0;
+    double commandsPerFrame = m_FrameCount > 0 ? (double)m_CommandCount / m_FrameCount : 0.0;
+    double drawCallsPerFrame = m_FrameCount > 0 ? (double)m_DrawCallCount / m_FrameCount : 0.0;
+
+    printf("instance batcher: %llu frames, %.1f instances (%.1f culled) in %.1f batches, "
+        "%.1f commands in %.1f %s draws per frame, %u buffer grows \n",
+        (unsigned long long)m_FrameCount,
+        instancesPerFrame,
+        culledPerFrame,
+        batchesPerFrame,
+        commandsPerFrame,
+        drawCallsPerFrame,
+        m_UseMultiDrawIndirect ? "multi-draw indirect" : m_UseIndirectDraws ? "indirect" : "direct",
+        m_GrowCount);
+}
+
+bool LTVKInstanceBatcher::CreateLayouts(uint32_t framesInFlight)
+{
+    // the textures are streamed, so the sampler takes whatever levels the view has
+    VkSamplerCreateInfo samplerInfo = {};
+    samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+    samplerInfo.magFilter = VK_FILTER_LINEAR;
+    samplerInfo.minFilter = VK_FILTER_LINEAR;
+    samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+    samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+    samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+    samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+    samplerInfo.anisotropyEnable = VK_TRUE;
+    samplerInfo.maxAnisotropy = m_LTVKDevice->GetProperties().limits.maxSamplerAnisotropy < 8.0f
+        ? m_LTVKDevice->GetProperties().limits.maxSamplerAnisotropy
+        : 8.0f;
+    samplerInfo.minLod = 0.0f;
+    samplerInfo.maxLod = VK_LOD_CLAMP_NONE;
+
+    if (vkCreateSampler(m_Device, &samplerInfo, nullptr, &m_Sampler) != VK_SUCCESS)
+    {
+        return false;
+    }
+
+    VkDescriptorSetLayoutBinding bindings[2] = {};
+    bindings[0].binding = 0;
+    bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    bindings[0].descriptorCount = 1;
+    bindings[0].stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+    bindings[1].binding = 1;
+    bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    bindings[1].descriptorCount = 1;
+    bindings[1].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+
+    VkDescriptorSetLayoutCreateInfo setLayoutInfo = {};
+    setLayoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    setLayoutInfo.bindingCount = 2;
+    setLayoutInfo.pBindings = bindings;
+
+    if (vkCreateDescriptorSetLayout(m_Device, &setLayoutInfo, nullptr, &m_DescriptorSetLayout) != VK_SUCCESS)
+    {
+        return false;
+    }
+
+    // 96 bytes, inside the 128 every device guarantees
+    VkPushConstantRange pushConstantRange = {};
+    pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+    pushConstantRange.offset = 0;
+    pushConstantRange.size = sizeof(LTVKInstancePushConstants);
+
+    VkPipelineLayoutCreateInfo layoutInfo = {};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    layoutInfo.setLayoutCount = 1;
+    layoutInfo.pSetLayouts = &m_DescriptorSetLayout;
+    layoutInfo.pushConstantRangeCount = 1;
+    layoutInfo.pPushConstantRanges = &pushConstantRange;
+
+    if (vkCreatePipelineLayout(m_Device, &layoutInfo, nullptr, &m_PipelineLayout) != VK_SUCCESS)
+    {
+        return false;
+    }
+
+    VkDescriptorPoolSize poolSizes[2] = {};
+    poolSizes[0].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    poolSizes[0].descriptorCount = framesInFlight;
+    poolSizes[1].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    poolSizes[1].descriptorCount = framesInFlight;
+
+    VkDescriptorPoolCreateInfo poolInfo = {};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.maxSets = framesInFlight;
+    poolInfo.poolSizeCount = 2;
+    poolInfo.pPoolSizes = poolSizes;
+
+    return vkCreateDescriptorPool(m_Device, &poolInfo, nullptr, &m_DescriptorPool) == VK_SUCCESS;
+}
+
+void LTVKInstanceBatcher::GrowInstanceBuffer(LTVKInstanceFrame& frame, uint32_t instanceCount)
+{
+    // doubled so a count that creeps up grows the buffer only a few times
+    uint32_t capacity = frame.instanceCapacity * 2 > instanceCount ? frame.instanceCapacity * 2 : instanceCount;
+
+    if (frame.instanceBuffer != VK_NULL_HANDLE)
+    {
+        m_LTVKDevice->DestroyBuffer(frame.instanceBuffer, frame.instanceAllocation);
+    }
+
+    // written once by the CPU and read once by the GPU each frame, so it is left in
+    // host-visible memory rather than copied to device-local memory
+    m_LTVKDevice->CreateBuffer(
+        (VkDeviceSize)capacity * sizeof(LTVKInstanceTransform),
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        frame.instanceBuffer,
+        frame.instanceAllocation);
+
+    frame.instanceCapacity = capacity;
+
+    VkDescriptorBufferInfo bufferInfo = {};
+    bufferInfo.buffer = frame.instanceBuffer;
+    bufferInfo.offset = 0;
+    bufferInfo.range = VK_WHOLE_SIZE;
+
+    VkWriteDescriptorSet write = {};
+    write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.dstSet = frame.descriptorSet;
+    write.dstBinding = 0;
+    write.descriptorCount = 1;
+    write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    write.pBufferInfo = &bufferInfo;
+
+    vkUpdateDescriptorSets(m_Device, 1, &write, 0, nullptr);
+
+    ++m_GrowCount;
+}
+
+void LTVKInstanceBatcher::GrowIndirectBuffer(LTVKInstanceFrame& frame, uint32_t commandCount)
+{
+    uint32_t capacity = frame.commandCapacity * 2 > commandCount ? frame.commandCapacity * 2 : commandCount;
+
+    if (frame.indirectBuffer != VK_NULL_HANDLE)
+    {
+        m_LTVKDevice->DestroyBuffer(frame.indirectBuffer, frame.indirectAllocation);
+    }
+
+    m_LTVKDevice->CreateBuffer(
+        (VkDeviceSize)capacity * sizeof(VkDrawIndexedIndirectCommand),
+        VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        frame.indirectBuffer,
+        frame.indirectAllocation);
+
+    frame.commandCapacity = capacity;
+
+    ++m_GrowCount;
+}
+
+uint32_t LTVKInstanceBatcher::FindBatch(VkPipeline pipeline, const LTModel* model, uint32_t lod)
+{
+    // copies of a model are usually added one after another, so the last batch is
+    // checked before the rest; a frame has few batches, so the rest are searched
+    if (m_LastBatch < m_Batches.size())
+    {
+        const LTVKInstanceBatch& lastBatch = m_Batches[m_LastBatch];
+
+        if (lastBatch.pipeline == pipeline && lastBatch.model == model && lastBatch.lod == lod)
+        {
+            return m_LastBatch;
+        }
+    }
+
+    for (uint32_t i = 0; i < m_Batches.size(); ++i)
+    {
+        const LTVKInstanceBatch& batch = m_Batches[i];
+
+        if (batch.pipeline == pipeline && batch.model == model && batch.lod == lod)
+        {
+            m_LastBatch = i;
+            return i;
+        }
+    }
+
+    LTVKInstanceBatch batch;
+    batch.pipeline = pipeline;
+    batch.model = model;
+    batch.lod = lod;
+
+    m_Batches.push_back(std::move(batch));
+    m_LastBatch = (uint32_t)m_Batches.size() - 1;
+    return m_LastBatch;
+}
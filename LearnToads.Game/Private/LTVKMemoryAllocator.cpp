@@ -0,0 +1,694 @@
+#include "PrecompiledHeader.h"
+
+#include "LTVKMemoryAllocator.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+/**
+ * Gets the index of the highest set bit; the value must not be 0.
+ */
+static uint32_t HighestBit(uint64_t value)
+{
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanReverse64(&index, value);
+    return (uint32_t)index;
+#else
+    return 63 - (uint32_t)__builtin_clzll(value);
+#endif
+}
+
+/**
+ * Gets the index of the lowest set bit; the value must not be 0.
+ */
+static uint32_t LowestBit(uint64_t value)
+{
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward64(&index, value);
+    return (uint32_t)index;
+#else
+    return (uint32_t)__builtin_ctzll(value);
+#endif
+}
+
+static VkDeviceSize AlignUp(VkDeviceSize value, VkDeviceSize alignment)
+{
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+void LTVKTlsfAllocator::Initialize(VkDeviceSize size)
+{
+    m_Ranges.clear();
+    m_UnusedRanges.clear();
+
+    for (uint32_t firstLevel = 0; firstLevel < LT_VK_TLSF_FL_COUNT; ++firstLevel)
+    {
+        m_SecondLevelBitmaps[firstLevel] = 0;
+
+        for (uint32_t secondLevel = 0; secondLevel < LT_VK_TLSF_SL_COUNT; ++secondLevel)
+        {
+            m_FreeHeads[firstLevel][secondLevel] = LT_VK_NO_RANGE;
+        }
+    }
+
+    m_FirstLevelBitmap = 0;
+    m_Size = size & ~(LT_VK_TLSF_MIN_SIZE - 1);
+    m_UsedBytes = 0;
+    m_AllocationCount = 0;
+
+    m_FirstRange = NewRange();
+    m_Ranges[m_FirstRange].offset = 0;
+    m_Ranges[m_FirstRange].size = m_Size;
+
+    InsertFree(m_FirstRange);
+}
+
+void LTVKTlsfAllocator::GetBin(VkDeviceSize size, uint32_t& outFirstLevel, uint32_t& outSecondLevel)
+{
+    // the first level is the power of two at or below the size; the second is the
+    // next LT_VK_TLSF_SL_BITS bits below it
+    uint32_t highestBit = HighestBit(size);
+
+    outFirstLevel = highestBit - LT_VK_TLSF_SL_BITS;
+    outSecondLevel = (uint32_t)(size >> (highestBit - LT_VK_TLSF_SL_BITS)) - LT_VK_TLSF_SL_COUNT;
+}
+
+uint32_t LTVKTlsfAllocator::FindFree(VkDeviceSize size) const
+{
+    // rounding up to the next bin boundary means every range in the bin found fits
+    uint32_t highestBit = HighestBit(size);
+    VkDeviceSize rounded = size + (1ull << (highestBit - LT_VK_TLSF_SL_BITS)) - 1;
+
+    if (rounded < size || rounded > m_Size)
+    {
+        return LT_VK_NO_RANGE;
+    }
+
+    uint32_t firstLevel;
+    uint32_t secondLevel;
+    GetBin(rounded, firstLevel, secondLevel);
+
+    uint32_t secondLevelMap = m_SecondLevelBitmaps[firstLevel] & (~0u << secondLevel);
+
+    if (secondLevelMap == 0)
+    {
+        uint64_t firstLevelMap = firstLevel + 1 < 64 ? m_FirstLevelBitmap & (~0ull << (firstLevel + 1)) : 0;
+
+        if (firstLevelMap == 0)
+        {
+            return LT_VK_NO_RANGE;
+        }
+
+        firstLevel = LowestBit(firstLevelMap);
+        secondLevelMap = m_SecondLevelBitmaps[firstLevel];
+    }
+
+    return m_FreeHeads[firstLevel][LowestBit(secondLevelMap)];
+}
+
+void LTVKTlsfAllocator::InsertFree(uint32_t range)
+{
+    uint32_t firstLevel;
+    uint32_t secondLevel;
+    GetBin(m_Ranges[range].size, firstLevel, secondLevel);
+
+    uint32_t head = m_FreeHeads[firstLevel][secondLevel];
+
+    m_Ranges[range].isFree = true;
+    m_Ranges[range].prevFree = LT_VK_NO_RANGE;
+    m_Ranges[range].nextFree = head;
+
+    if (head != LT_VK_NO_RANGE)
+    {
+        m_Ranges[head].prevFree = range;
+    }
+
+    m_FreeHeads[firstLevel][secondLevel] = range;
+    m_FirstLevelBitmap |= 1ull << firstLevel;
+    m_SecondLevelBitmaps[firstLevel] |= 1u << secondLevel;
+}
+
+void LTVKTlsfAllocator::RemoveFree(uint32_t range)
+{
+    LTVKMemoryRange& freeRange = m_Ranges[range];
+
+    uint32_t firstLevel;
+    uint32_t secondLevel;
+    GetBin(freeRange.size, firstLevel, secondLevel);
+
+    if (freeRange.prevFree != LT_VK_NO_RANGE)
+    {
+        m_Ranges[freeRange.prevFree].nextFree = freeRange.nextFree;
+    }
+    else
+    {
+        m_FreeHeads[firstLevel][secondLevel] = freeRange.nextFree;
+    }
+
+    if (freeRange.nextFree != LT_VK_NO_RANGE)
+    {
+        m_Ranges[freeRange.nextFree].prevFree = freeRange.prevFree;
+    }
+
+    if (m_FreeHeads[firstLevel][secondLevel] == LT_VK_NO_RANGE)
+    {
+        m_SecondLevelBitmaps[firstLevel] &= ~(1u << secondLevel);
+
+        if (m_SecondLevelBitmaps[firstLevel] == 0)
+        {
+            m_FirstLevelBitmap &= ~(1ull << firstLevel);
+        }
+    }
+
+    freeRange.isFree = false;
+    freeRange.prevFree = LT_VK_NO_RANGE;
+    freeRange.nextFree = LT_VK_NO_RANGE;
+}
+
+uint32_t LTVKTlsfAllocator::NewRange()
+{
+    if (!m_UnusedRanges.empty())
+    {
+        uint32_t range = m_UnusedRanges.back();
+        m_UnusedRanges.pop_back();
+        return range;
+    }
+
+    m_Ranges.push_back(LTVKMemoryRange());
+    return (uint32_t)(m_Ranges.size() - 1);
+}
+
+void LTVKTlsfAllocator::ReleaseRange(uint32_t range)
+{
+    m_Ranges[range] = LTVKMemoryRange();
+    m_UnusedRanges.push_back(range);
+}
+
+bool LTVKTlsfAllocator::Allocate(
+    VkDeviceSize size,
+    VkDeviceSize alignment,
+    uint32_t& outRange,
+    VkDeviceSize& outOffset)
+{
+    size = AlignUp(size > 0 ? size : 1, LT_VK_TLSF_MIN_SIZE);
+    alignment = alignment > LT_VK_TLSF_MIN_SIZE ? alignment : LT_VK_TLSF_MIN_SIZE;
+
+    // every offset is a multiple of the minimum size, so aligning one moves it
+    // forward by at most this much
+    VkDeviceSize searchSize = size + alignment - LT_VK_TLSF_MIN_SIZE;
+    uint32_t range = FindFree(searchSize);
+
+    if (range == LT_VK_NO_RANGE)
+    {
+        return false;
+    }
+
+    RemoveFree(range);
+
+    VkDeviceSize alignedOffset = AlignUp(m_Ranges[range].offset, alignment);
+    VkDeviceSize padding = alignedOffset - m_Ranges[range].offset;
+
+    // the padding in front becomes a free range of its own. the range before it was
+    // not free, or the two would have merged, so it cannot merge with anything
+    if (padding > 0)
+    {
+        uint32_t paddingRange = NewRange();
+        LTVKMemoryRange& allocated = m_Ranges[range];
+        LTVKMemoryRange& front = m_Ranges[paddingRange];
+
+        front.offset = allocated.offset;
+        front.size = padding;
+        front.prevPhysical = allocated.prevPhysical;
+        front.nextPhysical = range;
+
+        if (allocated.prevPhysical != LT_VK_NO_RANGE)
+        {
+            m_Ranges[allocated.prevPhysical].nextPhysical = paddingRange;
+        }
+        else
+        {
+            m_FirstRange = paddingRange;
+        }
+
+        allocated.prevPhysical = paddingRange;
+        allocated.offset = alignedOffset;
+        allocated.size -= padding;
+
+        InsertFree(paddingRange);
+    }
+
+    // and so does whatever is left over behind it
+    if (m_Ranges[range].size > size)
+    {
+        uint32_t remainderRange = NewRange();
+        LTVKMemoryRange& allocated = m_Ranges[range];
+        LTVKMemoryRange& back = m_Ranges[remainderRange];
+
+        back.offset = allocated.offset + size;
+        back.size = allocated.size - size;
+        back.prevPhysical = range;
+        back.nextPhysical = allocated.nextPhysical;
+
+        if (allocated.nextPhysical != LT_VK_NO_RANGE)
+        {
+            m_Ranges[allocated.nextPhysical].prevPhysical = remainderRange;
+        }
+
+        allocated.nextPhysical = remainderRange;
+        allocated.size = size;
+
+        InsertFree(remainderRange);
+    }
+
+    m_UsedBytes += size;
+    m_AllocationCount++;
+
+    outRange = range;
+    outOffset = alignedOffset;
+    return true;
+}
+
+void LTVKTlsfAllocator::Free(uint32_t range)
+{
+    m_UsedBytes -= m_Ranges[range].size;
+    m_AllocationCount--;
+
+    uint32_t next = m_Ranges[range].nextPhysical;
+
+    if (next != LT_VK_NO_RANGE && m_Ranges[next].isFree)
+    {
+        RemoveFree(next);
+
+        m_Ranges[range].size += m_Ranges[next].size;
+        m_Ranges[range].nextPhysical = m_Ranges[next].nextPhysical;
+
+        if (m_Ranges[next].nextPhysical != LT_VK_NO_RANGE)
+        {
+            m_Ranges[m_Ranges[next].nextPhysical].prevPhysical = range;
+        }
+
+        ReleaseRange(next);
+    }
+
+    uint32_t prev = m_Ranges[range].prevPhysical;
+
+    if (prev != LT_VK_NO_RANGE && m_Ranges[prev].isFree)
+    {
+        RemoveFree(prev);
+
+        m_Ranges[prev].size += m_Ranges[range].size;
+        m_Ranges[prev].nextPhysical = m_Ranges[range].nextPhysical;
+
+        if (m_Ranges[range].nextPhysical != LT_VK_NO_RANGE)
+        {
+            m_Ranges[m_Ranges[range].nextPhysical].prevPhysical = prev;
+        }
+
+        ReleaseRange(range);
+        range = prev;
+    }
+
+    InsertFree(range);
+}
+
+void LTVKTlsfAllocator::GetFreeRanges(uint32_t& outFreeRangeCount, VkDeviceSize& outLargestFreeRange) const
+{
+    outFreeRangeCount = 0;
+    outLargestFreeRange = 0;
+
+    for (uint32_t range = m_FirstRange; range != LT_VK_NO_RANGE; range = m_Ranges[range].nextPhysical)
+    {
+        const LTVKMemoryRange& freeRange = m_Ranges[range];
+
+        if (freeRange.isFree)
+        {
+            outFreeRangeCount++;
+            outLargestFreeRange = freeRange.size > outLargestFreeRange ? freeRange.size : outLargestFreeRange;
+        }
+    }
+}
+
+void LTVKMemoryAllocator::Initialize(VkPhysicalDevice physicalDevice, VkDevice device)
+{
+    m_Device = device;
+
+    vkGetPhysicalDeviceMemoryProperties(physicalDevice, &m_MemoryProperties);
+
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+
+    m_BufferImageGranularity = properties.limits.bufferImageGranularity;
+    m_NonCoherentAtomSize = properties.limits.nonCoherentAtomSize;
+    m_MaxAllocationCount = properties.limits.maxMemoryAllocationCount;
+
+    // small heaps (integrated GPUs, the host-visible window into VRAM) get smaller
+    // blocks so one block does not take a large share of them
+    for (uint32_t memoryTypeIndex = 0; memoryTypeIndex < m_MemoryProperties.memoryTypeCount; ++memoryTypeIndex)
+    {
+        uint32_t heapIndex = m_MemoryProperties.memoryTypes[memoryTypeIndex].heapIndex;
+        VkDeviceSize heapSize = m_MemoryProperties.memoryHeaps[heapIndex].size;
+
+        m_BlockSizes[memoryTypeIndex] = heapSize <= 1024ull * 1024 * 1024
+            ? AlignUp(heapSize / 8, LT_VK_TLSF_MIN_SIZE)
+            : LT_VK_MEMORY_BLOCK_SIZE;
+    }
+}
+
+void LTVKMemoryAllocator::Destroy()
+{
+    std::scoped_lock lock(m_Mutex);
+
+    for (uint32_t memoryTypeIndex = 0; memoryTypeIndex < VK_MAX_MEMORY_TYPES; ++memoryTypeIndex)
+    {
+        for (eastl::vector<LTVKMemoryBlock*>& blocks : m_Blocks[memoryTypeIndex])
+        {
+            for (LTVKMemoryBlock* block : blocks)
+            {
+                if (block->ranges.GetAllocationCount() > 0)
+                {
+                    printf("gpu memory type %u: %u allocations were never freed \n",
+                        memoryTypeIndex,
+                        block->ranges.GetAllocationCount());
+                }
+
+                FreeDeviceMemory(block->memory);
+                delete block;
+            }
+
+            blocks.clear();
+        }
+
+        if (m_DedicatedCounts[memoryTypeIndex] > 0)
+        {
+            printf("gpu memory type %u: %u dedicated allocations were never freed \n",
+                memoryTypeIndex,
+                m_DedicatedCounts[memoryTypeIndex]);
+        }
+    }
+}
+
+bool LTVKMemoryAllocator::FindMemoryType(
+    uint32_t typeBits,
+    VkMemoryPropertyFlags properties,
+    uint32_t& outMemoryTypeIndex) const
+{
+    for (uint32_t memoryTypeIndex = 0; memoryTypeIndex < m_MemoryProperties.memoryTypeCount; ++memoryTypeIndex)
+    {
+        if ((typeBits & (1u << memoryTypeIndex)) &&
+            (m_MemoryProperties.memoryTypes[memoryTypeIndex].propertyFlags & properties) == properties)
+        {
+            outMemoryTypeIndex = memoryTypeIndex;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool LTVKMemoryAllocator::AllocateDeviceMemory(
+    uint32_t memoryTypeIndex,
+    VkDeviceSize size,
+    VkDeviceMemory& outMemory,
+    void*& outMappedData)
+{
+    if (m_MaxAllocationCount > 0 && m_DeviceAllocationCount >= m_MaxAllocationCount)
+    {
+        return false;
+    }
+
+    VkMemoryAllocateInfo allocInfo = {};
+    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocInfo.allocationSize = size;
+    allocInfo.memoryTypeIndex = memoryTypeIndex;
+
+    if (vkAllocateMemory(m_Device, &allocInfo, nullptr, &outMemory) != VK_SUCCESS)
+    {
+        return false;
+    }
+
+    outMappedData = nullptr;
+
+    if ((m_MemoryProperties.memoryTypes[memoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) &&
+        vkMapMemory(m_Device, outMemory, 0, VK_WHOLE_SIZE, 0, &outMappedData) != VK_SUCCESS)
+    {
+        vkFreeMemory(m_Device, outMemory, nullptr);
+        return false;
+    }
+
+    m_DeviceAllocationCount++;
+    return true;
+}
+
+void LTVKMemoryAllocator::FreeDeviceMemory(VkDeviceMemory memory)
+{
+    // freeing memory unmaps it
+    vkFreeMemory(m_Device, memory, nullptr);
+    m_DeviceAllocationCount--;
+}
+
+bool LTVKMemoryAllocator::AllocateFromBlocks(
+    uint32_t memoryTypeIndex,
+    uint32_t pool,
+    VkDeviceSize size,
+    VkDeviceSize alignment,
+    LTVKAllocation& outAllocation)
+{
+    eastl::vector<LTVKMemoryBlock*>& blocks = m_Blocks[memoryTypeIndex][pool];
+
+    uint32_t range = LT_VK_NO_RANGE;
+    VkDeviceSize offset = 0;
+    LTVKMemoryBlock* block = nullptr;
+
+    for (LTVKMemoryBlock* candidate : blocks)
+    {
+        if (candidate->ranges.Allocate(size, alignment, range, offset))
+        {
+            block = candidate;
+            break;
+        }
+    }
+
+    // none fits, so reserve another block; when the device is short of memory,
+    // smaller blocks are tried down to twice the request
+    if (!block)
+    {
+        VkDeviceSize blockSize = m_BlockSizes[memoryTypeIndex];
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        void* mappedData = nullptr;
+        bool allocated = false;
+
+        while (!allocated && blockSize >= size * 2)
+        {
+            allocated = AllocateDeviceMemory(memoryTypeIndex, blockSize, memory, mappedData);
+
+            if (!allocated)
+            {
+                blockSize /= 2;
+            }
+        }
+
+        if (!allocated)
+        {
+            return false;
+        }
+
+        block = new LTVKMemoryBlock();
+        block->memory = memory;
+        block->mappedData = mappedData;
+        block->ranges.Initialize(blockSize);
+
+        // the alignment can still push the request past a block this small; the
+        // empty block would otherwise be kept, counting against the device's
+        // allocations
+        if (!block->ranges.Allocate(size, alignment, range, offset))
+        {
+            FreeDeviceMemory(block->memory);
+            delete block;
+            return false;
+        }
+
+        blocks.push_back(block);
+    }
+
+    outAllocation.memory = block->memory;
+    outAllocation.offset = offset;
+    outAllocation.size = AlignUp(size > 0 ? size : 1, LT_VK_TLSF_MIN_SIZE);
+    outAllocation.mappedData = block->mappedData ? (uint8_t*)block->mappedData + offset : nullptr;
+    outAllocation.block = block;
+    outAllocation.range = range;
+    outAllocation.memoryTypeIndex = memoryTypeIndex;
+
+    return true;
+}
+
+bool LTVKMemoryAllocator::Allocate(
+    const VkMemoryRequirements& requirements,
+    VkMemoryPropertyFlags properties,
+    bool isOptimalImage,
+    LTVKAllocation& outAllocation)
+{
+    uint32_t memoryTypeIndex;
+
+    if (!FindMemoryType(requirements.memoryTypeBits, properties, memoryTypeIndex))
+    {
+        return false;
+    }
+
+    std::scoped_lock lock(m_Mutex);
+
+    // big resources would leave most of a block unusable around them
+    if (requirements.size > m_BlockSizes[memoryTypeIndex] / 2)
+    {
+        VkDeviceMemory memory;
+        void* mappedData;
+
+        if (!AllocateDeviceMemory(memoryTypeIndex, requirements.size, memory, mappedData))
+        {
+            return false;
+        }
+
+        m_DedicatedCounts[memoryTypeIndex]++;
+        m_DedicatedBytes[memoryTypeIndex] += requirements.size;
+
+        outAllocation = LTVKAllocation();
+        outAllocation.memory = memory;
+        outAllocation.size = requirements.size;
+        outAllocation.mappedData = mappedData;
+        outAllocation.memoryTypeIndex = memoryTypeIndex;
+
+        return true;
+    }
+
+    // mapped ranges of non-coherent memory are flushed in whole atoms, so two
+    // allocations must not share one
+    VkDeviceSize alignment = requirements.alignment;
+    VkMemoryPropertyFlags typeFlags = m_MemoryProperties.memoryTypes[memoryTypeIndex].propertyFlags;
+
+    if ((typeFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) &&
+        !(typeFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) &&
+        m_NonCoherentAtomSize > alignment)
+    {
+        alignment = m_NonCoherentAtomSize;
+    }
+
+    uint32_t pool = isOptimalImage && m_BufferImageGranularity > 1 ? 1 : 0;
+
+    return AllocateFromBlocks(memoryTypeIndex, pool, requirements.size, alignment, outAllocation);
+}
+
+void LTVKMemoryAllocator::Free(LTVKAllocation& allocation)
+{
+    if (allocation.memory == VK_NULL_HANDLE)
+    {
+        return;
+    }
+
+    std::scoped_lock lock(m_Mutex);
+
+    uint32_t memoryTypeIndex = allocation.memoryTypeIndex;
+    LTVKMemoryBlock* block = allocation.block;
+
+    if (!block)
+    {
+        FreeDeviceMemory(allocation.memory);
+
+        m_DedicatedCounts[memoryTypeIndex]--;
+        m_DedicatedBytes[memoryTypeIndex] -= allocation.size;
+
+        allocation = LTVKAllocation();
+        return;
+    }
+
+    block->ranges.Free(allocation.range);
+    allocation = LTVKAllocation();
+
+    // an empty block is released unless it is the last of its pool, which is kept
+    // so a pool that empties and fills again does not reserve a block every time
+    if (block->ranges.GetAllocationCount() > 0)
+    {
+        return;
+    }
+
+    for (eastl::vector<LTVKMemoryBlock*>& blocks : m_Blocks[memoryTypeIndex])
+    {
+        for (size_t i = 0; i < blocks.size(); ++i)
+        {
+            if (blocks[i] == block && blocks.size() > 1)
+            {
+                FreeDeviceMemory(block->memory);
+                delete block;
+
+                blocks.erase(blocks.begin() + i);
+                return;
+            }
+        }
+    }
+}
+
+LTVKMemoryStats LTVKMemoryAllocator::GetStats(uint32_t memoryTypeIndex)
+{
+    std::scoped_lock lock(m_Mutex);
+
+    LTVKMemoryStats stats;
+
+    for (const eastl::vector<LTVKMemoryBlock*>& blocks : m_Blocks[memoryTypeIndex])
+    {
+        for (const LTVKMemoryBlock* block : blocks)
+        {
+            uint32_t freeRangeCount;
+            VkDeviceSize largestFreeRange;
+            block->ranges.GetFreeRanges(freeRangeCount, largestFreeRange);
+
+            stats.blockCount++;
+            stats.blockBytes += block->ranges.GetSize();
+            stats.allocationCount += block->ranges.GetAllocationCount();
+            stats.usedBytes += block->ranges.GetUsedBytes();
+            stats.freeRangeCount += freeRangeCount;
+            stats.fragmentedBytes += block->ranges.GetSize() - block->ranges.GetUsedBytes() - largestFreeRange;
+            stats.largestFreeRange = largestFreeRange > stats.largestFreeRange ? largestFreeRange : stats.largestFreeRange;
+        }
+    }
+
+    stats.dedicatedCount = m_DedicatedCounts[memoryTypeIndex];
+    stats.dedicatedBytes = m_DedicatedBytes[memoryTypeIndex];
+
+    return stats;
+}
+
+void LTVKMemoryAllocator::PrintStats()
+{
+    for (uint32_t memoryTypeIndex = 0; memoryTypeIndex < m_MemoryProperties.memoryTypeCount; ++memoryTypeIndex)
+    {
+        LTVKMemoryStats stats = GetStats(memoryTypeIndex);
+
+        if (stats.blockCount == 0 && stats.dedicatedCount == 0)
+        {
+            continue;
+        }
+
+        VkDeviceSize freeBytes = stats.blockBytes - stats.usedBytes;
+        double fragmentation = freeBytes > 0
+            ? 100.0 * (double)stats.fragmentedBytes / (double)freeBytes
+            : 0.0;
+
+        printf("gpu memory type %u (flags 0x%x): %u blocks, %llu / %llu bytes in %u allocations, "
+            "%u free ranges, largest %llu bytes, fragmentation %.1f%%, %u dedicated, %llu bytes \n",
+            memoryTypeIndex,
+            m_MemoryProperties.memoryTypes[memoryTypeIndex].propertyFlags,
+            stats.blockCount,
+            (unsigned long long)stats.usedBytes,
+            (unsigned long long)stats.blockBytes,
+            stats.allocationCount,
+            stats.freeRangeCount,
+            (unsigned long long)stats.largestFreeRange,
+            fragmentation,
+            stats.dedicatedCount,
+            (unsigned long long)stats.dedicatedBytes);
+    }
+
+    std::scoped_lock lock(m_Mutex);
+    printf("gpu memory: %u of %u device allocations \n", m_DeviceAllocationCount, m_MaxAllocationCount);
+}
@@ -2,6 +2,7 @@
 #include "LTVKPipeline.h"
 #include "LTAsset.h"
 #include "LTVKDevice.h"
+#include "LTVKVertexFormat.h"
 
 LTVKPipeline::LTVKPipeline(
     LTVKDevice* device,
@@ -35,8 +36,24 @@ bool LTVKPipeline::Initialize(const LTVKPipelineConfig& config)
 
     VkPipelineVertexInputStateCreateInfo vertexInputInfo = {};
     vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-    vertexInputInfo.pVertexAttributeDescriptions = 0;
-    vertexInputInfo.pVertexBindingDescriptions = 0;
+
+    // without a vertex format there is no vertex input at all
+    if (config.vertexFormat != nullptr)
+    {
+        vertexInputInfo.vertexBindingDescriptionCount = 1;
+        vertexInputInfo.pVertexBindingDescriptions = &config.vertexFormat->binding;
+        vertexInputInfo.vertexAttributeDescriptionCount = config.vertexFormat->attributeCount;
+        vertexInputInfo.pVertexAttributeDescriptions = config.vertexFormat->attributes;
+    }
+
+    // the viewport and scissor are set when drawing, so pipelines are not tied to
+    // the size of the swapchain
+    VkDynamicState dynamicStates[] = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+
+    VkPipelineDynamicStateCreateInfo dynamicStateInfo = {};
+    dynamicStateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+    dynamicStateInfo.dynamicStateCount = 2;
+    dynamicStateInfo.pDynamicStates = dynamicStates;
 
     VkGraphicsPipelineCreateInfo pipelineInfo = {};
     pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
@@ -49,6 +66,7 @@ bool LTVKPipeline::Initialize(const LTVKPipelineConfig& config)
     pipelineInfo.pMultisampleState = &config.multisampleInfo;
     pipelineInfo.pColorBlendState = &config.colorBlendInfo;
     pipelineInfo.pDepthStencilState = &config.depthStencilInfo;
+    pipelineInfo.pDynamicState = &dynamicStateInfo;
     pipelineInfo.layout = config.pipelineLayout;
     pipelineInfo.renderPass = config.renderPass;
     pipelineInfo.subpass = config.subpass;
@@ -56,9 +74,13 @@ bool LTVKPipeline::Initialize(const LTVKPipelineConfig& config)
     pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
     pipelineInfo.basePipelineIndex = -1;
 
+    // the device's cache skips compiling pipelines it has seen, this run or an
+    // earlier one; the time taken is recorded to show what the cache saves
+    auto createStart = std::chrono::steady_clock::now();
+
     if (vkCreateGraphicsPipelines(
         m_Device->GetDevice(),
-        VK_NULL_HANDLE,
+        m_Device->GetPipelineCache(),
         1,
         &pipelineInfo,
         nullptr,
@@ -67,6 +89,8 @@ bool LTVKPipeline::Initialize(const LTVKPipelineConfig& config)
         return false;
     }
 
+    m_Device->RecordPipelineCreation(std::chrono::steady_clock::now() - createStart);
+
     return true;
 }
 
@@ -0,0 +1,390 @@
+#include "PrecompiledHeader.h"
+
+#include "LTVKPipelineManager.h"
+#include "LTAsset.h"
+#include "LTContentPak.h"
+#include "LTVKDevice.h"
+
+#include <cstring>
+
+void LTVKPipelineManager::Initialize(LTVKDevice* ltvkDevice, uint32_t workerCount)
+{
+    m_LTVKDevice = ltvkDevice;
+
+    // leave a core for the main thread when sizing from the hardware
+    if (workerCount == 0)
+    {
+        uint32_t hardwareThreads = std::thread::hardware_concurrency();
+        workerCount = hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+    }
+
+    m_IsRunning = true;
+
+    for (uint32_t i = 0; i < workerCount; ++i)
+    {
+        m_CompileThreads.push_back(new std::thread(&LTVKPipelineManager::CompileThread, this));
+    }
+}
+
+void LTVKPipelineManager::Destroy()
+{
+    {
+        std::scoped_lock lock(m_Mutex);
+        m_IsRunning = false;
+    }
+
+    m_PendingCondition.notify_all();
+
+    for (std::thread* compileThread : m_CompileThreads)
+    {
+        compileThread->join();
+        delete compileThread;
+    }
+
+    m_CompileThreads.clear();
+
+    for (LTVKPipelineEntry* entry : m_Entries)
+    {
+        if (entry->state.load() == LTVKPipelineState::LT_VK_PIPELINE_STATE_READY)
+        {
+            entry->pipeline.Destroy();
+        }
+
+        delete entry;
+    }
+
+    m_Entries.clear();
+    m_PendingEntries.clear();
+    m_NextPending = 0;
+    m_CompilingCount = 0;
+    m_Placeholder = nullptr;
+
+    for (LTVKPipelineEntry*& bucket : m_Buckets)
+    {
+        bucket = nullptr;
+    }
+}
+
+LTVKPipelineEntry* LTVKPipelineManager::RequestPipeline(
+    const LTVKPipelineConfig& config,
+    LTShader* vertexShader,
+    LTShader* fragmentShader)
+{
+    LTVKPipelineKey key;
+    BuildKey(config, vertexShader, fragmentShader, key);
+
+    uint32_t hash = LTContentPak::ComputeHash((const uint8_t*)&key, sizeof(key));
+    LTVKPipelineEntry*& bucket = m_Buckets[hash & (LT_VK_PIPELINE_BUCKET_COUNT - 1)];
+
+    std::scoped_lock lock(m_Mutex);
+
+    ++m_RequestCount;
+
+    for (LTVKPipelineEntry* entry = bucket; entry != nullptr; entry = entry->nextInBucket)
+    {
+        if (entry->hash == hash && memcmp(&entry->key, &key, sizeof(key)) == 0)
+        {
+            ++m_DeduplicatedCount;
+            return entry;
+        }
+    }
+
+    LTVKPipelineEntry* entry = new LTVKPipelineEntry(m_LTVKDevice, vertexShader, fragmentShader);
+    memcpy(&entry->key, &key, sizeof(key));
+    entry->hash = hash;
+    entry->nextInBucket = bucket;
+    bucket = entry;
+
+    m_Entries.push_back(entry);
+    m_PendingEntries.push_back(entry);
+
+    // the busy time runs from the first pipeline queued to the last compiled
+    if (m_CompilingCount++ == 0)
+    {
+        m_BusyStart = std::chrono::steady_clock::now();
+    }
+
+    m_PendingCondition.notify_one();
+
+    return entry;
+}
+
+void LTVKPipelineManager::SetPlaceholder(const LTVKPipelineEntry* placeholder)
+{
+    m_Placeholder = placeholder;
+}
+
+VkPipeline LTVKPipelineManager::GetPipeline(const LTVKPipelineEntry* entry) const
+{
+    if (IsReady(entry))
+    {
+        return entry->pipeline.GetPipeline();
+    }
+
+    if (m_Placeholder != nullptr && IsReady(m_Placeholder))
+    {
+        return m_Placeholder->pipeline.GetPipeline();
+    }
+
+    return VK_NULL_HANDLE;
+}
+
+bool LTVKPipelineManager::Wait(const LTVKPipelineEntry* entry)
+{
+    std::unique_lock lock(m_Mutex);
+
+    m_CompiledCondition.wait(lock, [entry]()
+    {
+        return entry->state.load() != LTVKPipelineState::LT_VK_PIPELINE_STATE_PENDING;
+    });
+
+    return entry->state.load() == LTVKPipelineState::LT_VK_PIPELINE_STATE_READY;
+}
+
+void LTVKPipelineManager::WaitAll()
+{
+    std::unique_lock lock(m_Mutex);
+
+    m_CompiledCondition.wait(lock, [this]()
+    {
+        return m_CompilingCount == 0;
+    });
+}
+
+void LTVKPipelineManager::PrintStats()
+{
+    std::scoped_lock lock(m_Mutex);
+
+    double compileMs = std::chrono::duration<double, std::milli>(m_CompileTime).count();
+    double busyMs = std::chrono::duration<double, std::milli>(m_BusyTime).count();
+
+    // the compile time is summed over the workers, so the more of it overlaps the
+    // further the wall time falls below it
+    printf("pipeline manager: %u requested, %u deduplicated, %u compiled, %u failed, "
+        "%.2f ms compiling in %.2f ms wall on %zu workers \n",
+        m_RequestCount,
+        m_DeduplicatedCount,
+        m_CompiledCount,
+        m_FailedCount,
+        compileMs,
+        busyMs,
+        m_CompileThreads.size());
+}
+
+void LTVKPipelineManager::BuildKey(
+    const LTVKPipelineConfig& config,
+    LTShader* vertexShader,
+    LTShader* fragmentShader,
+    LTVKPipelineKey& outKey)
+{
+    // the config's create infos point at its own viewport, scissor and blend
+    // attachment, so only one of each is supported
+    assert(config.viewportInfo.viewportCount == 1 && config.viewportInfo.scissorCount == 1);
+    assert(config.colorBlendInfo.attachmentCount == 1);
+    assert(config.multisampleInfo.pSampleMask == nullptr);
+
+    // zeroed first so the padding compares and hashes the same in every key
+    memset(&outKey, 0, sizeof(outKey));
+
+    outKey.vertexShaderID = vertexShader->GetAssetID();
+    outKey.fragmentShaderID = fragmentShader->GetAssetID();
+
+    if (config.vertexFormat != nullptr)
+    {
+        outKey.vertexFormat.binding = config.vertexFormat->binding;
+        outKey.vertexFormat.attributeCount = config.vertexFormat->attributeCount;
+
+        for (uint32_t i = 0; i < config.vertexFormat->attributeCount; ++i)
+        {
+            outKey.vertexFormat.attributes[i] = config.vertexFormat->attributes[i];
+        }
+
+        outKey.hasVertexFormat = VK_TRUE;
+    }
+
+    outKey.topology = config.inputAssemblyInfo.topology;
+    outKey.primitiveRestartEnable = config.inputAssemblyInfo.primitiveRestartEnable;
+
+    outKey.depthClampEnable = config.rasterizationInfo.depthClampEnable;
+    outKey.rasterizerDiscardEnable = config.rasterizationInfo.rasterizerDiscardEnable;
+    outKey.polygonMode = config.rasterizationInfo.polygonMode;
+    outKey.cullMode = config.rasterizationInfo.cullMode;
+    outKey.frontFace = config.rasterizationInfo.frontFace;
+    outKey.depthBiasEnable = config.rasterizationInfo.depthBiasEnable;
+    outKey.depthBiasConstantFactor = config.rasterizationInfo.depthBiasConstantFactor;
+    outKey.depthBiasClamp = config.rasterizationInfo.depthBiasClamp;
+    outKey.depthBiasSlopeFactor = config.rasterizationInfo.depthBiasSlopeFactor;
+    outKey.lineWidth = config.rasterizationInfo.lineWidth;
+
+    outKey.rasterizationSamples = config.multisampleInfo.rasterizationSamples;
+    outKey.sampleShadingEnable = config.multisampleInfo.sampleShadingEnable;
+    outKey.minSampleShading = config.multisampleInfo.minSampleShading;
+    outKey.alphaToCoverageEnable = config.multisampleInfo.alphaToCoverageEnable;
+    outKey.alphaToOneEnable = config.multisampleInfo.alphaToOneEnable;
+
+    outKey.colorBlendAttachment = config.colorBlendAttachment;
+    outKey.logicOpEnable = config.colorBlendInfo.logicOpEnable;
+    outKey.logicOp = config.colorBlendInfo.logicOp;
+
+    for (uint32_t i = 0; i < 4; ++i)
+    {
+        outKey.blendConstants[i] = config.colorBlendInfo.blendConstants[i];
+    }
+
+    outKey.depthTestEnable = config.depthStencilInfo.depthTestEnable;
+    outKey.depthWriteEnable = config.depthStencilInfo.depthWriteEnable;
+    outKey.depthCompareOp = config.depthStencilInfo.depthCompareOp;
+    outKey.depthBoundsTestEnable = config.depthStencilInfo.depthBoundsTestEnable;
+    outKey.stencilTestEnable = config.depthStencilInfo.stencilTestEnable;
+    outKey.front = config.depthStencilInfo.front;
+    outKey.back = config.depthStencilInfo.back;
+    outKey.minDepthBounds = config.depthStencilInfo.minDepthBounds;
+    outKey.maxDepthBounds = config.depthStencilInfo.maxDepthBounds;
+
+    outKey.pipelineLayout = config.pipelineLayout;
+    outKey.renderPass = config.renderPass;
+    outKey.subpass = config.subpass;
+}
+
+void LTVKPipelineManager::BuildConfig(const LTVKPipelineKey& key, LTVKPipelineConfig& outConfig)
+{
+    outConfig.vertexFormat = key.hasVertexFormat ? &key.vertexFormat : nullptr;
+
+    outConfig.inputAssemblyInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+    outConfig.inputAssemblyInfo.topology = key.topology;
+    outConfig.inputAssemblyInfo.primitiveRestartEnable = key.primitiveRestartEnable;
+
+    outConfig.viewportInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+    outConfig.viewportInfo.viewportCount = 1;
+    outConfig.viewportInfo.pViewports = &outConfig.viewport;
+    outConfig.viewportInfo.scissorCount = 1;
+    outConfig.viewportInfo.pScissors = &outConfig.scissor;
+
+    outConfig.rasterizationInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+    outConfig.rasterizationInfo.depthClampEnable = key.depthClampEnable;
+    outConfig.rasterizationInfo.rasterizerDiscardEnable = key.rasterizerDiscardEnable;
+    outConfig.rasterizationInfo.polygonMode = key.polygonMode;
+    outConfig.rasterizationInfo.cullMode = key.cullMode;
+    outConfig.rasterizationInfo.frontFace = key.frontFace;
+    outConfig.rasterizationInfo.depthBiasEnable = key.depthBiasEnable;
+    outConfig.rasterizationInfo.depthBiasConstantFactor = key.depthBiasConstantFactor;
+    outConfig.rasterizationInfo.depthBiasClamp = key.depthBiasClamp;
+    outConfig.rasterizationInfo.depthBiasSlopeFactor = key.depthBiasSlopeFactor;
+    outConfig.rasterizationInfo.lineWidth = key.lineWidth;
+
+    outConfig.multisampleInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+    outConfig.multisampleInfo.rasterizationSamples = key.rasterizationSamples;
+    outConfig.multisampleInfo.sampleShadingEnable = key.sampleShadingEnable;
+    outConfig.multisampleInfo.minSampleShading = key.minSampleShading;
+    outConfig.multisampleInfo.alphaToCoverageEnable = key.alphaToCoverageEnable;
+    outConfig.multisampleInfo.alphaToOneEnable = key.alphaToOneEnable;
+
+    outConfig.colorBlendAttachment = key.colorBlendAttachment;
+
+    outConfig.colorBlendInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+    outConfig.colorBlendInfo.logicOpEnable = key.logicOpEnable;
+    outConfig.colorBlendInfo.logicOp = key.logicOp;
+    outConfig.colorBlendInfo.attachmentCount = 1;
+    outConfig.colorBlendInfo.pAttachments = &outConfig.colorBlendAttachment;
+
+    for (uint32_t i = 0; i < 4; ++i)
+    {
+        outConfig.colorBlendInfo.blendConstants[i] = key.blendConstants[i];
+    }
+
+    outConfig.depthStencilInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+    outConfig.depthStencilInfo.depthTestEnable = key.depthTestEnable;
+    outConfig.depthStencilInfo.depthWriteEnable = key.depthWriteEnable;
+    outConfig.depthStencilInfo.depthCompareOp = key.depthCompareOp;
+    outConfig.depthStencilInfo.depthBoundsTestEnable = key.depthBoundsTestEnable;
+    outConfig.depthStencilInfo.stencilTestEnable = key.stencilTestEnable;
+    outConfig.depthStencilInfo.front = key.front;
+    outConfig.depthStencilInfo.back = key.back;
+    outConfig.depthStencilInfo.minDepthBounds = key.minDepthBounds;
+    outConfig.depthStencilInfo.maxDepthBounds = key.maxDepthBounds;
+
+    outConfig.pipelineLayout = key.pipelineLayout;
+    outConfig.renderPass = key.renderPass;
+    outConfig.subpass = key.subpass;
+}
+
+void LTVKPipelineManager::CompileThread()
+{
+    while (true)
+    {
+        LTVKPipelineEntry* entry;
+
+        {
+            std::unique_lock lock(m_Mutex);
+
+            m_PendingCondition.wait(lock, [this]()
+            {
+                return !m_IsRunning || m_NextPending < m_PendingEntries.size();
+            });
+
+            if (!m_IsRunning)
+            {
+                return;
+            }
+
+            entry = m_PendingEntries[m_NextPending++];
+
+            // every queued entry is taken; start the list over
+            if (m_NextPending == m_PendingEntries.size())
+            {
+                m_PendingEntries.clear();
+                m_NextPending = 0;
+            }
+        }
+
+        Compile(entry);
+    }
+}
+
+void LTVKPipelineManager::Compile(LTVKPipelineEntry* entry)
+{
+    LTVKPipelineConfig config;
+    BuildConfig(entry->key, config);
+
+    auto compileStart = std::chrono::steady_clock::now();
+
+    // the device's pipeline cache is internally synchronized, so the workers
+    // create through it at the same time
+    bool isCompiled = entry->pipeline.Initialize(config);
+
+    auto compileEnd = std::chrono::steady_clock::now();
+
+    if (!isCompiled)
+    {
+        printf("Failed to create pipeline for shaders %u and %u. \n",
+            entry->key.vertexShaderID,
+            entry->key.fragmentShaderID);
+    }
+
+    {
+        std::scoped_lock lock(m_Mutex);
+
+        if (isCompiled)
+        {
+            ++m_CompiledCount;
+        }
+        else
+        {
+            ++m_FailedCount;
+        }
+
+        m_CompileTime += compileEnd - compileStart;
+
+        if (--m_CompilingCount == 0)
+        {
+            m_BusyTime += compileEnd - m_BusyStart;
+        }
+
+        entry->state.store(isCompiled
+            ? LTVKPipelineState::LT_VK_PIPELINE_STATE_READY
+            : LTVKPipelineState::LT_VK_PIPELINE_STATE_FAILED,
+            std::memory_order_release);
+    }
+
+    m_CompiledCondition.notify_all();
+}
@@ -0,0 +1,1161 @@
+#include "PrecompiledHeader.h"
+
+#include "LTVKRenderGraph.h"
+#include "LTVKDevice.h"
+
+#include <algorithm>
+
+/**
+ * What an access means to the GPU, and the usage it needs the resource created with.
+ */
+struct LTVKAccessInfo
+{
+    VkPipelineStageFlags stages;
+    VkAccessFlags access;
+    VkImageLayout layout;
+    VkImageUsageFlags imageUsage;
+    VkBufferUsageFlags bufferUsage;
+    bool isWrite;
+};
+
+static const LTVKAccessInfo s_AccessInfos[(size_t)LTVKResourceAccess::LT_VK_RESOURCE_ACCESS_COUNT] =
+{
+    // LT_VK_RESOURCE_ACCESS_COLOR_ATTACHMENT
+    {
+        VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+        VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+        VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+        VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT,
+        0,
+        true
+    },
+    // LT_VK_RESOURCE_ACCESS_DEPTH_ATTACHMENT
+    {
+        VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+        VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+        VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+        VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT,
+        0,
+        true
+    },
+    // LT_VK_RESOURCE_ACCESS_DEPTH_READ
+    {
+        VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+        VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT,
+        VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL,
+        VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT,
+        0,
+        false
+    },
+    // LT_VK_RESOURCE_ACCESS_SAMPLED
+    {
+        VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        VK_ACCESS_SHADER_READ_BIT,
+        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+        VK_IMAGE_USAGE_SAMPLED_BIT,
+        VK_BUFFER_USAGE_UNIFORM_TEXEL_BUFFER_BIT,
+        false
+    },
+    // LT_VK_RESOURCE_ACCESS_UNIFORM
+    {
+        VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        VK_ACCESS_UNIFORM_READ_BIT,
+        VK_IMAGE_LAYOUT_UNDEFINED,
+        0,
+        VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+        false
+    },
+    // LT_VK_RESOURCE_ACCESS_STORAGE_READ
+    {
+        VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        VK_ACCESS_SHADER_READ_BIT,
+        VK_IMAGE_LAYOUT_GENERAL,
+        VK_IMAGE_USAGE_STORAGE_BIT,
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+        false
+    },
+    // LT_VK_RESOURCE_ACCESS_STORAGE_WRITE
+    {
+        VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+        VK_IMAGE_LAYOUT_GENERAL,
+        VK_IMAGE_USAGE_STORAGE_BIT,
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+        true
+    },
+    // LT_VK_RESOURCE_ACCESS_TRANSFER_READ
+    {
+        VK_PIPELINE_STAGE_TRANSFER_BIT,
+        VK_ACCESS_TRANSFER_READ_BIT,
+        VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+        VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+        VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+        false
+    },
+    // LT_VK_RESOURCE_ACCESS_TRANSFER_WRITE
+    {
+        VK_PIPELINE_STAGE_TRANSFER_BIT,
+        VK_ACCESS_TRANSFER_WRITE_BIT,
+        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+        VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        true
+    },
+    // LT_VK_RESOURCE_ACCESS_VERTEX_BUFFER
+    {
+        VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+        VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT,
+        VK_IMAGE_LAYOUT_UNDEFINED,
+        0,
+        VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+        false
+    },
+    // LT_VK_RESOURCE_ACCESS_INDEX_BUFFER
+    {
+        VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+        VK_ACCESS_INDEX_READ_BIT,
+        VK_IMAGE_LAYOUT_UNDEFINED,
+        0,
+        VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+        false
+    },
+    // LT_VK_RESOURCE_ACCESS_INDIRECT_BUFFER
+    {
+        VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
+        VK_ACCESS_INDIRECT_COMMAND_READ_BIT,
+        VK_IMAGE_LAYOUT_UNDEFINED,
+        0,
+        VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+        false
+    },
+};
+
+void LTVKRenderGraph::Initialize(LTVKDevice* ltvkDevice)
+{
+    m_LTVKDevice = ltvkDevice;
+    m_Device = ltvkDevice->GetDevice();
+}
+
+void LTVKRenderGraph::Destroy()
+{
+    for (LTVKRenderGraphResources* retired : m_RetiredResources)
+    {
+        DestroyResources(*retired);
+        delete retired;
+    }
+
+    m_RetiredResources.clear();
+
+    if (m_PhysicalResources != nullptr)
+    {
+        DestroyResources(*m_PhysicalResources);
+        delete m_PhysicalResources;
+        m_PhysicalResources = nullptr;
+    }
+
+    Reset();
+}
+
+void LTVKRenderGraph::Reset()
+{
+    m_Resources.clear();
+    m_Passes.clear();
+    m_Order.clear();
+}
+
+LTVKRenderGraphResource LTVKRenderGraph::CreateImage(const char* name, VkFormat format, VkExtent2D extent)
+{
+    LTVKRenderGraphResourceDesc desc = {};
+    desc.name = name;
+    desc.isImage = true;
+    desc.format = format;
+    desc.extent = extent;
+
+    m_Resources.push_back(desc);
+    return (LTVKRenderGraphResource)(m_Resources.size() - 1);
+}
+
+LTVKRenderGraphResource LTVKRenderGraph::CreateBuffer(const char* name, VkDeviceSize size)
+{
+    LTVKRenderGraphResourceDesc desc = {};
+    desc.name = name;
+    desc.size = size;
+
+    m_Resources.push_back(desc);
+    return (LTVKRenderGraphResource)(m_Resources.size() - 1);
+}
+
+LTVKRenderGraphResource LTVKRenderGraph::ImportImage(
+    const char* name,
+    VkImage image,
+    VkImageView imageView,
+    VkFormat format,
+    VkExtent2D extent,
+    VkImageLayout currentLayout,
+    VkPipelineStageFlags currentStages,
+    VkAccessFlags currentAccess,
+    VkImageLayout finalLayout)
+{
+    LTVKRenderGraphResourceDesc desc = {};
+    desc.name = name;
+    desc.isImage = true;
+    desc.isImported = true;
+    desc.format = format;
+    desc.extent = extent;
+    desc.image = image;
+    desc.imageView = imageView;
+    desc.finalLayout = finalLayout;
+
+    // the first access waits for the stages the image is in use by, e.g. the wait
+    // stage of its acquire semaphore
+    desc.importState.writeStages = currentStages;
+    desc.importState.writeAccess = currentAccess;
+    desc.importState.layout = currentLayout;
+
+    m_Resources.push_back(desc);
+    return (LTVKRenderGraphResource)(m_Resources.size() - 1);
+}
+
+LTVKRenderGraphResource LTVKRenderGraph::ImportBuffer(
+    const char* name,
+    VkBuffer buffer,
+    VkDeviceSize size,
+    VkPipelineStageFlags currentStages,
+    VkAccessFlags currentAccess)
+{
+    LTVKRenderGraphResourceDesc desc = {};
+    desc.name = name;
+    desc.isImported = true;
+    desc.size = size;
+    desc.buffer = buffer;
+
+    desc.importState.writeStages = currentStages;
+    desc.importState.writeAccess = currentAccess;
+
+    m_Resources.push_back(desc);
+    return (LTVKRenderGraphResource)(m_Resources.size() - 1);
+}
+
+uint32_t LTVKRenderGraph::AddPass(const char* name, const LTVKRenderGraphExecute& execute, bool hasSideEffects)
+{
+    LTVKRenderGraphPass pass;
+    pass.name = name;
+    pass.execute = execute;
+    pass.hasSideEffects = hasSideEffects;
+    pass.isCulled = false;
+    pass.dependencyCount = 0;
+
+    m_Passes.push_back(pass);
+    return (uint32_t)(m_Passes.size() - 1);
+}
+
+void LTVKRenderGraph::AddUse(uint32_t pass, LTVKRenderGraphResource resource, LTVKResourceAccess access)
+{
+    eastl::vector<LTVKRenderGraphUse>& uses = m_Passes[pass].uses;
+
+    for (const LTVKRenderGraphUse& use : uses)
+    {
+        assert(use.resource != resource);
+    }
+
+    LTVKRenderGraphUse use;
+    use.resource = resource;
+    use.access = access;
+
+    uses.push_back(use);
+}
+
+bool LTVKRenderGraph::Compile(uint64_t completedFrame)
+{
+    for (size_t i = 0; i < m_RetiredResources.size();)
+    {
+        LTVKRenderGraphResources* retired = m_RetiredResources[i];
+
+        if (retired->lastFrame > completedFrame)
+        {
+            ++i;
+            continue;
+        }
+
+        DestroyResources(*retired);
+        delete retired;
+
+        m_RetiredResources.erase(m_RetiredResources.begin() + i);
+    }
+
+    CullPasses();
+    SchedulePasses();
+
+    // the transient resources in use are backed in the order they were declared,
+    // so the same declarations map to the same physical resources
+    eastl::vector<uint64_t> signature;
+    uint32_t physicalCount = 0;
+
+    for (LTVKRenderGraphResourceDesc& desc : m_Resources)
+    {
+        if (desc.isImported || desc.firstPass == LT_VK_RENDER_GRAPH_NO_RESOURCE)
+        {
+            continue;
+        }
+
+        desc.physicalIndex = physicalCount++;
+
+        signature.push_back(desc.isImage);
+        signature.push_back(desc.format);
+        signature.push_back(((uint64_t)desc.extent.width << 32) | desc.extent.height);
+        signature.push_back(desc.size);
+        signature.push_back(desc.usage);
+        signature.push_back(((uint64_t)desc.firstPass << 32) | desc.lastPass);
+    }
+
+    m_DidResourcesChange = m_PhysicalResources == nullptr || m_PhysicalResources->signature != signature;
+
+    if (!m_DidResourcesChange)
+    {
+        return true;
+    }
+
+    // the frames in flight may still be using the old resources
+    if (m_PhysicalResources != nullptr)
+    {
+        m_RetiredResources.push_back(m_PhysicalResources);
+    }
+
+    m_PhysicalResources = new LTVKRenderGraphResources();
+    m_PhysicalResources->signature = signature;
+    ++m_ResourceCreateCount;
+
+    if (!CreateResources(*m_PhysicalResources))
+    {
+        // so the next compile tries again rather than reusing them
+        m_PhysicalResources->signature.clear();
+        return false;
+    }
+
+    return true;
+}
+
+void LTVKRenderGraph::Execute(VkCommandBuffer commandBuffer, uint64_t frameNumber)
+{
+    m_PhysicalResources->lastFrame = frameNumber;
+    ++m_ExecuteCount;
+
+    for (uint32_t position = 0; position < m_Order.size(); ++position)
+    {
+        LTVKRenderGraphPass& pass = m_Passes[m_Order[position]];
+
+        m_ImageBarriers.clear();
+        m_BufferBarriers.clear();
+
+        VkPipelineStageFlags srcStages = 0;
+        VkPipelineStageFlags dstStages = 0;
+
+        VkMemoryBarrier memoryBarrier = {};
+        memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+
+        for (const LTVKRenderGraphUse& use : pass.uses)
+        {
+            LTVKRenderGraphResourceDesc& desc = m_Resources[use.resource];
+
+            AddBarrier(
+                desc,
+                GetState(desc),
+                use.access,
+                !desc.isImported && desc.firstPass == position,
+                srcStages,
+                dstStages,
+                memoryBarrier);
+        }
+
+        RecordBarriers(commandBuffer, srcStages, dstStages, memoryBarrier);
+
+        pass.execute(commandBuffer);
+    }
+
+    // leave the imported images as the code after the graph expects them, e.g. the
+    // swapchain image ready to present
+    m_ImageBarriers.clear();
+    m_BufferBarriers.clear();
+
+    VkPipelineStageFlags srcStages = 0;
+
+    VkMemoryBarrier memoryBarrier = {};
+    memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+
+    for (LTVKRenderGraphResourceDesc& desc : m_Resources)
+    {
+        LTVKResourceState& state = desc.importState;
+
+        if (!desc.isImported
+            || !desc.isImage
+            || desc.finalLayout == VK_IMAGE_LAYOUT_UNDEFINED
+            || desc.finalLayout == state.layout)
+        {
+            continue;
+        }
+
+        VkImageMemoryBarrier barrier = {};
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.srcAccessMask = state.writeAccess;
+        barrier.dstAccessMask = 0;
+        barrier.oldLayout = state.layout;
+        barrier.newLayout = desc.finalLayout;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image = desc.image;
+        barrier.subresourceRange.aspectMask = GetImageAspect(desc.format);
+        barrier.subresourceRange.baseMipLevel = 0;
+        barrier.subresourceRange.levelCount = VK_REMAINING_MIP_LEVELS;
+        barrier.subresourceRange.baseArrayLayer = 0;
+        barrier.subresourceRange.layerCount = VK_REMAINING_ARRAY_LAYERS;
+
+        m_ImageBarriers.push_back(barrier);
+
+        srcStages |= state.writeStages | state.readStages;
+        state.layout = desc.finalLayout;
+    }
+
+    RecordBarriers(commandBuffer, srcStages, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, memoryBarrier);
+}
+
+void LTVKRenderGraph::PrintStats()
+{
+    uint32_t physicalCount = 0;
+    VkDeviceSize requestedBytes = 0;
+    VkDeviceSize allocatedBytes = 0;
+
+    if (m_PhysicalResources != nullptr)
+    {
+        physicalCount = (uint32_t)m_PhysicalResources->resources.size();
+        requestedBytes = m_PhysicalResources->requestedBytes;
+        allocatedBytes = m_PhysicalResources->imageHeap.size + m_PhysicalResources->bufferHeap.size;
+
+        for (const LTVKPhysicalResource& resource : m_PhysicalResources->resources)
+        {
+            allocatedBytes += resource.dedicatedAllocation.size;
+        }
+    }
+
+    printf("render graph: %u passes, %u culled, %u reordered, %u transient resources in %.2f MB "
+        "(%.2f MB unaliased), %u resource sets created \n",
+        (uint32_t)m_Passes.size(),
+        m_CulledPassCount,
+        m_ReorderedPassCount,
+        physicalCount,
+        allocatedBytes / (1024.0 * 1024.0),
+        requestedBytes / (1024.0 * 1024.0),
+        m_ResourceCreateCount);
+
+    printf("render graph: %u executes, %u barrier batches, %u image and %u buffer barriers, "
+        "%u uses needing none \n",
+        m_ExecuteCount,
+        m_BarrierBatchCount,
+        m_ImageBarrierCount,
+        m_BufferBarrierCount,
+        m_SkippedBarrierCount);
+}
+
+VkImage LTVKRenderGraph::GetImage(LTVKRenderGraphResource resource) const
+{
+    const LTVKRenderGraphResourceDesc& desc = m_Resources[resource];
+
+    if (desc.isImported)
+    {
+        return desc.image;
+    }
+
+    return desc.physicalIndex != LT_VK_RENDER_GRAPH_NO_RESOURCE
+        ? m_PhysicalResources->resources[desc.physicalIndex].image
+        : VK_NULL_HANDLE;
+}
+
+VkImageView LTVKRenderGraph::GetImageView(LTVKRenderGraphResource resource) const
+{
+    const LTVKRenderGraphResourceDesc& desc = m_Resources[resource];
+
+    if (desc.isImported)
+    {
+        return desc.imageView;
+    }
+
+    return desc.physicalIndex != LT_VK_RENDER_GRAPH_NO_RESOURCE
+        ? m_PhysicalResources->resources[desc.physicalIndex].imageView
+        : VK_NULL_HANDLE;
+}
+
+VkBuffer LTVKRenderGraph::GetBuffer(LTVKRenderGraphResource resource) const
+{
+    const LTVKRenderGraphResourceDesc& desc = m_Resources[resource];
+
+    if (desc.isImported)
+    {
+        return desc.buffer;
+    }
+
+    return desc.physicalIndex != LT_VK_RENDER_GRAPH_NO_RESOURCE
+        ? m_PhysicalResources->resources[desc.physicalIndex].buffer
+        : VK_NULL_HANDLE;
+}
+
+void LTVKRenderGraph::CullPasses()
+{
+    // walking back from the last pass, a pass is kept if it has side effects or
+    // writes a resource a kept pass after it reads; what it reads is then needed
+    // too. Writes do not end the need for a resource, since an attachment may be
+    // loaded rather than cleared
+    eastl::vector<bool> isNeeded(m_Resources.size(), false);
+    m_CulledPassCount = 0;
+
+    for (uint32_t p = (uint32_t)m_Passes.size(); p-- > 0;)
+    {
+        LTVKRenderGraphPass& pass = m_Passes[p];
+        bool isKept = pass.hasSideEffects;
+
+        for (const LTVKRenderGraphUse& use : pass.uses)
+        {
+            if (s_AccessInfos[(size_t)use.access].isWrite
+                && (m_Resources[use.resource].isImported || isNeeded[use.resource]))
+            {
+                isKept = true;
+            }
+        }
+
+        pass.isCulled = !isKept;
+
+        if (pass.isCulled)
+        {
+            ++m_CulledPassCount;
+            continue;
+        }
+
+        for (const LTVKRenderGraphUse& use : pass.uses)
+        {
+            if (!s_AccessInfos[(size_t)use.access].isWrite)
+            {
+                isNeeded[use.resource] = true;
+            }
+        }
+    }
+
+}
+
+void LTVKRenderGraph::SchedulePasses()
+{
+    // walking the passes kept as declared, a use depends on the last write of its
+    // resource, and a write also on the reads since, which it would overwrite
+    eastl::vector<uint32_t> lastWriters(m_Resources.size(), LT_VK_RENDER_GRAPH_NO_RESOURCE);
+    eastl::vector<eastl::vector<uint32_t>> readers(m_Resources.size());
+    uint32_t lastSideEffectPass = LT_VK_RENDER_GRAPH_NO_RESOURCE;
+    uint32_t keptCount = 0;
+
+    for (uint32_t p = 0; p < m_Passes.size(); ++p)
+    {
+        LTVKRenderGraphPass& pass = m_Passes[p];
+        pass.dependents.clear();
+        pass.dependencyCount = 0;
+
+        if (pass.isCulled)
+        {
+            continue;
+        }
+
+        ++keptCount;
+
+        for (const LTVKRenderGraphUse& use : pass.uses)
+        {
+            if (lastWriters[use.resource] != LT_VK_RENDER_GRAPH_NO_RESOURCE)
+            {
+                AddDependency(lastWriters[use.resource], p);
+            }
+
+            if (!s_AccessInfos[(size_t)use.access].isWrite)
+            {
+                readers[use.resource].push_back(p);
+                continue;
+            }
+
+            for (uint32_t reader : readers[use.resource])
+            {
+                AddDependency(reader, p);
+            }
+
+            readers[use.resource].clear();
+            lastWriters[use.resource] = p;
+        }
+
+        // what they do outside the graph may depend on each other
+        if (pass.hasSideEffects)
+        {
+            if (lastSideEffectPass != LT_VK_RENDER_GRAPH_NO_RESOURCE)
+            {
+                AddDependency(lastSideEffectPass, p);
+            }
+
+            lastSideEffectPass = p;
+        }
+    }
+
+    eastl::vector<uint32_t> readyPasses;
+
+    for (uint32_t p = 0; p < m_Passes.size(); ++p)
+    {
+        if (!m_Passes[p].isCulled && m_Passes[p].dependencyCount == 0)
+        {
+            readyPasses.push_back(p);
+        }
+    }
+
+    m_Order.clear();
+    m_ReorderedPassCount = 0;
+
+    while (!readyPasses.empty())
+    {
+        // the ready pass declared first, unless it has to wait for the pass just
+        // scheduled and another does not
+        uint32_t picked = 0;
+        bool isPickedDependent = true;
+
+        for (uint32_t i = 0; i < readyPasses.size(); ++i)
+        {
+            bool isDependent = false;
+
+            if (!m_Order.empty())
+            {
+                const eastl::vector<uint32_t>& dependents = m_Passes[m_Order.back()].dependents;
+                isDependent = std::find(dependents.begin(), dependents.end(), readyPasses[i]) != dependents.end();
+            }
+
+            if ((isPickedDependent && !isDependent)
+                || (isPickedDependent == isDependent && readyPasses[i] < readyPasses[picked]))
+            {
+                picked = i;
+                isPickedDependent = isDependent;
+            }
+        }
+
+        uint32_t p = readyPasses[picked];
+        readyPasses.erase(readyPasses.begin() + picked);
+
+        if (!m_Order.empty() && p < m_Order.back())
+        {
+            ++m_ReorderedPassCount;
+        }
+
+        m_Order.push_back(p);
+
+        for (uint32_t dependent : m_Passes[p].dependents)
+        {
+            if (--m_Passes[dependent].dependencyCount == 0)
+            {
+                readyPasses.push_back(dependent);
+            }
+        }
+    }
+
+    // every dependency points forward in declaration order, so there are no cycles
+    assert(m_Order.size() == keptCount);
+
+    for (LTVKRenderGraphResourceDesc& desc : m_Resources)
+    {
+        desc.firstPass = LT_VK_RENDER_GRAPH_NO_RESOURCE;
+        desc.lastPass = LT_VK_RENDER_GRAPH_NO_RESOURCE;
+        desc.physicalIndex = LT_VK_RENDER_GRAPH_NO_RESOURCE;
+        desc.usage = 0;
+    }
+
+    for (uint32_t position = 0; position < m_Order.size(); ++position)
+    {
+        for (const LTVKRenderGraphUse& use : m_Passes[m_Order[position]].uses)
+        {
+            LTVKRenderGraphResourceDesc& desc = m_Resources[use.resource];
+            const LTVKAccessInfo& info = s_AccessInfos[(size_t)use.access];
+
+            if (desc.firstPass == LT_VK_RENDER_GRAPH_NO_RESOURCE)
+            {
+                desc.firstPass = position;
+
+                // a transient resource has no contents until something writes it
+                assert(desc.isImported || info.isWrite);
+            }
+
+            desc.lastPass = position;
+            desc.usage |= desc.isImage ? info.imageUsage : info.bufferUsage;
+        }
+    }
+}
+
+void LTVKRenderGraph::AddDependency(uint32_t pass, uint32_t dependent)
+{
+    // the uses of a pass are walked together, so a dependency on the same pass
+    // through another resource was the last one added
+    eastl::vector<uint32_t>& dependents = m_Passes[pass].dependents;
+
+    if (!dependents.empty() && dependents.back() == dependent)
+    {
+        return;
+    }
+
+    dependents.push_back(dependent);
+    ++m_Passes[dependent].dependencyCount;
+}
+
+bool LTVKRenderGraph::CreateResources(LTVKRenderGraphResources& physicalResources)
+{
+    for (const LTVKRenderGraphResourceDesc& desc : m_Resources)
+    {
+        if (desc.physicalIndex == LT_VK_RENDER_GRAPH_NO_RESOURCE)
+        {
+            continue;
+        }
+
+        physicalResources.resources.push_back(LTVKPhysicalResource());
+        LTVKPhysicalResource& resource = physicalResources.resources.back();
+        resource.firstPass = desc.firstPass;
+        resource.lastPass = desc.lastPass;
+
+        if (desc.isImage)
+        {
+            VkImageCreateInfo imageInfo = {};
+            imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+            imageInfo.imageType = VK_IMAGE_TYPE_2D;
+            imageInfo.extent.width = desc.extent.width;
+            imageInfo.extent.height = desc.extent.height;
+            imageInfo.extent.depth = 1;
+            imageInfo.mipLevels = 1;
+            imageInfo.arrayLayers = 1;
+            imageInfo.format = desc.format;
+            imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+            imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+            imageInfo.usage = desc.usage;
+            imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+            imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+            if (vkCreateImage(m_Device, &imageInfo, nullptr, &resource.image) != VK_SUCCESS)
+            {
+                return false;
+            }
+
+            vkGetImageMemoryRequirements(m_Device, resource.image, &resource.requirements);
+        }
+        else
+        {
+            VkBufferCreateInfo bufferInfo = {};
+            bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+            bufferInfo.size = desc.size;
+            bufferInfo.usage = desc.usage;
+            bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+            if (vkCreateBuffer(m_Device, &bufferInfo, nullptr, &resource.buffer) != VK_SUCCESS)
+            {
+                return false;
+            }
+
+            vkGetBufferMemoryRequirements(m_Device, resource.buffer, &resource.requirements);
+        }
+
+        physicalResources.requestedBytes += resource.requirements.size;
+    }
+
+    // images and buffers are placed in heaps of their own, so no buffer shares a
+    // bufferImageGranularity page with an image
+    if (!PlaceResources(physicalResources, true, physicalResources.imageHeap)
+        || !PlaceResources(physicalResources, false, physicalResources.bufferHeap))
+    {
+        return false;
+    }
+
+    for (const LTVKRenderGraphResourceDesc& desc : m_Resources)
+    {
+        if (desc.physicalIndex == LT_VK_RENDER_GRAPH_NO_RESOURCE)
+        {
+            continue;
+        }
+
+        LTVKPhysicalResource& resource = physicalResources.resources[desc.physicalIndex];
+
+        if (desc.isImage)
+        {
+            const LTVKAllocation& allocation = resource.dedicatedAllocation.memory != VK_NULL_HANDLE
+                ? resource.dedicatedAllocation
+                : physicalResources.imageHeap;
+
+            vkBindImageMemory(m_Device, resource.image, allocation.memory, allocation.offset + resource.offset);
+
+            VkImageViewCreateInfo viewInfo = {};
+            viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+            viewInfo.image = resource.image;
+            viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+            viewInfo.format = desc.format;
+            viewInfo.subresourceRange.aspectMask = GetImageAspect(desc.format);
+            viewInfo.subresourceRange.baseMipLevel = 0;
+            viewInfo.subresourceRange.levelCount = 1;
+            viewInfo.subresourceRange.baseArrayLayer = 0;
+            viewInfo.subresourceRange.layerCount = 1;
+
+            if (vkCreateImageView(m_Device, &viewInfo, nullptr, &resource.imageView) != VK_SUCCESS)
+            {
+                return false;
+            }
+        }
+        else
+        {
+            const LTVKAllocation& allocation = resource.dedicatedAllocation.memory != VK_NULL_HANDLE
+                ? resource.dedicatedAllocation
+                : physicalResources.bufferHeap;
+
+            vkBindBufferMemory(m_Device, resource.buffer, allocation.memory, allocation.offset + resource.offset);
+        }
+    }
+
+    return true;
+}
+
+bool LTVKRenderGraph::PlaceResources(
+    LTVKRenderGraphResources& physicalResources,
+    bool isImage,
+    LTVKAllocation& outHeap)
+{
+    LTVKMemoryAllocator& memoryAllocator = m_LTVKDevice->GetMemoryAllocator();
+    eastl::vector<LTVKPhysicalResource>& resources = physicalResources.resources;
+    eastl::vector<uint32_t> placed;
+
+    VkMemoryRequirements heapRequirements = {};
+    heapRequirements.alignment = 1;
+    heapRequirements.memoryTypeBits = UINT32_MAX;
+
+    for (uint32_t i = 0; i < resources.size(); ++i)
+    {
+        LTVKPhysicalResource& resource = resources[i];
+
+        if ((resource.image != VK_NULL_HANDLE) != isImage)
+        {
+            continue;
+        }
+
+        // a resource no memory type of the heap suits gets memory of its own and
+        // shares it with nothing
+        if ((heapRequirements.memoryTypeBits & resource.requirements.memoryTypeBits) == 0)
+        {
+            if (!memoryAllocator.Allocate(
+                resource.requirements,
+                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                isImage,
+                resource.dedicatedAllocation))
+            {
+                return false;
+            }
+
+            continue;
+        }
+
+        // the lowest of offset 0 and the ends of the resources alive at the same
+        // time that overlaps none of them
+        VkDeviceSize alignment = resource.requirements.alignment;
+        VkDeviceSize size = resource.requirements.size;
+        VkDeviceSize bestOffset = UINT64_MAX;
+
+        for (size_t c = 0; c <= placed.size(); ++c)
+        {
+            VkDeviceSize offset = 0;
+
+            if (c < placed.size())
+            {
+                const LTVKPhysicalResource& other = resources[placed[c]];
+
+                if (other.lastPass < resource.firstPass || resource.lastPass < other.firstPass)
+                {
+                    continue;
+                }
+
+                offset = (other.offset + other.requirements.size + alignment - 1) / alignment * alignment;
+            }
+
+            if (offset >= bestOffset)
+            {
+                continue;
+            }
+
+            bool isFree = true;
+
+            for (uint32_t otherIndex : placed)
+            {
+                const LTVKPhysicalResource& other = resources[otherIndex];
+
+                if (other.lastPass < resource.firstPass || resource.lastPass < other.firstPass)
+                {
+                    continue;
+                }
+
+                if (offset < other.offset + other.requirements.size && other.offset < offset + size)
+                {
+                    isFree = false;
+                    break;
+                }
+            }
+
+            if (isFree)
+            {
+                bestOffset = offset;
+            }
+        }
+
+        resource.offset = bestOffset;
+
+        heapRequirements.size = bestOffset + size > heapRequirements.size ? bestOffset + size : heapRequirements.size;
+        heapRequirements.alignment = alignment > heapRequirements.alignment ? alignment : heapRequirements.alignment;
+        heapRequirements.memoryTypeBits &= resource.requirements.memoryTypeBits;
+
+        placed.push_back(i);
+    }
+
+    // resources sharing memory, whose lifetimes do not overlap by construction
+    for (size_t a = 0; a < placed.size(); ++a)
+    {
+        for (size_t b = a + 1; b < placed.size(); ++b)
+        {
+            LTVKPhysicalResource& first = resources[placed[a]];
+            LTVKPhysicalResource& second = resources[placed[b]];
+
+            if (first.offset < second.offset + second.requirements.size
+                && second.offset < first.offset + first.requirements.size)
+            {
+                first.aliases.push_back(placed[b]);
+                second.aliases.push_back(placed[a]);
+            }
+        }
+    }
+
+    if (heapRequirements.size == 0)
+    {
+        return true;
+    }
+
+    return memoryAllocator.Allocate(
+        heapRequirements,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+        isImage,
+        outHeap);
+}
+
+void LTVKRenderGraph::DestroyResources(LTVKRenderGraphResources& physicalResources)
+{
+    LTVKMemoryAllocator& memoryAllocator = m_LTVKDevice->GetMemoryAllocator();
+
+    for (LTVKPhysicalResource& resource : physicalResources.resources)
+    {
+        vkDestroyImageView(m_Device, resource.imageView, nullptr);
+        vkDestroyImage(m_Device, resource.image, nullptr);
+        vkDestroyBuffer(m_Device, resource.buffer, nullptr);
+        memoryAllocator.Free(resource.dedicatedAllocation);
+    }
+
+    physicalResources.resources.clear();
+
+    memoryAllocator.Free(physicalResources.imageHeap);
+    memoryAllocator.Free(physicalResources.bufferHeap);
+}
+
+void LTVKRenderGraph::AddBarrier(
+    LTVKRenderGraphResourceDesc& desc,
+    LTVKResourceState& state,
+    LTVKResourceAccess access,
+    bool isFirstUse,
+    VkPipelineStageFlags& srcStages,
+    VkPipelineStageFlags& dstStages,
+    VkMemoryBarrier& memoryBarrier)
+{
+    const LTVKAccessInfo& info = s_AccessInfos[(size_t)access];
+    VkImageLayout layout = desc.isImage ? info.layout : VK_IMAGE_LAYOUT_UNDEFINED;
+
+    VkPipelineStageFlags waitStages;
+    VkAccessFlags waitAccess;
+    bool isTransition = desc.isImage && (isFirstUse || layout != state.layout);
+    bool isBarrierNeeded;
+
+    if (isFirstUse)
+    {
+        // the contents are discarded, but the memory may still be in use by the
+        // accesses of the last frame, to this resource or one sharing its memory
+        const LTVKPhysicalResource& physical = m_PhysicalResources->resources[desc.physicalIndex];
+
+        waitStages = state.writeStages | state.readStages;
+        waitAccess = state.writeAccess;
+
+        for (uint32_t alias : physical.aliases)
+        {
+            const LTVKResourceState& aliasState = m_PhysicalResources->resources[alias].state;
+            waitStages |= aliasState.writeStages | aliasState.readStages;
+            waitAccess |= aliasState.writeAccess;
+        }
+
+        state.layout = VK_IMAGE_LAYOUT_UNDEFINED;
+        isBarrierNeeded = desc.isImage || waitStages != 0;
+    }
+    else if (isTransition)
+    {
+        waitStages = state.writeStages | state.readStages;
+        waitAccess = state.writeAccess;
+        isBarrierNeeded = true;
+    }
+    else if (info.isWrite)
+    {
+        // the reads since the last write have waited for it, so waiting for them
+        // is enough; without any, the write waits for the last write
+        waitStages = state.readStages != 0 ? state.readStages : state.writeStages;
+        waitAccess = state.readStages != 0 ? 0 : state.writeAccess;
+        isBarrierNeeded = waitStages != 0;
+    }
+    else
+    {
+        // a read after a read needs nothing once the write before them is visible
+        // to its stage and access
+        waitStages = state.writeStages;
+        waitAccess = state.writeAccess;
+        isBarrierNeeded = state.writeStages != 0
+            && ((info.stages & ~state.visibleStages) != 0 || (info.access & ~state.visibleAccess) != 0);
+    }
+
+    if (!isBarrierNeeded)
+    {
+        ++m_SkippedBarrierCount;
+    }
+    else if (desc.isImage)
+    {
+        VkImageMemoryBarrier barrier = {};
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.srcAccessMask = waitAccess;
+        barrier.dstAccessMask = info.access;
+        barrier.oldLayout = state.layout;
+        barrier.newLayout = layout;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image = desc.isImported ? desc.image : m_PhysicalResources->resources[desc.physicalIndex].image;
+        barrier.subresourceRange.aspectMask = GetImageAspect(desc.format);
+        barrier.subresourceRange.baseMipLevel = 0;
+        barrier.subresourceRange.levelCount = VK_REMAINING_MIP_LEVELS;
+        barrier.subresourceRange.baseArrayLayer = 0;
+        barrier.subresourceRange.layerCount = VK_REMAINING_ARRAY_LAYERS;
+
+        m_ImageBarriers.push_back(barrier);
+    }
+    else if (isFirstUse)
+    {
+        // the hazard is on memory another buffer used, which a barrier on this
+        // buffer would not cover
+        memoryBarrier.srcAccessMask |= waitAccess;
+        memoryBarrier.dstAccessMask |= info.access;
+    }
+    else
+    {
+        VkBufferMemoryBarrier barrier = {};
+        barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+        barrier.srcAccessMask = waitAccess;
+        barrier.dstAccessMask = info.access;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.buffer = desc.isImported ? desc.buffer : m_PhysicalResources->resources[desc.physicalIndex].buffer;
+        barrier.offset = 0;
+        barrier.size = VK_WHOLE_SIZE;
+
+        m_BufferBarriers.push_back(barrier);
+    }
+
+    if (isBarrierNeeded)
+    {
+        srcStages |= waitStages;
+        dstStages |= info.stages;
+    }
+
+    if (info.isWrite)
+    {
+        state.writeStages = info.stages;
+        state.writeAccess = info.access;
+        state.readStages = 0;
+        state.visibleStages = 0;
+        state.visibleAccess = 0;
+    }
+    else if (isTransition)
+    {
+        // the transition writes the image; later reads in other stages wait for
+        // this stage, whose barrier already made it available
+        state.writeStages = info.stages;
+        state.writeAccess = 0;
+        state.readStages = info.stages;
+        state.visibleStages = info.stages;
+        state.visibleAccess = info.access;
+    }
+    else
+    {
+        state.readStages |= info.stages;
+
+        if (isBarrierNeeded)
+        {
+            state.visibleStages |= info.stages;
+            state.visibleAccess |= info.access;
+        }
+    }
+
+    state.layout = layout;
+}
+
+void LTVKRenderGraph::RecordBarriers(
+    VkCommandBuffer commandBuffer,
+    VkPipelineStageFlags srcStages,
+    VkPipelineStageFlags dstStages,
+    const VkMemoryBarrier& memoryBarrier)
+{
+    bool hasMemoryBarrier = memoryBarrier.dstAccessMask != 0;
+
+    if (m_ImageBarriers.empty() && m_BufferBarriers.empty() && !hasMemoryBarrier)
+    {
+        return;
+    }
+
+    // nothing to wait for, as for the first use of a new image
+    if (srcStages == 0)
+    {
+        srcStages = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+    }
+
+    vkCmdPipelineBarrier(
+        commandBuffer,
+        srcStages,
+        dstStages,
+        0,
+        hasMemoryBarrier ? 1 : 0,
+        &memoryBarrier,
+        (uint32_t)m_BufferBarriers.size(),
+        m_BufferBarriers.data(),
+        (uint32_t)m_ImageBarriers.size(),
+        m_ImageBarriers.data());
+
+    ++m_BarrierBatchCount;
+    m_ImageBarrierCount += (uint32_t)m_ImageBarriers.size();
+    m_BufferBarrierCount += (uint32_t)m_BufferBarriers.size();
+}
+
+LTVKResourceState& LTVKRenderGraph::GetState(LTVKRenderGraphResourceDesc& desc)
+{
+    return desc.isImported
+        ? desc.importState
+        : m_PhysicalResources->resources[desc.physicalIndex].state;
+}
+
+VkImageAspectFlags LTVKRenderGraph::GetImageAspect(VkFormat format)
+{
+    switch (format)
+    {
+    case VK_FORMAT_D16_UNORM:
+    case VK_FORMAT_X8_D24_UNORM_PACK32:
+    case VK_FORMAT_D32_SFLOAT:
+        return VK_IMAGE_ASPECT_DEPTH_BIT;
+    case VK_FORMAT_D16_UNORM_S8_UINT:
+    case VK_FORMAT_D24_UNORM_S8_UINT:
+    case VK_FORMAT_D32_SFLOAT_S8_UINT:
+        return VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
+    case VK_FORMAT_S8_UINT:
+        return VK_IMAGE_ASPECT_STENCIL_BIT;
+    default:
+        return VK_IMAGE_ASPECT_COLOR_BIT;
+    }
+}
@@ -0,0 +1,518 @@
+#include "PrecompiledHeader.h"
+
+#include "LTVKRenderer.h"
+#include "LTVKDevice.h"
+#include "LTGameWindow.h"
+
+bool LTVKRenderer::Initialize(LTVKDevice* ltvkDevice, LTGameWindow* window, const LTVKRendererConfig& config)
+{
+    m_LTVKDevice = ltvkDevice;
+    m_Device = ltvkDevice->GetDevice();
+    m_Window = window;
+    m_Config = config;
+
+    assert(config.framesInFlight >= 1 && config.framesInFlight <= LT_VK_MAX_FRAMES_IN_FLIGHT);
+
+    VkPipelineLayoutCreateInfo layoutInfo = {};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+
+    if (vkCreatePipelineLayout(m_Device, &layoutInfo, nullptr, &m_EmptyPipelineLayout) != VK_SUCCESS)
+    {
+        return false;
+    }
+
+    // a minimized window only means the swapchain is created on the first frame
+    // drawn after it is restored
+    if (!CreateRenderPass()
+        || !CreateFrames()
+        || !m_CommandRecorder.Initialize(ltvkDevice, config.framesInFlight, config.recordWorkerCount))
+    {
+        return false;
+    }
+
+    m_RenderGraph.Initialize(ltvkDevice);
+
+    m_IsSwapChainStale = !RecreateSwapChain();
+    m_SwapChainRecreateCount = 0;
+
+    return true;
+}
+
+void LTVKRenderer::Destroy()
+{
+    WaitForFrame(m_FrameNumber - 1);
+
+    m_CommandRecorder.Destroy();
+    m_RenderGraph.Destroy();
+
+    for (LTVKRetiredSwapChain& retired : m_RetiredSwapChains)
+    {
+        retired.swapChain->Destroy();
+        delete retired.swapChain;
+    }
+
+    m_RetiredSwapChains.clear();
+
+    if (m_SwapChain != nullptr)
+    {
+        m_SwapChain->Destroy();
+        delete m_SwapChain;
+        m_SwapChain = nullptr;
+    }
+
+    for (LTVKFrame& frame : m_Frames)
+    {
+        vkDestroyFence(m_Device, frame.fence, nullptr);
+        vkDestroySemaphore(m_Device, frame.imageAvailableSemaphore, nullptr);
+        vkDestroyCommandPool(m_Device, frame.commandPool, nullptr);
+        frame = LTVKFrame();
+    }
+
+    vkDestroyRenderPass(m_Device, m_RenderPass, nullptr);
+    vkDestroyPipelineLayout(m_Device, m_EmptyPipelineLayout, nullptr);
+    m_RenderPass = VK_NULL_HANDLE;
+    m_EmptyPipelineLayout = VK_NULL_HANDLE;
+}
+
+bool LTVKRenderer::BeginFrame()
+{
+    assert(m_CurrentFrame == nullptr);
+
+    if (m_Window->WasResized())
+    {
+        m_Window->ClearResized();
+        m_IsSwapChainStale = true;
+    }
+
+    if (m_IsSwapChainStale)
+    {
+        if (!RecreateSwapChain())
+        {
+            return false;
+        }
+
+        m_IsSwapChainStale = false;
+    }
+
+    LTVKFrame& frame = m_Frames[m_FrameNumber % m_Config.framesInFlight];
+
+    // the only wait on the GPU: the frame that last used these resources, which
+    // the GPU has usually finished while the frames since were recorded
+    WaitForFrame(frame.frameNumber);
+    ReleaseRetiredSwapChains();
+
+    VkResult result = vkAcquireNextImageKHR(
+        m_Device,
+        m_SwapChain->GetSwapChain(),
+        UINT64_MAX,
+        frame.imageAvailableSemaphore,
+        VK_NULL_HANDLE,
+        &frame.imageIndex);
+
+    if (result == VK_ERROR_OUT_OF_DATE_KHR)
+    {
+        m_IsSwapChainStale = true;
+        return false;
+    }
+
+    // a suboptimal image still signals the semaphore, so it is drawn to and the
+    // swapchain replaced after it is presented
+    if (result == VK_SUBOPTIMAL_KHR)
+    {
+        m_IsSwapChainStale = true;
+    }
+    else if (result != VK_SUCCESS)
+    {
+        return false;
+    }
+
+    // with fewer images than frames in flight, an image can come back while an
+    // earlier frame is still rendering to it
+    WaitForFrame(m_ImageFrames[frame.imageIndex]);
+    m_ImageFrames[frame.imageIndex] = m_FrameNumber;
+
+    vkResetCommandPool(m_Device, frame.commandPool, 0);
+    m_CommandRecorder.ResetFrame(GetFrameIndex());
+
+    VkCommandBufferBeginInfo beginInfo = {};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+    vkBeginCommandBuffer(frame.commandBuffer, &beginInfo);
+
+    // the image's last contents were presented and are not kept, and it is written
+    // once the acquire semaphore is waited on; the depth buffer the frames share is
+    // cleared, once the frame before has finished with it
+    m_RenderGraph.Reset();
+
+    m_BackBuffer = m_RenderGraph.ImportImage(
+        "back buffer",
+        m_SwapChain->GetImage(frame.imageIndex),
+        m_SwapChain->GetImageView(frame.imageIndex),
+        m_ColorFormat,
+        m_SwapChain->GetExtent(),
+        VK_IMAGE_LAYOUT_UNDEFINED,
+        VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+        0,
+        VK_IMAGE_LAYOUT_PRESENT_SRC_KHR);
+
+    m_DepthBuffer = m_RenderGraph.ImportImage(
+        "depth buffer",
+        m_SwapChain->GetDepthImage(),
+        m_SwapChain->GetDepthImageView(),
+        m_DepthFormat,
+        m_SwapChain->GetExtent(),
+        VK_IMAGE_LAYOUT_UNDEFINED,
+        VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+        VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+        VK_IMAGE_LAYOUT_UNDEFINED);
+
+    m_CurrentFrame = &frame;
+    return true;
+}
+
+uint32_t LTVKRenderer::AddScenePass(
+    const char* name,
+    float red,
+    float green,
+    float blue,
+    VkSubpassContents contents,
+    const LTVKRenderGraphExecute& record)
+{
+    assert(m_CurrentFrame != nullptr);
+
+    uint32_t pass = m_RenderGraph.AddPass(name, [this, red, green, blue, contents, record](VkCommandBuffer commandBuffer)
+    {
+        BeginRenderPass(red, green, blue, contents);
+        record(commandBuffer);
+        EndRenderPass();
+    });
+
+    m_RenderGraph.AddUse(pass, m_BackBuffer, LTVKResourceAccess::LT_VK_RESOURCE_ACCESS_COLOR_ATTACHMENT);
+    m_RenderGraph.AddUse(pass, m_DepthBuffer, LTVKResourceAccess::LT_VK_RESOURCE_ACCESS_DEPTH_ATTACHMENT);
+
+    return pass;
+}
+
+void LTVKRenderer::BeginRenderPass(float red, float green, float blue, VkSubpassContents contents)
+{
+    VkExtent2D extent = m_SwapChain->GetExtent();
+
+    VkClearValue clearValues[2] = {};
+    clearValues[0].color.float32[0] = red;
+    clearValues[0].color.float32[1] = green;
+    clearValues[0].color.float32[2] = blue;
+    clearValues[0].color.float32[3] = 1.0f;
+    clearValues[1].depthStencil.depth = 1.0f;
+    clearValues[1].depthStencil.stencil = 0;
+
+    VkRenderPassBeginInfo renderPassInfo = {};
+    renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+    renderPassInfo.renderPass = m_RenderPass;
+    renderPassInfo.framebuffer = m_SwapChain->GetFramebuffer(m_CurrentFrame->imageIndex);
+    renderPassInfo.renderArea.offset = { 0, 0 };
+    renderPassInfo.renderArea.extent = extent;
+    renderPassInfo.clearValueCount = 2;
+    renderPassInfo.pClearValues = clearValues;
+
+    vkCmdBeginRenderPass(m_CurrentFrame->commandBuffer, &renderPassInfo, contents);
+    m_SubpassContents = contents;
+
+    // the secondary command buffers set their own
+    if (contents != VK_SUBPASS_CONTENTS_INLINE)
+    {
+        return;
+    }
+
+    // pipelines take the viewport and scissor as dynamic state, so they outlive
+    // the swapchain
+    VkViewport viewport = {};
+    viewport.x = 0.0f;
+    viewport.y = 0.0f;
+    viewport.width = (float)extent.width;
+    viewport.height = (float)extent.height;
+    viewport.minDepth = 0.0f;
+    viewport.maxDepth = 1.0f;
+
+    VkRect2D scissor = {};
+    scissor.offset = { 0, 0 };
+    scissor.extent = extent;
+
+    vkCmdSetViewport(m_CurrentFrame->commandBuffer, 0, 1, &viewport);
+    vkCmdSetScissor(m_CurrentFrame->commandBuffer, 0, 1, &scissor);
+}
+
+void LTVKRenderer::EndRenderPass()
+{
+    vkCmdEndRenderPass(m_CurrentFrame->commandBuffer);
+}
+
+void LTVKRenderer::RecordParallel(uint32_t taskCount, const LTVKRecordCallback& record)
+{
+    assert(m_SubpassContents == VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+
+    VkCommandBufferInheritanceInfo inheritance = {};
+    inheritance.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+    inheritance.renderPass = m_RenderPass;
+    inheritance.subpass = 0;
+    inheritance.framebuffer = m_SwapChain->GetFramebuffer(m_CurrentFrame->imageIndex);
+
+    m_SecondaryCommandBuffers.clear();
+    m_CommandRecorder.Record(inheritance, m_SwapChain->GetExtent(), taskCount, record, m_SecondaryCommandBuffers);
+
+    if (!m_SecondaryCommandBuffers.empty())
+    {
+        vkCmdExecuteCommands(
+            m_CurrentFrame->commandBuffer,
+            (uint32_t)m_SecondaryCommandBuffers.size(),
+            m_SecondaryCommandBuffers.data());
+    }
+}
+
+void LTVKRenderer::EndFrame()
+{
+    LTVKFrame& frame = *m_CurrentFrame;
+
+    // the transient resources of the frame's passes are created here, so a failure
+    // is as fatal as a failed submit
+    if (!m_RenderGraph.Compile(m_CompletedFrame))
+    {
+        throw std::runtime_error("failed to compile the render graph!");
+    }
+
+    m_RenderGraph.Execute(frame.commandBuffer, m_FrameNumber);
+    m_CurrentFrame = nullptr;
+
+    vkEndCommandBuffer(frame.commandBuffer);
+
+    VkSemaphore renderFinishedSemaphore = m_SwapChain->GetRenderFinishedSemaphore(frame.imageIndex);
+    VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+
+    VkSubmitInfo submitInfo = {};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.waitSemaphoreCount = 1;
+    submitInfo.pWaitSemaphores = &frame.imageAvailableSemaphore;
+    submitInfo.pWaitDstStageMask = &waitStage;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &frame.commandBuffer;
+    submitInfo.signalSemaphoreCount = 1;
+    submitInfo.pSignalSemaphores = &renderFinishedSemaphore;
+
+    // reset only now that the frame is certain to be submitted; a frame skipped
+    // after its wait must leave the fence signalled
+    vkResetFences(m_Device, 1, &frame.fence);
+
+    if (m_LTVKDevice->QueueSubmit(m_LTVKDevice->GetGraphicsQueue(), submitInfo, frame.fence) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to submit frame!");
+    }
+
+    frame.frameNumber = m_FrameNumber++;
+
+    VkSwapchainKHR swapChain = m_SwapChain->GetSwapChain();
+
+    VkPresentInfoKHR presentInfo = {};
+    presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+    presentInfo.waitSemaphoreCount = 1;
+    presentInfo.pWaitSemaphores = &renderFinishedSemaphore;
+    presentInfo.swapchainCount = 1;
+    presentInfo.pSwapchains = &swapChain;
+    presentInfo.pImageIndices = &frame.imageIndex;
+
+    VkResult result = m_LTVKDevice->QueuePresent(presentInfo);
+
+    if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR)
+    {
+        m_IsSwapChainStale = true;
+    }
+}
+
+void LTVKRenderer::PrintStats()
+{
+    uint64_t frameCount = m_FrameNumber - 1;
+    double waitMs = std::chrono::duration<double, std::milli>(m_FrameWaitTime).count();
+
+    // little wait per frame means the CPU was recording while the GPU executed
+    printf("renderer: %llu frames, %u in flight, %.2f ms waiting for the GPU (%.3f ms per frame), "
+        "%u swapchains recreated \n",
+        (unsigned long long)frameCount,
+        m_Config.framesInFlight,
+        waitMs,
+        frameCount > 0 ? waitMs / frameCount : 0.0,
+        m_SwapChainRecreateCount);
+
+    m_CommandRecorder.PrintStats();
+    m_RenderGraph.PrintStats();
+}
+
+bool LTVKRenderer::CreateRenderPass()
+{
+    VkAttachmentDescription attachments[2] = {};
+
+    m_ColorFormat = LTVKSwapChain::ChooseSurfaceFormat(m_LTVKDevice).format;
+    m_DepthFormat = LTVKSwapChain::ChooseDepthFormat(m_LTVKDevice);
+
+    // the render graph transitions the attachments to and from the layouts the
+    // subpass uses, and synchronizes them with the frames before, so the pass
+    // neither changes their layouts nor has dependencies of its own
+    VkAttachmentDescription& colorAttachment = attachments[0];
+    colorAttachment.format = m_ColorFormat;
+    colorAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
+    colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+    colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+    colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    colorAttachment.initialLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+    colorAttachment.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+    VkAttachmentDescription& depthAttachment = attachments[1];
+    depthAttachment.format = m_DepthFormat;
+    depthAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
+    depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+    depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    depthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    depthAttachment.initialLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+    depthAttachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+    VkAttachmentReference colorReference = {};
+    colorReference.attachment = 0;
+    colorReference.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+    VkAttachmentReference depthReference = {};
+    depthReference.attachment = 1;
+    depthReference.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+    VkSubpassDescription subpass = {};
+    subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+    subpass.colorAttachmentCount = 1;
+    subpass.pColorAttachments = &colorReference;
+    subpass.pDepthStencilAttachment = &depthReference;
+
+    VkRenderPassCreateInfo renderPassInfo = {};
+    renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+    renderPassInfo.attachmentCount = 2;
+    renderPassInfo.pAttachments = attachments;
+    renderPassInfo.subpassCount = 1;
+    renderPassInfo.pSubpasses = &subpass;
+
+    return vkCreateRenderPass(m_Device, &renderPassInfo, nullptr, &m_RenderPass) == VK_SUCCESS;
+}
+
+bool LTVKRenderer::CreateFrames()
+{
+    for (uint32_t i = 0; i < m_Config.framesInFlight; ++i)
+    {
+        LTVKFrame& frame = m_Frames[i];
+
+        VkCommandPoolCreateInfo poolInfo = {};
+        poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        poolInfo.queueFamilyIndex = m_LTVKDevice->GetQueueFamilies().graphicsFamily;
+        poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+
+        if (vkCreateCommandPool(m_Device, &poolInfo, nullptr, &frame.commandPool) != VK_SUCCESS)
+        {
+            return false;
+        }
+
+        VkCommandBufferAllocateInfo allocInfo = {};
+        allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        allocInfo.commandPool = frame.commandPool;
+        allocInfo.commandBufferCount = 1;
+
+        VkSemaphoreCreateInfo semaphoreInfo = {};
+        semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+        // signalled, so the first wait on each frame returns at once
+        VkFenceCreateInfo fenceInfo = {};
+        fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+        fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+
+        if (vkAllocateCommandBuffers(m_Device, &allocInfo, &frame.commandBuffer) != VK_SUCCESS ||
+            vkCreateSemaphore(m_Device, &semaphoreInfo, nullptr, &frame.imageAvailableSemaphore) != VK_SUCCESS ||
+            vkCreateFence(m_Device, &fenceInfo, nullptr, &frame.fence) != VK_SUCCESS)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool LTVKRenderer::RecreateSwapChain()
+{
+    VkExtent2D windowExtent = { m_Window->GetWidth(), m_Window->GetHeight() };
+
+    LTVKSwapChain* swapChain = new LTVKSwapChain();
+
+    if (!swapChain->Initialize(
+        m_LTVKDevice,
+        windowExtent,
+        m_Config.presentMode,
+        m_RenderPass,
+        m_SwapChain != nullptr ? m_SwapChain->GetSwapChain() : VK_NULL_HANDLE))
+    {
+        swapChain->Destroy();
+        delete swapChain;
+        return false;
+    }
+
+    // the frames already submitted may still be rendering to or presenting the
+    // old swapchain; rather than waiting for the device, it is kept until they
+    // have completed
+    if (m_SwapChain != nullptr)
+    {
+        LTVKRetiredSwapChain retired;
+        retired.swapChain = m_SwapChain;
+        retired.lastFrame = m_FrameNumber - 1;
+        m_RetiredSwapChains.push_back(retired);
+
+        ++m_SwapChainRecreateCount;
+    }
+
+    m_SwapChain = swapChain;
+    m_ImageFrames.clear();
+    m_ImageFrames.resize(swapChain->GetImageCount(), 0);
+
+    return true;
+}
+
+void LTVKRenderer::ReleaseRetiredSwapChains()
+{
+    for (size_t i = 0; i < m_RetiredSwapChains.size();)
+    {
+        LTVKRetiredSwapChain& retired = m_RetiredSwapChains[i];
+
+        if (retired.lastFrame > m_CompletedFrame)
+        {
+            ++i;
+            continue;
+        }
+
+        retired.swapChain->Destroy();
+        delete retired.swapChain;
+
+        m_RetiredSwapChains.erase(m_RetiredSwapChains.begin() + i);
+    }
+}
+
+void LTVKRenderer::WaitForFrame(uint64_t frameNumber)
+{
+    if (frameNumber <= m_CompletedFrame)
+    {
+        return;
+    }
+
+    // a frame's resources are only reused once it has completed, so they still
+    // hold the frame being waited for
+    LTVKFrame& frame = m_Frames[frameNumber % m_Config.framesInFlight];
+    assert(frame.frameNumber == frameNumber);
+
+    auto waitStart = std::chrono::steady_clock::now();
+    vkWaitForFences(m_Device, 1, &frame.fence, VK_TRUE, UINT64_MAX);
+    m_FrameWaitTime += std::chrono::steady_clock::now() - waitStart;
+
+    // the queue completes frames in the order they were submitted
+    m_CompletedFrame = frameNumber;
+}
@@ -0,0 +1,285 @@
+#include "PrecompiledHeader.h"
+
+#include "LTVKSwapChain.h"
+#include "LTVKDevice.h"
+
+bool LTVKSwapChain::Initialize(
+    LTVKDevice* ltvkDevice,
+    VkExtent2D windowExtent,
+    LTVKPresentMode presentMode,
+    VkRenderPass renderPass,
+    VkSwapchainKHR oldSwapChain)
+{
+    m_LTVKDevice = ltvkDevice;
+    m_Device = ltvkDevice->GetDevice();
+
+    LTVKSwapChainSupportDetails support = ltvkDevice->GetSwapChainSupport();
+    const VkSurfaceCapabilitiesKHR& capabilities = support.capabilities;
+
+    // the surface decides the extent unless it leaves it to the window
+    if (capabilities.currentExtent.width != UINT32_MAX)
+    {
+        m_Extent = capabilities.currentExtent;
+    }
+    else
+    {
+        m_Extent.width = windowExtent.width < capabilities.minImageExtent.width ? capabilities.minImageExtent.width
+            : windowExtent.width > capabilities.maxImageExtent.width ? capabilities.maxImageExtent.width
+            : windowExtent.width;
+        m_Extent.height = windowExtent.height < capabilities.minImageExtent.height ? capabilities.minImageExtent.height
+            : windowExtent.height > capabilities.maxImageExtent.height ? capabilities.maxImageExtent.height
+            : windowExtent.height;
+    }
+
+    // a minimized window has nothing to present to
+    if (m_Extent.width == 0 || m_Extent.height == 0)
+    {
+        return false;
+    }
+
+    VkSurfaceFormatKHR surfaceFormat = ChooseSurfaceFormat(ltvkDevice);
+    m_ImageFormat = surfaceFormat.format;
+    m_PresentMode = ChoosePresentMode(support.presentModes, presentMode);
+
+    // one image more than the minimum, so acquiring never waits on the driver
+    uint32_t imageCount = capabilities.minImageCount + 1;
+
+    if (capabilities.maxImageCount > 0 && imageCount > capabilities.maxImageCount)
+    {
+        imageCount = capabilities.maxImageCount;
+    }
+
+    VkSwapchainCreateInfoKHR createInfo = {};
+    createInfo.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
+    createInfo.surface = ltvkDevice->GetSurface();
+    createInfo.minImageCount = imageCount;
+    createInfo.imageFormat = surfaceFormat.format;
+    createInfo.imageColorSpace = surfaceFormat.colorSpace;
+    createInfo.imageExtent = m_Extent;
+    createInfo.imageArrayLayers = 1;
+    createInfo.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+
+    const LTVKQueueFamilyIndices& queueFamilies = ltvkDevice->GetQueueFamilies();
+    uint32_t queueFamilyIndices[] = { queueFamilies.graphicsFamily, queueFamilies.presentFamily };
+
+    if (queueFamilies.graphicsFamily != queueFamilies.presentFamily)
+    {
+        createInfo.imageSharingMode = VK_SHARING_MODE_CONCURRENT;
+        createInfo.queueFamilyIndexCount = 2;
+        createInfo.pQueueFamilyIndices = queueFamilyIndices;
+    }
+    else
+    {
+        createInfo.imageSharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    }
+
+    createInfo.preTransform = capabilities.currentTransform;
+    createInfo.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
+    createInfo.presentMode = m_PresentMode;
+    createInfo.clipped = VK_TRUE;
+
+    // lets the driver hand the old swapchain's resources over rather than waiting
+    // for the frames still queued on it
+    createInfo.oldSwapchain = oldSwapChain;
+
+    if (vkCreateSwapchainKHR(m_Device, &createInfo, nullptr, &m_SwapChain) != VK_SUCCESS)
+    {
+        return false;
+    }
+
+    vkGetSwapchainImagesKHR(m_Device, m_SwapChain, &imageCount, nullptr);
+    m_Images.resize(imageCount);
+    vkGetSwapchainImagesKHR(m_Device, m_SwapChain, &imageCount, m_Images.data());
+
+    m_RenderFinishedSemaphores.resize(imageCount, VK_NULL_HANDLE);
+
+    for (VkSemaphore& semaphore : m_RenderFinishedSemaphores)
+    {
+        VkSemaphoreCreateInfo semaphoreInfo = {};
+        semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+        if (vkCreateSemaphore(m_Device, &semaphoreInfo, nullptr, &semaphore) != VK_SUCCESS)
+        {
+            return false;
+        }
+    }
+
+    return CreateImageViews()
+        && CreateDepthImage()
+        && CreateFramebuffers(renderPass);
+}
+
+void LTVKSwapChain::Destroy()
+{
+    for (VkFramebuffer framebuffer : m_Framebuffers)
+    {
+        vkDestroyFramebuffer(m_Device, framebuffer, nullptr);
+    }
+
+    for (VkImageView imageView : m_ImageViews)
+    {
+        vkDestroyImageView(m_Device, imageView, nullptr);
+    }
+
+    for (VkSemaphore semaphore : m_RenderFinishedSemaphores)
+    {
+        vkDestroySemaphore(m_Device, semaphore, nullptr);
+    }
+
+    m_Framebuffers.clear();
+    m_ImageViews.clear();
+    m_RenderFinishedSemaphores.clear();
+    m_Images.clear();
+
+    if (m_DepthImage != VK_NULL_HANDLE)
+    {
+        vkDestroyImageView(m_Device, m_DepthImageView, nullptr);
+        m_LTVKDevice->DestroyImage(m_DepthImage, m_DepthAllocation);
+        m_DepthImageView = VK_NULL_HANDLE;
+    }
+
+    vkDestroySwapchainKHR(m_Device, m_SwapChain, nullptr);
+    m_SwapChain = VK_NULL_HANDLE;
+}
+
+VkSurfaceFormatKHR LTVKSwapChain::ChooseSurfaceFormat(LTVKDevice* ltvkDevice)
+{
+    LTVKSwapChainSupportDetails support = ltvkDevice->GetSwapChainSupport();
+
+    for (const VkSurfaceFormatKHR& format : support.formats)
+    {
+        if (format.format == VK_FORMAT_B8G8R8A8_SRGB && format.colorSpace == VK_COLOR_SPACE_SRGB_NONLINEAR_KHR)
+        {
+            return format;
+        }
+    }
+
+    return support.formats[0];
+}
+
+VkFormat LTVKSwapChain::ChooseDepthFormat(LTVKDevice* ltvkDevice)
+{
+    return ltvkDevice->FindSupportedFormat(
+        { VK_FORMAT_D32_SFLOAT, VK_FORMAT_D32_SFLOAT_S8_UINT, VK_FORMAT_D24_UNORM_S8_UINT },
+        VK_IMAGE_TILING_OPTIMAL,
+        VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT);
+}
+
+VkPresentModeKHR LTVKSwapChain::ChoosePresentMode(
+    const std::vector<VkPresentModeKHR>& availableModes,
+    LTVKPresentMode presentMode)
+{
+    bool hasMailbox = false;
+    bool hasImmediate = false;
+
+    for (VkPresentModeKHR availableMode : availableModes)
+    {
+        hasMailbox |= availableMode == VK_PRESENT_MODE_MAILBOX_KHR;
+        hasImmediate |= availableMode == VK_PRESENT_MODE_IMMEDIATE_KHR;
+    }
+
+    if (presentMode == LTVKPresentMode::LT_VK_PRESENT_MODE_IMMEDIATE && hasImmediate)
+    {
+        return VK_PRESENT_MODE_IMMEDIATE_KHR;
+    }
+
+    // mailbox is the next best way not to wait on the display
+    if (presentMode != LTVKPresentMode::LT_VK_PRESENT_MODE_FIFO && hasMailbox)
+    {
+        return VK_PRESENT_MODE_MAILBOX_KHR;
+    }
+
+    // the only mode every device supports
+    return VK_PRESENT_MODE_FIFO_KHR;
+}
+
+bool LTVKSwapChain::CreateImageViews()
+{
+    m_ImageViews.resize(m_Images.size(), VK_NULL_HANDLE);
+
+    for (size_t i = 0; i < m_Images.size(); ++i)
+    {
+        VkImageViewCreateInfo viewInfo = {};
+        viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+        viewInfo.image = m_Images[i];
+        viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+        viewInfo.format = m_ImageFormat;
+        viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        viewInfo.subresourceRange.baseMipLevel = 0;
+        viewInfo.subresourceRange.levelCount = 1;
+        viewInfo.subresourceRange.baseArrayLayer = 0;
+        viewInfo.subresourceRange.layerCount = 1;
+
+        if (vkCreateImageView(m_Device, &viewInfo, nullptr, &m_ImageViews[i]) != VK_SUCCESS)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool LTVKSwapChain::CreateDepthImage()
+{
+    VkFormat depthFormat = ChooseDepthFormat(m_LTVKDevice);
+
+    VkImageCreateInfo imageInfo = {};
+    imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    imageInfo.imageType = VK_IMAGE_TYPE_2D;
+    imageInfo.extent.width = m_Extent.width;
+    imageInfo.extent.height = m_Extent.height;
+    imageInfo.extent.depth = 1;
+    imageInfo.mipLevels = 1;
+    imageInfo.arrayLayers = 1;
+    imageInfo.format = depthFormat;
+    imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+    imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    imageInfo.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+    imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+    imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    m_LTVKDevice->CreateImageWithInfo(
+        imageInfo,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+        m_DepthImage,
+        m_DepthAllocation);
+
+    VkImageViewCreateInfo viewInfo = {};
+    viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    viewInfo.image = m_DepthImage;
+    viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    viewInfo.format = depthFormat;
+    viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
+    viewInfo.subresourceRange.baseMipLevel = 0;
+    viewInfo.subresourceRange.levelCount = 1;
+    viewInfo.subresourceRange.baseArrayLayer = 0;
+    viewInfo.subresourceRange.layerCount = 1;
+
+    return vkCreateImageView(m_Device, &viewInfo, nullptr, &m_DepthImageView) == VK_SUCCESS;
+}
+
+bool LTVKSwapChain::CreateFramebuffers(VkRenderPass renderPass)
+{
+    m_Framebuffers.resize(m_Images.size(), VK_NULL_HANDLE);
+
+    for (size_t i = 0; i < m_Images.size(); ++i)
+    {
+        VkImageView attachments[] = { m_ImageViews[i], m_DepthImageView };
+
+        VkFramebufferCreateInfo framebufferInfo = {};
+        framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+        framebufferInfo.renderPass = renderPass;
+        framebufferInfo.attachmentCount = 2;
+        framebufferInfo.pAttachments = attachments;
+        framebufferInfo.width = m_Extent.width;
+        framebufferInfo.height = m_Extent.height;
+        framebufferInfo.layers = 1;
+
+        if (vkCreateFramebuffer(m_Device, &framebufferInfo, nullptr, &m_Framebuffers[i]) != VK_SUCCESS)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,564 @@
+#include "PrecompiledHeader.h"
+
+#include "LTVKUploadManager.h"
+#include "LTVKDevice.h"
+
+static VkDeviceSize AlignUp(VkDeviceSize value, VkDeviceSize alignment)
+{
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+bool LTVKUploadManager::Initialize(LTVKDevice* ltvkDevice)
+{
+    m_LTVKDevice = ltvkDevice;
+    m_Device = ltvkDevice->GetDevice();
+    m_Queue = ltvkDevice->GetTransferQueue();
+
+    LTVKQueueFamilyIndices queueFamilies = ltvkDevice->GetQueueFamilies();
+    m_IsDedicatedTransferQueue = queueFamilies.transferFamily != queueFamilies.graphicsFamily;
+
+    // the copy offsets into compressed images must also suit the device
+    VkDeviceSize copyAlignment = ltvkDevice->GetProperties().limits.optimalBufferCopyOffsetAlignment;
+    m_Alignment = copyAlignment > LT_VK_UPLOAD_ALIGNMENT ? copyAlignment : LT_VK_UPLOAD_ALIGNMENT;
+
+    VkCommandPoolCreateInfo poolInfo = {};
+    poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    poolInfo.queueFamilyIndex = queueFamilies.transferFamily;
+    poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT |
+        VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+
+    if (vkCreateCommandPool(m_Device, &poolInfo, nullptr, &m_CommandPool) != VK_SUCCESS)
+    {
+        return false;
+    }
+
+    for (LTVKUploadBatch& batch : m_Batches)
+    {
+        VkCommandBufferAllocateInfo allocInfo = {};
+        allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        allocInfo.commandPool = m_CommandPool;
+        allocInfo.commandBufferCount = 1;
+
+        VkFenceCreateInfo fenceInfo = {};
+        fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+
+        if (vkAllocateCommandBuffers(m_Device, &allocInfo, &batch.commandBuffer) != VK_SUCCESS ||
+            vkCreateFence(m_Device, &fenceInfo, nullptr, &batch.fence) != VK_SUCCESS)
+        {
+            return false;
+        }
+    }
+
+    m_LTVKDevice->CreateBuffer(
+        LT_VK_UPLOAD_RING_SIZE,
+        VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        m_Ring.buffer,
+        m_Ring.allocation);
+
+    m_RingData = (uint8_t*)m_Ring.allocation.mappedData;
+    m_RingSize = LT_VK_UPLOAD_RING_SIZE;
+    m_RingHead = 0;
+    m_RingUsedBytes = 0;
+
+    return true;
+}
+
+void LTVKUploadManager::Destroy()
+{
+    {
+        std::unique_lock lock(m_Mutex);
+
+        if (m_OpenUploadCount > 0)
+        {
+            SubmitOpenBatch();
+        }
+
+        while (LTVKUploadBatch* batch = GetOldestBatch())
+        {
+            vkWaitForFences(m_Device, 1, &batch->fence, VK_TRUE, UINT64_MAX);
+            RetireBatches();
+        }
+
+        if (!m_Reservations.empty())
+        {
+            printf("upload manager: %zu staging ranges were never queued \n", m_Reservations.size());
+        }
+    }
+
+    m_LTVKDevice->DestroyBuffer(m_Ring.buffer, m_Ring.allocation);
+    m_RingData = nullptr;
+
+    for (LTVKUploadBatch& batch : m_Batches)
+    {
+        vkDestroyFence(m_Device, batch.fence, nullptr);
+        batch.fence = VK_NULL_HANDLE;
+    }
+
+    // destroying the pool frees the command buffers
+    vkDestroyCommandPool(m_Device, m_CommandPool, nullptr);
+    m_CommandPool = VK_NULL_HANDLE;
+}
+
+bool LTVKUploadManager::ReserveRing(VkDeviceSize size, VkDeviceSize& outOffset, uint64_t& outReservation)
+{
+    // an empty ring starts again from the beginning, so large ranges wrap less
+    if (m_RingUsedBytes == 0)
+    {
+        m_RingHead = 0;
+    }
+
+    VkDeviceSize offset = m_RingHead;
+    VkDeviceSize ringBytes = size;
+
+    // a range never straddles the end; the bytes left there go with the range
+    if (offset + size > m_RingSize)
+    {
+        ringBytes += m_RingSize - offset;
+        offset = 0;
+    }
+
+    if (m_RingUsedBytes + ringBytes > m_RingSize)
+    {
+        return false;
+    }
+
+    m_RingHead = offset + size;
+    m_RingUsedBytes += ringBytes;
+
+    LTVKStagingReservation reservation;
+    reservation.id = m_NextReservation++;
+    reservation.ringBytes = ringBytes;
+    reservation.batch = 0;
+    m_Reservations.push_back(reservation);
+
+    outOffset = offset;
+    outReservation = reservation.id;
+    return true;
+}
+
+bool LTVKUploadManager::BeginUpload(VkDeviceSize size, LTVKUpload& outUpload)
+{
+    outUpload.bufferUploads.clear();
+    outUpload.imageUploads.clear();
+    outUpload.imageRegions.clear();
+
+    VkDeviceSize alignedSize = AlignUp(size, m_Alignment);
+
+    if (alignedSize > m_RingSize)
+    {
+        // called from the asset workers, whose jobs fail when memory runs out
+        if (!m_LTVKDevice->TryCreateBuffer(
+            size,
+            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            outUpload.ownStagingBuffer.buffer,
+            outUpload.ownStagingBuffer.allocation))
+        {
+            return false;
+        }
+
+        outUpload.buffer = outUpload.ownStagingBuffer.buffer;
+        outUpload.offset = 0;
+        outUpload.size = size;
+        outUpload.mappedData = outUpload.ownStagingBuffer.allocation.mappedData;
+        outUpload.reservation = 0;
+        return outUpload.mappedData != nullptr;
+    }
+
+    std::unique_lock lock(m_Mutex);
+
+    VkDeviceSize offset;
+    uint64_t reservation;
+
+    while (!ReserveRing(alignedSize, offset, reservation))
+    {
+        // the ring is full: the oldest ranges are freed by submitting the batch they
+        // are queued into and waiting for it, or by the threads still filling them
+        // queueing them first
+        if (m_OpenUploadCount > 0)
+        {
+            SubmitOpenBatch();
+        }
+
+        RetireBatches();
+
+        LTVKUploadBatch* oldestBatch = GetOldestBatch();
+
+        if (!m_Reservations.empty() && m_Reservations.front().batch == 0)
+        {
+            m_RingCondition.wait(lock);
+        }
+        else if (oldestBatch)
+        {
+            vkWaitForFences(m_Device, 1, &oldestBatch->fence, VK_TRUE, UINT64_MAX);
+            RetireBatches();
+        }
+    }
+
+    outUpload.buffer = m_Ring.buffer;
+    outUpload.offset = offset;
+    outUpload.size = size;
+    outUpload.mappedData = m_RingData + offset;
+    outUpload.reservation = reservation;
+    outUpload.ownStagingBuffer = LTVKStagingBuffer();
+    return true;
+}
+
+void LTVKUploadManager::CopyToBuffer(
+    LTVKUpload& upload,
+    VkDeviceSize srcOffset,
+    VkBuffer dstBuffer,
+    VkDeviceSize dstOffset,
+    VkDeviceSize size)
+{
+    LTVKBufferUpload bufferUpload;
+    bufferUpload.srcBuffer = upload.buffer;
+    bufferUpload.dstBuffer = dstBuffer;
+    bufferUpload.region.srcOffset = upload.offset + srcOffset;
+    bufferUpload.region.dstOffset = dstOffset;
+    bufferUpload.region.size = size;
+
+    upload.bufferUploads.push_back(bufferUpload);
+}
+
+void LTVKUploadManager::CopyToImage(
+    LTVKUpload& upload,
+    VkImage dstImage,
+    uint32_t mipCount,
+    const VkBufferImageCopy* regions,
+    uint32_t regionCount)
+{
+    LTVKImageUpload imageUpload;
+    imageUpload.srcBuffer = upload.buffer;
+    imageUpload.dstImage = dstImage;
+    imageUpload.mipCount = mipCount;
+    imageUpload.firstRegion = (uint32_t)upload.imageRegions.size();
+    imageUpload.regionCount = regionCount;
+
+    upload.imageUploads.push_back(imageUpload);
+
+    for (uint32_t i = 0; i < regionCount; ++i)
+    {
+        VkBufferImageCopy region = regions[i];
+        region.bufferOffset += upload.offset;
+        upload.imageRegions.push_back(region);
+    }
+}
+
+uint64_t LTVKUploadManager::EndUpload(LTVKUpload& upload)
+{
+    std::scoped_lock lock(m_Mutex);
+
+    for (LTVKStagingReservation& reservation : m_Reservations)
+    {
+        if (reservation.id == upload.reservation)
+        {
+            reservation.batch = m_OpenBatchValue;
+            break;
+        }
+    }
+
+    uint32_t regionBase = (uint32_t)m_OpenBatch.imageRegions.size();
+
+    for (LTVKImageUpload& imageUpload : upload.imageUploads)
+    {
+        imageUpload.firstRegion += regionBase;
+        m_OpenBatch.imageUploads.push_back(imageUpload);
+    }
+
+    m_OpenBatch.bufferUploads.insert(m_OpenBatch.bufferUploads.end(), upload.bufferUploads.begin(), upload.bufferUploads.end());
+    m_OpenBatch.imageRegions.insert(m_OpenBatch.imageRegions.end(), upload.imageRegions.begin(), upload.imageRegions.end());
+
+    if (upload.ownStagingBuffer.buffer != VK_NULL_HANDLE)
+    {
+        m_OpenBatch.stagingBuffers.push_back(upload.ownStagingBuffer);
+    }
+
+    upload.bufferUploads.clear();
+    upload.imageUploads.clear();
+    upload.imageRegions.clear();
+    upload.ownStagingBuffer = LTVKStagingBuffer();
+    upload.mappedData = nullptr;
+
+    m_OpenUploadCount++;
+    m_RingCondition.notify_all();
+    return m_OpenBatchValue;
+}
+
+void LTVKUploadManager::Submit()
+{
+    std::scoped_lock lock(m_Mutex);
+
+    if (m_OpenUploadCount > 0)
+    {
+        SubmitOpenBatch();
+    }
+}
+
+bool LTVKUploadManager::IsComplete(uint64_t batch)
+{
+    std::scoped_lock lock(m_Mutex);
+
+    RetireBatches();
+    return m_CompletedBatch >= batch;
+}
+
+void LTVKUploadManager::Wait(uint64_t batch)
+{
+    std::unique_lock lock(m_Mutex);
+
+    while (m_CompletedBatch < batch)
+    {
+        // a submitted batch is waited on directly. while the previous batch is on the
+        // GPU the open one keeps collecting the uploads of other threads, so it waits
+        // for the newest batch in flight and is submitted once the queue catches up
+        bool isOpen = batch == m_OpenBatchValue;
+        LTVKUploadBatch* waitBatch = nullptr;
+
+        for (LTVKUploadBatch& inFlightBatch : m_Batches)
+        {
+            if (inFlightBatch.value == 0)
+            {
+                continue;
+            }
+
+            if (isOpen ? !waitBatch || inFlightBatch.value > waitBatch->value : inFlightBatch.value == batch)
+            {
+                waitBatch = &inFlightBatch;
+            }
+        }
+
+        if (!waitBatch)
+        {
+            if (isOpen)
+            {
+                SubmitOpenBatch();
+            }
+            else
+            {
+                RetireBatches();
+            }
+
+            continue;
+        }
+
+        // the batch is not reused while it is waited on, so its fence stays valid
+        // with the mutex released
+        waitBatch->waiterCount++;
+        VkFence fence = waitBatch->fence;
+
+        lock.unlock();
+        vkWaitForFences(m_Device, 1, &fence, VK_TRUE, UINT64_MAX);
+        lock.lock();
+
+        waitBatch->waiterCount--;
+        RetireBatches();
+    }
+}
+
+void LTVKUploadManager::SubmitOpenBatch()
+{
+    LTVKUploadBatch& batch = AcquireBatch();
+
+    batch.bufferUploads.swap(m_OpenBatch.bufferUploads);
+    batch.imageUploads.swap(m_OpenBatch.imageUploads);
+    batch.imageRegions.swap(m_OpenBatch.imageRegions);
+    batch.stagingBuffers.swap(m_OpenBatch.stagingBuffers);
+
+    RecordBatch(batch);
+
+    VkSubmitInfo submitInfo = {};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &batch.commandBuffer;
+
+    vkResetFences(m_Device, 1, &batch.fence);
+    m_LTVKDevice->QueueSubmit(m_Queue, submitInfo, batch.fence);
+
+    batch.value = m_OpenBatchValue++;
+    m_OpenUploadCount = 0;
+
+    // the copies are recorded; only the staging buffers are kept until it completes
+    batch.bufferUploads.clear();
+    batch.imageUploads.clear();
+    batch.imageRegions.clear();
+}
+
+void LTVKUploadManager::RecordBatch(LTVKUploadBatch& batch)
+{
+    vkResetCommandBuffer(batch.commandBuffer, 0);
+
+    VkCommandBufferBeginInfo beginInfo = {};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+    vkBeginCommandBuffer(batch.commandBuffer, &beginInfo);
+
+    // every image of the batch is transitioned for the copies in one barrier
+    m_Barriers.clear();
+
+    for (const LTVKImageUpload& imageUpload : batch.imageUploads)
+    {
+        VkImageMemoryBarrier barrier = {};
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.srcAccessMask = 0;
+        barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image = imageUpload.dstImage;
+        barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        barrier.subresourceRange.baseMipLevel = 0;
+        barrier.subresourceRange.levelCount = imageUpload.mipCount;
+        barrier.subresourceRange.baseArrayLayer = 0;
+        barrier.subresourceRange.layerCount = 1;
+        m_Barriers.push_back(barrier);
+    }
+
+    if (!m_Barriers.empty())
+    {
+        vkCmdPipelineBarrier(
+            batch.commandBuffer,
+            VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+            VK_PIPELINE_STAGE_TRANSFER_BIT,
+            0,
+            0, nullptr,
+            0, nullptr,
+            (uint32_t)m_Barriers.size(), m_Barriers.data());
+    }
+
+    for (const LTVKBufferUpload& bufferUpload : batch.bufferUploads)
+    {
+        vkCmdCopyBuffer(batch.commandBuffer, bufferUpload.srcBuffer, bufferUpload.dstBuffer, 1, &bufferUpload.region);
+    }
+
+    for (const LTVKImageUpload& imageUpload : batch.imageUploads)
+    {
+        vkCmdCopyBufferToImage(
+            batch.commandBuffer,
+            imageUpload.srcBuffer,
+            imageUpload.dstImage,
+            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            imageUpload.regionCount,
+            batch.imageRegions.data() + imageUpload.firstRegion);
+    }
+
+    // a transfer queue has no shader stages to hand the images to; the fence the
+    // batch is waited on orders the copies before any frame that samples them
+    VkAccessFlags dstAccess = m_IsDedicatedTransferQueue ? 0 : VK_ACCESS_SHADER_READ_BIT;
+    VkPipelineStageFlags dstStage = m_IsDedicatedTransferQueue ?
+        VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT :
+        VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+
+    for (VkImageMemoryBarrier& barrier : m_Barriers)
+    {
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = dstAccess;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    }
+
+    if (!m_Barriers.empty())
+    {
+        vkCmdPipelineBarrier(
+            batch.commandBuffer,
+            VK_PIPELINE_STAGE_TRANSFER_BIT,
+            dstStage,
+            0,
+            0, nullptr,
+            0, nullptr,
+            (uint32_t)m_Barriers.size(), m_Barriers.data());
+    }
+
+    vkEndCommandBuffer(batch.commandBuffer);
+}
+
+LTVKUploadBatch& LTVKUploadManager::AcquireBatch()
+{
+    while (true)
+    {
+        for (LTVKUploadBatch& batch : m_Batches)
+        {
+            if (batch.value == 0 && batch.waiterCount == 0)
+            {
+                return batch;
+            }
+        }
+
+        RetireBatches();
+
+        // every batch is in flight or still being waited on; the oldest frees first
+        LTVKUploadBatch* oldestBatch = GetOldestBatch();
+
+        if (oldestBatch)
+        {
+            vkWaitForFences(m_Device, 1, &oldestBatch->fence, VK_TRUE, UINT64_MAX);
+            RetireBatches();
+        }
+        else
+        {
+            // retired batches are only held by threads about to take the mutex
+            m_RingCondition.notify_all();
+            m_Mutex.unlock();
+            std::this_thread::yield();
+            m_Mutex.lock();
+        }
+    }
+}
+
+LTVKUploadBatch* LTVKUploadManager::GetOldestBatch()
+{
+    LTVKUploadBatch* oldestBatch = nullptr;
+
+    for (LTVKUploadBatch& batch : m_Batches)
+    {
+        if (batch.value != 0 && (!oldestBatch || batch.value < oldestBatch->value))
+        {
+            oldestBatch = &batch;
+        }
+    }
+
+    return oldestBatch;
+}
+
+void LTVKUploadManager::RetireBatches()
+{
+    // a queue completes its submissions in order, so the batches retire in order
+    while (LTVKUploadBatch* batch = GetOldestBatch())
+    {
+        if (vkGetFenceStatus(m_Device, batch->fence) != VK_SUCCESS)
+        {
+            break;
+        }
+
+        for (LTVKStagingBuffer& stagingBuffer : batch->stagingBuffers)
+        {
+            m_LTVKDevice->DestroyBuffer(stagingBuffer.buffer, stagingBuffer.allocation);
+        }
+
+        batch->stagingBuffers.clear();
+
+        m_CompletedBatch = batch->value;
+        batch->value = 0;
+    }
+
+    // the ring is released from its oldest range up to the first one still in use
+    size_t releasedCount = 0;
+
+    while (releasedCount < m_Reservations.size() &&
+        m_Reservations[releasedCount].batch != 0 &&
+        m_Reservations[releasedCount].batch <= m_CompletedBatch)
+    {
+        m_RingUsedBytes -= m_Reservations[releasedCount].ringBytes;
+        releasedCount++;
+    }
+
+    if (releasedCount > 0)
+    {
+        m_Reservations.erase(m_Reservations.begin(), m_Reservations.begin() + releasedCount);
+        m_RingCondition.notify_all();
+    }
+}
@@ -0,0 +1,36 @@
+#include "PrecompiledHeader.h"
+#include "LTVKVertexFormat.h"
+
+#include <cstddef>
+
+static const LTVKVertexFormat s_ModelVertexFormats[(uint32_t)LTModelVertexFormat::LT_MODEL_VERTEX_FORMAT_COUNT] =
+{
+    // LT_MODEL_VERTEX_FORMAT_FLOAT
+    {
+        { 0, sizeof(LTModelVertex), VK_VERTEX_INPUT_RATE_VERTEX },
+        {
+            { 0, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(LTModelVertex, position) },
+            { 1, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(LTModelVertex, normal) },
+            { 2, 0, VK_FORMAT_R32G32_SFLOAT, offsetof(LTModelVertex, uv) },
+        },
+        3
+    },
+
+    // LT_MODEL_VERTEX_FORMAT_QUANTIZED
+    {
+        { 0, sizeof(LTModelVertexQuantized), VK_VERTEX_INPUT_RATE_VERTEX },
+        {
+            { 0, 0, VK_FORMAT_R16G16B16A16_UNORM, offsetof(LTModelVertexQuantized, position) },
+            { 1, 0, VK_FORMAT_R16G16_SNORM, offsetof(LTModelVertexQuantized, normal) },
+            { 2, 0, VK_FORMAT_R16G16_SFLOAT, offsetof(LTModelVertexQuantized, uv) },
+        },
+        3
+    },
+};
+
+const LTVKVertexFormat& LTVKVertexFormat::GetModelVertexFormat(LTModelVertexFormat format)
+{
+    assert(format < LTModelVertexFormat::LT_MODEL_VERTEX_FORMAT_COUNT);
+
+    return s_ModelVertexFormats[(uint32_t)format];
+}
@@ -5,12 +5,116 @@
 #include "LTAsset.h"
 #include "LTVKDevice.h"
 #include "LTVKPipeline.h"
+#include "LTVKRenderer.h"
+#include "LTVKInstanceBatcher.h"
+#include "LTVKVertexFormat.h"
+#include "LTJobQueueBenchmark.h"
 
-int main()
+#include <cfloat>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+/**
+ * A cube fired from the origin, spinning as it flies until it is fired again.
+ */
+struct LTProjectile
+{
+    glm::vec3 position;
+    glm::vec3 velocity;
+    glm::vec3 spinAxis;
+    float spinSpeed;
+    float age;
+};
+
+/**
+ * How long a projectile flies before it is fired again, in seconds, and the size of
+ * its cube in world units.
+ */
+constexpr float LT_PROJECTILE_LIFETIME = 4.0f;
+constexpr float LT_PROJECTILE_SIZE = 0.2f;
+
+/**
+ * The downward acceleration of the projectiles, in world units per second squared.
+ */
+constexpr float LT_PROJECTILE_GRAVITY = 9.8f;
+
+/**
+ * The most a projectile's cube may be off from the full detail model on screen, in
+ * pixels; its level of detail is picked, and finer ones streamed in, to stay within it.
+ */
+constexpr float LT_LOD_PIXEL_ERROR = 1.0f;
+
+/**
+ * Fires a projectile from the origin, up and outwards in a random direction.
+ */
+static void FireCube(LTProjectile& projectile, std::mt19937& random)
 {
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+
+    projectile.position = glm::vec3(0.0f);
+    projectile.velocity = glm::vec3(unit(random) * 4.0f, 9.0f + unit(random) * 3.0f, unit(random) * 4.0f);
+    projectile.spinAxis = glm::normalize(glm::vec3(unit(random), unit(random), unit(random)) + glm::vec3(0.0f, 0.0f, 1.5f));
+    projectile.spinSpeed = unit(random) * 6.0f;
+    projectile.age = 0.0f;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc > 1 && strcmp(argv[1], "--benchmark-job-queue") == 0)
+    {
+        RunJobQueueBenchmark();
+        return 0;
+    }
+
+    // --present-mode=fifo|mailbox|immediate, --frames-in-flight=1..3,
+    // --record-workers=N and --projectiles=N
+    LTVKRendererConfig rendererConfig;
+    uint32_t projectileCount = 4096;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "--present-mode=fifo") == 0)
+        {
+            rendererConfig.presentMode = LTVKPresentMode::LT_VK_PRESENT_MODE_FIFO;
+        }
+        else if (strcmp(argv[i], "--present-mode=mailbox") == 0)
+        {
+            rendererConfig.presentMode = LTVKPresentMode::LT_VK_PRESENT_MODE_MAILBOX;
+        }
+        else if (strcmp(argv[i], "--present-mode=immediate") == 0)
+        {
+            rendererConfig.presentMode = LTVKPresentMode::LT_VK_PRESENT_MODE_IMMEDIATE;
+        }
+        else if (strncmp(argv[i], "--frames-in-flight=", 19) == 0)
+        {
+            int framesInFlight = atoi(argv[i] + 19);
+            rendererConfig.framesInFlight = framesInFlight < 1 ? 1
+                : framesInFlight > (int)LT_VK_MAX_FRAMES_IN_FLIGHT ? LT_VK_MAX_FRAMES_IN_FLIGHT
+                : (uint32_t)framesInFlight;
+        }
+        else if (strncmp(argv[i], "--record-workers=", 17) == 0)
+        {
+            int recordWorkerCount = atoi(argv[i] + 17);
+            rendererConfig.recordWorkerCount = recordWorkerCount < 0 ? 0 : (uint32_t)recordWorkerCount;
+        }
+        else if (strncmp(argv[i], "--projectiles=", 14) == 0)
+        {
+            int count = atoi(argv[i] + 14);
+            projectileCount = count < 0 ? 0 : (uint32_t)count;
+        }
+    }
+
     printf("sizeof(LTAssetState): %zu,\n", sizeof(LTAssetState));
     printf("sizeof(std::atomic<LTAssetState>): %zu,\n", sizeof(std::atomic<LTAssetState>));
 
+    // measured up to the first frame; pipeline creation is much of it without a
+    // warm pipeline cache
+    auto startupBegin = std::chrono::steady_clock::now();
+
     LTGameWindow gameWindow;
     gameWindow.Initialize();
 
@@ -21,42 +125,343 @@ int main()
         return 0;
     }
 
+    LTVKRenderer renderer;
+
+    if (!renderer.Initialize(&graphicsDevice, &gameWindow, rendererConfig))
+    {
+        graphicsDevice.Destroy();
+        gameWindow.Destroy();
+        return 0;
+    }
+
+    LTVKInstanceBatcher instanceBatcher;
+
+    if (!instanceBatcher.Initialize(&graphicsDevice, rendererConfig.framesInFlight))
+    {
+        renderer.Destroy();
+        graphicsDevice.Destroy();
+        gameWindow.Destroy();
+        return 0;
+    }
+
     LTAssetManager& assetManager = LTAssetManager::GetInstance();
     assetManager.Initialize(&graphicsDevice);
 
-    LTAssetHandle simpleVertShaderAsset = Content::VertexShaders::GetSimple();
-    LTAssetHandle simpleFragShaderAsset = Content::FragmentShaders::GetSimple();
+    // the pipeline below needs these immediately, so they go ahead of anything else
+    LTAssetLoadToken simpleVertShaderLoad = Content::VertexShaders::LoadSimple(LTAssetPriority::LT_ASSET_PRIORITY_CRITICAL);
+    LTAssetLoadToken simpleFragShaderLoad = Content::FragmentShaders::LoadSimple(LTAssetPriority::LT_ASSET_PRIORITY_CRITICAL);
+
+    // the projectiles are drawn once these and the cube are in, not before the first frame
+    LTAssetLoadToken instancedVertShaderLoad = Content::VertexShaders::LoadInstanced(LTAssetPriority::LT_ASSET_PRIORITY_HIGH);
+    LTAssetLoadToken instancedFragShaderLoad = Content::FragmentShaders::LoadInstanced(LTAssetPriority::LT_ASSET_PRIORITY_HIGH);
+
+    // the crate the projectiles are textured with loads with its mip tail only; the
+    // larger mips stream in as the projectiles come close enough to need them
+    LTAssetLoadToken crateLoad = Content::Images::LoadCrate(LTAssetPriority::LT_ASSET_PRIORITY_HIGH);
+    LTTexture* crateTexture = (LTTexture*)crateLoad.GetAssetHandle().GetAsset();
+    uint32_t crateMip = LT_TEXTURE_NO_MIP;
+    uint32_t requestedCrateMip = LT_TEXTURE_NO_MIP;
 
-    LTVKPipeline pipeline(
-        &graphicsDevice,
-        (LTShader*)simpleVertShaderAsset.GetAsset(),
-        (LTShader*)simpleFragShaderAsset.GetAsset());
+    if (!simpleVertShaderLoad.Wait(std::chrono::milliseconds(5000)) ||
+        !simpleFragShaderLoad.Wait(std::chrono::milliseconds(5000)) ||
+        simpleVertShaderLoad.GetResult() != LTAssetJobResult::LT_ASSET_JOB_RESULT_SUCCESS ||
+        simpleFragShaderLoad.GetResult() != LTAssetJobResult::LT_ASSET_JOB_RESULT_SUCCESS)
+    {
+        printf("Failed to load the simple shaders.\n");
+
+        assetManager.Destroy();
+        instanceBatcher.Destroy();
+        renderer.Destroy();
+        graphicsDevice.Destroy();
+        gameWindow.Destroy();
+        return 0;
+    }
+
+    LTVKPipelineManager& pipelineManager = graphicsDevice.GetPipelineManager();
 
     LTVKPipelineConfig config;
-    pipeline.GetDefaultPipelineConfig(
+    LTVKPipeline::GetDefaultPipelineConfig(
         config,
         gameWindow.GetWidth(),
         gameWindow.GetHeight());
 
-    pipeline.Initialize(config);
+    config.pipelineLayout = renderer.GetEmptyPipelineLayout();
+    config.renderPass = renderer.GetRenderPass();
+
+    // the simple pipeline stands in for every pipeline still compiling, so it is
+    // the one pipeline waited for
+    LTVKPipelineEntry* simplePipeline = pipelineManager.RequestPipeline(
+        config,
+        (LTShader*)simpleVertShaderLoad.GetAssetHandle().GetAsset(),
+        (LTShader*)simpleFragShaderLoad.GetAssetHandle().GetAsset());
+
+    pipelineManager.SetPlaceholder(simplePipeline);
+    pipelineManager.Wait(simplePipeline);
+
+    // the load completes with the cube's coarsest level of detail, so this only
+    // waits for *something*; the finer levels stream in behind it
+    LTAssetLoadToken cubeLoad = Content::Models::LoadCube(LTAssetPriority::LT_ASSET_PRIORITY_HIGH);
+
+    if (!cubeLoad.Wait(std::chrono::milliseconds(5000)) ||
+        cubeLoad.GetResult() != LTAssetJobResult::LT_ASSET_JOB_RESULT_SUCCESS)
+    {
+        printf("Failed to load the cube.\n");
+
+        // the workers may still be compiling with shaders the asset manager unloads
+        renderer.Destroy();
+        instanceBatcher.Destroy();
+        pipelineManager.Destroy();
+        assetManager.Destroy();
+        graphicsDevice.Destroy();
+        gameWindow.Destroy();
+        return 0;
+    }
+
+    LTModel* cubeModel = (LTModel*)cubeLoad.GetAssetHandle().GetAsset();
+    uint32_t cubeLOD = LT_MODEL_NO_LOD;
+    uint32_t requestedCubeLOD = LT_MODEL_NO_LOD;
+
+    // every projectile is an instance of the cube, so thousands of them are drawn
+    // with one draw call; the pipeline compiles in the background and the
+    // projectiles appear once it is ready
+    LTVKPipelineEntry* instancedPipeline = nullptr;
+
+    if (instancedVertShaderLoad.Wait(std::chrono::milliseconds(5000)) &&
+        instancedFragShaderLoad.Wait(std::chrono::milliseconds(5000)) &&
+        instancedVertShaderLoad.GetResult() == LTAssetJobResult::LT_ASSET_JOB_RESULT_SUCCESS &&
+        instancedFragShaderLoad.GetResult() == LTAssetJobResult::LT_ASSET_JOB_RESULT_SUCCESS)
+    {
+        LTVKPipelineConfig instancedConfig;
+        LTVKPipeline::GetDefaultPipelineConfig(
+            instancedConfig,
+            gameWindow.GetWidth(),
+            gameWindow.GetHeight());
+
+        instancedConfig.vertexFormat = &LTVKVertexFormat::GetModelVertexFormat(cubeModel->GetVertexFormat());
+        instancedConfig.pipelineLayout = instanceBatcher.GetPipelineLayout();
+        instancedConfig.renderPass = renderer.GetRenderPass();
 
-    //if (GetMouseDown(left))
-    //{
-    //    LTAsset* cubeAsset = Content::Models::GetCubePtr();
-    //    FireCube(cubeAsset); // <-- create the cube and give it velocity
-    //    // p = Create Projectile
-    //    // p.SetMesh(cubeAsset); <-- renderer can use cube when its ready
-    //    // 0. have already loaded the smallest version of cube
-    //    // 1. render nothing
-    //    // 2. sync wait for *something*  (small scale)
-    //    // 3. async wait for full scale
-    //}
+        instancedPipeline = pipelineManager.RequestPipeline(
+            instancedConfig,
+            (LTShader*)instancedVertShaderLoad.GetAssetHandle().GetAsset(),
+            (LTShader*)instancedFragShaderLoad.GetAssetHandle().GetAsset());
+    }
+    else
+    {
+        printf("Failed to load the instanced shaders; projectiles are not drawn.\n");
+    }
+
+    // scaled so the cube is LT_PROJECTILE_SIZE across whatever units it was modelled in
+    float cubeExtent = 0.0f;
+
+    for (uint32_t axis = 0; axis < 3; ++axis)
+    {
+        float extent = cubeModel->GetBoundsMax()[axis] - cubeModel->GetBoundsMin()[axis];
+        cubeExtent = extent > cubeExtent ? extent : cubeExtent;
+    }
+
+    float cubeScale = cubeExtent > 0.0f ? LT_PROJECTILE_SIZE / cubeExtent : 1.0f;
+
+    // staggered so they are not all fired again in the same frame
+    std::mt19937 random(1234);
+    eastl::vector<LTProjectile> projectiles(projectileCount);
+
+    for (uint32_t i = 0; i < projectileCount; ++i)
+    {
+        LTProjectile& projectile = projectiles[i];
+        FireCube(projectile, random);
+
+        float age = LT_PROJECTILE_LIFETIME * i / projectileCount;
+        projectile.position = projectile.velocity * age + glm::vec3(0.0f, -0.5f * LT_PROJECTILE_GRAVITY * age * age, 0.0f);
+        projectile.velocity.y -= LT_PROJECTILE_GRAVITY * age;
+        projectile.age = age;
+    }
+
+    auto lastFrameTime = std::chrono::steady_clock::now();
+
+    printf("startup: %.2f ms \n",
+        std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startupBegin).count());
 
     while (!gameWindow.ShouldClose())
     {
+        // images and buffers the asset manager replaces or unloads are kept until
+        // the frames that may use them have completed
+        assetManager.SetRenderFrames(renderer.GetFrameNumber(), renderer.GetCompletedFrame());
+        assetManager.BeginFrame();
+        assetManager.DispatchMainThreadCallbacks();
+        graphicsDevice.UpdatePipelineCache();
+
+        // nothing is drawn until a level exists; levels are never trimmed while the
+        // cube is loaded, so any level at or coarser than one read is safe to draw
+        uint32_t residentLOD = cubeModel->GetResidentLOD();
+
+        if (residentLOD != cubeLOD && residentLOD != LT_MODEL_NO_LOD)
+        {
+            printf("cube: LOD %u of %u resident\n", residentLOD, cubeModel->GetLODCount());
+        }
+
+        cubeLOD = residentLOD;
+
+        uint32_t residentMip = crateTexture->GetResidentMip();
+
+        if (residentMip != crateMip && residentMip != LT_TEXTURE_NO_MIP)
+        {
+            printf("crate: mip %u of %u resident\n", residentMip, crateTexture->GetMipCount());
+        }
+
+        crateMip = residentMip;
+
+        auto frameTime = std::chrono::steady_clock::now();
+        float deltaTime = std::chrono::duration<float>(frameTime - lastFrameTime).count();
+        lastFrameTime = frameTime;
+
+        // a long stall, e.g. dragging the window, would otherwise throw them all at once
+        deltaTime = deltaTime > 0.1f ? 0.1f : deltaTime;
+
+        for (LTProjectile& projectile : projectiles)
+        {
+            projectile.age += deltaTime;
+
+            if (projectile.age >= LT_PROJECTILE_LIFETIME)
+            {
+                FireCube(projectile, random);
+            }
+
+            projectile.velocity.y -= LT_PROJECTILE_GRAVITY * deltaTime;
+            projectile.position += projectile.velocity * deltaTime;
+        }
+
+        // skipped while minimized or while the swapchain is replaced
+        if (renderer.BeginFrame())
+        {
+            VkPipeline simpleVkPipeline = pipelineManager.GetPipeline(simplePipeline);
+
+            // the simple pipeline is the placeholder, but it cannot stand in here: it
+            // has neither the vertex input nor the layout
+            VkPipeline instancedVkPipeline = instancedPipeline != nullptr && pipelineManager.IsReady(instancedPipeline)
+                ? pipelineManager.GetPipeline(instancedPipeline)
+                : VK_NULL_HANDLE;
+
+            VkExtent2D extent = renderer.GetExtent();
+            float fieldOfView = glm::radians(60.0f);
+
+            // Vulkan's clip space has y pointing down
+            glm::mat4 projection = glm::perspective(fieldOfView, (float)extent.width / (float)extent.height, 0.1f, 100.0f);
+            projection[1][1] *= -1.0f;
+
+            glm::vec3 cameraPosition(0.0f, 6.0f, 20.0f);
+            glm::mat4 view = glm::lookAt(cameraPosition, glm::vec3(0.0f, 5.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+            glm::mat4 viewProjection = projection * view;
+
+            // projectiles that are out of view are culled as they are added
+            instanceBatcher.BeginFrame(renderer.GetFrameIndex());
+            instanceBatcher.SetCamera(viewProjection, cameraPosition);
+
+            // read once, so the view the frame samples is the one it keeps alive
+            VkImageView crateView = crateTexture->GetImageView();
+
+            if (instancedVkPipeline != VK_NULL_HANDLE && cubeLOD != LT_MODEL_NO_LOD && crateView != VK_NULL_HANDLE)
+            {
+                instanceBatcher.SetTexture(crateView);
+
+                // the pixels a world unit covers one unit from the camera, and the
+                // size of a pixel in the cube's model units per unit of distance
+                float pixelsPerDistance = (float)extent.height / (2.0f * tanf(fieldOfView * 0.5f));
+                float errorPerDistance = LT_LOD_PIXEL_ERROR / pixelsPerDistance / cubeScale;
+                uint32_t wantedLOD = LT_MODEL_NO_LOD;
+                float nearestDistance = FLT_MAX;
+
+                for (const LTProjectile& projectile : projectiles)
+                {
+                    glm::mat4 transform = glm::translate(glm::mat4(1.0f), projectile.position);
+                    transform = glm::rotate(transform, projectile.age * projectile.spinSpeed, projectile.spinAxis);
+                    transform = glm::scale(transform, glm::vec3(cubeScale));
+
+                    // the coarsest resident level that is close enough, and the level
+                    // to stream in when even the finest resident one is not
+                    float distance = glm::length(projectile.position - cameraPosition);
+                    float maxError = distance * errorPerDistance;
+                    uint32_t lod = cubeModel->SelectLOD(maxError);
+
+                    if (cubeModel->GetLOD(lod).error > maxError)
+                    {
+                        uint32_t neededLOD = cubeModel->GetLODForError(maxError);
+                        wantedLOD = neededLOD < wantedLOD ? neededLOD : wantedLOD;
+                    }
+
+                    instanceBatcher.AddInstance(instancedVkPipeline, cubeModel, lod, transform);
+                    nearestDistance = distance < nearestDistance ? distance : nearestDistance;
+                }
+
+                if (wantedLOD != LT_MODEL_NO_LOD)
+                {
+                    assetManager.RequestModelLOD(cubeLoad.GetAssetHandle(), wantedLOD);
+
+                    if (wantedLOD < requestedCubeLOD)
+                    {
+                        printf("cube: LOD %u requested \n", wantedLOD);
+                        requestedCubeLOD = wantedLOD;
+                    }
+                }
+
+                // the crate's mips are asked for by the nearest projectile's size on
+                // screen, each frame, so they are trimmed again once none is that close
+                if (nearestDistance != FLT_MAX)
+                {
+                    uint32_t wantedMip = crateTexture->GetMipForScreenSize(LT_PROJECTILE_SIZE * pixelsPerDistance / nearestDistance);
+                    assetManager.RequestTextureMip(crateLoad.GetAssetHandle(), wantedMip);
+
+                    if (wantedMip != requestedCrateMip)
+                    {
+                        printf("crate: mip %u requested \n", wantedMip);
+                        requestedCrateMip = wantedMip;
+                    }
+                }
+            }
+
+            instanceBatcher.Prepare();
+
+            // a task for the triangle and one for every projectile; a scene splits
+            // its draws into a task per range of objects so they are recorded across
+            // the cores. The pass runs when the frame's graph does, in EndFrame
+            renderer.AddScenePass("scene", 0.1f, 0.1f, 0.1f, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS,
+                [&renderer, simpleVkPipeline, &instanceBatcher, &viewProjection](VkCommandBuffer)
+            {
+                renderer.RecordParallel(2, [simpleVkPipeline, &instanceBatcher, &viewProjection](VkCommandBuffer commandBuffer, uint32_t task)
+                {
+                    if (task == 0 && simpleVkPipeline != VK_NULL_HANDLE)
+                    {
+                        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, simpleVkPipeline);
+                        vkCmdDraw(commandBuffer, 3, 1, 0, 0);
+                    }
+                    else if (task == 1)
+                    {
+                        instanceBatcher.Draw(commandBuffer, viewProjection);
+                    }
+                });
+            });
+
+            renderer.EndFrame();
+        }
+
         gameWindow.Update();
     }
 
+    assetManager.PrintQueueStats();
+    assetManager.PrintMemoryStats();
+    graphicsDevice.GetGeometryArena().PrintStats();
+    assetManager.PrintDecodeStats();
+    graphicsDevice.PrintPipelineStats();
+    pipelineManager.PrintStats();
+    renderer.PrintStats();
+    instanceBatcher.PrintStats();
+
+    // the frames in flight still use the pipelines and the instance buffers, and the
+    // workers may still be compiling with shaders the asset manager unloads
+    renderer.Destroy();
+    instanceBatcher.Destroy();
+    pipelineManager.Destroy();
+    assetManager.Destroy();
     graphicsDevice.Destroy();
     gameWindow.Destroy();
 }
\ No newline at end of file
@@ -1,6 +1,41 @@
 #pragma once
 
 #include "PrecompiledHeader.h"
+#include "LTJobQueue.h"
+#include "LTContentPak.h"
+#include "LTModelFormat.h"
+#include "LTTextureFormat.h"
+#include "LTMeshletCulling.h"
+#include "LTVKMemoryAllocator.h"
+#include "LTVKGeometryArena.h"
+
+/**
+ * The maximum number of asset jobs that can be queued at once, per priority.
+ */
+constexpr size_t LT_ASSET_JOB_QUEUE_CAPACITY = 4096;
+
+/**
+ * How a producer backs off while its job queue is full: it yields this many times,
+ * then sleeps for doubling intervals of at most LT_ASSET_QUEUE_FULL_MAX_SLEEP_US.
+ */
+constexpr uint32_t LT_ASSET_QUEUE_FULL_YIELDS = 16;
+constexpr uint32_t LT_ASSET_QUEUE_FULL_MAX_SLEEP_US = 1000;
+
+/**
+ * The number of times a queue with waiting jobs can be passed over for a higher
+ * priority queue before its next job is served regardless of priority.
+ */
+constexpr uint32_t LT_ASSET_AGING_THRESHOLD = 8;
+
+/**
+ * Deadline value meaning the load has no frame deadline.
+ */
+constexpr uint64_t LT_ASSET_NO_DEADLINE = 0;
+
+/**
+ * Budget value meaning the asset type may use unlimited memory.
+ */
+constexpr size_t LT_ASSET_UNLIMITED_BUDGET = SIZE_MAX;
 
 /**
  * Specifies the kind of asset.
@@ -11,6 +46,7 @@ enum class LTAssetType
     LT_ASSET_TYPE_SHADER = 0x1,
     LT_ASSET_TYPE_TEXTURE = 0x2,
     LT_ASSET_TYPE_MODEL = 0x3,
+    LT_ASSET_TYPE_COUNT = 0x4
 };
 
 /**
@@ -20,6 +56,8 @@ enum class LTAssetState
 {
     LT_ASSET_STATE_NOT_LOADED = 0x1,
     LT_ASSET_STATE_LOADED = 0x2,
+    LT_ASSET_STATE_LOADING = 0x3,
+    LT_ASSET_STATE_UNLOADING = 0x4,
 };
 
 /**
@@ -28,7 +66,24 @@ enum class LTAssetState
 enum class LTAssetJobType
 {
     LT_ASSET_JOB_TYPE_LOAD = 0x1,
-    LT_ASSET_JOB_TYPE_UNLOAD = 0x2
+    LT_ASSET_JOB_TYPE_UNLOAD = 0x2,
+
+    /**
+     * Loads the next finer level of detail of an asset that is already loaded.
+     */
+    LT_ASSET_JOB_TYPE_STREAM = 0x3
+};
+
+/**
+ * Specifies how urgently an asset job should be scheduled; lower values are served first.
+ */
+enum class LTAssetPriority
+{
+    LT_ASSET_PRIORITY_CRITICAL = 0x0,
+    LT_ASSET_PRIORITY_HIGH = 0x1,
+    LT_ASSET_PRIORITY_NORMAL = 0x2,
+    LT_ASSET_PRIORITY_BACKGROUND = 0x3,
+    LT_ASSET_PRIORITY_COUNT = 0x4
 };
 
 /**
@@ -41,11 +96,50 @@ enum class LTAssetJobResult
     LT_ASSET_JOB_RESULT_FAILURE = 0x2
 };
 
+/**
+ * Specifies which thread a load completion callback runs on.
+ */
+enum class LTAssetCallbackThread
+{
+    /**
+     * Runs on the worker that finished the load, as soon as it finishes.
+     */
+    LT_ASSET_CALLBACK_THREAD_WORKER = 0x1,
+
+    /**
+     * Runs on the main thread the next time it calls DispatchMainThreadCallbacks.
+     */
+    LT_ASSET_CALLBACK_THREAD_MAIN = 0x2
+};
+
+/**
+ * An amount of CPU and GPU memory; used for both asset budgets and usage.
+ */
+struct LTAssetMemory
+{
+    size_t cpuBytes = 0;
+    size_t gpuBytes = 0;
+};
+
 /**
  * The ID used to uniquely identify assets.
  */
 using LTAssetID = uint32_t;
 
+/**
+ * Called when a load completes, with the asset and whether it loaded.
+ */
+using LTAssetCallback = std::function<void(class LTAssetHandle&, LTAssetJobResult)>;
+
+/**
+ * A callback waiting on an asset load, and the thread it should run on.
+ */
+struct LTAssetContinuation
+{
+    LTAssetCallback callback;
+    LTAssetCallbackThread thread;
+};
+
 /**
  * LTAsset is meant to be inherited (e.g. LTTexture, LTModel, LTShader, LTAudio, etc.)
  * The base class for all assets in the game.
@@ -93,6 +187,56 @@ private:
      */
     LTAsset* m_LRUPrev;
 
+    /**
+     * True while the asset is linked into the LRU.
+     * m_LRUNext, m_LRUPrev and this are guarded by the asset manager's residency mutex.
+     */
+    bool m_IsInLRU;
+
+    /**
+     * The CPU memory held by the loaded asset, in bytes.
+     * Atomic because streaming grows it while the asset is loaded and readable.
+     */
+    std::atomic<size_t> m_CpuBytes;
+
+    /**
+     * The GPU memory held by the loaded asset, in bytes.
+     */
+    std::atomic<size_t> m_GpuBytes;
+
+    /**
+     * Set when a load is requested while the asset is being unloaded; the unload
+     * then re-queues the load at m_ReloadPriority instead of leaving the asset unloaded.
+     * Guarded by the asset manager's continuation mutex.
+     */
+    bool m_ReloadRequested;
+
+    /**
+     * The priority of the requested reload.
+     */
+    LTAssetPriority m_ReloadPriority;
+
+    /**
+     * The priority and deadline the in-flight load is queued with, and whether a
+     * worker has taken it. A more urgent request queues the load again until then.
+     * Guarded by the asset manager's continuation mutex.
+     */
+    LTAssetPriority m_LoadPriority;
+    uint64_t m_LoadDeadline;
+    bool m_IsLoadClaimed;
+
+    /**
+     * Incremented every time a load of this asset completes, successfully or not.
+     * Completion tokens compare against it to know when their load is done.
+     */
+    std::atomic<uint32_t> m_LoadGeneration;
+
+    /**
+     * Callbacks waiting for the in-flight load to complete.
+     * Guarded by the asset manager's continuation mutex.
+     */
+    eastl::vector<LTAssetContinuation> m_Continuations;
+
     /**
      * Constructors
      */
@@ -104,7 +248,16 @@ public:
         m_FileName(""),
         m_RefCount(0),
         m_LRUNext(nullptr),
-        m_LRUPrev(nullptr) {}
+        m_LRUPrev(nullptr),
+        m_IsInLRU(false),
+        m_CpuBytes(0),
+        m_GpuBytes(0),
+        m_ReloadRequested(false),
+        m_ReloadPriority(LTAssetPriority::LT_ASSET_PRIORITY_NORMAL),
+        m_LoadPriority(LTAssetPriority::LT_ASSET_PRIORITY_NORMAL),
+        m_LoadDeadline(LT_ASSET_NO_DEADLINE),
+        m_IsLoadClaimed(false),
+        m_LoadGeneration(0) {}
 
     LTAsset(LTAssetID assetID, LTAssetType assetType) :
         m_AssetID(assetID),
@@ -113,7 +266,16 @@ public:
         m_FileName(""),
         m_RefCount(0),
         m_LRUNext(nullptr),
-        m_LRUPrev(nullptr) {}
+        m_LRUPrev(nullptr),
+        m_IsInLRU(false),
+        m_CpuBytes(0),
+        m_GpuBytes(0),
+        m_ReloadRequested(false),
+        m_ReloadPriority(LTAssetPriority::LT_ASSET_PRIORITY_NORMAL),
+        m_LoadPriority(LTAssetPriority::LT_ASSET_PRIORITY_NORMAL),
+        m_LoadDeadline(LT_ASSET_NO_DEADLINE),
+        m_IsLoadClaimed(false),
+        m_LoadGeneration(0) {}
 
     LTAsset(LTAssetID assetID, LTAssetType assetType, const std::string& fileName) :
         m_AssetID(assetID),
@@ -122,7 +284,16 @@ public:
         m_FileName(fileName),
         m_RefCount(0),
         m_LRUNext(nullptr),
-        m_LRUPrev(nullptr) {}
+        m_LRUPrev(nullptr),
+        m_IsInLRU(false),
+        m_CpuBytes(0),
+        m_GpuBytes(0),
+        m_ReloadRequested(false),
+        m_ReloadPriority(LTAssetPriority::LT_ASSET_PRIORITY_NORMAL),
+        m_LoadPriority(LTAssetPriority::LT_ASSET_PRIORITY_NORMAL),
+        m_LoadDeadline(LT_ASSET_NO_DEADLINE),
+        m_IsLoadClaimed(false),
+        m_LoadGeneration(0) {}
 
     virtual ~LTAsset()
     {
@@ -146,6 +317,21 @@ private:
         m_AssetState = state;
     }
 
+    /**
+     * Atomically moves the asset from NOT_LOADED to LOADING.
+     * Returns false if the asset is already loading or loaded, in which case
+     * the caller must not queue another load.
+     */
+    inline bool TryBeginLoad()
+    {
+        LTAssetState expected = LTAssetState::LT_ASSET_STATE_NOT_LOADED;
+
+        return m_AssetState.compare_exchange_strong(
+            expected,
+            LTAssetState::LT_ASSET_STATE_LOADING,
+            std::memory_order_acq_rel);
+    }
+
     /**
      * Public Methods
      */
@@ -182,6 +368,22 @@ public:
         return m_AssetType;
     }
 
+    /**
+     * Determines if a load for the asset has been queued but not finished.
+     */
+    inline const bool IsLoading() const
+    {
+        return m_AssetState == LTAssetState::LT_ASSET_STATE_LOADING;
+    }
+
+    /**
+     * Determines if the asset has been chosen for eviction and is being unloaded.
+     */
+    inline const bool IsUnloading() const
+    {
+        return m_AssetState == LTAssetState::LT_ASSET_STATE_UNLOADING;
+    }
+
     /**
      * Determines if asset is valid (loaded).
      */
@@ -190,12 +392,28 @@ public:
         return m_AssetState == LTAssetState::LT_ASSET_STATE_LOADED;
     }
 
+    /**
+     * Gets the CPU memory held by the loaded asset, in bytes.
+     */
+    inline const size_t GetCpuBytes() const
+    {
+        return m_CpuBytes.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Gets the GPU memory held by the loaded asset, in bytes.
+     */
+    inline const size_t GetGpuBytes() const
+    {
+        return m_GpuBytes.load(std::memory_order_relaxed);
+    }
+
     /**
      * Atomically gets the ref count.
      */
     inline const uint32_t GetRefCount() const
     {
-        return m_RefCount.load(std::memory_order::memory_order_acquire);
+        return m_RefCount.load(std::memory_order_acquire);
     }
 
     /**
@@ -207,6 +425,11 @@ public:
      * The LTAssetHandle needs direct access to private reference count data on this class.
      */
     friend class LTAssetHandle;
+
+    /**
+     * The LTAssetLoadToken needs direct access to the load generation on this class.
+     */
+    friend class LTAssetLoadToken;
 };
 
 /**
@@ -249,7 +472,7 @@ public:
         if (asset)
         {
             // atomic increment the ref count
-            asset->m_RefCount.fetch_add(1, std::memory_order::memory_order_release);
+            asset->m_RefCount.fetch_add(1, std::memory_order_release);
         }
 
         m_Asset = asset;
@@ -261,7 +484,7 @@ public:
         if (m_Asset)
         {
             // atomic increment the reference count
-            m_Asset->m_RefCount.fetch_add(1, std::memory_order::memory_order_release);
+            m_Asset->m_RefCount.fetch_add(1, std::memory_order_release);
         }
     }
 
@@ -280,8 +503,7 @@ public:
 
         if (m_Asset)
         {
-            // atomic decrement the reference count
-            m_Asset->m_RefCount.fetch_sub(1, std::memory_order::memory_order_release);
+            Release();
         }
 
         m_Asset = other.m_Asset;
@@ -289,7 +511,7 @@ public:
         if (m_Asset)
         {
             // atomic increment the ref count
-            m_Asset->m_RefCount.fetch_add(1, std::memory_order::memory_order_release);
+            m_Asset->m_RefCount.fetch_add(1, std::memory_order_release);
         }
 
         return *this;
@@ -299,8 +521,7 @@ public:
     {
         if (m_Asset)
         {
-            // atomic decrement the reference count
-            m_Asset->m_RefCount.fetch_sub(1, std::memory_order::memory_order_release);
+            Release();
         }
 
         m_Asset = other.m_Asset;
@@ -313,14 +534,31 @@ public:
     {
         if (m_Asset)
         {
-            // atomic decrement the reference count
-            m_Asset->m_RefCount.fetch_sub(1, std::memory_order::memory_order_release);
+            Release();
         }
     }
 
     /**
      * Methods
      */
+private:
+    /**
+     * Atomically decrements the reference count, handing the asset to the
+     * asset manager's LRU when the last reference goes away.
+     */
+    inline void Release()
+    {
+        if (m_Asset->m_RefCount.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            OnLastReferenceReleased(m_Asset);
+        }
+    }
+
+    /**
+     * Makes an unreferenced asset a candidate for eviction.
+     */
+    static void OnLastReferenceReleased(LTAsset* asset);
+
 public:
     /**
      * Get the asset wrapped by this handle.
@@ -332,250 +570,1225 @@ public:
 };
 
 /**
- * Asset type for shaders (spv/glsl)
+ * A lightweight completion token for an asset load, returned by LTAssetManager::Load.
+ * The token holds a handle to the asset, so the asset stays referenced while anyone waits on it.
+ *
+ * Completion can be observed by:
+ * - polling IsComplete()
+ * - blocking on Wait() with a timeout
+ * - registering a continuation with Then(), on a worker or the main thread
+ * - co_await on the token (only when compiled as C++20)
  */
-class LTShader : public LTAsset
+class LTAssetLoadToken
 {
     /**
      * Fields
      */
 private:
+    /**
+     * The asset being loaded.
+     */
+    LTAssetHandle m_AssetHandle;
 
     /**
-     * Vulkan internal shader module.
+     * The asset's load generation at which this token's load is complete.
      */
-    VkShaderModule m_ShaderModule;
+    uint32_t m_CompleteGeneration;
 
     /**
      * Constructors
      */
 public:
-    LTShader() :
-        m_ShaderModule()
-    {
-    }
+    LTAssetLoadToken() :
+        m_AssetHandle(),
+        m_CompleteGeneration(0) {}
 
-    LTShader(LTAssetID assetID, LTAssetType assetType) :
-        LTAsset(assetID, LTAssetType::LT_ASSET_TYPE_SHADER),
-        m_ShaderModule()
-    {
-    }
+    LTAssetLoadToken(const LTAssetHandle& assetHandle, uint32_t completeGeneration) :
+        m_AssetHandle(assetHandle),
+        m_CompleteGeneration(completeGeneration) {}
 
-    LTShader(LTAssetID assetID, const std::string& fileName) :
-        LTAsset(assetID, LTAssetType::LT_ASSET_TYPE_SHADER, fileName),
-        m_ShaderModule()
+    /**
+     * Methods
+     */
+public:
+    /**
+     * Gets the handle of the asset being loaded.
+     */
+    inline const LTAssetHandle& GetAssetHandle() const
     {
+        return m_AssetHandle;
     }
 
-    ~LTShader()
+    /**
+     * Determines if the load has finished, whether or not it succeeded.
+     */
+    inline bool IsComplete() const
     {
+        if (!m_AssetHandle.GetAsset())
+        {
+            return false;
+        }
+
+        uint32_t generation = m_AssetHandle.GetAsset()->m_LoadGeneration.load(std::memory_order_acquire);
+
+        // wrap-safe generation >= m_CompleteGeneration
+        return (int32_t)(generation - m_CompleteGeneration) >= 0;
     }
 
     /**
-     * Methods
+     * Gets the result of the load; NONE while it is still in flight.
      */
-public:
+    LTAssetJobResult GetResult() const;
 
     /**
-     * Gets the Vulkan shader module.
+     * Blocks until the load completes or the timeout elapses.
+     * Returns true if the load completed.
      */
-    VkShaderModule& GetShaderModule();
-};
+    bool Wait(std::chrono::milliseconds timeout) const;
 
-/**
- * Asset type for models (fbx, obj).
- */
-class LTModel : public LTAsset
-{
     /**
-     * Fields
+     * Runs 'callback' on the chosen thread once the load completes. If the load has
+     * already completed, worker callbacks run immediately on the calling thread and
+     * main thread callbacks are queued for the next dispatch.
      */
-private:
+    void Then(
+        LTAssetCallback callback,
+        LTAssetCallbackThread thread = LTAssetCallbackThread::LT_ASSET_CALLBACK_THREAD_MAIN) const;
 
+#if defined(__cpp_impl_coroutine)
     /**
-     * Constructors
+     * Awaits the load, resuming on the worker that finished it.
      */
-public:
-    LTModel()
-    {
-    }
+    struct LTAssetLoadAwaiter operator co_await() const;
 
-    LTModel(LTAssetID assetID) :
-        LTAsset(assetID, LTAssetType::LT_ASSET_TYPE_MODEL)
+    /**
+     * Awaits the load, resuming on the chosen thread (e.g. co_await token.ResumeOn(MAIN)).
+     */
+    struct LTAssetLoadAwaiter ResumeOn(LTAssetCallbackThread thread) const;
+#endif
+};
+
+#if defined(__cpp_impl_coroutine)
+/**
+ * The awaiter used by co_await on an LTAssetLoadToken; resumes the coroutine on
+ * the chosen thread and yields the asset handle.
+ */
+struct LTAssetLoadAwaiter
+{
+    LTAssetLoadToken token;
+    LTAssetCallbackThread thread;
+
+    bool await_ready() const
     {
+        return token.IsComplete();
     }
 
-    LTModel(LTAssetID assetID, const std::string& fileName) :
-        LTAsset(assetID, LTAssetType::LT_ASSET_TYPE_MODEL, fileName)
+    void await_suspend(std::coroutine_handle<> coroutine) const
     {
+        token.Then([coroutine](LTAssetHandle&, LTAssetJobResult)
+        {
+            coroutine.resume();
+        }, thread);
     }
 
-    ~LTModel()
+    LTAssetHandle await_resume() const
     {
+        return token.GetAssetHandle();
     }
-
-    /**
-     * Methods
-     */
-private:
-public:
 };
 
+inline LTAssetLoadAwaiter LTAssetLoadToken::operator co_await() const
+{
+    return LTAssetLoadAwaiter{ *this, LTAssetCallbackThread::LT_ASSET_CALLBACK_THREAD_WORKER };
+}
+
+inline LTAssetLoadAwaiter LTAssetLoadToken::ResumeOn(LTAssetCallbackThread thread) const
+{
+    return LTAssetLoadAwaiter{ *this, thread };
+}
+#endif
+
 /**
- * Asset type for textures (png, tga, bmp, etc.).
+ * Asset type for shaders (spv/glsl)
  */
-class LTTexture : public LTAsset
+class LTShader : public LTAsset
 {
     /**
      * Fields
      */
 private:
 
+    /**
+     * Vulkan internal shader module.
+     */
+    VkShaderModule m_ShaderModule;
+
     /**
      * Constructors
      */
 public:
-    LTTexture()
+    LTShader() :
+        m_ShaderModule()
     {
     }
 
-    LTTexture(LTAssetID assetID) :
-        LTAsset(assetID, LTAssetType::LT_ASSET_TYPE_MODEL)
+    LTShader(LTAssetID assetID, LTAssetType assetType) :
+        LTAsset(assetID, LTAssetType::LT_ASSET_TYPE_SHADER),
+        m_ShaderModule()
     {
     }
 
-    LTTexture(LTAssetID assetID, const std::string& fileName) :
-        LTAsset(assetID, LTAssetType::LT_ASSET_TYPE_MODEL, fileName)
+    LTShader(LTAssetID assetID, const std::string& fileName) :
+        LTAsset(assetID, LTAssetType::LT_ASSET_TYPE_SHADER, fileName),
+        m_ShaderModule()
     {
     }
 
-    ~LTTexture()
+    ~LTShader()
     {
     }
 
     /**
      * Methods
      */
-private:
 public:
+
+    /**
+     * Gets the Vulkan shader module.
+     */
+    VkShaderModule& GetShaderModule();
 };
 
 /**
- * Data for an asset job.
+ * Level of detail value meaning no level of the model is resident.
  */
-struct LTAssetJob
+constexpr uint32_t LT_MODEL_NO_LOD = UINT32_MAX;
+
+/**
+ * One level of detail of a model, in the device's geometry arena.
+ */
+struct LTModelMesh
 {
     /**
-     * Fields
+     * The range of the arena's vertex buffer holding the baked, interleaved
+     * vertices, and the first of them, the vertex offset of the level's draws.
      */
-
-     /**
-      * The asset that this job is operating on.
-      */
-    LTAssetHandle assetHandle;
+    LTVKGeometryRange vertexRange;
+    int32_t firstVertex = 0;
 
     /**
-     * The type of job being performed.
+     * The range of the arena's index buffer holding the indices, which are relative
+     * to the level's first vertex, and the first of them.
      */
-    LTAssetJobType jobType;
+    LTVKGeometryRange indexRange;
+    uint32_t firstIndex = 0;
 
     /**
-     * The result of the job when it has terminated.
+     * The number of vertices and indices in the ranges.
      */
-    LTAssetJobResult result;
+    uint32_t vertexCount = 0;
+    uint32_t indexCount = 0;
 
+    /**
+     * The farthest any vertex moved when the level was simplified, in model units.
+     */
+    float error = 0.0f;
 
     /**
-     * Constructors
+     * The meshlets the indices are split into, for culling on the CPU.
      */
-    LTAssetJob(LTAssetHandle assetHandle, LTAssetJobType type) :
-        assetHandle(assetHandle),
-        jobType(type),
-        result(LTAssetJobResult::LT_ASSET_JOB_RESULT_NONE)
-    {
-    }
+    LTModelMeshlets meshlets;
 };
 
 /**
- * The manager of all assets in the game. Responsible for loading and unloading assets.
+ * Asset type for models (fbx, obj).
+ *
+ * A model is loaded as soon as its coarsest level of detail is resident; the finer
+ * levels are streamed in when asked for with LTAssetManager::RequestModelLOD, one at
+ * a time, and become visible through GetResidentLOD() without the loaded model
+ * ever going away.
  */
-class LTAssetManager
+class LTModel : public LTAsset
 {
     /**
      * Fields
      */
 private:
+
     /**
-     * List of all assets in game -- these may or may not be loaded.
+     * The levels of detail, LOD 0 being the full mesh.
      */
-    eastl::vector<LTAsset*> m_Assets;
+    LTModelMesh m_LODs[LT_MODEL_MAX_LODS];
 
     /**
-     * The thread used to process asset jobs.
+     * Where each level of detail is stored in the model's payload, kept so the finer
+     * levels can be streamed in after the load.
      */
-    std::thread* m_ContentThread;
+    LTModelLOD m_LODSections[LT_MODEL_MAX_LODS];
 
     /**
-     * The queue of all asset jobs to be processed.
+     * The number of levels of detail.
      */
-    eastl::queue<LTAssetJob> m_AssetJobs;
+    uint32_t m_LODCount;
 
     /**
-     * The mutex for controlling access to the asset jobs queue.
+     * The finest level of detail whose buffers are ready, or LT_MODEL_NO_LOD.
+     * Written by the worker that streams a level in, once its upload has finished.
      */
-    std::mutex m_AssetMutex;
+    std::atomic<uint32_t> m_ResidentLOD;
 
     /**
-     * The wrapper around the Vulkan graphics device.
+     * The finest level of detail asked for, or LT_MODEL_NO_LOD, and whether a level
+     * is streaming in towards it.
      */
-    class LTVKDevice* m_LTVKDevice;
+    std::atomic<uint32_t> m_RequestedLOD;
+    std::atomic<bool> m_IsStreaming;
 
     /**
-     * Constructors
+     * The index type of every index buffer; 16-bit when every vertex fits.
      */
-private:
-    LTAssetManager() :
-        m_ContentThread(nullptr),
-        m_LTVKDevice(nullptr)
-    {
-    }
+    VkIndexType m_IndexType;
 
     /**
-     * Methods
+     * The layout of the vertices in the vertex buffers.
      */
-private:
+    LTModelVertexFormat m_VertexFormat;
 
     /**
-     * Loads the asset.
+     * Decodes the stored vertex positions into model space.
      */
-    bool LoadAsset(LTAssetJob& assetJob);
+    LTModelVertexDecode m_VertexDecode;
 
     /**
-     * Loads the asset file from disk.
+     * The axis-aligned bounds of the model, in model space.
      */
-    bool LoadAsset_File(
-        const std::string& fileName,
-        std::ifstream& file,
-        uint8_t*& outBuffer,
-        size_t& outSize);
+    float m_BoundsMin[3];
+    float m_BoundsMax[3];
 
     /**
-     * Loads the asset according to its type.
+     * Constructors
      */
-    bool LoadAsset_ByType(
+public:
+    LTModel() :
+        m_LODSections(),
+        m_LODCount(0),
+        m_ResidentLOD(LT_MODEL_NO_LOD),
+        m_RequestedLOD(LT_MODEL_NO_LOD),
+        m_IsStreaming(false),
+        m_IndexType(VK_INDEX_TYPE_UINT16),
+        m_VertexFormat(LTModelVertexFormat::LT_MODEL_VERTEX_FORMAT_FLOAT),
+        m_VertexDecode(),
+        m_BoundsMin(),
+        m_BoundsMax()
+    {
+    }
+
+    LTModel(LTAssetID assetID) :
+        LTAsset(assetID, LTAssetType::LT_ASSET_TYPE_MODEL),
+        m_LODSections(),
+        m_LODCount(0),
+        m_ResidentLOD(LT_MODEL_NO_LOD),
+        m_RequestedLOD(LT_MODEL_NO_LOD),
+        m_IsStreaming(false),
+        m_IndexType(VK_INDEX_TYPE_UINT16),
+        m_VertexFormat(LTModelVertexFormat::LT_MODEL_VERTEX_FORMAT_FLOAT),
+        m_VertexDecode(),
+        m_BoundsMin(),
+        m_BoundsMax()
+    {
+    }
+
+    LTModel(LTAssetID assetID, const std::string& fileName) :
+        LTAsset(assetID, LTAssetType::LT_ASSET_TYPE_MODEL, fileName),
+        m_LODSections(),
+        m_LODCount(0),
+        m_ResidentLOD(LT_MODEL_NO_LOD),
+        m_RequestedLOD(LT_MODEL_NO_LOD),
+        m_IsStreaming(false),
+        m_IndexType(VK_INDEX_TYPE_UINT16),
+        m_VertexFormat(LTModelVertexFormat::LT_MODEL_VERTEX_FORMAT_FLOAT),
+        m_VertexDecode(),
+        m_BoundsMin(),
+        m_BoundsMax()
+    {
+    }
+
+    ~LTModel()
+    {
+    }
+
+    /**
+     * Methods
+     */
+public:
+
+    /**
+     * Gets the number of levels of detail.
+     */
+    inline uint32_t GetLODCount() const
+    {
+        return m_LODCount;
+    }
+
+    /**
+     * Gets the finest level of detail that can be drawn; every coarser level can be
+     * drawn too. LT_MODEL_NO_LOD until the model has loaded. Read it once per frame
+     * and use that level throughout, as a finer one may arrive at any time.
+     */
+    inline uint32_t GetResidentLOD() const
+    {
+        return m_ResidentLOD.load(std::memory_order_acquire);
+    }
+
+    /**
+     * Determines if every level of detail has been streamed in.
+     */
+    inline bool IsFullyResident() const
+    {
+        return GetResidentLOD() == 0;
+    }
+
+    /**
+     * Gets the coarsest resident level of detail whose error is at most 'maxError'
+     * model units, or the finest resident level if none is that accurate.
+     * LT_MODEL_NO_LOD until the model has loaded.
+     */
+    inline uint32_t SelectLOD(float maxError) const
+    {
+        uint32_t lod = GetResidentLOD();
+
+        if (lod == LT_MODEL_NO_LOD)
+        {
+            return LT_MODEL_NO_LOD;
+        }
+
+        while (lod + 1 < m_LODCount && m_LODs[lod + 1].error <= maxError)
+        {
+            ++lod;
+        }
+
+        return lod;
+    }
+
+    /**
+     * Gets the coarsest level of detail whose error is at most 'maxError' model
+     * units, resident or not; the one to ask for when SelectLOD's is too coarse.
+     */
+    inline uint32_t GetLODForError(float maxError) const
+    {
+        uint32_t lod = 0;
+
+        while (lod + 1 < m_LODCount && m_LODs[lod + 1].error <= maxError)
+        {
+            ++lod;
+        }
+
+        return lod;
+    }
+
+    /**
+     * Gets a level of detail. Only levels at or coarser than GetResidentLOD() have
+     * buffers. Draw the ranges LTMeshletCulling::CullMeshlets returns for its
+     * meshlets instead of its whole index buffer.
+     */
+    inline const LTModelMesh& GetLOD(uint32_t lod) const
+    {
+        assert(lod < m_LODCount);
+        return m_LODs[lod];
+    }
+
+    /**
+     * Gets the index type to bind the index buffers with.
+     */
+    inline VkIndexType GetIndexType() const
+    {
+        return m_IndexType;
+    }
+
+    /**
+     * Gets the layout of the vertices in the vertex buffers.
+     */
+    inline LTModelVertexFormat GetVertexFormat() const
+    {
+        return m_VertexFormat;
+    }
+
+    /**
+     * Gets the parameters that decode the stored vertex positions; shaders take
+     * them as push constants.
+     */
+    inline const LTModelVertexDecode& GetVertexDecode() const
+    {
+        return m_VertexDecode;
+    }
+
+    /**
+     * Gets the minimum corner of the model's bounds.
+     */
+    inline const float* GetBoundsMin() const
+    {
+        return m_BoundsMin;
+    }
+
+    /**
+     * Gets the maximum corner of the model's bounds.
+     */
+    inline const float* GetBoundsMax() const
+    {
+        return m_BoundsMax;
+    }
+
+    /**
+     * Asset manager creates and destroys the buffers.
+     */
+    friend class LTAssetManager;
+};
+
+/**
+ * Mip value meaning no mip level of the texture is resident.
+ */
+constexpr uint32_t LT_TEXTURE_NO_MIP = UINT32_MAX;
+
+/**
+ * Mip levels no larger than this on their longest side are loaded with the
+ * texture; the larger ones are streamed in when the renderer asks for them.
+ */
+constexpr uint32_t LT_TEXTURE_TAIL_SIZE = 64;
+
+/**
+ * The number of frames a mip request holds for. A texture that has not been asked
+ * for a level in that long only needs its tail, and its larger mips are the first
+ * to go when textures are over their memory budget.
+ */
+constexpr uint64_t LT_TEXTURE_REQUEST_FRAMES = 120;
+
+/**
+ * Asset type for textures (png). Textures are baked into block-compressed mip
+ * chains by the content build and loaded into a sampled, device-local image.
+ *
+ * Only the mip tail (see LT_TEXTURE_TAIL_SIZE) is loaded with the texture. The
+ * renderer reports the finest level it needs through
+ * LTAssetManager::RequestTextureMip, which streams it in by replacing the image
+ * with one holding every level from the requested one down. Under memory pressure
+ * the image is replaced with a smaller one again.
+ */
+class LTTexture : public LTAsset
+{
+    /**
+     * Fields
+     */
+private:
+
+    /**
+     * Device-local image holding the resident mip levels, and its memory. Only the
+     * worker streaming the texture touches them.
+     */
+    VkImage m_Image;
+    LTVKAllocation m_ImageAllocation;
+
+    /**
+     * View of every resident mip level, for sampling. Replaced whenever a stream
+     * replaces the image.
+     */
+    std::atomic<VkImageView> m_ImageView;
+
+    /**
+     * The block-compressed format of the image, sRGB or not.
+     */
+    VkFormat m_Format;
+
+    /**
+     * The size of mip 0 in texels, and the number of mip levels in the baked texture.
+     */
+    uint32_t m_Width;
+    uint32_t m_Height;
+    uint32_t m_MipCount;
+
+    /**
+     * Where each mip level is stored in the texture's payload, kept so levels can
+     * be streamed in after the load.
+     */
+    LTTextureMip m_MipSections[LT_TEXTURE_MAX_MIPS];
+
+    /**
+     * The largest mip level loaded with the texture.
+     */
+    uint32_t m_TailMip;
+
+    /**
+     * The largest mip level in the image (its mip 0), or LT_TEXTURE_NO_MIP.
+     */
+    std::atomic<uint32_t> m_ResidentMip;
+
+    /**
+     * The finest mip level requested in the latest frame it was requested, packed
+     * as ((frame + 1) << 8) | mip so it is updated as one; 0 until requested.
+     */
+    std::atomic<uint64_t> m_MipRequest;
+
+    /**
+     * True while a stream job for the texture is queued or running; there is at
+     * most one at a time.
+     */
+    std::atomic<bool> m_IsStreaming;
+
+    /**
+     * Constructors
+     */
+public:
+    LTTexture() :
+        m_Image(VK_NULL_HANDLE),
+        m_ImageAllocation(),
+        m_ImageView(VK_NULL_HANDLE),
+        m_Format(VK_FORMAT_UNDEFINED),
+        m_Width(0),
+        m_Height(0),
+        m_MipCount(0),
+        m_MipSections(),
+        m_TailMip(0),
+        m_ResidentMip(LT_TEXTURE_NO_MIP),
+        m_MipRequest(0),
+        m_IsStreaming(false)
+    {
+    }
+
+    LTTexture(LTAssetID assetID) :
+        LTAsset(assetID, LTAssetType::LT_ASSET_TYPE_TEXTURE),
+        m_Image(VK_NULL_HANDLE),
+        m_ImageAllocation(),
+        m_ImageView(VK_NULL_HANDLE),
+        m_Format(VK_FORMAT_UNDEFINED),
+        m_Width(0),
+        m_Height(0),
+        m_MipCount(0),
+        m_MipSections(),
+        m_TailMip(0),
+        m_ResidentMip(LT_TEXTURE_NO_MIP),
+        m_MipRequest(0),
+        m_IsStreaming(false)
+    {
+    }
+
+    LTTexture(LTAssetID assetID, const std::string& fileName) :
+        LTAsset(assetID, LTAssetType::LT_ASSET_TYPE_TEXTURE, fileName),
+        m_Image(VK_NULL_HANDLE),
+        m_ImageAllocation(),
+        m_ImageView(VK_NULL_HANDLE),
+        m_Format(VK_FORMAT_UNDEFINED),
+        m_Width(0),
+        m_Height(0),
+        m_MipCount(0),
+        m_MipSections(),
+        m_TailMip(0),
+        m_ResidentMip(LT_TEXTURE_NO_MIP),
+        m_MipRequest(0),
+        m_IsStreaming(false)
+    {
+    }
+
+    ~LTTexture()
+    {
+    }
+
+    /**
+     * Methods
+     */
+private:
+
+    /**
+     * Gets the largest mip level the texture needs: the one requested within the
+     * last LT_TEXTURE_REQUEST_FRAMES frames, or the tail. Also gets when it was
+     * last requested, as the frame plus one, or 0 if never.
+     */
+    uint32_t GetWantedMip(uint64_t currentFrame, uint64_t& outRequestFrame) const
+    {
+        uint64_t request = m_MipRequest.load(std::memory_order_relaxed);
+        outRequestFrame = request >> 8;
+
+        if (request == 0 || currentFrame + 1 - outRequestFrame > LT_TEXTURE_REQUEST_FRAMES)
+        {
+            return m_TailMip;
+        }
+
+        uint32_t mip = (uint32_t)(request & 0xFF);
+        return mip < m_TailMip ? mip : m_TailMip;
+    }
+
+public:
+
+    /**
+     * Gets the view of every resident mip level. Read it once per frame; a stream
+     * may replace it at any time, and the view it replaces stays valid until the
+     * frames recorded with it have completed.
+     */
+    inline VkImageView GetImageView() const
+    {
+        return m_ImageView.load(std::memory_order_acquire);
+    }
+
+    /**
+     * Gets the largest resident mip level, which is mip 0 of the image view, or
+     * LT_TEXTURE_NO_MIP until the texture has loaded.
+     */
+    inline uint32_t GetResidentMip() const
+    {
+        return m_ResidentMip.load(std::memory_order_acquire);
+    }
+
+    /**
+     * Gets the format of the image.
+     */
+    inline VkFormat GetFormat() const
+    {
+        return m_Format;
+    }
+
+    /**
+     * Gets the size of mip 0 of the baked texture in texels, resident or not.
+     */
+    inline uint32_t GetWidth() const
+    {
+        return m_Width;
+    }
+
+    inline uint32_t GetHeight() const
+    {
+        return m_Height;
+    }
+
+    /**
+     * Gets the number of mip levels in the baked texture, resident or not.
+     */
+    inline uint32_t GetMipCount() const
+    {
+        return m_MipCount;
+    }
+
+    /**
+     * Gets the smallest mip level still at least 'screenSize' texels across its
+     * longest side, the one to request for a texture drawn that many pixels across.
+     * Call once the texture has loaded.
+     */
+    inline uint32_t GetMipForScreenSize(float screenSize) const
+    {
+        uint32_t size = m_Width > m_Height ? m_Width : m_Height;
+        uint32_t mip = 0;
+
+        while (mip + 1 < m_MipCount && (float)(size >> (mip + 1)) >= screenSize)
+        {
+            ++mip;
+        }
+
+        return mip;
+    }
+
+    /**
+     * Asset manager creates, replaces and destroys the image.
+     */
+    friend class LTAssetManager;
+};
+
+/**
+ * Data for an asset job.
+ */
+struct LTAssetJob
+{
+    /**
+     * Fields
+     */
+
+     /**
+      * The asset that this job is operating on.
+      */
+    LTAssetHandle assetHandle;
+
+    /**
+     * The type of job being performed.
+     */
+    LTAssetJobType jobType;
+
+    /**
+     * The result of the job when it has terminated.
+     */
+    LTAssetJobResult result;
+
+    /**
+     * The priority queue the job was scheduled in.
+     */
+    LTAssetPriority priority;
+
+    /**
+     * The frame by which the job should be complete, or LT_ASSET_NO_DEADLINE.
+     */
+    uint64_t deadlineFrame;
+
+    /**
+     * For load jobs, the load generation the job was queued for. A load promoted
+     * by a more urgent request is queued more than once; only the first copy a
+     * worker takes runs.
+     */
+    uint32_t loadGeneration;
+
+    /**
+     * The time the job was pushed onto its queue; used to measure queue wait.
+     */
+    std::chrono::steady_clock::time_point queuedTime;
+
+    /**
+     * For stream jobs, the level of detail to stream in. Model loads and streams
+     * that succeed set it to the level now resident; while that is above 0 the
+     * next finer level is queued to stream. For textures it is the mip level to
+     * make the largest resident one, finer or coarser than the current one.
+     */
+    uint32_t streamLevel;
+
+    /**
+     * The memory a successful stream job added to the asset, and the memory it
+     * released; a texture stream replaces the image it had.
+     */
+    LTAssetMemory streamedMemory;
+    LTAssetMemory releasedMemory;
+
+    /**
+     * Constructors
+     */
+    LTAssetJob() :
+        assetHandle(),
+        jobType(LTAssetJobType::LT_ASSET_JOB_TYPE_LOAD),
+        result(LTAssetJobResult::LT_ASSET_JOB_RESULT_NONE),
+        priority(LTAssetPriority::LT_ASSET_PRIORITY_NORMAL),
+        deadlineFrame(LT_ASSET_NO_DEADLINE),
+        loadGeneration(0),
+        queuedTime(),
+        streamLevel(0),
+        streamedMemory(),
+        releasedMemory()
+    {
+    }
+
+    LTAssetJob(
+        LTAssetHandle assetHandle,
+        LTAssetJobType type,
+        LTAssetPriority priority = LTAssetPriority::LT_ASSET_PRIORITY_NORMAL,
+        uint64_t deadlineFrame = LT_ASSET_NO_DEADLINE) :
+        assetHandle(assetHandle),
+        jobType(type),
+        result(LTAssetJobResult::LT_ASSET_JOB_RESULT_NONE),
+        priority(priority),
+        deadlineFrame(deadlineFrame),
+        loadGeneration(0),
+        queuedTime(),
+        streamLevel(0),
+        streamedMemory(),
+        releasedMemory()
+    {
+    }
+};
+
+/**
+ * Queue-wait measurements for a single asset priority.
+ */
+struct LTAssetQueueStats
+{
+    /**
+     * The number of jobs that have been taken off the queue.
+     */
+    uint64_t jobCount = 0;
+
+    /**
+     * The summed time those jobs spent waiting in the queue, in nanoseconds.
+     */
+    uint64_t totalWaitNs = 0;
+
+    /**
+     * The longest time a single job spent waiting in the queue, in nanoseconds.
+     */
+    uint64_t maxWaitNs = 0;
+
+    /**
+     * The number of jobs with a deadline that completed after their deadline frame.
+     */
+    uint64_t deadlineMisses = 0;
+};
+
+/**
+ * Load-time payload measurements for a single asset, from its most recent load.
+ */
+struct LTAssetDecodeStats
+{
+    /**
+     * How the payload was stored.
+     */
+    LTCompressionCodec codec = LTCompressionCodec::LT_COMPRESSION_CODEC_NONE;
+
+    /**
+     * The size of the payload as read from disk, in bytes.
+     */
+    uint64_t storedBytes = 0;
+
+    /**
+     * The size of the decoded payload, in bytes.
+     */
+    uint64_t uncompressedBytes = 0;
+
+    /**
+     * The time spent decoding the payload, in nanoseconds.
+     */
+    uint64_t decodeNs = 0;
+
+    /**
+     * The number of times the asset has been loaded.
+     */
+    uint32_t loadCount = 0;
+};
+
+/**
+ * The manager of all assets in the game. Responsible for loading and unloading assets.
+ */
+class LTAssetManager
+{
+    /**
+     * Fields
+     */
+private:
+    /**
+     * List of all assets in game -- these may or may not be loaded.
+     */
+    eastl::vector<LTAsset*> m_Assets;
+
+    /**
+     * The packed content archive that assets are looked up and loaded from.
+     */
+    LTContentPak m_ContentPak;
+
+    /**
+     * The worker threads used to process asset jobs.
+     */
+    eastl::vector<std::thread*> m_ContentThreads;
+
+    /**
+     * The lock-free queues of asset jobs to be processed, one per priority.
+     */
+    LTJobQueue<LTAssetJob> m_AssetJobs[(size_t)LTAssetPriority::LT_ASSET_PRIORITY_COUNT];
+
+    /**
+     * Per priority, the number of times a job was served from a higher priority
+     * queue while this queue had work waiting. Used to age low priority work so it
+     * cannot be starved.
+     */
+    std::atomic<uint32_t> m_StarvedPasses[(size_t)LTAssetPriority::LT_ASSET_PRIORITY_COUNT];
+
+    /**
+     * The current frame, advanced by the game loop; used for load deadlines and
+     * texture mip requests.
+     */
+    std::atomic<uint64_t> m_CurrentFrame;
+
+    /**
+     * The frame the renderer records next, or is recording, and the last frame the
+     * GPU has completed, as given to SetRenderFrames.
+     */
+    std::atomic<uint64_t> m_RecordFrame;
+    std::atomic<uint64_t> m_CompletedFrame;
+
+    /**
+     * An image and view, or the vertex and index ranges of a model level, replaced by
+     * a stream or unloaded, kept until the frames that may use it have completed;
+     * the image is null and the ranges are empty when it does not hold them.
+     */
+    struct LTRetiredResource
+    {
+        VkImage image;
+        LTVKAllocation imageAllocation;
+        VkImageView imageView;
+        LTVKGeometryRange vertexRange;
+        LTVKGeometryRange indexRange;
+        uint64_t retiredFrame;
+    };
+
+    /**
+     * Images and geometry waiting for ReleaseRetiredResources.
+     */
+    eastl::vector<LTRetiredResource> m_RetiredResources;
+
+    /**
+     * The mutex for controlling access to the retired images and geometry.
+     */
+    std::mutex m_RetiredResourcesMutex;
+
+    /**
+     * Per priority queue-wait measurements. Guarded by m_StatsMutex.
+     */
+    LTAssetQueueStats m_QueueStats[(size_t)LTAssetPriority::LT_ASSET_PRIORITY_COUNT];
+
+    /**
+     * Per asset payload measurements, indexed by asset ID. Guarded by m_StatsMutex.
+     */
+    eastl::vector<LTAssetDecodeStats> m_DecodeStats;
+
+    /**
+     * The mutex for controlling access to the queue and decode stats.
+     */
+    std::mutex m_StatsMutex;
+
+    /**
+     * Guards asset continuations and load completion, so registering a
+     * continuation cannot race with the load finishing.
+     */
+    std::mutex m_ContinuationMutex;
+
+    /**
+     * Signaled whenever any load completes; used by LTAssetLoadToken::Wait.
+     */
+    std::condition_variable m_LoadCompleteCondition;
+
+    /**
+     * A completed load callback that is waiting to run on the main thread.
+     */
+    struct LTMainThreadCallback
+    {
+        LTAssetCallback callback;
+        LTAssetHandle assetHandle;
+        LTAssetJobResult result;
+    };
+
+    /**
+     * Callbacks waiting for the main thread to drain them.
+     */
+    eastl::vector<LTMainThreadCallback> m_MainThreadCallbacks;
+
+    /**
+     * The mutex for controlling access to the main thread callbacks.
+     */
+    std::mutex m_MainThreadCallbackMutex;
+
+    /**
+     * The mutex used only for putting idle workers to sleep; queuing and
+     * taking jobs never locks it.
+     */
+    std::mutex m_AssetMutex;
+
+    /**
+     * Signaled when jobs are queued (or on shutdown) so idle workers can sleep
+     * instead of spinning on the queue.
+     */
+    std::condition_variable m_AssetCondition;
+
+    /**
+     * The number of workers currently asleep (or about to sleep) on m_AssetCondition.
+     * Producers only touch the mutex when this is non-zero.
+     */
+    std::atomic<uint32_t> m_SleepingWorkers;
+
+    /**
+     * The number of jobs that found their queue full and had to back off.
+     */
+    std::atomic<uint64_t> m_QueueFullCount;
+
+    /**
+     * The number of queued loads queued again at a higher priority by a more
+     * urgent request.
+     */
+    std::atomic<uint64_t> m_LoadPromotionCount;
+
+    /**
+     * True on the worker threads, which run a job themselves rather than wait for
+     * room in a full queue.
+     */
+    static thread_local bool s_IsContentThread;
+
+    /**
+     * True while the worker threads should keep processing jobs.
+     */
+    std::atomic<bool> m_IsRunning;
+
+    /**
+     * Guards the LRU, the memory budgets and the memory usage.
+     */
+    std::mutex m_ResidencyMutex;
+
+    /**
+     * The most recently released unreferenced asset.
+     */
+    LTAsset* m_LRUHead;
+
+    /**
+     * The least recently released unreferenced asset; the next to be evicted.
+     */
+    LTAsset* m_LRUTail;
+
+    /**
+     * Per asset type, the memory that loaded assets may use before unreferenced
+     * assets are evicted.
+     */
+    LTAssetMemory m_MemoryBudgets[(size_t)LTAssetType::LT_ASSET_TYPE_COUNT];
+
+    /**
+     * Per asset type, the memory used by loaded assets. Assets chosen for eviction
+     * stop counting as soon as their unload is queued.
+     */
+    LTAssetMemory m_MemoryUsage[(size_t)LTAssetType::LT_ASSET_TYPE_COUNT];
+
+    /**
+     * Per asset type, the number of assets evicted to stay within budget.
+     */
+    uint64_t m_Evictions[(size_t)LTAssetType::LT_ASSET_TYPE_COUNT];
+
+    /**
+     * True to read asset files through a memory mapping rather than an ifstream.
+     * Files that cannot be mapped fall back to the ifstream either way.
+     */
+    std::atomic<bool> m_UseFileMapping;
+
+    /**
+     * The wrapper around the Vulkan graphics device.
+     */
+    class LTVKDevice* m_LTVKDevice;
+
+    /**
+     * Constructors
+     */
+private:
+    LTAssetManager() :
+        m_AssetJobs{
+            LTJobQueue<LTAssetJob>(LT_ASSET_JOB_QUEUE_CAPACITY),
+            LTJobQueue<LTAssetJob>(LT_ASSET_JOB_QUEUE_CAPACITY),
+            LTJobQueue<LTAssetJob>(LT_ASSET_JOB_QUEUE_CAPACITY),
+            LTJobQueue<LTAssetJob>(LT_ASSET_JOB_QUEUE_CAPACITY) },
+        m_StarvedPasses{},
+        m_CurrentFrame(0),
+        m_RecordFrame(0),
+        m_CompletedFrame(0),
+        m_SleepingWorkers(0),
+        m_QueueFullCount(0),
+        m_LoadPromotionCount(0),
+        m_IsRunning(false),
+        m_LRUHead(nullptr),
+        m_LRUTail(nullptr),
+        m_Evictions{},
+        m_UseFileMapping(true),
+        m_LTVKDevice(nullptr)
+    {
+        for (LTAssetMemory& budget : m_MemoryBudgets)
+        {
+            budget.cpuBytes = LT_ASSET_UNLIMITED_BUDGET;
+            budget.gpuBytes = LT_ASSET_UNLIMITED_BUDGET;
+        }
+    }
+
+    /**
+     * Methods
+     */
+private:
+
+    /**
+     * Loads the asset.
+     */
+    bool LoadAsset(LTAssetJob& assetJob);
+
+    /**
+     * Loads an external asset file from disk into a heap buffer.
+     */
+    bool LoadAsset_File(
+        const std::string& fileName,
+        std::ifstream& file,
+        uint8_t*& outBuffer,
+        size_t& outSize);
+
+    /**
+     * Loads the asset according to its type. The payload is read-only and may still
+     * be compressed; loaders decode it straight into their destination.
+     */
+    bool LoadAsset_ByType(
         LTAssetJob& assetJob,
-        uint8_t* fileBuffer,
-        size_t fileSize);
+        LTContentPayload& payload);
 
     /**
      * Loads a shader asset.
      */
     bool LoadAsset_Shader(LTAssetJob& assetJob,
-        uint8_t* fileBuffer,
-        size_t fileSize);
+        LTContentPayload& payload);
+
+    /**
+     * Loads a baked model asset's coarsest level of detail into device-local vertex
+     * and index buffers, or for a stream job, the level the job asks for.
+     */
+    bool LoadAsset_Model(LTAssetJob& assetJob,
+        LTContentPayload& payload);
+
+    /**
+     * Uploads one level of detail of a model and makes it the resident level.
+     */
+    bool LoadAsset_ModelLOD(
+        LTModel* modelAsset,
+        uint32_t lod,
+        LTContentPayload& payload,
+        size_t& outGpuBytes);
+
+    /**
+     * Loads a baked texture asset's mip tail into a device-local image, or for a
+     * stream job, replaces the image with one holding the levels the job asks for.
+     */
+    bool LoadAsset_Texture(LTAssetJob& assetJob,
+        LTContentPayload& payload);
+
+    /**
+     * Uploads every mip level of a texture from firstMip down into a new image and
+     * makes it the resident one, retiring the image it replaces.
+     */
+    bool LoadAsset_TextureMips(
+        LTTexture* textureAsset,
+        uint32_t firstMip,
+        LTContentPayload& payload,
+        size_t& outGpuBytes);
+
+    /**
+     * Unloads the asset, unless it was referenced again after being chosen for eviction.
+     */
+    bool UnloadAsset(LTAssetJob& assetJob);
+
+    /**
+     * Releases the asset's resources according to its type.
+     */
+    void UnloadAsset_ByType(LTAsset* asset);
+
+    /**
+     * Releases a shader asset's shader module.
+     */
+    void UnloadAsset_Shader(LTAsset* asset);
+
+    /**
+     * Releases a model asset's vertex and index buffers.
+     */
+    void UnloadAsset_Model(LTAsset* asset);
+
+    /**
+     * Releases a texture asset's image and view.
+     */
+    void UnloadAsset_Texture(LTAsset* asset);
+
+    /**
+     * Keeps an image and its view, or the vertex and index ranges of a model level,
+     * alive until the frames that may still use them have completed. Null images and
+     * empty ranges are ignored.
+     */
+    void RetireImage(VkImage image, LTVKAllocation& imageAllocation, VkImageView imageView);
+    void RetireGeometry(const LTVKGeometryRange& vertexRange, const LTVKGeometryRange& indexRange);
+
+    /**
+     * Destroys the retired images and geometry whose frames have all completed by
+     * 'completedFrame'.
+     */
+    void ReleaseRetiredResources(uint64_t completedFrame);
 
     /**
-     * Initializes the content lookup from a csv file on disk.
+     * Queues streams that drop the mips textures have not been asked for recently,
+     * least recently asked first, until textures fit their memory budget.
+     */
+    void UpdateTextureStreaming(uint64_t frame);
+
+    /**
+     * Initializes the content lookup from the content archive's table of contents.
      */
     void InitializeContentLookup();
 
@@ -584,6 +1797,121 @@ private:
      */
     void ContentThread();
 
+    /**
+     * Gets the queue a load runs in: a load needed by the next frame is critical.
+     */
+    LTAssetPriority GetLoadPriority(LTAssetPriority priority, uint64_t deadlineFrame);
+
+    /**
+     * Queues the load job for an asset in the loading state, at the priority and
+     * deadline recorded on the asset. Called with the load generation read under
+     * the continuation mutex when the load was begun or promoted.
+     */
+    void QueueLoad(LTAssetHandle& assetHandle, uint32_t loadGeneration);
+
+    /**
+     * Takes the load a job was queued for, giving the job the load's latest
+     * deadline. False when the load already completed or another copy of the job
+     * was taken first; the job is dropped.
+     */
+    bool TryClaimLoad(LTAssetJob& assetJob);
+
+    /**
+     * Pushes a job onto the queue and wakes a sleeping worker if there is one.
+     * Blocks while the job's queue is full: the main thread backs off until a
+     * worker makes room, a worker runs queued jobs itself until there is room.
+     */
+    void QueueJob(LTAssetJob&& assetJob);
+
+    /**
+     * Takes the next job to run: highest priority first, unless a lower priority
+     * queue has been passed over LT_ASSET_AGING_THRESHOLD times.
+     */
+    bool TryDequeueJob(LTAssetJob& outAssetJob);
+
+    /**
+     * Runs a job taken from the queue.
+     */
+    void RunJob(LTAssetJob& assetJob);
+
+    /**
+     * Returns true if any of the priority queues has waiting jobs.
+     */
+    bool HasQueuedJobs() const;
+
+    /**
+     * Records how long a job waited in its queue.
+     */
+    void RecordQueueWait(const LTAssetJob& assetJob);
+
+    /**
+     * Records the payload sizes and decode time of a load.
+     */
+    void RecordDecode(const LTAsset* asset, const LTContentPayload& payload);
+
+    /**
+     * Records whether a job with a deadline completed in time.
+     */
+    void RecordDeadline(const LTAssetJob& assetJob);
+
+    /**
+     * Puts the calling worker to sleep until a job is queued or the manager shuts down.
+     */
+    void WaitForJobs();
+
+    /**
+     * Publishes the end of a load: sets the final asset state, releases anyone
+     * waiting on the asset, and dispatches its continuations.
+     */
+    void CompleteLoad(LTAssetJob& assetJob, bool success);
+
+    /**
+     * Publishes the end of a stream job: counts the streamed level against the
+     * asset's budget. A failed stream leaves the asset at its coarser level.
+     */
+    void CompleteStream(LTAssetJob& assetJob, bool success);
+
+    /**
+     * Publishes the end of a load or stream job, then queues the next finer level of
+     * detail to stream if the asset has one.
+     */
+    void CompleteLoadJob(LTAssetJob& assetJob, bool success);
+
+    /**
+     * Publishes the end of an unload: the asset goes back to NOT_LOADED, or back to
+     * LOADED if the unload was cancelled, and any reload requested meanwhile is queued.
+     */
+    void CompleteUnload(LTAssetJob& assetJob, bool unloaded);
+
+    /**
+     * Counts a newly loaded asset against its type's budget and evicts if it is over.
+     */
+    void AddResidency(LTAsset* asset);
+
+    /**
+     * Links an asset whose last handle was released into the head of the LRU.
+     */
+    void OnAssetUnreferenced(LTAsset* asset);
+
+    /**
+     * Unlinks an asset from the LRU. The residency mutex must be held.
+     */
+    void UnlinkLRU(LTAsset* asset);
+
+    /**
+     * Queues unloads for the least recently used unreferenced assets of a type
+     * until the type is back within its budget.
+     */
+    void EvictOverBudget(LTAssetType assetType);
+
+    /**
+     * Runs a continuation on its requested thread.
+     */
+    void DispatchCallback(
+        const LTAssetContinuation& continuation,
+        LTAssetHandle& assetHandle,
+        LTAssetJobResult result);
+
 public:
     /**
      * Singleton pattern accessor
@@ -595,9 +1923,16 @@ public:
     }
 
     /**
-     * Initializes the manager
+     * Initializes the manager and starts the worker threads.
+     * A worker count of 0 sizes the pool from the hardware concurrency.
+     */
+    void Initialize(class LTVKDevice* ltvkDevice, uint32_t workerCount = 0);
+
+    /**
+     * Stops and joins the worker threads. Jobs still in the queue are dropped and
+     * every asset that is still resident is unloaded.
      */
-    void Initialize(class LTVKDevice* ltvkDevice);
+    void Destroy();
 
     /**
      * Gets an asset, but does not load it.
@@ -606,13 +1941,149 @@ public:
 
     /**
      * Loads an asset -- this is asynchronous, the asset is not loaded immediately upon return to the caller.
+     * Loads whose deadline is the current or next frame are promoted to critical priority.
+     * Calls made while a load is already in flight return immediately without queuing another job.
+     */
+    bool Load(
+        LTAssetHandle& asset,
+        LTAssetPriority priority = LTAssetPriority::LT_ASSET_PRIORITY_NORMAL,
+        uint64_t deadlineFrame = LT_ASSET_NO_DEADLINE);
+
+    /**
+     * Loads an asset and returns a token that completes when the load does.
      */
-    bool Load(LTAssetHandle& asset);
+    bool Load(
+        LTAssetHandle& asset,
+        LTAssetLoadToken& outToken,
+        LTAssetPriority priority = LTAssetPriority::LT_ASSET_PRIORITY_NORMAL,
+        uint64_t deadlineFrame = LT_ASSET_NO_DEADLINE);
 
     /**
      * Gets the asset and then loads it -- this is asynchronous, the asset is not loaded immediately upon return to the caller.
      */
-    bool GetLoad(LTAssetID assetID, LTAssetHandle& outAsset);
+    bool GetLoad(
+        LTAssetID assetID,
+        LTAssetHandle& outAsset,
+        LTAssetPriority priority = LTAssetPriority::LT_ASSET_PRIORITY_NORMAL,
+        uint64_t deadlineFrame = LT_ASSET_NO_DEADLINE);
+
+    /**
+     * Gets the asset and then loads it, returning a token that completes when the load does.
+     */
+    bool GetLoad(
+        LTAssetID assetID,
+        LTAssetHandle& outAsset,
+        LTAssetLoadToken& outToken,
+        LTAssetPriority priority = LTAssetPriority::LT_ASSET_PRIORITY_NORMAL,
+        uint64_t deadlineFrame = LT_ASSET_NO_DEADLINE);
+
+    /**
+     * Runs the load callbacks that were registered for the main thread.
+     * Call once per frame from the main thread.
+     */
+    void DispatchMainThreadCallbacks();
+
+    /**
+     * Tells the manager the frame the renderer records next and the last frame the
+     * GPU has completed. Images and buffers replaced by streams or unloaded are
+     * destroyed once the frames that may use them have completed; until this is
+     * first called, they are kept until Destroy. Call once per frame from the main
+     * thread, before BeginFrame.
+     */
+    void SetRenderFrames(uint64_t recordFrame, uint64_t completedFrame);
+
+    /**
+     * Advances the frame counter used for load deadlines and mip requests, releases
+     * the images and geometry whose frames have completed, and trims texture mips
+     * when textures are over their memory budget. Call once per frame from the main
+     * thread.
+     */
+    void BeginFrame();
+
+    /**
+     * Asks for a texture's mip level to be resident, along with every smaller one.
+     * The renderer calls it each frame for every texture it draws, with the largest
+     * level it samples; the level streams in unless textures are over budget, and
+     * stays until the texture has not been asked for it in LT_TEXTURE_REQUEST_FRAMES
+     * frames and the memory is needed.
+     */
+    void RequestTextureMip(const LTAssetHandle& textureHandle, uint32_t mip);
+
+    /**
+     * Asks for a model's level of detail to be resident, along with every coarser
+     * one. The levels between the resident one and the finest asked for stream in
+     * one at a time; call it each frame a drawn level is too coarse, as a request
+     * made while a stream is finishing may be dropped.
+     */
+    void RequestModelLOD(const LTAssetHandle& modelHandle, uint32_t lod);
+
+    /**
+     * Gets the current frame used for load deadlines.
+     */
+    inline uint64_t GetCurrentFrame() const
+    {
+        return m_CurrentFrame.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Gets a snapshot of the queue-wait measurements for a priority.
+     */
+    LTAssetQueueStats GetQueueStats(LTAssetPriority priority);
+
+    /**
+     * Prints the queue-wait measurements for every priority.
+     */
+    void PrintQueueStats();
+
+    /**
+     * Gets a snapshot of the payload measurements for an asset.
+     */
+    LTAssetDecodeStats GetDecodeStats(LTAssetID assetID);
+
+    /**
+     * Prints the payload measurements for every asset type, and for every
+     * loaded asset if 'perAsset' is set.
+     */
+    void PrintDecodeStats(bool perAsset = false);
+
+    /**
+     * Sets the memory loaded assets of a type may use before unreferenced assets
+     * of that type are evicted. Evicts immediately if the type is over the new budget.
+     */
+    void SetMemoryBudget(LTAssetType assetType, const LTAssetMemory& budget);
+
+    /**
+     * Gets the memory budget for an asset type.
+     */
+    LTAssetMemory GetMemoryBudget(LTAssetType assetType);
+
+    /**
+     * Gets the memory used by loaded assets of a type.
+     */
+    LTAssetMemory GetMemoryUsage(LTAssetType assetType);
+
+    /**
+     * Prints the memory usage, budget and evictions for every asset type.
+     */
+    void PrintMemoryStats();
+
+    /**
+     * Chooses between memory-mapped and ifstream reads of asset files.
+     */
+    inline void SetFileMappingEnabled(bool enabled)
+    {
+        m_UseFileMapping = enabled;
+    }
+
+    /**
+     * The load token waits on and registers continuations with the manager.
+     */
+    friend class LTAssetLoadToken;
+
+    /**
+     * The asset handle hands unreferenced assets to the LRU.
+     */
+    friend class LTAssetHandle;
 
     ///**
     // * Debugging only -- used to inspect assets
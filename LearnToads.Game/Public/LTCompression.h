@@ -0,0 +1,56 @@
+#pragma once
+
+#include "PrecompiledHeader.h"
+
+/**
+ * Specifies how an asset payload is stored in the content archive.
+ */
+enum class LTCompressionCodec : uint32_t
+{
+    LT_COMPRESSION_CODEC_NONE = 0x0,
+
+    /**
+     * A single LZ4 block (no frame header); fast to decode on the load path.
+     */
+    LT_COMPRESSION_CODEC_LZ4 = 0x1,
+
+    LT_COMPRESSION_CODEC_COUNT = 0x2
+};
+
+/**
+ * Decoders for compressed asset payloads.
+ */
+class LTCompression
+{
+    /**
+     * Methods
+     */
+public:
+    /**
+     * Decodes 'source' into 'destination'. Decoding stops once 'destinationSize' bytes
+     * have been written, so passing a smaller size decodes just that prefix of the
+     * payload. Returns false if the source is corrupt or ends before
+     * 'destinationSize' bytes were produced.
+     */
+    static bool Decompress(
+        LTCompressionCodec codec,
+        const uint8_t* source,
+        size_t sourceSize,
+        uint8_t* destination,
+        size_t destinationSize);
+
+    /**
+     * Gets a printable name for a codec.
+     */
+    static const char* GetCodecName(LTCompressionCodec codec);
+
+private:
+    /**
+     * Decodes an LZ4 block, stopping when the destination is full.
+     */
+    static bool DecompressLZ4(
+        const uint8_t* source,
+        size_t sourceSize,
+        uint8_t* destination,
+        size_t destinationSize);
+};
@@ -0,0 +1,338 @@
+#pragma once
+
+#include "PrecompiledHeader.h"
+#include "LTFileMapping.h"
+#include "LTCompression.h"
+
+#ifdef NDEBUG
+#define LT_CONTENT_VERIFY_HASHES 0
+#else
+#define LT_CONTENT_VERIFY_HASHES 1
+#endif
+
+/**
+ * Identifies a content archive ("LTPK", little-endian).
+ */
+constexpr uint32_t LT_CONTENT_PAK_MAGIC = 0x4B50544C;
+
+/**
+ * The archive layout version; bumped whenever the header or entry layout changes.
+ */
+constexpr uint32_t LT_CONTENT_PAK_VERSION = 2;
+
+/**
+ * Flags on a content archive entry.
+ */
+enum LTContentPakEntryFlags : uint32_t
+{
+    /**
+     * The payload is not packed; the asset is read from the loose file named by the entry.
+     */
+    LT_CONTENT_PAK_ENTRY_FLAG_EXTERNAL = 0x1,
+
+    /**
+     * No asset uses this ID any more. IDs are kept stable between content builds,
+     * so removed content leaves empty entries behind until the next full rebuild.
+     */
+    LT_CONTENT_PAK_ENTRY_FLAG_EMPTY = 0x2,
+};
+
+/**
+ * The fixed header at the start of a content archive.
+ *
+ * Layout: header, then entryCount entries indexed by asset ID, then the string
+ * table of asset names, then the payloads, each starting on payloadAlignment.
+ */
+struct LTContentPakHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t entryCount;
+    uint32_t payloadAlignment;
+    uint64_t stringTableOffset;
+    uint64_t stringTableSize;
+};
+
+/**
+ * A table of contents entry. Entry i describes the asset with ID i.
+ */
+struct LTContentPakEntry
+{
+    /**
+     * The asset ID; always equal to the entry's index.
+     */
+    uint32_t assetID;
+
+    /**
+     * The LTAssetType of the asset.
+     */
+    uint32_t assetType;
+
+    /**
+     * The offset of the payload from the start of the archive.
+     */
+    uint64_t offset;
+
+    /**
+     * The size of the payload as stored in the archive, in bytes.
+     */
+    uint64_t size;
+
+    /**
+     * The size of the payload once decoded, in bytes.
+     */
+    uint64_t uncompressedSize;
+
+    /**
+     * The CRC-32 of the payload as stored.
+     */
+    uint32_t hash;
+
+    /**
+     * LTContentPakEntryFlags.
+     */
+    uint32_t flags;
+
+    /**
+     * The LTCompressionCodec the payload is stored with.
+     */
+    uint32_t codec;
+
+    /**
+     * The offset of the asset's name (its source path) in the string table.
+     */
+    uint32_t nameOffset;
+
+    /**
+     * The length of the asset's name, without a terminator.
+     */
+    uint32_t nameLength;
+
+    uint32_t reserved;
+};
+
+static_assert(sizeof(LTContentPakHeader) == 32, "LTContentPakHeader must match BuildContent.py");
+static_assert(sizeof(LTContentPakEntry) == 56, "LTContentPakEntry must match BuildContent.py");
+
+/**
+ * A view of an asset's payload that type loaders read from.
+ *
+ * Uncompressed payloads are read in place. Compressed payloads are decoded on
+ * demand, either straight into a destination the loader owns (such as mapped
+ * staging memory) with ReadInto, or into a scratch buffer owned by the payload
+ * with GetContiguous for loaders that need the whole payload in memory.
+ */
+class LTContentPayload
+{
+    /**
+     * Fields
+     */
+private:
+    /**
+     * The payload as stored.
+     */
+    const uint8_t* m_StoredData;
+
+    /**
+     * The size of the payload as stored, in bytes.
+     */
+    size_t m_StoredSize;
+
+    /**
+     * The size of the decoded payload, in bytes.
+     */
+    size_t m_Size;
+
+    /**
+     * How the payload is stored.
+     */
+    LTCompressionCodec m_Codec;
+
+    /**
+     * The decoded payload when GetContiguous had to decode it.
+     */
+    uint8_t* m_DecodedData;
+
+    /**
+     * The time spent decoding so far, in nanoseconds.
+     */
+    uint64_t m_DecodeNs;
+
+    /**
+     * Constructors
+     */
+public:
+    LTContentPayload(
+        const uint8_t* storedData,
+        size_t storedSize,
+        size_t size,
+        LTCompressionCodec codec) :
+        m_StoredData(storedData),
+        m_StoredSize(storedSize),
+        m_Size(size),
+        m_Codec(codec),
+        m_DecodedData(nullptr),
+        m_DecodeNs(0)
+    {
+    }
+
+    ~LTContentPayload();
+
+    // non-copyable
+    LTContentPayload(const LTContentPayload&) = delete;
+    void operator=(const LTContentPayload&) = delete;
+
+    /**
+     * Methods
+     */
+public:
+    /**
+     * Decodes the first 'size' bytes of the payload into 'destination'.
+     * Passing less than GetSize() decodes only that prefix.
+     */
+    bool ReadInto(uint8_t* destination, size_t size);
+
+    /**
+     * Gets the whole decoded payload in contiguous memory: in place when it is
+     * stored uncompressed, otherwise decoded once into a scratch buffer.
+     */
+    bool GetContiguous(const uint8_t*& outData);
+
+    /**
+     * Gets the size of the decoded payload, in bytes.
+     */
+    inline size_t GetSize() const
+    {
+        return m_Size;
+    }
+
+    /**
+     * Gets the size of the payload as stored, in bytes.
+     */
+    inline size_t GetStoredSize() const
+    {
+        return m_StoredSize;
+    }
+
+    /**
+     * Gets how the payload is stored.
+     */
+    inline LTCompressionCodec GetCodec() const
+    {
+        return m_Codec;
+    }
+
+    /**
+     * Gets the time spent decoding the payload so far, in nanoseconds.
+     */
+    inline uint64_t GetDecodeNs() const
+    {
+        return m_DecodeNs;
+    }
+};
+
+/**
+ * A read-only view of the packed content archive written by BuildContent.py.
+ * The archive is mapped once and entries are looked up by asset ID with no parsing.
+ */
+class LTContentPak
+{
+    /**
+     * Fields
+     */
+private:
+    /**
+     * The mapping of the whole archive.
+     */
+    LTFileMapping m_FileMapping;
+
+    /**
+     * The archive header, inside the mapping.
+     */
+    const LTContentPakHeader* m_Header;
+
+    /**
+     * The table of contents, inside the mapping.
+     */
+    const LTContentPakEntry* m_Entries;
+
+    /**
+     * The string table, inside the mapping.
+     */
+    const char* m_StringTable;
+
+    /**
+     * Constructors
+     */
+public:
+    LTContentPak() :
+        m_Header(nullptr),
+        m_Entries(nullptr),
+        m_StringTable(nullptr)
+    {
+    }
+
+    // non-copyable
+    LTContentPak(const LTContentPak&) = delete;
+    void operator=(const LTContentPak&) = delete;
+
+    /**
+     * Methods
+     */
+public:
+    /**
+     * Maps the archive and validates its header and table of contents.
+     */
+    bool Open(const std::string& fileName);
+
+    /**
+     * Unmaps the archive.
+     */
+    void Close();
+
+    /**
+     * Determines if an archive is open.
+     */
+    inline bool IsOpen() const
+    {
+        return m_Header != nullptr;
+    }
+
+    /**
+     * Gets the number of entries (one past the highest asset ID).
+     */
+    inline uint32_t GetEntryCount() const
+    {
+        return m_Header ? m_Header->entryCount : 0;
+    }
+
+    /**
+     * Gets the entry for an asset ID.
+     */
+    inline const LTContentPakEntry& GetEntry(uint32_t assetID) const
+    {
+        assert(assetID < GetEntryCount());
+        return m_Entries[assetID];
+    }
+
+    /**
+     * Gets the payload of a packed entry.
+     */
+    inline const uint8_t* GetPayload(const LTContentPakEntry& entry) const
+    {
+        return m_FileMapping.GetData() + entry.offset;
+    }
+
+    /**
+     * Gets the name of an entry.
+     */
+    inline std::string GetName(const LTContentPakEntry& entry) const
+    {
+        return std::string(m_StringTable + entry.nameOffset, entry.nameLength);
+    }
+
+    /**
+     * Computes the CRC-32 used for entry hashes.
+     */
+    static uint32_t ComputeHash(const uint8_t* data, size_t size);
+};
@@ -0,0 +1,108 @@
+#pragma once
+
+#include "PrecompiledHeader.h"
+
+/**
+ * A read-only memory mapping of a whole file.
+ *
+ * The view comes straight from the OS page cache, so reading through it needs
+ * no heap buffer and no copy. The view stays valid until Close() is called or
+ * the mapping is destroyed.
+ */
+class LTFileMapping
+{
+    /**
+     * Fields
+     */
+private:
+    /**
+     * The start of the mapped view.
+     */
+    const uint8_t* m_Data;
+
+    /**
+     * The size of the mapped view in bytes.
+     */
+    size_t m_Size;
+
+#if defined(_WIN32)
+    /**
+     * The Win32 file handle.
+     */
+    void* m_FileHandle;
+
+    /**
+     * The Win32 file mapping object handle.
+     */
+    void* m_MappingHandle;
+#else
+    /**
+     * The POSIX file descriptor.
+     */
+    int m_FileDescriptor;
+#endif
+
+    /**
+     * Constructors
+     */
+public:
+    LTFileMapping() :
+        m_Data(nullptr),
+        m_Size(0),
+#if defined(_WIN32)
+        m_FileHandle(nullptr),
+        m_MappingHandle(nullptr)
+#else
+        m_FileDescriptor(-1)
+#endif
+    {
+    }
+
+    ~LTFileMapping()
+    {
+        Close();
+    }
+
+    // non-copyable
+    LTFileMapping(const LTFileMapping&) = delete;
+    void operator=(const LTFileMapping&) = delete;
+
+    /**
+     * Methods
+     */
+public:
+    /**
+     * Maps the whole file read-only. Returns false if the file cannot be opened,
+     * is empty, or cannot be mapped.
+     */
+    bool Open(const std::string& fileName);
+
+    /**
+     * Unmaps the view and closes the file.
+     */
+    void Close();
+
+    /**
+     * Determines if a file is currently mapped.
+     */
+    inline bool IsOpen() const
+    {
+        return m_Data != nullptr;
+    }
+
+    /**
+     * Gets the start of the mapped view.
+     */
+    inline const uint8_t* GetData() const
+    {
+        return m_Data;
+    }
+
+    /**
+     * Gets the size of the mapped view in bytes.
+     */
+    inline size_t GetSize() const
+    {
+        return m_Size;
+    }
+};
@@ -31,6 +31,11 @@ private:
      */
     uint32_t m_Height;
 
+    /**
+     * Set when the framebuffer is resized, until the renderer has seen it.
+     */
+    bool m_WasResized;
+
     /**
      * Constructors
      */
@@ -39,7 +44,8 @@ public:
         : m_Window(nullptr)
         , m_Title("Game")
         , m_Width(800)
-        , m_Height(600) { }
+        , m_Height(600)
+        , m_WasResized(false) { }
 
     /**
      * Copy/Move protection
@@ -56,6 +62,10 @@ private:
      * Methods
      */
 private:
+    /**
+     * Called by GLFW when the framebuffer is resized.
+     */
+    static void OnFramebufferResized(GLFWwindow* window, int width, int height);
 
 public:
     /**
@@ -87,7 +97,20 @@ public:
     }
 
     /**
-     * Gets the window width
+     * Returns true if the framebuffer was resized since ClearResized.
+     */
+    inline bool WasResized() const
+    {
+        return m_WasResized;
+    }
+
+    inline void ClearResized()
+    {
+        m_WasResized = false;
+    }
+
+    /**
+     * Gets the window width, in framebuffer pixels; 0 while minimized
      */
     inline const uint32_t GetWidth() const
     {
@@ -95,7 +118,7 @@ public:
     }
 
     /**
-     * Gets the window height
+     * Gets the window height, in framebuffer pixels; 0 while minimized
      */
     inline const uint32_t GetHeight() const
     {
@@ -0,0 +1,217 @@
+#pragma once
+
+#include "PrecompiledHeader.h"
+
+/**
+ * The size of a cache line; used to keep the producer and consumer cursors
+ * from false sharing.
+ */
+constexpr size_t LT_CACHE_LINE_SIZE = 64;
+
+/**
+ * A bounded, lock-free, multi-producer/multi-consumer ring buffer.
+ *
+ * Each cell carries a sequence number that tells producers and consumers whether
+ * the cell is free to write or ready to read for the current lap around the ring,
+ * so a push or pop is a single CAS on the shared cursor plus one release store.
+ *
+ * The capacity must be a power of two. TryEnqueue fails when the ring is full
+ * and TryDequeue fails when it is empty; neither ever blocks.
+ */
+template <typename T>
+class LTJobQueue
+{
+    /**
+     * Types
+     */
+private:
+    struct Cell
+    {
+        /**
+         * Equal to the cell index when the cell is free to be written, and
+         * index + 1 once the value has been published for consumers.
+         */
+        std::atomic<size_t> sequence;
+
+        /**
+         * Uninitialized storage for the value.
+         */
+        alignas(T) unsigned char storage[sizeof(T)];
+    };
+
+    /**
+     * Fields
+     */
+private:
+    /**
+     * The ring of cells.
+     */
+    Cell* m_Buffer;
+
+    /**
+     * Capacity - 1; used to wrap cursors into the ring.
+     */
+    size_t m_Mask;
+
+    /**
+     * The next position to write to.
+     */
+    alignas(LT_CACHE_LINE_SIZE) std::atomic<size_t> m_EnqueuePos;
+
+    /**
+     * The next position to read from.
+     */
+    alignas(LT_CACHE_LINE_SIZE) std::atomic<size_t> m_DequeuePos;
+
+    /**
+     * Constructors
+     */
+public:
+    explicit LTJobQueue(size_t capacity) :
+        m_Buffer(nullptr),
+        m_Mask(capacity - 1),
+        m_EnqueuePos(0),
+        m_DequeuePos(0)
+    {
+        assert(capacity >= 2 && (capacity & (capacity - 1)) == 0);
+
+        m_Buffer = (Cell*)eastl::GetDefaultAllocator()->allocate(
+            sizeof(Cell) * capacity,
+            alignof(Cell),
+            0);
+
+        for (size_t i = 0; i < capacity; ++i)
+        {
+            new(&m_Buffer[i].sequence) std::atomic<size_t>(i);
+        }
+    }
+
+    ~LTJobQueue()
+    {
+        // destroy anything still sitting in the ring
+        T value;
+        while (TryDequeue(value))
+        {
+        }
+
+        eastl::GetDefaultAllocator()->deallocate(m_Buffer, sizeof(Cell) * (m_Mask + 1));
+    }
+
+    // non-copyable
+    LTJobQueue(const LTJobQueue&) = delete;
+    void operator=(const LTJobQueue&) = delete;
+    // non-movable
+    LTJobQueue(LTJobQueue&&) = delete;
+    LTJobQueue& operator=(LTJobQueue&&) = delete;
+
+    /**
+     * Methods
+     */
+public:
+    /**
+     * Pushes a value onto the queue. Returns false if the queue is full.
+     */
+    template <typename U>
+    bool TryEnqueue(U&& value)
+    {
+        Cell* cell;
+        size_t pos = m_EnqueuePos.load(std::memory_order_relaxed);
+
+        while (true)
+        {
+            cell = &m_Buffer[pos & m_Mask];
+            size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            intptr_t diff = (intptr_t)sequence - (intptr_t)pos;
+
+            if (diff == 0)
+            {
+                // the cell is free for this lap; try to claim it
+                if (m_EnqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    break;
+                }
+            }
+            else if (diff < 0)
+            {
+                // the consumer has not freed this cell yet -- the ring is full
+                return false;
+            }
+            else
+            {
+                // another producer claimed the cell; reload and retry
+                pos = m_EnqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+
+        new(cell->storage) T(std::forward<U>(value));
+
+        // publish the value to consumers
+        cell->sequence.store(pos + 1, std::memory_order_release);
+
+        return true;
+    }
+
+    /**
+     * Pops a value from the queue. Returns false if the queue is empty.
+     */
+    bool TryDequeue(T& outValue)
+    {
+        Cell* cell;
+        size_t pos = m_DequeuePos.load(std::memory_order_relaxed);
+
+        while (true)
+        {
+            cell = &m_Buffer[pos & m_Mask];
+            size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            intptr_t diff = (intptr_t)sequence - (intptr_t)(pos + 1);
+
+            if (diff == 0)
+            {
+                // the value has been published; try to claim it
+                if (m_DequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    break;
+                }
+            }
+            else if (diff < 0)
+            {
+                // nothing has been published to this cell -- the ring is empty
+                return false;
+            }
+            else
+            {
+                // another consumer claimed the cell; reload and retry
+                pos = m_DequeuePos.load(std::memory_order_relaxed);
+            }
+        }
+
+        T* value = reinterpret_cast<T*>(cell->storage);
+        outValue = std::move(*value);
+        value->~T();
+
+        // free the cell for the producers' next lap around the ring
+        cell->sequence.store(pos + m_Mask + 1, std::memory_order_release);
+
+        return true;
+    }
+
+    /**
+     * Gets the number of queued values. This is only a snapshot and may be stale
+     * by the time the caller uses it.
+     */
+    inline size_t GetApproximateSize() const
+    {
+        size_t enqueuePos = m_EnqueuePos.load(std::memory_order_relaxed);
+        size_t dequeuePos = m_DequeuePos.load(std::memory_order_relaxed);
+
+        return enqueuePos > dequeuePos ? enqueuePos - dequeuePos : 0;
+    }
+
+    /**
+     * Gets the maximum number of values the queue can hold.
+     */
+    inline size_t GetCapacity() const
+    {
+        return m_Mask + 1;
+    }
+};
@@ -0,0 +1,11 @@
+#pragma once
+
+/**
+ * Measures enqueue and dequeue throughput of LTJobQueue against a mutex-guarded
+ * eastl::queue at 1, 4 and 16 threads, and prints the results to stdout. Each queue
+ * is first filled and drained in separate phases, then run with as many producers
+ * as consumers at once through a queue of the asset manager's capacity.
+ *
+ * Run the game with --benchmark-job-queue to invoke this instead of the game loop.
+ */
+void RunJobQueueBenchmark();
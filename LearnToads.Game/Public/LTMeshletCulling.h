@@ -0,0 +1,137 @@
+#pragma once
+
+#include "PrecompiledHeader.h"
+#include "LTModelFormat.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define LT_MESHLET_CULLING_SSE2 1
+#else
+#define LT_MESHLET_CULLING_SSE2 0
+#endif
+
+/**
+ * The culling bounds of four meshlets, one lane each, so they can be tested together.
+ */
+struct LTMeshletBounds4
+{
+    float centerX[4];
+    float centerY[4];
+    float centerZ[4];
+    float radius[4];
+    float coneApexX[4];
+    float coneApexY[4];
+    float coneApexZ[4];
+    float coneAxisX[4];
+    float coneAxisY[4];
+    float coneAxisZ[4];
+    float coneCutoff[4];
+};
+
+/**
+ * A contiguous range of a model's index buffer, drawn with one vkCmdDrawIndexed.
+ */
+struct LTMeshletDrawRange
+{
+    uint32_t firstIndex;
+    uint32_t indexCount;
+};
+
+/**
+ * A model's meshlets, kept on the CPU for culling.
+ */
+struct LTModelMeshlets
+{
+    /**
+     * The bounds of every meshlet, four to a block. The unused lanes of the last
+     * block are never visible.
+     */
+    eastl::vector<LTMeshletBounds4> bounds;
+
+    /**
+     * The index range of every meshlet, in index buffer order.
+     */
+    eastl::vector<LTMeshletDrawRange> ranges;
+};
+
+/**
+ * The six planes of a view frustum as (a, b, c, d), normals pointing inwards.
+ * A point p is inside a plane when a * p.x + b * p.y + c * p.z + d >= 0.
+ */
+struct LTFrustum
+{
+    glm::vec4 planes[6];
+};
+
+/**
+ * Culls a model's meshlets on the CPU, before the draw.
+ *
+ * Culling happens in model space: the frustum comes from the full
+ * model-view-projection matrix and the camera position is transformed into the
+ * model's space by the caller. Only core Vulkan 1.0 is needed to draw the result.
+ */
+class LTMeshletCulling
+{
+    /**
+     * Methods
+     */
+public:
+    /**
+     * Extracts the frustum planes from a model-view-projection matrix with a zero to
+     * one depth range.
+     */
+    static void ExtractFrustum(const glm::mat4& modelViewProjection, LTFrustum& outFrustum);
+
+    /**
+     * Converts baked meshlets into the culling layout.
+     */
+    static void BuildMeshlets(
+        const LTModelMeshlet* meshlets,
+        uint32_t meshletCount,
+        LTModelMeshlets& outMeshlets);
+
+    /**
+     * Culls the meshlets against the frustum and by their normal cones. Visible
+     * meshlets that are adjacent in the index buffer are merged into a single range.
+     * Returns the number of visible meshlets.
+     */
+    static uint32_t CullMeshlets(
+        const LTModelMeshlets& meshlets,
+        const LTFrustum& frustum,
+        const glm::vec3& cameraPosition,
+        eastl::vector<LTMeshletDrawRange>& outRanges);
+
+    /**
+     * Culls the meshlets against one view like CullMeshlets, setting the bit of each
+     * visible meshlet in the mask of its block rather than building ranges. Marking
+     * several views, e.g. one per instance of the model, accumulates the meshlets
+     * any of them sees. Returns the number of meshlets visible from this view.
+     */
+    static uint32_t MarkVisibleMeshlets(
+        const LTModelMeshlets& meshlets,
+        const LTFrustum& frustum,
+        const glm::vec3& cameraPosition,
+        uint8_t* inOutBlockMasks);
+
+    /**
+     * Gets the index ranges of the meshlets marked by MarkVisibleMeshlets, merging
+     * the ones adjacent in the index buffer.
+     */
+    static void BuildDrawRanges(
+        const LTModelMeshlets& meshlets,
+        const uint8_t* blockMasks,
+        eastl::vector<LTMeshletDrawRange>& outRanges);
+
+private:
+    /**
+     * Appends a meshlet's range, extending the last range if they are adjacent.
+     */
+    static void AppendRange(const LTMeshletDrawRange& range, eastl::vector<LTMeshletDrawRange>& outRanges);
+
+    /**
+     * Gets a bit per lane of the block, set when that meshlet is visible.
+     */
+    static uint32_t CullBlock(
+        const LTMeshletBounds4& block,
+        const LTFrustum& frustum,
+        const glm::vec3& cameraPosition);
+};
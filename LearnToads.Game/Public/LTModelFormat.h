@@ -0,0 +1,191 @@
+#pragma once
+
+#include "PrecompiledHeader.h"
+
+/**
+ * Identifies a baked model ("LTMD", little-endian).
+ */
+constexpr uint32_t LT_MODEL_MAGIC = 0x444D544C;
+
+/**
+ * The baked model layout version; bumped whenever the header or vertex layout changes.
+ */
+constexpr uint32_t LT_MODEL_VERSION = 4;
+
+/**
+ * The most levels of detail a baked model has, counting the full mesh.
+ */
+constexpr uint32_t LT_MODEL_MAX_LODS = 4;
+
+/**
+ * The layout of a baked model's vertices.
+ */
+enum class LTModelVertexFormat : uint32_t
+{
+    /**
+     * LTModelVertex: full precision floats.
+     */
+    LT_MODEL_VERTEX_FORMAT_FLOAT = 0x0,
+
+    /**
+     * LTModelVertexQuantized: positions relative to the bounds, octahedral normals
+     * and half-float uvs.
+     */
+    LT_MODEL_VERTEX_FORMAT_QUANTIZED = 0x1,
+
+    LT_MODEL_VERTEX_FORMAT_COUNT = 0x2
+};
+
+/**
+ * The header at the start of a baked model.
+ *
+ * Layout: header, then lodCount LTModelLOD records (LOD 0, the full mesh, first),
+ * then the meshlets of every level, then the interleaved vertices and the indices
+ * of each level from the coarsest to the finest. A prefix of the model therefore
+ * holds every level coarser than the one it ends with. The vertex and index
+ * sections are written by ContentTools/model.py ready to be copied straight into
+ * GPU buffers.
+ */
+struct LTModelHeader
+{
+    uint32_t magic;
+    uint32_t version;
+
+    /**
+     * The size of each vertex in bytes, and of each index (2 or 4), in every level.
+     */
+    uint32_t vertexStride;
+    uint32_t indexSize;
+
+    /**
+     * The LTModelVertexFormat of the vertices.
+     */
+    uint32_t vertexFormat;
+
+    /**
+     * The number of levels of detail, at most LT_MODEL_MAX_LODS.
+     */
+    uint32_t lodCount;
+
+    /**
+     * The axis-aligned bounds of every vertex position, in model space.
+     */
+    float boundsMin[3];
+    float boundsMax[3];
+};
+
+/**
+ * Where one level of detail of a baked model is stored.
+ */
+struct LTModelLOD
+{
+    /**
+     * The number of vertices, indices and meshlets in the level.
+     */
+    uint32_t vertexCount;
+    uint32_t indexCount;
+    uint32_t meshletCount;
+
+    /**
+     * The farthest any vertex moved when the level was simplified, in model units;
+     * 0 for the full mesh.
+     */
+    float error;
+
+    /**
+     * The offsets of the level's meshlet, vertex and index sections from the start
+     * of the model.
+     */
+    uint64_t meshletOffset;
+    uint64_t vertexOffset;
+    uint64_t indexOffset;
+
+    /**
+     * The end of the level's index section. Decoding this prefix of the model is
+     * enough to upload the level.
+     */
+    uint64_t endOffset;
+};
+
+/**
+ * A baked model vertex in LT_MODEL_VERTEX_FORMAT_FLOAT.
+ */
+struct LTModelVertex
+{
+    float position[3];
+    float normal[3];
+    float uv[2];
+};
+
+/**
+ * A baked model vertex in LT_MODEL_VERTEX_FORMAT_QUANTIZED.
+ */
+struct LTModelVertexQuantized
+{
+    /**
+     * The position within the model's bounds, 0 at boundsMin and 65535 at boundsMax.
+     * The fourth component is padding.
+     */
+    uint16_t position[4];
+
+    /**
+     * The unit normal, octahedral encoded.
+     */
+    int16_t normal[2];
+
+    /**
+     * The texture coordinate as half floats.
+     */
+    uint16_t uv[2];
+};
+
+/**
+ * A cluster of at most 64 vertices and 124 triangles, stored as a contiguous range
+ * of its level of detail's indices, with the bounds to cull it by.
+ */
+struct LTModelMeshlet
+{
+    /**
+     * The bounding sphere of the meshlet's vertices, in model space.
+     */
+    float center[3];
+    float radius;
+
+    /**
+     * The cone containing every triangle normal. The meshlet faces away from a camera
+     * at eye when dot(normalize(coneApex - eye), coneAxis) > coneCutoff. A zero axis
+     * disables the test.
+     */
+    float coneApex[3];
+    float coneCutoff;
+    float coneAxis[3];
+
+    /**
+     * The number of unique vertices the meshlet references.
+     */
+    uint32_t vertexCount;
+
+    /**
+     * The range of its level of detail's indices the meshlet draws.
+     */
+    uint32_t firstIndex;
+    uint32_t indexCount;
+    uint32_t reserved[2];
+};
+
+/**
+ * Turns a model's stored positions into model space: position * scale + offset.
+ * Identity for float vertices; for quantized vertices, offset is boundsMin and
+ * scale is the size of the bounds. Shaders apply it unconditionally.
+ */
+struct LTModelVertexDecode
+{
+    float positionScale[3];
+    float positionOffset[3];
+};
+
+static_assert(sizeof(LTModelHeader) == 48, "LTModelHeader must match ContentTools/model.py");
+static_assert(sizeof(LTModelLOD) == 48, "LTModelLOD must match ContentTools/model.py");
+static_assert(sizeof(LTModelVertex) == 32, "LTModelVertex must match ContentTools/model.py");
+static_assert(sizeof(LTModelVertexQuantized) == 16, "LTModelVertexQuantized must match ContentTools/model.py");
+static_assert(sizeof(LTModelMeshlet) == 64, "LTModelMeshlet must match ContentTools/model.py");
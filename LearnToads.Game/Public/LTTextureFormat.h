@@ -0,0 +1,123 @@
+#pragma once
+
+#include "PrecompiledHeader.h"
+
+/**
+ * Identifies a baked texture ("LTTX", little-endian).
+ */
+constexpr uint32_t LT_TEXTURE_MAGIC = 0x5854544C;
+
+/**
+ * The baked texture layout version; bumped whenever the header or mip layout changes.
+ */
+constexpr uint32_t LT_TEXTURE_VERSION = 1;
+
+/**
+ * The most mip levels a baked texture has, enough for a 32768x32768 image.
+ */
+constexpr uint32_t LT_TEXTURE_MAX_MIPS = 16;
+
+/**
+ * The block compression format of a baked texture. Every format stores 4x4 texel
+ * blocks.
+ */
+enum class LTTextureFormat : uint32_t
+{
+    /**
+     * Opaque RGB, 8 bytes per block.
+     */
+    LT_TEXTURE_FORMAT_BC1 = 0x0,
+
+    /**
+     * RGB with separately interpolated alpha, 16 bytes per block.
+     */
+    LT_TEXTURE_FORMAT_BC3 = 0x1,
+
+    /**
+     * Two independent channels, 16 bytes per block; used for the x and y of normal
+     * maps, whose z is reconstructed in the shader.
+     */
+    LT_TEXTURE_FORMAT_BC5 = 0x2,
+
+    /**
+     * High quality RGBA, 16 bytes per block.
+     */
+    LT_TEXTURE_FORMAT_BC7 = 0x3,
+
+    LT_TEXTURE_FORMAT_COUNT = 0x4
+};
+
+/**
+ * Flags describing how a baked texture's texels are interpreted.
+ */
+enum LTTextureFlags : uint32_t
+{
+    /**
+     * The color channels are sRGB encoded; alpha is always linear.
+     */
+    LT_TEXTURE_FLAG_SRGB = 0x1
+};
+
+/**
+ * The header at the start of a baked texture.
+ *
+ * Layout: header, then mipCount LTTextureMip records (mip 0, the full image, first),
+ * then the blocks of each mip level from the smallest to the largest, as KTX2 stores
+ * them. A prefix of the texture therefore holds every level smaller than the one
+ * it ends with. The levels are written by ContentTools/texture.py ready to be copied
+ * straight into an image.
+ */
+struct LTTextureHeader
+{
+    uint32_t magic;
+    uint32_t version;
+
+    /**
+     * The LTTextureFormat of every level.
+     */
+    uint32_t format;
+
+    /**
+     * LTTextureFlags.
+     */
+    uint32_t flags;
+
+    /**
+     * The size of mip 0 in texels.
+     */
+    uint32_t width;
+    uint32_t height;
+
+    /**
+     * The number of mip levels, down to 1x1 and at most LT_TEXTURE_MAX_MIPS.
+     */
+    uint32_t mipCount;
+    uint32_t reserved;
+};
+
+/**
+ * Where one mip level of a baked texture is stored.
+ */
+struct LTTextureMip
+{
+    /**
+     * The size of the level in texels; partial blocks at the edges are padded.
+     */
+    uint32_t width;
+    uint32_t height;
+
+    /**
+     * The bytes in one row of blocks.
+     */
+    uint32_t rowPitch;
+    uint32_t reserved;
+
+    /**
+     * The offset of the level's blocks from the start of the texture, and their size.
+     */
+    uint64_t offset;
+    uint64_t size;
+};
+
+static_assert(sizeof(LTTextureHeader) == 32, "LTTextureHeader must match ContentTools/texture.py");
+static_assert(sizeof(LTTextureMip) == 32, "LTTextureMip must match ContentTools/texture.py");
@@ -0,0 +1,197 @@
+#pragma once
+
+#include "PrecompiledHeader.h"
+
+#include <vulkan/vulkan.h>
+
+#include "LTJobQueue.h"
+
+class LTVKDevice;
+
+/**
+ * Records one task of a parallel recording into the secondary command buffer it is
+ * given, which has the viewport and scissor set. Called on any of the recording
+ * threads, so it may only touch what is safe to read from several threads at once.
+ */
+using LTVKRecordCallback = std::function<void(VkCommandBuffer, uint32_t)>;
+
+/**
+ * The command pool one thread records into for one frame in flight, and the
+ * secondary command buffers allocated from it. Only the owning thread records into
+ * the pool, so it needs no lock; padded so threads do not false share their counts.
+ */
+struct alignas(LT_CACHE_LINE_SIZE) LTVKThreadCommands
+{
+    VkCommandPool commandPool = VK_NULL_HANDLE;
+    eastl::vector<VkCommandBuffer> commandBuffers;
+
+    /**
+     * The command buffers handed out since the pool was last reset.
+     */
+    uint32_t usedCount = 0;
+};
+
+/**
+ * Records secondary command buffers for a render pass on worker threads.
+ *
+ * Every worker, and the main thread, has a command pool of its own for each frame
+ * in flight, reset as a whole when the frame's resources come round again rather
+ * than buffer by buffer. Record splits a pass into tasks that the threads take in
+ * turn and returns their command buffers in task order, so the draws are executed
+ * in the same order whichever thread recorded them. Record and ResetFrame are
+ * called from the main thread only.
+ */
+class LTVKCommandRecorder
+{
+    /**
+     * Fields
+     */
+private:
+    LTVKDevice* m_LTVKDevice;
+    VkDevice m_Device;
+
+    /**
+     * The pools of every thread for every frame in flight, indexed by
+     * frameIndex * threadCount + threadIndex; the main thread is the last thread.
+     */
+    eastl::vector<LTVKThreadCommands> m_ThreadCommands;
+    uint32_t m_FramesInFlight;
+    uint32_t m_ThreadCount;
+
+    /**
+     * The frame in flight being recorded.
+     */
+    uint32_t m_FrameIndex;
+
+    eastl::vector<std::thread*> m_RecordThreads;
+    bool m_IsRunning;
+
+    /**
+     * The recording in progress: a new one starts each time the number changes. The
+     * workers copy its description under the mutex when they join it.
+     */
+    uint64_t m_RecordingNumber;
+    const LTVKRecordCallback* m_Record;
+    VkCommandBufferInheritanceInfo m_Inheritance;
+    VkExtent2D m_Extent;
+    uint32_t m_TaskCount;
+
+    /**
+     * The next task to be taken, and the command buffer each task was recorded into.
+     */
+    std::atomic<uint32_t> m_NextTask;
+    eastl::vector<VkCommandBuffer> m_TaskCommandBuffers;
+
+    /**
+     * The workers taking tasks from the recording in progress. Once it is 0 and the
+     * main thread has run out of tasks, every task has been recorded.
+     */
+    uint32_t m_ActiveWorkerCount;
+
+    /**
+     * Recordings and tasks recorded, and the wall time spent in Record.
+     */
+    uint32_t m_RecordingCount;
+    uint32_t m_RecordedTaskCount;
+    std::chrono::nanoseconds m_RecordTime;
+
+    /**
+     * The mutex for controlling access to the recording in progress, the condition
+     * signalled when one starts, and the one signalled when the last worker leaves it.
+     */
+    std::mutex m_Mutex;
+    std::condition_variable m_RecordingCondition;
+    std::condition_variable m_FinishedCondition;
+
+    /**
+     * Constructors
+     */
+public:
+    LTVKCommandRecorder() :
+        m_LTVKDevice(nullptr),
+        m_Device(VK_NULL_HANDLE),
+        m_FramesInFlight(0),
+        m_ThreadCount(0),
+        m_FrameIndex(0),
+        m_IsRunning(false),
+        m_RecordingNumber(0),
+        m_Record(nullptr),
+        m_Inheritance(),
+        m_Extent(),
+        m_TaskCount(0),
+        m_NextTask(0),
+        m_ActiveWorkerCount(0),
+        m_RecordingCount(0),
+        m_RecordedTaskCount(0),
+        m_RecordTime(0)
+    {
+    }
+
+    // non-copyable
+    LTVKCommandRecorder(const LTVKCommandRecorder&) = delete;
+    void operator=(const LTVKCommandRecorder&) = delete;
+
+    /**
+     * Methods
+     */
+public:
+
+    /**
+     * Creates the command pools and starts the workers. With a worker count of 0,
+     * one is started for every hardware thread but the main thread's.
+     */
+    bool Initialize(LTVKDevice* ltvkDevice, uint32_t framesInFlight, uint32_t workerCount = 0);
+
+    /**
+     * Stops the workers and destroys the command pools. The frames recorded must
+     * have completed.
+     */
+    void Destroy();
+
+    /**
+     * Resets every thread's pool for a frame in flight, once the frame that last
+     * used it has completed.
+     */
+    void ResetFrame(uint32_t frameIndex);
+
+    /**
+     * Records taskCount tasks into secondary command buffers that continue the given
+     * subpass, on the workers and the calling thread, and waits for them all. The
+     * command buffers are appended to outCommandBuffers in task order.
+     */
+    void Record(
+        const VkCommandBufferInheritanceInfo& inheritance,
+        VkExtent2D extent,
+        uint32_t taskCount,
+        const LTVKRecordCallback& record,
+        eastl::vector<VkCommandBuffer>& outCommandBuffers);
+
+    /**
+     * Prints the threads recording, and the tasks recorded against the time it took.
+     */
+    void PrintStats();
+
+    inline uint32_t GetThreadCount() const
+    {
+        return m_ThreadCount;
+    }
+
+private:
+
+    void RecordThread(uint32_t threadIndex);
+
+    /**
+     * Takes tasks from the recording in progress until there are none left.
+     */
+    void RecordTasks(
+        LTVKThreadCommands& threadCommands,
+        const LTVKRecordCallback& record,
+        const VkCommandBufferInheritanceInfo& inheritance,
+        VkExtent2D extent,
+        uint32_t taskCount);
+
+    /**
+     * Hands out the next unused command buffer of a pool, allocating one if all are used.
+     */
+    VkCommandBuffer AcquireCommandBuffer(LTVKThreadCommands& threadCommands);
+};
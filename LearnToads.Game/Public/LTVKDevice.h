@@ -1,9 +1,17 @@
 #pragma once
 
+#include <atomic>
+#include <chrono>
+#include <mutex>
 #include <string>
 #include <vector>
 #include <vulkan/vulkan_core.h>
 
+#include "LTVKMemoryAllocator.h"
+#include "LTVKUploadManager.h"
+#include "LTVKGeometryArena.h"
+#include "LTVKPipelineManager.h"
+
 struct LTVKSwapChainSupportDetails {
     VkSurfaceCapabilitiesKHR capabilities;
     std::vector<VkSurfaceFormatKHR> formats;
@@ -13,11 +21,19 @@ struct LTVKSwapChainSupportDetails {
 struct LTVKQueueFamilyIndices {
     uint32_t graphicsFamily;
     uint32_t presentFamily;
+    // a transfer-only family when the device has one, otherwise the graphics family
+    uint32_t transferFamily;
     bool graphicsFamilyHasValue = false;
     bool presentFamilyHasValue = false;
     bool isComplete() { return graphicsFamilyHasValue && presentFamilyHasValue; }
 };
 
+// where compiled pipelines are kept between runs, next to the built content
+constexpr const char* LT_VK_PIPELINE_CACHE_PATH = "Build/pipeline.cache";
+
+// how often UpdatePipelineCache writes newly compiled pipelines to disk
+constexpr std::chrono::seconds LT_VK_PIPELINE_CACHE_SAVE_INTERVAL(30);
+
 #ifdef NDEBUG
 #define LTVK_ENABLE_VALIDATION_LAYERS 0
 #else
@@ -33,12 +49,53 @@ private:
     class LTGameWindow& m_Window;
     VkCommandPool m_CommandPool;
 
+    // guards m_CommandPool between Begin/EndSingleTimeCommands, which can be called
+    // from worker threads
+    std::mutex m_SingleTimeCommandsMutex;
+
+    // guards submissions to m_GraphicsQueue, which the upload manager shares when
+    // the device has no transfer queue family
+    std::mutex m_GraphicsQueueMutex;
+
     VkDevice m_Device;
     VkSurfaceKHR m_Surface;
     VkQueue m_GraphicsQueue;
     VkQueue m_PresentQueue;
+    VkQueue m_TransferQueue;
+    LTVKQueueFamilyIndices m_QueueFamilies;
     VkPhysicalDeviceProperties m_Properties;
 
+    // the features the device was created with, including the optional ones it supports
+    VkPhysicalDeviceFeatures m_EnabledFeatures = {};
+
+    // sub-allocates the memory of every buffer and image the device creates
+    LTVKMemoryAllocator m_MemoryAllocator;
+
+    // streams data into device-local buffers and images on the transfer queue
+    LTVKUploadManager m_UploadManager;
+
+    // the vertex and index buffers every model level of detail is placed in
+    LTVKGeometryArena m_GeometryArena;
+
+    // every pipeline is created through this cache, which is loaded from
+    // LT_VK_PIPELINE_CACHE_PATH at startup so pipelines compiled by an earlier run
+    // are not compiled again
+    VkPipelineCache m_PipelineCache = VK_NULL_HANDLE;
+    size_t m_PipelineCacheLoadedBytes = 0;
+
+    // guards writing the cache to disk
+    std::mutex m_PipelineCacheSaveMutex;
+    std::chrono::steady_clock::time_point m_PipelineCacheSaveTime;
+
+    // pipelines created since the cache was last saved, and the time spent creating
+    // every pipeline this run
+    std::atomic<uint32_t> m_PipelinesSinceSave = 0;
+    std::atomic<uint32_t> m_PipelineCount = 0;
+    std::atomic<uint64_t> m_PipelineCreateNs = 0;
+
+    // compiles pipelines on worker threads through the cache, once per distinct config
+    LTVKPipelineManager m_PipelineManager;
+
     const std::vector<const char*> m_ValidationLayers = { "VK_LAYER_KHRONOS_validation" };
     const std::vector<const char*> m_DeviceExtensions = { VK_KHR_SWAPCHAIN_EXTENSION_NAME };
 
@@ -62,6 +119,15 @@ public:
     VkSurfaceKHR GetSurface() { return m_Surface; }
     VkQueue GetGraphicsQueue() { return m_GraphicsQueue; }
     VkQueue GetPresentQueue() { return m_PresentQueue; }
+    VkQueue GetTransferQueue() { return m_TransferQueue; }
+    const LTVKQueueFamilyIndices& GetQueueFamilies() { return m_QueueFamilies; }
+    const VkPhysicalDeviceProperties& GetProperties() { return m_Properties; }
+    const VkPhysicalDeviceFeatures& GetEnabledFeatures() { return m_EnabledFeatures; }
+    LTVKMemoryAllocator& GetMemoryAllocator() { return m_MemoryAllocator; }
+    LTVKUploadManager& GetUploadManager() { return m_UploadManager; }
+    LTVKGeometryArena& GetGeometryArena() { return m_GeometryArena; }
+    VkPipelineCache GetPipelineCache() { return m_PipelineCache; }
+    LTVKPipelineManager& GetPipelineManager() { return m_PipelineManager; }
 
     LTVKSwapChainSupportDetails GetSwapChainSupport()
     {
@@ -80,17 +146,38 @@ public:
         VkImageTiling tiling,
         VkFormatFeatureFlags features);
 
+    // throws when the buffer cannot be created or its memory allocated
     void CreateBuffer(
         VkDeviceSize size,
         VkBufferUsageFlags usage,
         VkMemoryPropertyFlags properties,
         VkBuffer& buffer,
-        VkDeviceMemory& bufferMemory);
+        LTVKAllocation& bufferAllocation);
+
+    // as CreateBuffer, but returns false instead of throwing and leaves nothing
+    // behind; for worker threads, whose jobs fail rather than the process
+    bool TryCreateBuffer(
+        VkDeviceSize size,
+        VkBufferUsageFlags usage,
+        VkMemoryPropertyFlags properties,
+        VkBuffer& buffer,
+        LTVKAllocation& bufferAllocation);
 
+    // destroys a buffer from CreateBuffer and frees its memory; null buffers are ignored
+    void DestroyBuffer(VkBuffer& buffer, LTVKAllocation& bufferAllocation);
+
+    // the command buffer must be ended with EndSingleTimeCommands on the same thread
     VkCommandBuffer BeginSingleTimeCommands();
 
+    // submits the commands and waits for them alone, not for the rest of the queue
     void EndSingleTimeCommands(VkCommandBuffer commandBuffer);
 
+    // submits to a queue of the device; safe to call from any thread
+    VkResult QueueSubmit(VkQueue queue, const VkSubmitInfo& submitInfo, VkFence fence);
+
+    // presents on the present queue, which may be the graphics queue
+    VkResult QueuePresent(const VkPresentInfoKHR& presentInfo);
+
     void CopyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size);
 
     void CopyBufferToImage(
@@ -98,13 +185,63 @@ public:
         VkImage image,
         uint32_t width,
         uint32_t height,
-        uint32_t layerCount);
+        uint32_t layerCount,
+        uint32_t mipLevel = 0,
+        VkDeviceSize bufferOffset = 0);
+
+    // records the copy into a command buffer from BeginSingleTimeCommands, so the
+    // levels of an image can be copied in one submission
+    void CopyBufferToImage(
+        VkCommandBuffer commandBuffer,
+        VkBuffer buffer,
+        VkImage image,
+        uint32_t width,
+        uint32_t height,
+        uint32_t layerCount,
+        uint32_t mipLevel,
+        VkDeviceSize bufferOffset);
 
+    // records a barrier moving the image's first mipCount levels between layouts;
+    // supports UNDEFINED -> TRANSFER_DST_OPTIMAL -> SHADER_READ_ONLY_OPTIMAL
+    void TransitionImageLayout(
+        VkCommandBuffer commandBuffer,
+        VkImage image,
+        uint32_t mipCount,
+        VkImageLayout oldLayout,
+        VkImageLayout newLayout);
+
+    // throws when the image cannot be created or its memory allocated and bound
     void CreateImageWithInfo(
         const VkImageCreateInfo& imageInfo,
         VkMemoryPropertyFlags properties,
         VkImage& image,
-        VkDeviceMemory& imageMemory);
+        LTVKAllocation& imageAllocation);
+
+    // as CreateImageWithInfo, but returns false instead of throwing and leaves
+    // nothing behind
+    bool TryCreateImageWithInfo(
+        const VkImageCreateInfo& imageInfo,
+        VkMemoryPropertyFlags properties,
+        VkImage& image,
+        LTVKAllocation& imageAllocation);
+
+    // destroys an image from CreateImageWithInfo and frees its memory; null images are ignored
+    void DestroyImage(VkImage& image, LTVKAllocation& imageAllocation);
+
+    // records how long a pipeline took to create through the pipeline cache
+    void RecordPipelineCreation(std::chrono::nanoseconds duration);
+
+    // writes the pipeline cache to disk if pipelines were created since it was last
+    // written; safe to call from any thread
+    bool SavePipelineCache();
+
+    // saves the pipeline cache at most once every LT_VK_PIPELINE_CACHE_SAVE_INTERVAL,
+    // so a crash loses little; call once a frame
+    void UpdatePipelineCache();
+
+    // prints how many pipelines were created, how long they took and how much of
+    // the cache came from disk
+    void PrintPipelineStats();
 
 private:
     bool Initialize_CreateInstance();
@@ -113,6 +250,15 @@ private:
     bool Initialize_PickPhysicalDevice();
     bool Initialize_CreateLogicalDevice();
     bool Initialize_CreateCommandPool();
+    bool Initialize_CreateMemoryAllocator();
+    bool Initialize_CreateUploadManager();
+    bool Initialize_CreateGeometryArena();
+    bool Initialize_CreatePipelineCache();
+    bool Initialize_CreatePipelineManager();
+
+    // reads the cache saved by an earlier run; false if there is none or it was
+    // written for a different device or driver
+    bool LoadPipelineCacheData(std::vector<uint8_t>& outData);
 
     // helper functions
     bool IsDeviceSuitable(VkPhysicalDevice device);
@@ -0,0 +1,136 @@
+#pragma once
+
+#include "PrecompiledHeader.h"
+
+#include <mutex>
+#include <vulkan/vulkan.h>
+
+#include "LTVKMemoryAllocator.h"
+
+class LTVKDevice;
+
+/**
+ * The size of the vertex buffer and of the index buffer every model level of detail
+ * is placed in.
+ */
+constexpr VkDeviceSize LT_VK_GEOMETRY_ARENA_VERTEX_BYTES = 64ull * 1024 * 1024;
+constexpr VkDeviceSize LT_VK_GEOMETRY_ARENA_INDEX_BYTES = 32ull * 1024 * 1024;
+
+/**
+ * A range of the arena's vertex or index buffer.
+ */
+struct LTVKGeometryRange
+{
+    uint32_t range = LT_VK_NO_RANGE;
+    VkDeviceSize offset = 0;
+    VkDeviceSize size = 0;
+};
+
+/**
+ * One device-local vertex buffer and one index buffer that the vertices and indices
+ * of every model level of detail are sub-allocated from.
+ *
+ * With every mesh in the same two buffers, draws of different meshes only differ in
+ * their first vertex and first index, so they can be issued together by a single
+ * indirect draw rather than one per mesh with the buffers bound in between. Ranges
+ * of the vertex buffer start at a multiple of the vertex stride, so each starts at
+ * a whole vertex, and ranges of the index buffer at a multiple of the index size.
+ *
+ * Allocating and freeing may be called from any thread. A full arena fails the
+ * allocation rather than growing, since the buffers are bound by frames in flight.
+ */
+class LTVKGeometryArena
+{
+    /**
+     * Fields
+     */
+private:
+    LTVKDevice* m_LTVKDevice;
+
+    VkBuffer m_VertexBuffer;
+    LTVKAllocation m_VertexAllocation;
+    VkBuffer m_IndexBuffer;
+    LTVKAllocation m_IndexAllocation;
+
+    /**
+     * Guards the sub-allocators, and the ranges of each buffer handed out.
+     */
+    std::mutex m_Mutex;
+    LTVKTlsfAllocator m_VertexRanges;
+    LTVKTlsfAllocator m_IndexRanges;
+
+    /**
+     * Allocations that did not fit, and the most bytes of each buffer in use at once.
+     */
+    uint32_t m_FailedCount;
+    VkDeviceSize m_PeakVertexBytes;
+    VkDeviceSize m_PeakIndexBytes;
+
+    /**
+     * Constructors
+     */
+public:
+    LTVKGeometryArena() :
+        m_LTVKDevice(nullptr),
+        m_VertexBuffer(VK_NULL_HANDLE),
+        m_IndexBuffer(VK_NULL_HANDLE),
+        m_FailedCount(0),
+        m_PeakVertexBytes(0),
+        m_PeakIndexBytes(0)
+    {
+    }
+
+    // non-copyable
+    LTVKGeometryArena(const LTVKGeometryArena&) = delete;
+    void operator=(const LTVKGeometryArena&) = delete;
+
+    /**
+     * Methods
+     */
+public:
+
+    /**
+     * Creates the vertex and index buffers, filled through the upload manager.
+     */
+    bool Initialize(LTVKDevice* ltvkDevice);
+
+    /**
+     * Destroys the buffers. Nothing drawn from them may still be in flight.
+     */
+    void Destroy();
+
+    /**
+     * Allocates a range of the vertex buffer for vertices of a stride, starting at a
+     * multiple of it; false when the arena has no room for it.
+     */
+    bool AllocateVertices(VkDeviceSize size, uint32_t stride, LTVKGeometryRange& outRange);
+
+    /**
+     * Allocates a range of the index buffer for indices of 2 or 4 bytes; false when
+     * the arena has no room for it.
+     */
+    bool AllocateIndices(VkDeviceSize size, uint32_t indexSize, LTVKGeometryRange& outRange);
+
+    /**
+     * Frees a range from AllocateVertices or AllocateIndices and resets it; empty
+     * ranges are ignored. Nothing drawn from it may still be in flight.
+     */
+    void FreeVertices(LTVKGeometryRange& range);
+    void FreeIndices(LTVKGeometryRange& range);
+
+    /**
+     * Prints the bytes of each buffer in use, the peak, how fragmented they are and
+     * the allocations that did not fit.
+     */
+    void PrintStats();
+
+    inline VkBuffer GetVertexBuffer() const
+    {
+        return m_VertexBuffer;
+    }
+
+    inline VkBuffer GetIndexBuffer() const
+    {
+        return m_IndexBuffer;
+    }
+};
@@ -0,0 +1,329 @@
+#pragma once
+
+#include "PrecompiledHeader.h"
+
+#include <vulkan/vulkan.h>
+
+#include "LTVKMemoryAllocator.h"
+#include "LTMeshletCulling.h"
+
+class LTVKDevice;
+class LTModel;
+
+/**
+ * The instances each frame's buffer holds before it first has to grow.
+ */
+constexpr uint32_t LT_VK_INSTANCE_INITIAL_CAPACITY = 1024;
+
+/**
+ * The model to world transform of one instance: the top three rows of the matrix,
+ * the bottom row being 0, 0, 0, 1. Must match InstanceTransform in instanced.vert.
+ */
+struct LTVKInstanceTransform
+{
+    float rows[3][4];
+};
+
+static_assert(sizeof(LTVKInstanceTransform) == 48, "LTVKInstanceTransform must match instanced.vert");
+
+/**
+ * The push constants of the instance pipeline layout. Must match PushConstants in
+ * instanced.vert.
+ */
+struct LTVKInstancePushConstants
+{
+    glm::mat4 viewProjection;
+
+    /**
+     * The model's LTModelVertexDecode; the w of the scale is 1 when the model's
+     * normals are octahedral encoded.
+     */
+    float positionScale[4];
+    float positionOffset[4];
+};
+
+/**
+ * Every instance of one model level of detail drawn with one pipeline in a frame.
+ */
+struct LTVKInstanceBatch
+{
+    VkPipeline pipeline = VK_NULL_HANDLE;
+    const LTModel* model = nullptr;
+    uint32_t lod = 0;
+
+    /**
+     * The transforms added this frame; kept between frames so the storage is reused.
+     */
+    eastl::vector<LTVKInstanceTransform> transforms;
+
+    /**
+     * With a camera set, the meshlets of the level any instance sees, a mask per
+     * block of four as marked by LTMeshletCulling; empty draws the whole level.
+     */
+    eastl::vector<uint8_t> meshletMasks;
+
+    /**
+     * The batch's draw commands, one per range of visible meshlets, written by Prepare.
+     */
+    uint32_t firstCommand = 0;
+    uint32_t commandCount = 0;
+};
+
+/**
+ * The batches of one pipeline and model in a frame, drawn together. Their commands
+ * are next to each other in the indirect buffer, and every level of detail is in
+ * the geometry arena, so they are issued by one indirect draw.
+ */
+struct LTVKInstanceDraw
+{
+    VkPipeline pipeline = VK_NULL_HANDLE;
+    const LTModel* model = nullptr;
+    uint32_t firstCommand = 0;
+    uint32_t commandCount = 0;
+};
+
+/**
+ * The buffers of one frame in flight, reused every framesInFlight frames.
+ */
+struct LTVKInstanceFrame
+{
+    /**
+     * The transforms of every batch, one batch after another, read by the vertex
+     * shader through the descriptor set. Host visible and mapped for as long as it
+     * lives.
+     */
+    VkBuffer instanceBuffer = VK_NULL_HANDLE;
+    LTVKAllocation instanceAllocation;
+    uint32_t instanceCapacity = 0;
+
+    /**
+     * A VkDrawIndexedIndirectCommand per range of visible meshlets of each batch,
+     * host visible and mapped.
+     */
+    VkBuffer indirectBuffer = VK_NULL_HANDLE;
+    LTVKAllocation indirectAllocation;
+    uint32_t commandCapacity = 0;
+
+    /**
+     * Points at the frame's instance buffer and at the texture view it samples.
+     */
+    VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+    VkImageView textureView = VK_NULL_HANDLE;
+};
+
+/**
+ * Draws many copies of the same models with a draw call per model rather than per
+ * copy.
+ *
+ * Instances are grouped into batches by pipeline, model and level of detail as they
+ * are added. Prepare writes the transforms of each batch next to each other in the
+ * frame's instance buffer and a VkDrawIndexedIndirectCommand for each batch, whose
+ * first instance is where its transforms start and whose first vertex and index are
+ * where its level is in the device's geometry arena. Batches are drawn sorted by
+ * pipeline, then by model; the arena's buffers are bound once, and with
+ * multiDrawIndirect the commands of every level of a model under a pipeline are
+ * issued by one indirect draw. Thousands of projectiles sharing a model, at any
+ * mix of levels, cost one draw. Each model takes a draw of its own, since its vertex
+ * decode is pushed as constants.
+ *
+ * Every instance samples the texture set for the frame; a frame draws nothing until
+ * one is set.
+ *
+ * With a camera set, each instance is culled by its model's meshlets as it is added:
+ * an instance none of whose meshlets is in view is dropped, and a batch draws only
+ * the meshlets at least one of its instances sees, with a command per run of them
+ * in the index buffer.
+ *
+ * The buffers of a frame in flight are only written after the renderer has waited
+ * for the frame that last used them, and grow when a frame has more instances or
+ * batches than they hold. Call from the main thread only, except Draw.
+ */
+class LTVKInstanceBatcher
+{
+    /**
+     * Fields
+     */
+private:
+    LTVKDevice* m_LTVKDevice;
+    VkDevice m_Device;
+
+    /**
+     * One storage buffer of transforms for the vertex stage and one texture for the
+     * fragment stage, plus the push constants.
+     */
+    VkDescriptorSetLayout m_DescriptorSetLayout;
+    VkPipelineLayout m_PipelineLayout;
+    VkDescriptorPool m_DescriptorPool;
+    VkSampler m_Sampler;
+
+    eastl::vector<LTVKInstanceFrame> m_Frames;
+
+    /**
+     * The frame being batched, between BeginFrame and the next BeginFrame.
+     */
+    LTVKInstanceFrame* m_CurrentFrame;
+
+    /**
+     * The batches of the frame, and the one instances were last added to, which the
+     * next instance most likely belongs to as well.
+     */
+    eastl::vector<LTVKInstanceBatch> m_Batches;
+    uint32_t m_LastBatch;
+
+    /**
+     * The batches with instances, in the order they are drawn, and the command of
+     * each. The commands are kept for devices that cannot take the first instance
+     * from the indirect buffer, which draw them directly.
+     */
+    eastl::vector<uint32_t> m_DrawOrder;
+    eastl::vector<VkDrawIndexedIndirectCommand> m_Commands;
+
+    /**
+     * The batches of each pipeline and model, in the order they are drawn.
+     */
+    eastl::vector<LTVKInstanceDraw> m_Draws;
+
+    /**
+     * Whether the device takes each draw's first instance from the indirect buffer,
+     * whether one indirect draw may issue many commands, and how many at most.
+     */
+    bool m_UseIndirectDraws;
+    bool m_UseMultiDrawIndirect;
+    uint32_t m_MaxDrawIndirectCount;
+
+    /**
+     * The camera instances are culled against, while m_IsCulling, and the ranges of
+     * a batch's visible meshlets, kept for their storage.
+     */
+    glm::mat4 m_ViewProjection;
+    glm::vec3 m_CameraPosition;
+    bool m_IsCulling;
+    eastl::vector<LTMeshletDrawRange> m_Ranges;
+
+    /**
+     * Frames prepared, the instances and batches drawn, the instances culled, the
+     * draw commands written, the draw calls they were issued by, and the times a
+     * frame's buffers grew.
+     */
+    uint64_t m_FrameCount;
+    uint64_t m_InstanceCount;
+    uint64_t m_BatchCount;
+    uint64_t m_CulledInstanceCount;
+    uint64_t m_CommandCount;
+    uint64_t m_DrawCallCount;
+    uint32_t m_GrowCount;
+
+    /**
+     * Constructors
+     */
+public:
+    LTVKInstanceBatcher() :
+        m_LTVKDevice(nullptr),
+        m_Device(VK_NULL_HANDLE),
+        m_DescriptorSetLayout(VK_NULL_HANDLE),
+        m_PipelineLayout(VK_NULL_HANDLE),
+        m_DescriptorPool(VK_NULL_HANDLE),
+        m_Sampler(VK_NULL_HANDLE),
+        m_CurrentFrame(nullptr),
+        m_LastBatch(0),
+        m_UseIndirectDraws(false),
+        m_UseMultiDrawIndirect(false),
+        m_MaxDrawIndirectCount(1),
+        m_ViewProjection(1.0f),
+        m_CameraPosition(0.0f),
+        m_IsCulling(false),
+        m_FrameCount(0),
+        m_InstanceCount(0),
+        m_BatchCount(0),
+        m_CulledInstanceCount(0),
+        m_CommandCount(0),
+        m_DrawCallCount(0),
+        m_GrowCount(0)
+    {
+    }
+
+    // non-copyable
+    LTVKInstanceBatcher(const LTVKInstanceBatcher&) = delete;
+    void operator=(const LTVKInstanceBatcher&) = delete;
+
+    /**
+     * Methods
+     */
+public:
+
+    /**
+     * Creates the pipeline layout and the buffers of every frame in flight.
+     */
+    bool Initialize(LTVKDevice* ltvkDevice, uint32_t framesInFlight);
+
+    /**
+     * Destroys everything the batcher created. The frames drawn must have completed.
+     */
+    void Destroy();
+
+    /**
+     * Starts batching a frame, dropping the instances of the last one. Call once the
+     * renderer has begun the frame, so the GPU is done with the frame's buffers.
+     */
+    void BeginFrame(uint32_t frameIndex);
+
+    /**
+     * Culls the instances added after it against a camera, by their model's
+     * meshlets. Call after BeginFrame; frames without a camera are not culled.
+     */
+    void SetCamera(const glm::mat4& viewProjection, const glm::vec3& cameraPosition);
+
+    /**
+     * Sets the texture the frame's instances sample. Call after BeginFrame, with the
+     * view read once for the frame; it must stay valid until the frame has completed.
+     */
+    void SetTexture(VkImageView imageView);
+
+    /**
+     * Adds an instance of a model level of detail, drawn with a pipeline created
+     * with GetPipelineLayout and the model's vertex format. The level must stay
+     * resident until the frame has completed.
+     */
+    void AddInstance(VkPipeline pipeline, const LTModel* model, uint32_t lod, const glm::mat4& transform);
+
+    /**
+     * Writes the instances and draw commands of the frame to its buffers, growing
+     * them if needed. Call after the last AddInstance and before Draw.
+     */
+    void Prepare();
+
+    /**
+     * Records the frame's draws into a command buffer inside the render pass the
+     * pipelines were created for. Only reads what Prepare wrote, so it may be called
+     * from a recording thread.
+     */
+    void Draw(VkCommandBuffer commandBuffer, const glm::mat4& viewProjection) const;
+
+    /**
+     * Prints the instances drawn and culled per frame against the draw commands and
+     * draw calls they took.
+     */
+    void PrintStats();
+
+    inline VkPipelineLayout GetPipelineLayout() const
+    {
+        return m_PipelineLayout;
+    }
+
+private:
+
+    bool CreateLayouts(uint32_t framesInFlight);
+
+    /**
+     * Replaces a frame's instance or indirect buffer with one that holds at least the
+     * given count, and points the frame's descriptor set at the new instance buffer.
+     */
+    void GrowInstanceBuffer(LTVKInstanceFrame& frame, uint32_t instanceCount);
+    void GrowIndirectBuffer(LTVKInstanceFrame& frame, uint32_t commandCount);
+
+    /**
+     * Gets the batch of a pipeline, model and level of detail, adding it if the frame
+     * has none yet.
+     */
+    uint32_t FindBatch(VkPipeline pipeline, const LTModel* model, uint32_t lod);
+};
@@ -0,0 +1,390 @@
+#pragma once
+
+#include "PrecompiledHeader.h"
+
+#include <vulkan/vulkan.h>
+
+/**
+ * The size of the device memory blocks that resources are sub-allocated from. Heaps
+ * of a gigabyte or less use blocks of an eighth of the heap instead.
+ */
+constexpr VkDeviceSize LT_VK_MEMORY_BLOCK_SIZE = 64ull * 1024 * 1024;
+
+/**
+ * Each power of two size class of the TLSF allocator is split into 2^LT_VK_TLSF_SL_BITS
+ * linearly spaced bins.
+ */
+constexpr uint32_t LT_VK_TLSF_SL_BITS = 4;
+constexpr uint32_t LT_VK_TLSF_SL_COUNT = 1u << LT_VK_TLSF_SL_BITS;
+
+/**
+ * The number of power of two size classes, enough for any VkDeviceSize.
+ */
+constexpr uint32_t LT_VK_TLSF_FL_COUNT = 64 - LT_VK_TLSF_SL_BITS;
+
+/**
+ * The smallest range the TLSF allocator hands out; every offset and size in a block
+ * is a multiple of it.
+ */
+constexpr VkDeviceSize LT_VK_TLSF_MIN_SIZE = 1ull << LT_VK_TLSF_SL_BITS;
+
+/**
+ * Range index meaning no range.
+ */
+constexpr uint32_t LT_VK_NO_RANGE = UINT32_MAX;
+
+/**
+ * One range of a memory block, free or allocated. Ranges are linked to their
+ * neighbours in the block and, while free, to the other free ranges in their bin.
+ */
+struct LTVKMemoryRange
+{
+    VkDeviceSize offset = 0;
+    VkDeviceSize size = 0;
+
+    uint32_t prevPhysical = LT_VK_NO_RANGE;
+    uint32_t nextPhysical = LT_VK_NO_RANGE;
+
+    uint32_t prevFree = LT_VK_NO_RANGE;
+    uint32_t nextFree = LT_VK_NO_RANGE;
+
+    bool isFree = false;
+};
+
+/**
+ * A two-level segregated fit (TLSF) allocator for the ranges of one memory block.
+ *
+ * Free ranges are kept in bins by size: the first level is the power of two below
+ * the size, the second splits it linearly. A bitmap per level finds the smallest
+ * non-empty bin that fits a request in constant time, and freed ranges merge with
+ * free neighbours straight away, so allocation and free are both O(1).
+ */
+class LTVKTlsfAllocator
+{
+    /**
+     * Fields
+     */
+private:
+
+    /**
+     * Every range of the block, and the indices of the entries no longer in use.
+     */
+    eastl::vector<LTVKMemoryRange> m_Ranges;
+    eastl::vector<uint32_t> m_UnusedRanges;
+
+    /**
+     * The range at offset 0.
+     */
+    uint32_t m_FirstRange;
+
+    /**
+     * The first free range of each bin, and bitmaps of the non-empty bins.
+     */
+    uint32_t m_FreeHeads[LT_VK_TLSF_FL_COUNT][LT_VK_TLSF_SL_COUNT];
+    uint64_t m_FirstLevelBitmap;
+    uint32_t m_SecondLevelBitmaps[LT_VK_TLSF_FL_COUNT];
+
+    /**
+     * The size of the block, the bytes allocated from it and how many allocations.
+     */
+    VkDeviceSize m_Size;
+    VkDeviceSize m_UsedBytes;
+    uint32_t m_AllocationCount;
+
+    /**
+     * Constructors
+     */
+public:
+    LTVKTlsfAllocator() :
+        m_FirstRange(LT_VK_NO_RANGE),
+        m_FirstLevelBitmap(0),
+        m_SecondLevelBitmaps(),
+        m_Size(0),
+        m_UsedBytes(0),
+        m_AllocationCount(0)
+    {
+    }
+
+    /**
+     * Methods
+     */
+public:
+
+    /**
+     * Starts the allocator with the whole block free.
+     */
+    void Initialize(VkDeviceSize size);
+
+    /**
+     * Allocates an aligned range; false when no free range fits it.
+     */
+    bool Allocate(
+        VkDeviceSize size,
+        VkDeviceSize alignment,
+        uint32_t& outRange,
+        VkDeviceSize& outOffset);
+
+    /**
+     * Frees a range from Allocate, merging it with its free neighbours.
+     */
+    void Free(uint32_t range);
+
+    /**
+     * Gets the number of free ranges and the size of the largest.
+     */
+    void GetFreeRanges(uint32_t& outFreeRangeCount, VkDeviceSize& outLargestFreeRange) const;
+
+    inline VkDeviceSize GetSize() const
+    {
+        return m_Size;
+    }
+
+    inline VkDeviceSize GetUsedBytes() const
+    {
+        return m_UsedBytes;
+    }
+
+    inline uint32_t GetAllocationCount() const
+    {
+        return m_AllocationCount;
+    }
+
+private:
+
+    /**
+     * Gets the bin a free range of the given size belongs in.
+     */
+    static void GetBin(VkDeviceSize size, uint32_t& outFirstLevel, uint32_t& outSecondLevel);
+
+    /**
+     * Gets the first free range in the smallest bin whose ranges all hold the size.
+     */
+    uint32_t FindFree(VkDeviceSize size) const;
+
+    void InsertFree(uint32_t range);
+    void RemoveFree(uint32_t range);
+
+    /**
+     * Gets an unused range entry, growing the list if there is none.
+     */
+    uint32_t NewRange();
+    void ReleaseRange(uint32_t range);
+};
+
+/**
+ * A block of device memory that resources are sub-allocated from.
+ */
+struct LTVKMemoryBlock
+{
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+
+    /**
+     * The whole block, mapped for as long as it lives when its memory is host visible.
+     */
+    void* mappedData = nullptr;
+
+    LTVKTlsfAllocator ranges;
+};
+
+/**
+ * Memory bound to one buffer or image: a range of a block, or a dedicated allocation
+ * of its own.
+ */
+struct LTVKAllocation
+{
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    VkDeviceSize offset = 0;
+    VkDeviceSize size = 0;
+
+    /**
+     * The start of the allocation when its memory is host visible, otherwise null.
+     * Host-visible memory stays mapped, so this replaces vkMapMemory.
+     */
+    void* mappedData = nullptr;
+
+    /**
+     * The block and range the allocation came from; null for a dedicated allocation.
+     */
+    LTVKMemoryBlock* block = nullptr;
+    uint32_t range = LT_VK_NO_RANGE;
+
+    uint32_t memoryTypeIndex = 0;
+};
+
+/**
+ * Usage of one memory type.
+ */
+struct LTVKMemoryStats
+{
+    /**
+     * The blocks reserved and the bytes in them.
+     */
+    uint32_t blockCount = 0;
+    VkDeviceSize blockBytes = 0;
+
+    /**
+     * The ranges allocated from the blocks and their bytes.
+     */
+    uint32_t allocationCount = 0;
+    VkDeviceSize usedBytes = 0;
+
+    /**
+     * The free ranges in the blocks and the largest of them.
+     */
+    uint32_t freeRangeCount = 0;
+    VkDeviceSize largestFreeRange = 0;
+
+    /**
+     * The free bytes outside the largest free range of their block; an allocation
+     * as big as the free space of a block could not use them.
+     */
+    VkDeviceSize fragmentedBytes = 0;
+
+    /**
+     * The resources with memory of their own and their bytes.
+     */
+    uint32_t dedicatedCount = 0;
+    VkDeviceSize dedicatedBytes = 0;
+};
+
+/**
+ * Sub-allocates buffer and image memory from large blocks per memory type, rather
+ * than calling vkAllocateMemory for every resource; drivers cap the number of
+ * allocations (often at 4096) and each one is expensive.
+ *
+ * Buffers and images larger than half a block get a dedicated allocation. When the
+ * device's bufferImageGranularity is above 1, optimal-tiling images come from
+ * blocks of their own, so a buffer and an image never share a granularity page.
+ * Thread safe; the asset workers allocate concurrently.
+ */
+class LTVKMemoryAllocator
+{
+    /**
+     * Fields
+     */
+private:
+    VkDevice m_Device;
+    VkPhysicalDeviceMemoryProperties m_MemoryProperties;
+
+    /**
+     * The limits the allocations are laid out by.
+     */
+    VkDeviceSize m_BufferImageGranularity;
+    VkDeviceSize m_NonCoherentAtomSize;
+    uint32_t m_MaxAllocationCount;
+
+    /**
+     * The size of the blocks of each memory type.
+     */
+    VkDeviceSize m_BlockSizes[VK_MAX_MEMORY_TYPES];
+
+    /**
+     * The blocks of each memory type, for buffers and linear images, and for
+     * optimal-tiling images.
+     */
+    eastl::vector<LTVKMemoryBlock*> m_Blocks[VK_MAX_MEMORY_TYPES][2];
+
+    /**
+     * The dedicated allocations of each memory type, and their bytes.
+     */
+    uint32_t m_DedicatedCounts[VK_MAX_MEMORY_TYPES];
+    VkDeviceSize m_DedicatedBytes[VK_MAX_MEMORY_TYPES];
+
+    /**
+     * The number of live vkAllocateMemory allocations, blocks and dedicated.
+     */
+    uint32_t m_DeviceAllocationCount;
+
+    /**
+     * The mutex for controlling access to the blocks and counts.
+     */
+    std::mutex m_Mutex;
+
+    /**
+     * Constructors
+     */
+public:
+    LTVKMemoryAllocator() :
+        m_Device(VK_NULL_HANDLE),
+        m_MemoryProperties(),
+        m_BufferImageGranularity(1),
+        m_NonCoherentAtomSize(1),
+        m_MaxAllocationCount(0),
+        m_BlockSizes(),
+        m_DedicatedCounts(),
+        m_DedicatedBytes(),
+        m_DeviceAllocationCount(0)
+    {
+    }
+
+    /**
+     * Methods
+     */
+public:
+
+    /**
+     * Reads the device's memory types and limits and sizes the blocks of each type.
+     */
+    void Initialize(VkPhysicalDevice physicalDevice, VkDevice device);
+
+    /**
+     * Frees every block and dedicated allocation; call before the device is destroyed.
+     */
+    void Destroy();
+
+    /**
+     * Allocates memory meeting the requirements with the given properties. Images
+     * with VK_IMAGE_TILING_OPTIMAL must say so, for bufferImageGranularity.
+     */
+    bool Allocate(
+        const VkMemoryRequirements& requirements,
+        VkMemoryPropertyFlags properties,
+        bool isOptimalImage,
+        LTVKAllocation& outAllocation);
+
+    /**
+     * Frees an allocation and resets it; empty allocations are ignored.
+     */
+    void Free(LTVKAllocation& allocation);
+
+    /**
+     * Gets the usage of a memory type.
+     */
+    LTVKMemoryStats GetStats(uint32_t memoryTypeIndex);
+
+    /**
+     * Prints the usage and fragmentation of every memory type in use.
+     */
+    void PrintStats();
+
+private:
+
+    /**
+     * Gets the first memory type allowed by the bits that has every property.
+     */
+    bool FindMemoryType(
+        uint32_t typeBits,
+        VkMemoryPropertyFlags properties,
+        uint32_t& outMemoryTypeIndex) const;
+
+    /**
+     * Allocates device memory and maps it if it is host visible.
+     */
+    bool AllocateDeviceMemory(
+        uint32_t memoryTypeIndex,
+        VkDeviceSize size,
+        VkDeviceMemory& outMemory,
+        void*& outMappedData);
+
+    void FreeDeviceMemory(VkDeviceMemory memory);
+
+    /**
+     * Allocates from the blocks of a memory type, reserving a new block if none fits.
+     */
+    bool AllocateFromBlocks(
+        uint32_t memoryTypeIndex,
+        uint32_t pool,
+        VkDeviceSize size,
+        VkDeviceSize alignment,
+        LTVKAllocation& outAllocation);
+};
@@ -4,12 +4,19 @@
 
 class LTShader;
 class LTVKDevice;
+struct LTVKVertexFormat;
 
 /**
  * The configuration for describing a graphics pipeline in Vulkan.
  */
 struct LTVKPipelineConfig
 {
+    /**
+     * The layout of the vertex buffer the pipeline draws from; the vertex input state is
+     * derived from it. Null when the vertex shader generates its own vertices.
+     */
+    const LTVKVertexFormat* vertexFormat;
+
     /**
      * The input assembler, for purposes of generating geometry, describes how to interpret the list of vertices
      * that are given as input to the assembler. The assembler sees the input as a list of numbers
@@ -20,6 +27,8 @@ struct LTVKPipelineConfig
 
     /**
      * The viewport describes the transformation between the pipeline output and the target image.
+     * The viewport and scissor are dynamic state, so these only give their count; the renderer
+     * sets them for each frame.
      */
     VkViewport viewport;
 
@@ -66,6 +75,7 @@ struct LTVKPipelineConfig
     uint32_t subpass;
 
     LTVKPipelineConfig() :
+        vertexFormat(nullptr),
         inputAssemblyInfo({}),
         viewport({}),
         scissor({}),
@@ -133,10 +143,15 @@ public:
     bool Initialize(const LTVKPipelineConfig& config);
     void Destroy();
 
+    inline VkPipeline GetPipeline() const
+    {
+        return m_VkPipeline;
+    }
+
     /**
      * Gets the default pipeline configuration.
      */
-    void GetDefaultPipelineConfig(LTVKPipelineConfig& outConfig, uint32_t width, uint32_t height);
+    static void GetDefaultPipelineConfig(LTVKPipelineConfig& outConfig, uint32_t width, uint32_t height);
 };
 
 
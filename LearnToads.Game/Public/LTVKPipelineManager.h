@@ -0,0 +1,292 @@
+#pragma once
+
+#include "PrecompiledHeader.h"
+
+#include <vulkan/vulkan.h>
+
+#include "LTVKPipeline.h"
+#include "LTVKVertexFormat.h"
+
+class LTVKDevice;
+class LTShader;
+
+/**
+ * The number of hash buckets the pipeline entries are chained into.
+ */
+constexpr uint32_t LT_VK_PIPELINE_BUCKET_COUNT = 1024;
+
+/**
+ * Everything a graphics pipeline is created from, flattened out of an
+ * LTVKPipelineConfig and its shaders so it can be hashed, compared and kept after
+ * the config is gone. Keys are zeroed before they are filled, so two keys describe
+ * the same pipeline exactly when their bytes match. The viewport and scissor are
+ * dynamic state and not part of the key.
+ */
+struct LTVKPipelineKey
+{
+    /**
+     * The asset IDs of the shaders.
+     */
+    uint32_t vertexShaderID;
+    uint32_t fragmentShaderID;
+
+    /**
+     * A copy of the config's vertex format, valid when hasVertexFormat is set.
+     */
+    LTVKVertexFormat vertexFormat;
+    VkBool32 hasVertexFormat;
+
+    VkPrimitiveTopology topology;
+    VkBool32 primitiveRestartEnable;
+
+    VkBool32 depthClampEnable;
+    VkBool32 rasterizerDiscardEnable;
+    VkPolygonMode polygonMode;
+    VkCullModeFlags cullMode;
+    VkFrontFace frontFace;
+    VkBool32 depthBiasEnable;
+    float depthBiasConstantFactor;
+    float depthBiasClamp;
+    float depthBiasSlopeFactor;
+    float lineWidth;
+
+    VkSampleCountFlagBits rasterizationSamples;
+    VkBool32 sampleShadingEnable;
+    float minSampleShading;
+    VkBool32 alphaToCoverageEnable;
+    VkBool32 alphaToOneEnable;
+
+    VkPipelineColorBlendAttachmentState colorBlendAttachment;
+    VkBool32 logicOpEnable;
+    VkLogicOp logicOp;
+    float blendConstants[4];
+
+    VkBool32 depthTestEnable;
+    VkBool32 depthWriteEnable;
+    VkCompareOp depthCompareOp;
+    VkBool32 depthBoundsTestEnable;
+    VkBool32 stencilTestEnable;
+    VkStencilOpState front;
+    VkStencilOpState back;
+    float minDepthBounds;
+    float maxDepthBounds;
+
+    VkPipelineLayout pipelineLayout;
+    VkRenderPass renderPass;
+    uint32_t subpass;
+};
+
+/**
+ * Where a pipeline entry is in being compiled.
+ */
+enum class LTVKPipelineState : uint8_t
+{
+    LT_VK_PIPELINE_STATE_PENDING,
+    LT_VK_PIPELINE_STATE_READY,
+    LT_VK_PIPELINE_STATE_FAILED,
+};
+
+/**
+ * One distinct pipeline known to the manager. Entries live until the manager is
+ * destroyed, so a pointer to one is a stable handle to the pipeline.
+ */
+struct LTVKPipelineEntry
+{
+    LTVKPipelineKey key;
+    uint32_t hash;
+
+    /**
+     * The pipeline, valid once the state is ready.
+     */
+    LTVKPipeline pipeline;
+    std::atomic<LTVKPipelineState> state;
+
+    /**
+     * The next entry in the same hash bucket.
+     */
+    LTVKPipelineEntry* nextInBucket;
+
+    LTVKPipelineEntry(
+        LTVKDevice* device,
+        LTShader* vertexShader,
+        LTShader* fragmentShader) :
+        key(),
+        hash(0),
+        pipeline(device, vertexShader, fragmentShader),
+        state(LTVKPipelineState::LT_VK_PIPELINE_STATE_PENDING),
+        nextInBucket(nullptr)
+    {
+    }
+};
+
+/**
+ * Creates graphics pipelines on worker threads and never creates the same one twice.
+ *
+ * Requests are keyed by the full state of their LTVKPipelineConfig and the asset IDs
+ * of their shaders; a request matching an earlier one gets the earlier entry back.
+ * New pipelines are compiled by the workers in the order they were requested, and
+ * until an entry is ready GetPipeline hands back the placeholder pipeline instead,
+ * so a scene with many material variants can start drawing straight away. Thread safe.
+ */
+class LTVKPipelineManager
+{
+    /**
+     * Fields
+     */
+private:
+    LTVKDevice* m_LTVKDevice;
+
+    /**
+     * Every entry, in request order, and the same entries chained by hash.
+     */
+    eastl::vector<LTVKPipelineEntry*> m_Entries;
+    LTVKPipelineEntry* m_Buckets[LT_VK_PIPELINE_BUCKET_COUNT];
+
+    /**
+     * The entries waiting for a worker; the ones before m_NextPending are taken.
+     */
+    eastl::vector<LTVKPipelineEntry*> m_PendingEntries;
+    size_t m_NextPending;
+
+    /**
+     * The entries requested but not yet compiled, queued or in a worker's hands.
+     */
+    uint32_t m_CompilingCount;
+
+    /**
+     * Drawn with in place of a pipeline that is not ready yet. Set from the main
+     * thread only.
+     */
+    const LTVKPipelineEntry* m_Placeholder;
+
+    /**
+     * The worker threads compiling the pending entries.
+     */
+    eastl::vector<std::thread*> m_CompileThreads;
+    bool m_IsRunning;
+
+    /**
+     * Requests made, and how many of them matched an existing entry.
+     */
+    uint32_t m_RequestCount;
+    uint32_t m_DeduplicatedCount;
+
+    /**
+     * Pipelines compiled and failed, the time the workers spent compiling them
+     * summed, and the wall time during which any pipeline was being compiled.
+     */
+    uint32_t m_CompiledCount;
+    uint32_t m_FailedCount;
+    std::chrono::nanoseconds m_CompileTime;
+    std::chrono::nanoseconds m_BusyTime;
+    std::chrono::steady_clock::time_point m_BusyStart;
+
+    /**
+     * The mutex for controlling access to the entries and stats, the condition
+     * signalled when an entry is queued, and the one signalled when one is compiled.
+     */
+    std::mutex m_Mutex;
+    std::condition_variable m_PendingCondition;
+    std::condition_variable m_CompiledCondition;
+
+    /**
+     * Constructors
+     */
+public:
+    LTVKPipelineManager() :
+        m_LTVKDevice(nullptr),
+        m_Buckets(),
+        m_NextPending(0),
+        m_CompilingCount(0),
+        m_Placeholder(nullptr),
+        m_IsRunning(false),
+        m_RequestCount(0),
+        m_DeduplicatedCount(0),
+        m_CompiledCount(0),
+        m_FailedCount(0),
+        m_CompileTime(0),
+        m_BusyTime(0)
+    {
+    }
+
+    /**
+     * Methods
+     */
+public:
+
+    /**
+     * Starts the workers. With a worker count of 0, one is started for every
+     * hardware thread but the main thread's.
+     */
+    void Initialize(LTVKDevice* ltvkDevice, uint32_t workerCount = 0);
+
+    /**
+     * Stops the workers, dropping the requests they did not get to, and destroys
+     * every pipeline. Call before the shaders of pending requests are unloaded;
+     * calling it again does nothing.
+     */
+    void Destroy();
+
+    /**
+     * Gets the entry for a pipeline, queueing it to be compiled if it is new. The
+     * config is only read during the call, but the shaders must stay loaded until
+     * the entry is ready.
+     */
+    LTVKPipelineEntry* RequestPipeline(
+        const LTVKPipelineConfig& config,
+        LTShader* vertexShader,
+        LTShader* fragmentShader);
+
+    /**
+     * Sets the entry drawn with while other entries are pending. It must share their
+     * pipeline layout and render pass.
+     */
+    void SetPlaceholder(const LTVKPipelineEntry* placeholder);
+
+    /**
+     * Gets an entry's pipeline, or the placeholder's while the entry is pending or
+     * if it failed; VK_NULL_HANDLE when neither is ready, in which case skip the draw.
+     */
+    VkPipeline GetPipeline(const LTVKPipelineEntry* entry) const;
+
+    inline bool IsReady(const LTVKPipelineEntry* entry) const
+    {
+        return entry->state.load(std::memory_order_acquire) == LTVKPipelineState::LT_VK_PIPELINE_STATE_READY;
+    }
+
+    /**
+     * Waits until an entry is compiled; false if it failed.
+     */
+    bool Wait(const LTVKPipelineEntry* entry);
+
+    /**
+     * Waits until every entry requested so far is compiled.
+     */
+    void WaitAll();
+
+    /**
+     * Prints how many pipelines were requested and compiled, and the compile time
+     * against the wall time it took.
+     */
+    void PrintStats();
+
+private:
+
+    /**
+     * Flattens a config and its shaders into a zeroed key.
+     */
+    static void BuildKey(
+        const LTVKPipelineConfig& config,
+        LTShader* vertexShader,
+        LTShader* fragmentShader,
+        LTVKPipelineKey& outKey);
+
+    /**
+     * Fills a config from a key; the config points into the key.
+     */
+    static void BuildConfig(const LTVKPipelineKey& key, LTVKPipelineConfig& outConfig);
+
+    void CompileThread();
+
+    void Compile(LTVKPipelineEntry* entry);
+};
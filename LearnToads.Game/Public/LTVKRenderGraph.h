@@ -0,0 +1,456 @@
+#pragma once
+
+#include "PrecompiledHeader.h"
+
+#include <vulkan/vulkan.h>
+
+#include "LTVKMemoryAllocator.h"
+
+class LTVKDevice;
+
+/**
+ * A resource declared to a render graph, by index.
+ */
+using LTVKRenderGraphResource = uint32_t;
+
+constexpr LTVKRenderGraphResource LT_VK_RENDER_GRAPH_NO_RESOURCE = UINT32_MAX;
+
+/**
+ * Records a pass's commands. Called on the thread executing the graph, between
+ * the barriers the graph places.
+ */
+using LTVKRenderGraphExecute = std::function<void(VkCommandBuffer)>;
+
+/**
+ * How a pass uses a resource. Each access has one pipeline stage, access mask and
+ * image layout, from which the graph derives the barriers and the resource's usage
+ * flags. A render pass drawing to a graph image must take its attachments in the
+ * layout of their access and leave them in it, with no external dependencies; the
+ * graph transitions and synchronizes them.
+ */
+enum class LTVKResourceAccess : uint8_t
+{
+    LT_VK_RESOURCE_ACCESS_COLOR_ATTACHMENT,
+    LT_VK_RESOURCE_ACCESS_DEPTH_ATTACHMENT,
+    LT_VK_RESOURCE_ACCESS_DEPTH_READ,
+    LT_VK_RESOURCE_ACCESS_SAMPLED,
+    LT_VK_RESOURCE_ACCESS_UNIFORM,
+    LT_VK_RESOURCE_ACCESS_STORAGE_READ,
+    LT_VK_RESOURCE_ACCESS_STORAGE_WRITE,
+    LT_VK_RESOURCE_ACCESS_TRANSFER_READ,
+    LT_VK_RESOURCE_ACCESS_TRANSFER_WRITE,
+    LT_VK_RESOURCE_ACCESS_VERTEX_BUFFER,
+    LT_VK_RESOURCE_ACCESS_INDEX_BUFFER,
+    LT_VK_RESOURCE_ACCESS_INDIRECT_BUFFER,
+
+    LT_VK_RESOURCE_ACCESS_COUNT,
+};
+
+/**
+ * The synchronization a resource was last left in, as far as barriers are
+ * concerned.
+ */
+struct LTVKResourceState
+{
+    /**
+     * The stages and access of the last write, and the stages that have read since.
+     */
+    VkPipelineStageFlags writeStages = 0;
+    VkAccessFlags writeAccess = 0;
+    VkPipelineStageFlags readStages = 0;
+
+    /**
+     * The stages and accesses the last write has been made visible to.
+     */
+    VkPipelineStageFlags visibleStages = 0;
+    VkAccessFlags visibleAccess = 0;
+
+    VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
+};
+
+/**
+ * A resource as declared for one compile of the graph.
+ */
+struct LTVKRenderGraphResourceDesc
+{
+    const char* name;
+    bool isImage;
+    bool isImported;
+
+    /**
+     * The image's format and size, or the buffer's size.
+     */
+    VkFormat format;
+    VkExtent2D extent;
+    VkDeviceSize size;
+
+    /**
+     * The image or buffer usage, gathered from the accesses of the passes kept.
+     */
+    VkFlags usage;
+
+    /**
+     * The handles of an imported resource, the state it is in when the graph is
+     * executed and the layout an imported image is left in, or undefined to leave
+     * it in its last one.
+     */
+    VkImage image;
+    VkImageView imageView;
+    VkBuffer buffer;
+    LTVKResourceState importState;
+    VkImageLayout finalLayout;
+
+    /**
+     * Where the first and last passes kept that use the resource run, and the
+     * physical resource backing a transient one; none when no pass kept uses it.
+     */
+    uint32_t firstPass;
+    uint32_t lastPass;
+    uint32_t physicalIndex;
+};
+
+/**
+ * A resource use declared by a pass.
+ */
+struct LTVKRenderGraphUse
+{
+    LTVKRenderGraphResource resource;
+    LTVKResourceAccess access;
+};
+
+struct LTVKRenderGraphPass
+{
+    const char* name;
+    eastl::vector<LTVKRenderGraphUse> uses;
+    LTVKRenderGraphExecute execute;
+
+    /**
+     * Kept even when nothing reads what it writes; passes writing an imported
+     * resource always are.
+     */
+    bool hasSideEffects;
+    bool isCulled;
+
+    /**
+     * The passes kept that must run after it, and the passes it must run after that
+     * have not been scheduled yet.
+     */
+    eastl::vector<uint32_t> dependents;
+    uint32_t dependencyCount;
+};
+
+/**
+ * An image or buffer backing transient resources, at an offset in the heap of its
+ * kind, or in memory of its own when no heap memory type suits it.
+ */
+struct LTVKPhysicalResource
+{
+    VkImage image = VK_NULL_HANDLE;
+    VkImageView imageView = VK_NULL_HANDLE;
+    VkBuffer buffer = VK_NULL_HANDLE;
+
+    VkMemoryRequirements requirements = {};
+    VkDeviceSize offset = 0;
+    LTVKAllocation dedicatedAllocation;
+
+    /**
+     * Where the passes kept that use it run, first to last.
+     */
+    uint32_t firstPass = 0;
+    uint32_t lastPass = 0;
+
+    /**
+     * The other physical resources sharing some of its memory. Their lifetimes do
+     * not overlap with its, but their accesses must complete before it is reused.
+     */
+    eastl::vector<uint32_t> aliases;
+
+    LTVKResourceState state;
+};
+
+/**
+ * The physical resources of one compile, kept for as long as the graph's
+ * transient resources stay the same, and the frame that last used them.
+ */
+struct LTVKRenderGraphResources
+{
+    eastl::vector<LTVKPhysicalResource> resources;
+
+    /**
+     * The memory the images and the buffers are placed in, and the bytes each
+     * resource would have taken on its own.
+     */
+    LTVKAllocation imageHeap;
+    LTVKAllocation bufferHeap;
+    VkDeviceSize requestedBytes = 0;
+
+    /**
+     * Describes the transient resources and their lifetimes; a compile with the
+     * same signature reuses these resources.
+     */
+    eastl::vector<uint64_t> signature;
+
+    uint64_t lastFrame = 0;
+};
+
+/**
+ * Orders, culls and synchronizes the passes of a frame.
+ *
+ * Each frame the passes are declared anew with the resources they read and write:
+ * transient images and buffers the graph creates, and imported ones such as the
+ * swapchain image. Compile culls the passes nothing kept depends on and orders the
+ * rest by their dependencies: a pass runs after the last write of what it uses and,
+ * when it writes, after the reads since, as declared. Of the passes ready to run,
+ * one that does not depend on the pass just scheduled goes first, so a barrier has
+ * other work to overlap; passes with side effects keep their declared order. The
+ * transient resources whose lifetimes do not overlap in that order share memory.
+ * Execute records the passes with the barriers they need between them, one batch
+ * per pass, skipping those a read after a read would repeat.
+ *
+ * The transient resources are kept between frames while their declarations stay
+ * the same. When they change they are replaced, and the old ones destroyed once
+ * the frames using them have completed. Call from one thread only.
+ */
+class LTVKRenderGraph
+{
+    /**
+     * Fields
+     */
+private:
+    LTVKDevice* m_LTVKDevice;
+    VkDevice m_Device;
+
+    /**
+     * The resources and passes declared since the last Reset.
+     */
+    eastl::vector<LTVKRenderGraphResourceDesc> m_Resources;
+    eastl::vector<LTVKRenderGraphPass> m_Passes;
+
+    /**
+     * The passes kept, in the order the last compile scheduled them.
+     */
+    eastl::vector<uint32_t> m_Order;
+
+    /**
+     * The physical resources in use, whether Compile replaced them, and the ones
+     * replaced but still in use by frames in flight.
+     */
+    LTVKRenderGraphResources* m_PhysicalResources;
+    bool m_DidResourcesChange;
+    eastl::vector<LTVKRenderGraphResources*> m_RetiredResources;
+
+    /**
+     * The barriers of the pass being recorded.
+     */
+    eastl::vector<VkImageMemoryBarrier> m_ImageBarriers;
+    eastl::vector<VkBufferMemoryBarrier> m_BufferBarriers;
+
+    /**
+     * Passes culled and run out of their declared order by the last compile, and
+     * the barriers recorded over every execute.
+     */
+    uint32_t m_CulledPassCount;
+    uint32_t m_ReorderedPassCount;
+    uint32_t m_ExecuteCount;
+    uint32_t m_BarrierBatchCount;
+    uint32_t m_ImageBarrierCount;
+    uint32_t m_BufferBarrierCount;
+    uint32_t m_SkippedBarrierCount;
+    uint32_t m_ResourceCreateCount;
+
+    /**
+     * Constructors
+     */
+public:
+    LTVKRenderGraph() :
+        m_LTVKDevice(nullptr),
+        m_Device(VK_NULL_HANDLE),
+        m_PhysicalResources(nullptr),
+        m_DidResourcesChange(false),
+        m_CulledPassCount(0),
+        m_ReorderedPassCount(0),
+        m_ExecuteCount(0),
+        m_BarrierBatchCount(0),
+        m_ImageBarrierCount(0),
+        m_BufferBarrierCount(0),
+        m_SkippedBarrierCount(0),
+        m_ResourceCreateCount(0)
+    {
+    }
+
+    // non-copyable
+    LTVKRenderGraph(const LTVKRenderGraph&) = delete;
+    void operator=(const LTVKRenderGraph&) = delete;
+
+    /**
+     * Methods
+     */
+public:
+
+    void Initialize(LTVKDevice* ltvkDevice);
+
+    /**
+     * Destroys the physical resources. The frames using them must have completed.
+     */
+    void Destroy();
+
+    /**
+     * Forgets the passes and resources declared, to declare the next frame's. The
+     * physical resources are kept for it.
+     */
+    void Reset();
+
+    /**
+     * Declares a transient image or buffer, created by the graph; its first use
+     * must write it.
+     */
+    LTVKRenderGraphResource CreateImage(const char* name, VkFormat format, VkExtent2D extent);
+    LTVKRenderGraphResource CreateBuffer(const char* name, VkDeviceSize size);
+
+    /**
+     * Declares an image or buffer the graph does not own, in the layout and state
+     * it is in when the graph is executed; e.g. the swapchain image, with the stage
+     * its acquire semaphore is waited on. An imported image is left in finalLayout
+     * unless it is undefined.
+     */
+    LTVKRenderGraphResource ImportImage(
+        const char* name,
+        VkImage image,
+        VkImageView imageView,
+        VkFormat format,
+        VkExtent2D extent,
+        VkImageLayout currentLayout,
+        VkPipelineStageFlags currentStages,
+        VkAccessFlags currentAccess,
+        VkImageLayout finalLayout);
+    LTVKRenderGraphResource ImportBuffer(
+        const char* name,
+        VkBuffer buffer,
+        VkDeviceSize size,
+        VkPipelineStageFlags currentStages,
+        VkAccessFlags currentAccess);
+
+    /**
+     * Declares a pass. It sees each resource it uses as the passes declared before
+     * it leave it, but may run before passes it shares no resource with. Returns
+     * its index.
+     */
+    uint32_t AddPass(const char* name, const LTVKRenderGraphExecute& execute, bool hasSideEffects = false);
+
+    /**
+     * Declares that a pass reads or writes a resource, as the access says; at most
+     * once per resource and pass.
+     */
+    void AddUse(uint32_t pass, LTVKRenderGraphResource resource, LTVKResourceAccess access);
+
+    /**
+     * Culls the passes nothing depends on, orders the rest and places the transient
+     * resources, reusing the last compile's when they are the same. Retired
+     * resources used by no frame after completedFrame are destroyed.
+     */
+    bool Compile(uint64_t completedFrame);
+
+    /**
+     * Records the passes kept, with their barriers, into a command buffer of the
+     * given frame.
+     */
+    void Execute(VkCommandBuffer commandBuffer, uint64_t frameNumber);
+
+    /**
+     * Prints the passes culled, the barriers recorded and the memory the transient
+     * resources take against what they would without aliasing.
+     */
+    void PrintStats();
+
+    /**
+     * Gets the handles of a resource, valid after Compile; the image view is of the
+     * whole image. They stay the same between compiles unless DidResourcesChange.
+     */
+    VkImage GetImage(LTVKRenderGraphResource resource) const;
+    VkImageView GetImageView(LTVKRenderGraphResource resource) const;
+    VkBuffer GetBuffer(LTVKRenderGraphResource resource) const;
+
+    inline bool IsCulled(uint32_t pass) const
+    {
+        return m_Passes[pass].isCulled;
+    }
+
+    /**
+     * Gets the passes kept, in the order the last Compile scheduled them.
+     */
+    inline const eastl::vector<uint32_t>& GetOrder() const
+    {
+        return m_Order;
+    }
+
+    /**
+     * Whether the last Compile replaced the physical resources, so framebuffers and
+     * descriptors made from them must be made again.
+     */
+    inline bool DidResourcesChange() const
+    {
+        return m_DidResourcesChange;
+    }
+
+private:
+
+    /**
+     * Marks the passes to cull.
+     */
+    void CullPasses();
+
+    /**
+     * Orders the passes kept by their dependencies, and finds the lifetime and
+     * usage of each resource in that order.
+     */
+    void SchedulePasses();
+
+    /**
+     * Makes a pass run after another, once however many resources they share.
+     */
+    void AddDependency(uint32_t pass, uint32_t dependent);
+
+    /**
+     * Creates the physical resources of the transient resources in use and places
+     * them in memory.
+     */
+    bool CreateResources(LTVKRenderGraphResources& physicalResources);
+
+    /**
+     * Places one kind of physical resource in a heap, at the lowest offset not
+     * overlapping any placed resource whose lifetime overlaps its own.
+     */
+    bool PlaceResources(
+        LTVKRenderGraphResources& physicalResources,
+        bool isImage,
+        LTVKAllocation& outHeap);
+
+    void DestroyResources(LTVKRenderGraphResources& physicalResources);
+
+    /**
+     * Adds the barrier, if any, a resource needs before an access, and moves its
+     * state past the access. First uses of transient resources discard their
+     * contents and wait for the accesses to any resource sharing their memory.
+     */
+    void AddBarrier(
+        LTVKRenderGraphResourceDesc& desc,
+        LTVKResourceState& state,
+        LTVKResourceAccess access,
+        bool isFirstUse,
+        VkPipelineStageFlags& srcStages,
+        VkPipelineStageFlags& dstStages,
+        VkMemoryBarrier& memoryBarrier);
+
+    /**
+     * Records the barriers added for a pass as one batch, if there are any.
+     */
+    void RecordBarriers(
+        VkCommandBuffer commandBuffer,
+        VkPipelineStageFlags srcStages,
+        VkPipelineStageFlags dstStages,
+        const VkMemoryBarrier& memoryBarrier);
+
+    LTVKResourceState& GetState(LTVKRenderGraphResourceDesc& desc);
+
+    static VkImageAspectFlags GetImageAspect(VkFormat format);
+};
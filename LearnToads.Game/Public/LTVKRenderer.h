@@ -0,0 +1,360 @@
+#pragma once
+
+#include "PrecompiledHeader.h"
+
+#include <vulkan/vulkan.h>
+
+#include "LTVKCommandRecorder.h"
+#include "LTVKRenderGraph.h"
+#include "LTVKSwapChain.h"
+
+class LTVKDevice;
+class LTGameWindow;
+
+/**
+ * The most frames the CPU records ahead of the GPU.
+ */
+constexpr uint32_t LT_VK_MAX_FRAMES_IN_FLIGHT = 3;
+
+/**
+ * How the renderer presents.
+ */
+struct LTVKRendererConfig
+{
+    LTVKPresentMode presentMode = LTVKPresentMode::LT_VK_PRESENT_MODE_FIFO;
+
+    /**
+     * The frames recorded ahead of the GPU, from 1 to LT_VK_MAX_FRAMES_IN_FLIGHT. With
+     * 2 the CPU records frame N+1 while the GPU executes frame N.
+     */
+    uint32_t framesInFlight = 2;
+
+    /**
+     * The worker threads recording secondary command buffers next to the main
+     * thread; 0 starts one per hardware thread but the main thread's.
+     */
+    uint32_t recordWorkerCount = 0;
+};
+
+/**
+ * The resources of one frame in flight, reused every framesInFlight frames.
+ */
+struct LTVKFrame
+{
+    /**
+     * Reset as a whole when the frame is begun, rather than buffer by buffer.
+     */
+    VkCommandPool commandPool = VK_NULL_HANDLE;
+    VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+
+    /**
+     * Signalled when the swapchain image the frame renders to is acquired.
+     */
+    VkSemaphore imageAvailableSemaphore = VK_NULL_HANDLE;
+
+    /**
+     * Signalled when the GPU has executed the frame; created signalled.
+     */
+    VkFence fence = VK_NULL_HANDLE;
+
+    /**
+     * The number of the frame last submitted with these resources, or 0.
+     */
+    uint64_t frameNumber = 0;
+
+    /**
+     * The swapchain image the frame renders to.
+     */
+    uint32_t imageIndex = 0;
+};
+
+/**
+ * A swapchain replaced by a new one, and the last frame that may have used it.
+ */
+struct LTVKRetiredSwapChain
+{
+    LTVKSwapChain* swapChain;
+    uint64_t lastFrame;
+};
+
+/**
+ * Draws frames to the window through its swapchain, with up to
+ * LT_VK_MAX_FRAMES_IN_FLIGHT frames recorded ahead of the GPU.
+ *
+ * Each frame in flight has a command pool, semaphore and fence of its own, so
+ * beginning a frame waits only for the frame that last used the same resources,
+ * framesInFlight frames ago. When the window is resized the swapchain is replaced
+ * without waiting for the device; the old one is destroyed once the frames queued
+ * on it have completed. Call from the main thread only.
+ *
+ * A frame is recorded through a render graph. BeginFrame imports the acquired
+ * image and the depth buffer into it, passes are added to it, and EndFrame
+ * compiles and executes it; the graph places the layout transitions and barriers
+ * between the passes, which the render pass leaves to it.
+ */
+class LTVKRenderer
+{
+    /**
+     * Fields
+     */
+private:
+    LTVKDevice* m_LTVKDevice;
+    VkDevice m_Device;
+    LTGameWindow* m_Window;
+
+    LTVKRendererConfig m_Config;
+
+    /**
+     * Renders into a swapchain image and a depth buffer, of these formats; kept
+     * across swapchains.
+     */
+    VkRenderPass m_RenderPass;
+    VkFormat m_ColorFormat;
+    VkFormat m_DepthFormat;
+
+    /**
+     * A layout with no descriptor sets or push constants, for pipelines that take
+     * no resources.
+     */
+    VkPipelineLayout m_EmptyPipelineLayout;
+
+    /**
+     * The swapchain frames are drawn to, whether it has to be replaced before the
+     * next frame, and the ones replaced but still in use.
+     */
+    LTVKSwapChain* m_SwapChain;
+    bool m_IsSwapChainStale;
+    eastl::vector<LTVKRetiredSwapChain> m_RetiredSwapChains;
+
+    /**
+     * The number of the last frame rendered to each image of the swapchain, or 0.
+     */
+    eastl::vector<uint64_t> m_ImageFrames;
+
+    LTVKFrame m_Frames[LT_VK_MAX_FRAMES_IN_FLIGHT];
+
+    /**
+     * The frame being recorded, between BeginFrame and EndFrame, otherwise null.
+     */
+    LTVKFrame* m_CurrentFrame;
+
+    /**
+     * Records the secondary command buffers of RecordParallel, and the ones recorded
+     * for the current call.
+     */
+    LTVKCommandRecorder m_CommandRecorder;
+    eastl::vector<VkCommandBuffer> m_SecondaryCommandBuffers;
+
+    /**
+     * How the render pass in progress is recorded.
+     */
+    VkSubpassContents m_SubpassContents;
+
+    /**
+     * The passes of the frame being recorded, and the swapchain image and depth
+     * buffer imported into it.
+     */
+    LTVKRenderGraph m_RenderGraph;
+    LTVKRenderGraphResource m_BackBuffer;
+    LTVKRenderGraphResource m_DepthBuffer;
+
+    /**
+     * The number of the next frame to begin, and the last frame the GPU is known
+     * to have completed; frames complete in order.
+     */
+    uint64_t m_FrameNumber;
+    uint64_t m_CompletedFrame;
+
+    /**
+     * Swapchains created after the first, and the time the CPU spent waiting for
+     * frames in flight to complete.
+     */
+    uint32_t m_SwapChainRecreateCount;
+    std::chrono::nanoseconds m_FrameWaitTime;
+
+    /**
+     * Constructors
+     */
+public:
+    LTVKRenderer() :
+        m_LTVKDevice(nullptr),
+        m_Device(VK_NULL_HANDLE),
+        m_Window(nullptr),
+        m_RenderPass(VK_NULL_HANDLE),
+        m_ColorFormat(VK_FORMAT_UNDEFINED),
+        m_DepthFormat(VK_FORMAT_UNDEFINED),
+        m_EmptyPipelineLayout(VK_NULL_HANDLE),
+        m_SwapChain(nullptr),
+        m_IsSwapChainStale(false),
+        m_CurrentFrame(nullptr),
+        m_SubpassContents(VK_SUBPASS_CONTENTS_INLINE),
+        m_BackBuffer(LT_VK_RENDER_GRAPH_NO_RESOURCE),
+        m_DepthBuffer(LT_VK_RENDER_GRAPH_NO_RESOURCE),
+        m_FrameNumber(1),
+        m_CompletedFrame(0),
+        m_SwapChainRecreateCount(0),
+        m_FrameWaitTime(0)
+    {
+    }
+
+    // non-copyable
+    LTVKRenderer(const LTVKRenderer&) = delete;
+    void operator=(const LTVKRenderer&) = delete;
+
+    /**
+     * Methods
+     */
+public:
+
+    /**
+     * Creates the render pass, the frames in flight, the command recorder, the
+     * render graph and the swapchain.
+     */
+    bool Initialize(LTVKDevice* ltvkDevice, LTGameWindow* window, const LTVKRendererConfig& config);
+
+    /**
+     * Waits for the frames in flight and destroys everything the renderer created.
+     */
+    void Destroy();
+
+    /**
+     * Waits for the frame's resources to be free, acquires a swapchain image, begins
+     * recording and starts the frame's render graph. False when there is nothing to
+     * draw to, e.g. the window is minimized or the swapchain is being replaced; skip
+     * the frame.
+     */
+    bool BeginFrame();
+
+    /**
+     * Adds a pass to the frame's graph that draws into the render pass on the
+     * acquired image and the depth buffer, clearing both. Inline, the viewport and
+     * scissor are set to the whole image and the draws are recorded into the
+     * command buffer 'record' is given; with secondary command buffers, 'record' may
+     * only draw through RecordParallel. Returns the pass, for the uses of anything
+     * else it reads.
+     */
+    uint32_t AddScenePass(
+        const char* name,
+        float red,
+        float green,
+        float blue,
+        VkSubpassContents contents,
+        const LTVKRenderGraphExecute& record);
+
+    /**
+     * Records taskCount tasks into secondary command buffers on the command
+     * recorder's threads and executes them in task order. Call from a scene pass
+     * added with VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS.
+     */
+    void RecordParallel(uint32_t taskCount, const LTVKRecordCallback& record);
+
+    /**
+     * Compiles and executes the frame's render graph, submits the frame and
+     * presents it; does not wait for the GPU.
+     */
+    void EndFrame();
+
+    /**
+     * Prints the frames drawn, the time spent waiting for frames in flight, how
+     * often the swapchain was replaced, and the command recorder's and render
+     * graph's stats.
+     */
+    void PrintStats();
+
+    /**
+     * Gets the graph of the frame being recorded, to add passes to, and the
+     * acquired image and the depth buffer as its resources. The back buffer is
+     * presented after the graph has run.
+     */
+    inline LTVKRenderGraph& GetRenderGraph()
+    {
+        return m_RenderGraph;
+    }
+
+    inline LTVKRenderGraphResource GetBackBuffer() const
+    {
+        return m_BackBuffer;
+    }
+
+    inline LTVKRenderGraphResource GetDepthBuffer() const
+    {
+        return m_DepthBuffer;
+    }
+
+    inline VkRenderPass GetRenderPass() const
+    {
+        return m_RenderPass;
+    }
+
+    inline VkPipelineLayout GetEmptyPipelineLayout() const
+    {
+        return m_EmptyPipelineLayout;
+    }
+
+    /**
+     * Gets the command buffer of the frame being recorded.
+     */
+    inline VkCommandBuffer GetCommandBuffer() const
+    {
+        return m_CurrentFrame->commandBuffer;
+    }
+
+    /**
+     * Gets the number of the frame being recorded, or of the next frame between frames.
+     */
+    inline uint64_t GetFrameNumber() const
+    {
+        return m_FrameNumber;
+    }
+
+    /**
+     * Gets which of the frames in flight is being recorded, for resources kept per
+     * frame in flight; the GPU is done with them once BeginFrame has returned.
+     */
+    inline uint32_t GetFrameIndex() const
+    {
+        return (uint32_t)(m_FrameNumber % m_Config.framesInFlight);
+    }
+
+    /**
+     * Gets the last frame the GPU is known to have completed; resources used by no
+     * later frame can be destroyed.
+     */
+    inline uint64_t GetCompletedFrame() const
+    {
+        return m_CompletedFrame;
+    }
+
+    inline VkExtent2D GetExtent() const
+    {
+        return m_SwapChain->GetExtent();
+    }
+
+private:
+
+    /**
+     * Begins the render pass on the acquired image, clearing it, and ends it; run
+     * by a scene pass.
+     */
+    void BeginRenderPass(float red, float green, float blue, VkSubpassContents contents);
+    void EndRenderPass();
+
+    bool CreateRenderPass();
+    bool CreateFrames();
+
+    /**
+     * Replaces the swapchain with one for the window's current size, retiring the
+     * old one. False when the window is minimized.
+     */
+    bool RecreateSwapChain();
+
+    /**
+     * Destroys the retired swapchains whose frames have all completed.
+     */
+    void ReleaseRetiredSwapChains();
+
+    /**
+     * Waits until a frame has completed; frame 0 and completed frames return at once.
+     */
+    void WaitForFrame(uint64_t frameNumber);
+};
@@ -0,0 +1,193 @@
+#pragma once
+
+#include "PrecompiledHeader.h"
+
+#include <vulkan/vulkan.h>
+
+#include "LTVKMemoryAllocator.h"
+
+class LTVKDevice;
+
+/**
+ * How frames are handed to the display.
+ */
+enum class LTVKPresentMode : uint8_t
+{
+    /**
+     * Waits for vertical blank; never tears and is always supported.
+     */
+    LT_VK_PRESENT_MODE_FIFO,
+
+    /**
+     * Replaces the queued frame with the newest one at vertical blank; never tears
+     * and does not block on the display. Falls back to FIFO.
+     */
+    LT_VK_PRESENT_MODE_MAILBOX,
+
+    /**
+     * Presents straight away and may tear. Falls back to MAILBOX, then FIFO.
+     */
+    LT_VK_PRESENT_MODE_IMMEDIATE,
+};
+
+/**
+ * The swapchain images of the window surface, with a framebuffer each that shares
+ * one depth image.
+ *
+ * A new swapchain is created from the old one when the surface changes, so the
+ * old one can finish presenting the frames already queued on it; it is destroyed
+ * once those frames are done with it.
+ */
+class LTVKSwapChain
+{
+    /**
+     * Fields
+     */
+private:
+    LTVKDevice* m_LTVKDevice;
+    VkDevice m_Device;
+
+    VkSwapchainKHR m_SwapChain;
+    VkFormat m_ImageFormat;
+    VkExtent2D m_Extent;
+    VkPresentModeKHR m_PresentMode;
+
+    /**
+     * The swapchain images, and the view and framebuffer of each.
+     */
+    eastl::vector<VkImage> m_Images;
+    eastl::vector<VkImageView> m_ImageViews;
+    eastl::vector<VkFramebuffer> m_Framebuffers;
+
+    /**
+     * Signalled when rendering into an image is done and waited on by its present;
+     * one per image, since a present may still be waiting on one after its frame's
+     * fence has signalled.
+     */
+    eastl::vector<VkSemaphore> m_RenderFinishedSemaphores;
+
+    /**
+     * The depth buffer every framebuffer renders with.
+     */
+    VkImage m_DepthImage;
+    LTVKAllocation m_DepthAllocation;
+    VkImageView m_DepthImageView;
+
+    /**
+     * Constructors
+     */
+public:
+    LTVKSwapChain() :
+        m_LTVKDevice(nullptr),
+        m_Device(VK_NULL_HANDLE),
+        m_SwapChain(VK_NULL_HANDLE),
+        m_ImageFormat(VK_FORMAT_UNDEFINED),
+        m_Extent(),
+        m_PresentMode(VK_PRESENT_MODE_FIFO_KHR),
+        m_DepthImage(VK_NULL_HANDLE),
+        m_DepthAllocation(),
+        m_DepthImageView(VK_NULL_HANDLE)
+    {
+    }
+
+    // non-copyable
+    LTVKSwapChain(const LTVKSwapChain&) = delete;
+    void operator=(const LTVKSwapChain&) = delete;
+
+    /**
+     * Methods
+     */
+public:
+
+    /**
+     * Creates the swapchain for the window's framebuffer size, replacing an old one
+     * if given. False when the window is minimized; the old swapchain is then left
+     * as it was.
+     */
+    bool Initialize(
+        LTVKDevice* ltvkDevice,
+        VkExtent2D windowExtent,
+        LTVKPresentMode presentMode,
+        VkRenderPass renderPass,
+        VkSwapchainKHR oldSwapChain);
+
+    /**
+     * Destroys the swapchain and everything created with it. The frames rendered to
+     * it must have completed.
+     */
+    void Destroy();
+
+    /**
+     * Gets the format the surface is presented in; the same for every swapchain of
+     * the device.
+     */
+    static VkSurfaceFormatKHR ChooseSurfaceFormat(LTVKDevice* ltvkDevice);
+
+    /**
+     * Gets the format of the depth buffer.
+     */
+    static VkFormat ChooseDepthFormat(LTVKDevice* ltvkDevice);
+
+    inline VkSwapchainKHR GetSwapChain() const
+    {
+        return m_SwapChain;
+    }
+
+    inline VkExtent2D GetExtent() const
+    {
+        return m_Extent;
+    }
+
+    inline VkPresentModeKHR GetPresentMode() const
+    {
+        return m_PresentMode;
+    }
+
+    inline uint32_t GetImageCount() const
+    {
+        return (uint32_t)m_Images.size();
+    }
+
+    inline VkFramebuffer GetFramebuffer(uint32_t imageIndex) const
+    {
+        return m_Framebuffers[imageIndex];
+    }
+
+    inline VkImage GetImage(uint32_t imageIndex) const
+    {
+        return m_Images[imageIndex];
+    }
+
+    inline VkImageView GetImageView(uint32_t imageIndex) const
+    {
+        return m_ImageViews[imageIndex];
+    }
+
+    inline VkImage GetDepthImage() const
+    {
+        return m_DepthImage;
+    }
+
+    inline VkImageView GetDepthImageView() const
+    {
+        return m_DepthImageView;
+    }
+
+    inline VkSemaphore GetRenderFinishedSemaphore(uint32_t imageIndex) const
+    {
+        return m_RenderFinishedSemaphores[imageIndex];
+    }
+
+private:
+
+    /**
+     * Gets the supported present mode closest to the one asked for.
+     */
+    static VkPresentModeKHR ChoosePresentMode(
+        const std::vector<VkPresentModeKHR>& availableModes,
+        LTVKPresentMode presentMode);
+
+    bool CreateImageViews();
+    bool CreateDepthImage();
+    bool CreateFramebuffers(VkRenderPass renderPass);
+};
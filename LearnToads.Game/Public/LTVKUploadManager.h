@@ -0,0 +1,329 @@
+#pragma once
+
+#include "PrecompiledHeader.h"
+
+#include <vulkan/vulkan.h>
+
+#include "LTVKMemoryAllocator.h"
+
+class LTVKDevice;
+
+/**
+ * The size of the persistently mapped staging ring that uploads are written into.
+ * Uploads larger than the ring get a staging buffer of their own.
+ */
+constexpr VkDeviceSize LT_VK_UPLOAD_RING_SIZE = 64ull * 1024 * 1024;
+
+/**
+ * The most upload batches in flight on the queue at once.
+ */
+constexpr uint32_t LT_VK_UPLOAD_BATCH_COUNT = 8;
+
+/**
+ * The alignment of every staging range; a multiple of the 4 bytes buffer copies
+ * need and of the block size of every compressed texture format.
+ */
+constexpr VkDeviceSize LT_VK_UPLOAD_ALIGNMENT = 16;
+
+/**
+ * A staging buffer with memory of its own.
+ */
+struct LTVKStagingBuffer
+{
+    VkBuffer buffer = VK_NULL_HANDLE;
+    LTVKAllocation allocation;
+};
+
+/**
+ * A copy from staging memory into a buffer.
+ */
+struct LTVKBufferUpload
+{
+    VkBuffer srcBuffer;
+    VkBuffer dstBuffer;
+    VkBufferCopy region;
+};
+
+/**
+ * Copies from staging memory into the first mipCount levels of an image, which
+ * moves from VK_IMAGE_LAYOUT_UNDEFINED to VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL.
+ */
+struct LTVKImageUpload
+{
+    VkBuffer srcBuffer;
+    VkImage dstImage;
+    uint32_t mipCount;
+
+    /**
+     * The copy regions, in the image regions of the upload or batch.
+     */
+    uint32_t firstRegion;
+    uint32_t regionCount;
+};
+
+/**
+ * A range of staging memory being filled by one thread, and the copies out of it.
+ * Begun with LTVKUploadManager::BeginUpload and queued with EndUpload.
+ */
+struct LTVKUpload
+{
+    /**
+     * The staging buffer and the range of it that is the upload's.
+     */
+    VkBuffer buffer = VK_NULL_HANDLE;
+    VkDeviceSize offset = 0;
+    VkDeviceSize size = 0;
+
+    /**
+     * The start of the range; write the data here before queueing the upload.
+     */
+    void* mappedData = nullptr;
+
+    /**
+     * The range of the staging ring reserved for the upload; 0 when the upload has a
+     * staging buffer of its own.
+     */
+    uint64_t reservation = 0;
+    LTVKStagingBuffer ownStagingBuffer;
+
+    eastl::vector<LTVKBufferUpload> bufferUploads;
+    eastl::vector<LTVKImageUpload> imageUploads;
+    eastl::vector<VkBufferImageCopy> imageRegions;
+};
+
+/**
+ * The uploads recorded into one submission.
+ */
+struct LTVKUploadBatch
+{
+    VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+    VkFence fence = VK_NULL_HANDLE;
+
+    /**
+     * The value of the batch while it is in flight, otherwise 0.
+     */
+    uint64_t value = 0;
+
+    /**
+     * The threads waiting on the fence; the batch is not reused until they are done.
+     */
+    uint32_t waiterCount = 0;
+
+    eastl::vector<LTVKBufferUpload> bufferUploads;
+    eastl::vector<LTVKImageUpload> imageUploads;
+    eastl::vector<VkBufferImageCopy> imageRegions;
+
+    /**
+     * The staging buffers of uploads too large for the ring, freed once the batch
+     * completes.
+     */
+    eastl::vector<LTVKStagingBuffer> stagingBuffers;
+};
+
+/**
+ * A range of the staging ring, in ring order.
+ */
+struct LTVKStagingReservation
+{
+    uint64_t id;
+
+    /**
+     * The bytes of the ring the range took, including any skipped at its end when
+     * the range wrapped around to the start.
+     */
+    VkDeviceSize ringBytes;
+
+    /**
+     * The batch the range was queued into, or 0 while it is still being filled.
+     */
+    uint64_t batch;
+};
+
+/**
+ * Streams data into device-local buffers and images without stalling rendering.
+ *
+ * Threads write their data into a persistently mapped staging ring and queue the
+ * copies out of it; the copies queued while the previous batch is on the GPU are
+ * recorded into a single command buffer and submitted together. Submissions go to
+ * a dedicated transfer queue family when the device has one and are tracked with a
+ * fence each, so waiting for an upload never waits for the graphics queue. Staging
+ * ranges are released in ring order as their batches complete. Thread safe.
+ */
+class LTVKUploadManager
+{
+    /**
+     * Fields
+     */
+private:
+    LTVKDevice* m_LTVKDevice;
+    VkDevice m_Device;
+
+    /**
+     * The queue the batches are submitted to, and whether it belongs to a transfer
+     * family of its own rather than being the graphics queue.
+     */
+    VkQueue m_Queue;
+    bool m_IsDedicatedTransferQueue;
+
+    VkCommandPool m_CommandPool;
+
+    /**
+     * The staging ring. m_RingHead is where the next range starts; m_RingUsedBytes
+     * counts the bytes from the oldest live range up to it.
+     */
+    LTVKStagingBuffer m_Ring;
+    uint8_t* m_RingData;
+    VkDeviceSize m_RingSize;
+    VkDeviceSize m_RingHead;
+    VkDeviceSize m_RingUsedBytes;
+    VkDeviceSize m_Alignment;
+
+    /**
+     * The live ranges of the ring, oldest first.
+     */
+    eastl::vector<LTVKStagingReservation> m_Reservations;
+    uint64_t m_NextReservation;
+
+    /**
+     * The uploads queued since the last submission, how many, and the value their
+     * batch will have.
+     */
+    LTVKUploadBatch m_OpenBatch;
+    uint32_t m_OpenUploadCount;
+    uint64_t m_OpenBatchValue;
+
+    /**
+     * The submitted batches; every batch up to m_CompletedBatch has completed.
+     */
+    LTVKUploadBatch m_Batches[LT_VK_UPLOAD_BATCH_COUNT];
+    uint64_t m_CompletedBatch;
+
+    /**
+     * Scratch for the layout transitions of a batch.
+     */
+    eastl::vector<VkImageMemoryBarrier> m_Barriers;
+
+    /**
+     * The mutex for controlling access to the ring and batches, and the condition
+     * signalled when a range is queued or released.
+     */
+    std::mutex m_Mutex;
+    std::condition_variable m_RingCondition;
+
+    /**
+     * Constructors
+     */
+public:
+    LTVKUploadManager() :
+        m_LTVKDevice(nullptr),
+        m_Device(VK_NULL_HANDLE),
+        m_Queue(VK_NULL_HANDLE),
+        m_IsDedicatedTransferQueue(false),
+        m_CommandPool(VK_NULL_HANDLE),
+        m_RingData(nullptr),
+        m_RingSize(0),
+        m_RingHead(0),
+        m_RingUsedBytes(0),
+        m_Alignment(LT_VK_UPLOAD_ALIGNMENT),
+        m_NextReservation(1),
+        m_OpenUploadCount(0),
+        m_OpenBatchValue(1),
+        m_CompletedBatch(0)
+    {
+    }
+
+    /**
+     * Methods
+     */
+public:
+
+    /**
+     * Creates the staging ring, command buffers and fences on the device's transfer
+     * queue; call once the device and its memory allocator are initialized.
+     */
+    bool Initialize(LTVKDevice* ltvkDevice);
+
+    /**
+     * Waits for every queued upload and frees everything the manager created.
+     */
+    void Destroy();
+
+    /**
+     * Reserves size bytes of staging memory for an upload. A thread must end its
+     * upload before beginning another.
+     */
+    bool BeginUpload(VkDeviceSize size, LTVKUpload& outUpload);
+
+    /**
+     * Adds a copy of size bytes at srcOffset in the upload to dstOffset in a buffer.
+     */
+    void CopyToBuffer(
+        LTVKUpload& upload,
+        VkDeviceSize srcOffset,
+        VkBuffer dstBuffer,
+        VkDeviceSize dstOffset,
+        VkDeviceSize size);
+
+    /**
+     * Adds copies into the first mipCount levels of an image, which is transitioned
+     * for sampling afterwards. The regions' buffer offsets are relative to the upload.
+     */
+    void CopyToImage(
+        LTVKUpload& upload,
+        VkImage dstImage,
+        uint32_t mipCount,
+        const VkBufferImageCopy* regions,
+        uint32_t regionCount);
+
+    /**
+     * Queues the upload's copies into the open batch and returns the batch's value
+     * for IsComplete and Wait. An upload with no copies just releases its staging
+     * memory.
+     */
+    uint64_t EndUpload(LTVKUpload& upload);
+
+    /**
+     * Submits the uploads queued since the last submission.
+     */
+    void Submit();
+
+    bool IsComplete(uint64_t batch);
+
+    /**
+     * Waits until a batch has completed, submitting it first if it is still open.
+     * Blocks only the calling thread.
+     */
+    void Wait(uint64_t batch);
+
+private:
+
+    /**
+     * Reserves a range of the ring; false when the ring has no room for it.
+     */
+    bool ReserveRing(VkDeviceSize size, VkDeviceSize& outOffset, uint64_t& outReservation);
+
+    /**
+     * Records the open batch into a free command buffer and submits it. The mutex
+     * must be held.
+     */
+    void SubmitOpenBatch();
+
+    void RecordBatch(LTVKUploadBatch& batch);
+
+    /**
+     * Gets a batch that is not in flight, waiting for the oldest one if every batch
+     * is. The mutex must be held.
+     */
+    LTVKUploadBatch& AcquireBatch();
+
+    /**
+     * Gets the oldest batch in flight, or null if there is none.
+     */
+    LTVKUploadBatch* GetOldestBatch();
+
+    /**
+     * Releases the batches that have completed, in order, and their staging memory.
+     * The mutex must be held.
+     */
+    void RetireBatches();
+};
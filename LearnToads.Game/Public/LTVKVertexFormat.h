@@ -0,0 +1,30 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include "LTModelFormat.h"
+
+/**
+ * The most vertex attributes a vertex format declares.
+ */
+constexpr uint32_t LT_VK_MAX_VERTEX_ATTRIBUTES = 4;
+
+/**
+ * Describes how the input assembler reads a vertex buffer: a single interleaved
+ * binding and the attributes within it.
+ *
+ * Model formats bind position to location 0, normal to location 1 and uv to
+ * location 2. Quantized normals arrive octahedral encoded as a vec2, and
+ * positions must be decoded with the model's LTModelVertexDecode.
+ */
+struct LTVKVertexFormat
+{
+    VkVertexInputBindingDescription binding;
+    VkVertexInputAttributeDescription attributes[LT_VK_MAX_VERTEX_ATTRIBUTES];
+    uint32_t attributeCount;
+
+    /**
+     * Gets the vertex format for a baked model's vertices.
+     */
+    static const LTVKVertexFormat& GetModelVertexFormat(LTModelVertexFormat format);
+};
@@ -27,5 +27,12 @@
 #include <atomic>
 #include <chrono>
 #include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+#if defined(__cpp_impl_coroutine)
+#include <coroutine>
+#endif
 
 using namespace std::chrono_literals;
@@ -0,0 +1,17 @@
+#version 450
+
+// streamed in as the projectiles get close enough to need the larger mips
+layout (set = 0, binding = 1) uniform sampler2D crateTexture;
+
+layout (location = 0) in vec3 inNormal;
+layout (location = 1) in vec2 inUV;
+
+layout (location = 0) out vec4 outColor;
+
+void main()
+{
+    vec3 lightDirection = normalize(vec3(0.4, 1.0, 0.6));
+    float diffuse = max(dot(normalize(inNormal), lightDirection), 0.0);
+
+    outColor = vec4(texture(crateTexture, inUV).rgb * (0.25 + 0.75 * diffuse), 1.0);
+}
\ No newline at end of file
@@ -0,0 +1,57 @@
+#version 450
+
+// must match LTVKInstanceTransform: the top three rows of the model matrix
+struct InstanceTransform
+{
+    vec4 rows[3];
+};
+
+// every instance of the frame; each draw's first instance is where its batch starts
+layout (std430, set = 0, binding = 0) readonly buffer Instances
+{
+    InstanceTransform instances[];
+};
+
+// must match LTVKInstancePushConstants; positionScale.w is 1 when the normals
+// are octahedral encoded
+layout (push_constant) uniform PushConstants
+{
+    mat4 viewProjection;
+    vec4 positionScale;
+    vec4 positionOffset;
+} pushConstants;
+
+layout (location = 0) in vec3 inPosition;
+layout (location = 1) in vec3 inNormal;
+layout (location = 2) in vec2 inUV;
+
+layout (location = 0) out vec3 outNormal;
+layout (location = 1) out vec2 outUV;
+
+// reverses ContentTools/model.py's octahedral_encode
+vec3 DecodeOctahedral(vec2 encoded)
+{
+    vec3 normal = vec3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+
+    if (normal.z < 0.0)
+    {
+        normal.xy = (1.0 - abs(normal.yx)) * vec2(normal.x >= 0.0 ? 1.0 : -1.0, normal.y >= 0.0 ? 1.0 : -1.0);
+    }
+
+    return normalize(normal);
+}
+
+void main()
+{
+    InstanceTransform instance = instances[gl_InstanceIndex];
+
+    vec4 position = vec4(inPosition * pushConstants.positionScale.xyz + pushConstants.positionOffset.xyz, 1.0);
+    vec3 worldPosition = vec3(dot(instance.rows[0], position), dot(instance.rows[1], position), dot(instance.rows[2], position));
+
+    // the transforms only rotate and scale uniformly, so normals need no inverse transpose
+    vec4 normal = vec4(pushConstants.positionScale.w != 0.0 ? DecodeOctahedral(inNormal.xy) : inNormal, 0.0);
+    outNormal = vec3(dot(instance.rows[0], normal), dot(instance.rows[1], normal), dot(instance.rows[2], normal));
+    outUV = inUV;
+
+    gl_Position = pushConstants.viewProjection * vec4(worldPosition, 1.0);
+}
\ No newline at end of file